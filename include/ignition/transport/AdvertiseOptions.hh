@@ -21,6 +21,7 @@
 #include <cstdint>
 #include <iostream>
 #include <memory>
+#include <string>
 
 #include "ignition/transport/config.hh"
 #include "ignition/transport/Export.hh"
@@ -177,6 +178,16 @@ namespace ignition
         else
           _out << "\tThrottled? No" << std::endl;
 
+        if (!_other.Compression().empty())
+        {
+          _out << "\tCompression: " << _other.Compression() << " (level "
+               << _other.CompressionLevel() << ", from "
+               << _other.CompressionThreshold() << " bytes)" << std::endl;
+        }
+
+        if (_other.Latched())
+          _out << "\tLatch depth: " << _other.LatchDepth() << std::endl;
+
         return _out;
       }
 
@@ -197,6 +208,62 @@ namespace ignition
       /// \param[in] _newMsgsPerSec Maximum number of messages per second.
       public: void SetMsgsPerSec(const uint64_t _newMsgsPerSec);
 
+      /// \brief Get the codec that compresses the messages sent to other
+      /// processes.
+      /// \return The codec name or an empty string if the messages are not
+      /// compressed.
+      /// \sa SetCompression
+      public: std::string Compression() const;
+
+      /// \brief Get the compression level.
+      /// \return The compression level, 0 for the default of the codec.
+      /// \sa SetCompression
+      public: int CompressionLevel() const;
+
+      /// \brief Compress the messages sent to other processes. The codec is
+      /// advertised through discovery and the subscribers decompress the
+      /// messages transparently. Subscribers in the same process or reading
+      /// from shared memory always receive uncompressed messages.
+      /// The codec must be available in the publisher and the subscribers,
+      /// see Codec.
+      /// \param[in] _codec Codec name, such as "zstd" or "lz4". An empty
+      /// string disables the compression.
+      /// \param[in] _level Compression level. The meaning depends on the
+      /// codec, 0 selects its default level.
+      public: void SetCompression(const std::string &_codec,
+                                  const int _level = 0);
+
+      /// \brief Get the minimum size of a serialized message to compress it.
+      /// \return The size in bytes.
+      /// \sa SetCompressionThreshold
+      public: uint64_t CompressionThreshold() const;
+
+      /// \brief Set the minimum size of a serialized message to compress it.
+      /// Smaller messages are sent uncompressed, as are the messages that the
+      /// codec can't shrink. The default value is 1024 bytes.
+      /// \param[in] _bytes Minimum size in bytes.
+      public: void SetCompressionThreshold(const uint64_t _bytes);
+
+      /// \brief Whether the publisher keeps its last messages for the
+      /// subscribers that join later.
+      /// \return True when the latch depth is greater than 0.
+      /// \sa SetLatchDepth
+      public: bool Latched() const;
+
+      /// \brief Get the number of messages kept for the late subscribers.
+      /// \return The number of messages, 0 if the topic isn't latched.
+      /// \sa SetLatchDepth
+      public: uint64_t LatchDepth() const;
+
+      /// \brief Keep the last messages published and replay them to every
+      /// new subscriber, local or remote, as soon as it subscribes. This
+      /// suits slow or static topics, such as a map, whose subscribers
+      /// would otherwise wait for the next publication. Only the new
+      /// subscriber receives the replayed messages. The default value is 0,
+      /// which disables the latching.
+      /// \param[in] _depth Number of messages kept, oldest dropped first.
+      public: void SetLatchDepth(const uint64_t _depth);
+
 #ifdef _WIN32
 // Disable warning C4251 which is triggered by
 // std::unique_ptr
@@ -251,9 +318,45 @@ namespace ignition
                                           const AdvertiseServiceOptions &_other)
       {
         _out << static_cast<AdvertiseOptions>(_other);
+        if (_other.Threads() > 0)
+        {
+          _out << "\tThreads: " << _other.Threads() << std::endl;
+          _out << "\tMax in-flight requests: " << _other.MaxInFlight()
+               << std::endl;
+        }
         return _out;
       }
 
+      /// \brief Get the number of worker threads dedicated to this service.
+      /// \return The number of threads. 0 means that the requests received
+      /// from other processes are executed by the reception thread.
+      /// \sa SetThreads
+      public: unsigned int Threads() const;
+
+      /// \brief Set the number of worker threads dedicated to this service.
+      /// The requests received from other processes are executed by these
+      /// threads, concurrently, so a slow service doesn't delay the rest of
+      /// services and topics of the process. The callback must be thread
+      /// safe when using more than one thread. Requests from the same
+      /// process are always executed by the caller.
+      /// \param[in] _threads Number of threads. 0 (the default) executes the
+      /// requests in the reception thread.
+      public: void SetThreads(const unsigned int _threads);
+
+      /// \brief Get the maximum number of requests queued or running in the
+      /// worker threads.
+      /// \return The maximum number of requests. 0 means no limit.
+      /// \sa SetMaxInFlight
+      public: unsigned int MaxInFlight() const;
+
+      /// \brief Set the maximum number of requests queued or running in the
+      /// worker threads. Requests received when the limit is reached are
+      /// rejected: the requester receives a failed result right away. Only
+      /// used when Threads() is greater than 0.
+      /// \param[in] _maxInFlight Maximum number of requests. 0 (the
+      /// default) means no limit.
+      public: void SetMaxInFlight(const unsigned int _maxInFlight);
+
 #ifdef _WIN32
 // Disable warning C4251 which is triggered by
 // std::unique_ptr
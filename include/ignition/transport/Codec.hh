@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef IGN_TRANSPORT_CODEC_HH_
+#define IGN_TRANSPORT_CODEC_HH_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ignition/transport/config.hh"
+#include "ignition/transport/Export.hh"
+
+namespace ignition
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace IGNITION_TRANSPORT_VERSION_NAMESPACE {
+    //
+    /// \class Codec Codec.hh ignition/transport/Codec.hh
+    /// \brief A compression algorithm for the payload of the messages sent
+    /// to other processes. See AdvertiseMessageOptions::SetCompression().
+    ///
+    /// A codec is selected by name when advertising a topic, and it's
+    /// identified by a number in every compressed message. The library
+    /// provides "zlib" (1), "lz4" (2) and "zstd" (3) when it was built with
+    /// them. Custom codecs must be registered with the same name and
+    /// identifier by publishers and subscribers, and should use identifiers
+    /// from kFirstUserId.
+    class IGNITION_TRANSPORT_VISIBLE Codec
+    {
+      /// \brief Destructor.
+      public: virtual ~Codec();
+
+      /// \brief Get the name used to select this codec.
+      /// \return The codec name.
+      public: virtual std::string Name() const = 0;
+
+      /// \brief Get the identifier sent with every compressed message.
+      /// \return The codec identifier, which can't be 0.
+      public: virtual uint8_t Id() const = 0;
+
+      /// \brief Compress a buffer.
+      /// \param[in] _data Data to compress.
+      /// \param[in] _size Size of the data in bytes.
+      /// \param[in] _level Compression level. 0 selects the default level
+      /// of the codec.
+      /// \param[out] _out Compressed data.
+      /// \return True on success.
+      public: virtual bool Compress(const char *_data,
+                                    const std::size_t _size,
+                                    const int _level,
+                                    std::string &_out) const = 0;
+
+      /// \brief Decompress a buffer produced by Compress().
+      /// \param[in] _data Data to decompress.
+      /// \param[in] _size Size of the data in bytes.
+      /// \param[out] _out Decompressed data.
+      /// \return True on success or false if the data is corrupt.
+      public: virtual bool Decompress(const char *_data,
+                                      const std::size_t _size,
+                                      std::string &_out) const = 0;
+
+      /// \brief Make a codec available to publishers and subscribers.
+      /// \param[in] _codec The codec.
+      /// \return False if the codec is invalid or there is already a codec
+      /// with the same name or identifier.
+      public: static bool Register(std::shared_ptr<const Codec> _codec);
+
+      /// \brief Find a codec by name.
+      /// \param[in] _name Codec name.
+      /// \return The codec or nullptr if it's not available.
+      public: static std::shared_ptr<const Codec> Find(
+                  const std::string &_name);
+
+      /// \brief Find a codec by identifier.
+      /// \param[in] _id Codec identifier.
+      /// \return The codec or nullptr if it's not available.
+      public: static std::shared_ptr<const Codec> Find(const uint8_t _id);
+
+      /// \brief Get the names of the available codecs.
+      /// \return The codec names.
+      public: static std::vector<std::string> Names();
+
+      /// \brief First identifier reserved for custom codecs.
+      public: static constexpr uint8_t kFirstUserId = 128;
+    };
+    }
+  }
+}
+#endif
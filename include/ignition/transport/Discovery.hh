@@ -64,8 +64,10 @@
 #include <map>
 #include <memory>
 #include <mutex>
+#include <set>
 #include <string>
 #include <thread>
+#include <utility>
 #include <vector>
 
 #include <ignition/msgs/Utility.hh>
@@ -113,6 +115,15 @@ namespace ignition
     /// discovery uses heartbeats to track the state of other peers in the
     /// network. The discovery clients can register callbacks to detect when
     /// new topics are discovered or topics are no longer available.
+    ///
+    /// Alternatively, the discovery can run without multicast through one or
+    /// more discovery servers, listed in the environment variable
+    /// IGN_DISCOVERY_SERVER (IP addresses separated by ':'). The clients of
+    /// a server only talk to it. It stores the topics of all its clients and
+    /// forwards to each client the messages about the topics that it asked
+    /// for with Discover(), so the discovery traffic of a process grows with
+    /// its interests instead of with the number of processes. A server is a
+    /// Discovery instance created with _server set to true.
     template<typename Pub>
     class Discovery
     {
@@ -121,18 +132,22 @@ namespace ignition
       /// transport process. This parameter is the transport process' UUID.
       /// \param[in] _port UDP port used for discovery traffic.
       /// \param[in] _verbose true for enabling verbose mode.
+      /// \param[in] _server true for running as a discovery server.
       public: Discovery(const std::string &_pUuid,
                         const int _port,
-                        const bool _verbose = false)
+                        const bool _verbose = false,
+                        const bool _server = false)
         : port(_port),
           hostAddr(determineHost()),
           pUuid(_pUuid),
           silenceInterval(kDefSilenceInterval),
           activityInterval(kDefActivityInterval),
           heartbeatInterval(kDefHeartbeatInterval),
+          datagramSize(kDefDatagramSize),
           connectionCb(nullptr),
           disconnectionCb(nullptr),
           verbose(_verbose),
+          server(_server),
           initialized(false),
           numHeartbeatsUninitialized(0),
           exit(false),
@@ -147,6 +162,22 @@ namespace ignition
           this->hostInterfaces = determineInterfaces();
         }
 
+        // The clients of discovery servers don't use multicast.
+        std::string ignServer;
+        if (!this->server && env("IGN_DISCOVERY_SERVER", ignServer) &&
+            !ignServer.empty())
+        {
+          for (const auto &serverAddr : transport::split(ignServer, ':'))
+          {
+            sockaddr_in addr;
+            memset(&addr, 0, sizeof(addr));
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = inet_addr(serverAddr.c_str());
+            addr.sin_port = htons(static_cast<u_short>(this->port));
+            this->servers.push_back(addr);
+          }
+        }
+
 #ifdef _WIN32
         WORD wVersionRequested;
         WSADATA wsaData;
@@ -182,9 +213,11 @@ namespace ignition
         // Socket option: SO_REUSEADDR. This options is used only for receiving
         // data. We can reuse the same socket for receiving multicast data from
         // multiple interfaces. We will use the socket at position 0 for
-        // receiving data.
+        // receiving data. A discovery server doesn't share its port, as only
+        // one of the sockets would receive the unicast messages.
         int reuseAddr = 1;
-        if (setsockopt(this->sockets.at(0), SOL_SOCKET, SO_REUSEADDR,
+        if (!this->server &&
+            setsockopt(this->sockets.at(0), SOL_SOCKET, SO_REUSEADDR,
             reinterpret_cast<const char *>(&reuseAddr), sizeof(reuseAddr)) != 0)
         {
           std::cerr << "Error setting socket option (SO_REUSEADDR)."
@@ -199,7 +232,8 @@ namespace ignition
         // receiving data.
         int reusePort = 1;
         // cppcheck-suppress ConfigurationNotChecked
-        if (setsockopt(this->sockets.at(0), SOL_SOCKET, SO_REUSEPORT,
+        if (!this->server &&
+            setsockopt(this->sockets.at(0), SOL_SOCKET, SO_REUSEPORT,
             reinterpret_cast<const char *>(&reusePort), sizeof(reusePort)) != 0)
         {
           std::cerr << "Error setting socket option (SO_REUSEPORT)."
@@ -207,12 +241,14 @@ namespace ignition
           return;
         }
 #endif
-        // Bind the first socket to the discovery port.
+        // Bind the first socket to the discovery port. The clients of
+        // discovery servers receive their answers on an ephemeral port.
         sockaddr_in localAddr;
         memset(&localAddr, 0, sizeof(localAddr));
         localAddr.sin_family = AF_INET;
         localAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-        localAddr.sin_port = htons(static_cast<u_short>(this->port));
+        localAddr.sin_port =
+          htons(static_cast<u_short>(this->servers.empty() ? this->port : 0));
 
         if (bind(this->sockets.at(0),
           reinterpret_cast<sockaddr *>(&localAddr), sizeof(sockaddr_in)) < 0)
@@ -230,7 +266,8 @@ namespace ignition
 
         std::vector<std::string> relays;
         std::string ignRelay = "";
-        if (env("IGN_RELAY", ignRelay) && !ignRelay.empty())
+        if (this->Multicast() && env("IGN_RELAY", ignRelay) &&
+            !ignRelay.empty())
         {
           relays = transport::split(ignRelay, ':');
         }
@@ -290,9 +327,15 @@ namespace ignition
         auto now = std::chrono::steady_clock::now();
         this->timeNextHeartbeat = now;
         this->timeNextActivity = now;
+        this->timeBootstrap = now;
+        this->timeLastAnswer = now;
 
         // Start the thread that receives discovery information.
         this->threadReception = std::thread(&Discovery::RecvMessages, this);
+
+        // Ask all the peers for their topics instead of waiting for them. An
+        // empty topic without process UUID is a request for everyone.
+        this->SendMsg(DestinationType::ALL, msgs::Discovery::SUBSCRIBE, Pub());
       }
 
       /// \brief Advertise a new message.
@@ -489,6 +532,69 @@ namespace ignition
         return this->silenceInterval;
       }
 
+      /// \brief Only keep the remote publishers of the topics that this
+      /// process is interested in, see AddInterest() and AddInterestPrefix().
+      /// The discovery messages about other topics are dropped on reception,
+      /// without storing them or running the connection callbacks. Since this
+      /// process only knows part of the topics of the others, it doesn't
+      /// compare the digests of their heartbeats.
+      /// Disabled by default, the discovery keeps the full catalog of topics.
+      /// \param[in] _enabled True for dropping the topics without interest.
+      /// \sa FilterByInterest.
+      public: void SetFilterByInterest(const bool _enabled)
+      {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->filterByInterest = _enabled;
+      }
+
+      /// \brief Whether the discovery drops the topics without interest.
+      /// \sa SetFilterByInterest.
+      /// \return True if the discovery drops them.
+      public: bool FilterByInterest() const
+      {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        return this->filterByInterest;
+      }
+
+      /// \brief Declare the interest of this process in a topic.
+      /// \param[in] _topic Topic name.
+      /// \sa SetFilterByInterest.
+      public: void AddInterest(const std::string &_topic)
+      {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->interests.insert(_topic);
+      }
+
+      /// \brief Declare the interest of this process in all the topics that
+      /// start with a prefix, e.g. the topics of a partition.
+      /// \param[in] _prefix The prefix.
+      /// \sa SetFilterByInterest.
+      public: void AddInterestPrefix(const std::string &_prefix)
+      {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->interestPrefixes.insert(_prefix);
+      }
+
+      /// \brief Get the maximum size of the datagrams sent. The discovery
+      /// packs as many messages as fit in this size into each datagram. A
+      /// larger message is sent alone.
+      /// \sa SetDatagramSize.
+      /// \return The size in bytes.
+      public: uint16_t DatagramSize() const
+      {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        return this->datagramSize;
+      }
+
+      /// \brief Set the maximum size of the datagrams sent.
+      /// \sa DatagramSize.
+      /// \param[in] _size New value in bytes.
+      public: void SetDatagramSize(const uint16_t _size)
+      {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->datagramSize = _size;
+      }
+
       /// \brief Set the activity interval.
       /// \sa ActivityInterval.
       /// \param[in] _ms New value in milliseconds.
@@ -651,6 +757,8 @@ namespace ignition
               this->info.DelPublishersByProc(it->first);
 
               uuids.push_back(it->first);
+              this->peerSyncs.erase(it->first);
+              this->clients.erase(it->first);
 
               // Remove the activity entry.
               this->activity.erase(it++);
@@ -689,47 +797,251 @@ namespace ignition
             return;
         }
 
+        // The heartbeat carries the digest of our topics. The peers only ask
+        // for the whole list when their view of this process doesn't match.
         Publisher pub("", "", this->pUuid, "", AdvertiseOptions());
         this->SendMsg(DestinationType::ALL, msgs::Discovery::HEARTBEAT, pub);
 
+        {
+          std::lock_guard<std::mutex> lock(this->mutex);
+          if (!this->initialized)
+            ++this->numHeartbeatsUninitialized;
+
+          this->timeNextHeartbeat = std::chrono::steady_clock::now() +
+            std::chrono::milliseconds(this->heartbeatInterval);
+        }
+      }
+
+      /// \brief Check if the answers to the query sent by Start() stopped
+      /// arriving. The discovery is initialized when no ADVERTISE message was
+      /// received for twice the time that the first answer took, and at least
+      /// two activity intervals, as the peers answer once per activity
+      /// interval. It's initialized after two cycles of heartbeats anyway.
+      private: void UpdateInit()
+      {
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        if (this->initialized)
+          return;
+
+        auto quiet = std::max(
+          std::chrono::duration_cast<Timestamp::duration>(
+            std::chrono::milliseconds(2 * this->activityInterval)),
+          2 * this->answerDelay);
+
+        if (std::chrono::steady_clock::now() - this->timeLastAnswer < quiet &&
+            this->numHeartbeatsUninitialized < 2)
+        {
+          return;
+        }
+
+        this->initialized = true;
+
+        // Notify anyone waiting for the initialization phase to finish.
+        this->initializedCv.notify_all();
+      }
+
+      /// \brief Re-advertise all the topics of this process if a peer asked
+      /// for them. The requests of several peers received in a short period
+      /// are answered at once, as the answer goes to all of them.
+      private: void UpdateSync()
+      {
         std::map<std::string, std::vector<Pub>> nodes;
         {
           std::lock_guard<std::mutex> lock(this->mutex);
 
-          // Re-advertise topics that are advertised inside this process.
+          if (!this->syncRequested)
+            return;
+
+          Timestamp now = std::chrono::steady_clock::now();
+          if (now - this->timeLastSync <
+                std::chrono::milliseconds(this->activityInterval))
+          {
+            return;
+          }
+
+          this->syncRequested = false;
+          this->timeLastSync = now;
           this->info.PublishersByProc(this->pUuid, nodes);
         }
 
+        std::vector<Pub> pubs;
         for (const auto &topic : nodes)
         {
           for (const auto &node : topic.second)
           {
-            this->SendMsg(DestinationType::ALL,
-                msgs::Discovery::ADVERTISE, node);
+            if (node.Options().Scope() != Scope_t::PROCESS)
+              pubs.push_back(node);
           }
         }
 
+        this->SendMsgs(DestinationType::ALL, msgs::Discovery::ADVERTISE, pubs);
+      }
+
+      /// \brief Compare the digest received in the heartbeat of a peer with
+      /// the topics that we know from it, and ask for its topics if they
+      /// differ. The entries that it didn't advertise again one heartbeat
+      /// after asking are stale, e.g. their UNADVERTISE message was lost, and
+      /// are removed.
+      /// \param[in] _msg The heartbeat.
+      /// \param[in] _sameHost True if the peer runs on this host, so we also
+      /// know its topics with host scope.
+      /// \param[in] _disconnectCb Callback for the stale entries removed.
+      private: void CheckDigest(const msgs::Discovery &_msg,
+                                const bool _sameHost,
+                                const DiscoveryCallback<Pub> &_disconnectCb)
+      {
+        uint64_t digestAll = 0;
+        uint64_t digestHost = 0;
+        bool found = false;
+        for (const auto &data : _msg.header().data())
+        {
+          if (data.key() != kDigestKey || data.value_size() != 2)
+            continue;
+
+          try
+          {
+            digestAll = std::stoull(data.value(0));
+            digestHost = std::stoull(data.value(1));
+            found = true;
+          }
+          catch (...)
+          {
+          }
+        }
+
+        if (!found)
+          return;
+
+        const std::string &peer = _msg.process_uuid();
+        const uint64_t expected =
+          _sameHost ? digestAll + digestHost : digestAll;
+        std::vector<Pub> stale;
+        bool request = false;
         {
           std::lock_guard<std::mutex> lock(this->mutex);
-          if (!this->initialized)
+
+          if (this->Digest(peer).first == expected)
           {
-            ++this->numHeartbeatsUninitialized;
-            if (this->numHeartbeatsUninitialized == 2)
-            {
-              // We consider the discovery initialized after two cycles of
-              // heartbeats sent.
-              this->initialized = true;
+            this->peerSyncs.erase(peer);
+            return;
+          }
 
-              // Notify anyone waiting for the initialization phase to finish.
-              this->initializedCv.notify_all();
+          Timestamp now = std::chrono::steady_clock::now();
+          auto it = this->peerSyncs.find(peer);
+          if (it != this->peerSyncs.end() && now - it->second.requested <
+                std::chrono::milliseconds(this->heartbeatInterval))
+          {
+            // The answer to our last request might still be on its way.
+            return;
+          }
+
+          if (it != this->peerSyncs.end())
+          {
+            // The peer had time to advertise all its topics again.
+            std::map<std::string, std::vector<Pub>> nodes;
+            this->info.PublishersByProc(peer, nodes);
+            for (const auto &topic : nodes)
+            {
+              for (const auto &node : topic.second)
+              {
+                if (it->second.seen.find(SyncKey(node)) ==
+                    it->second.seen.end())
+                {
+                  stale.push_back(node);
+                  this->info.DelPublisherByNode(node.Topic(), peer,
+                    node.NUuid());
+                }
+              }
             }
           }
 
-          this->timeNextHeartbeat = std::chrono::steady_clock::now() +
-            std::chrono::milliseconds(this->heartbeatInterval);
+          if (this->Digest(peer).first != expected)
+          {
+            PeerSync &sync = this->peerSyncs[peer];
+            sync.requested = now;
+            sync.seen.clear();
+            request = true;
+          }
+          else
+          {
+            this->peerSyncs.erase(peer);
+          }
+        }
+
+        if (_disconnectCb)
+        {
+          for (const auto &pub : stale)
+            _disconnectCb(pub);
+        }
+
+        if (request)
+        {
+          // An empty topic asks the peer for all its topics.
+          Pub pub;
+          pub.SetPUuid(peer);
+          this->SendMsg(DestinationType::ALL, msgs::Discovery::SUBSCRIBE,
+            pub);
         }
       }
 
+      /// \brief Get the digest of the topics advertised by a process, as
+      /// known by this discovery instance. It's the sum of the hashes of its
+      /// publishers, so it doesn't depend on their order. It must be called
+      /// with the mutex locked.
+      /// \param[in] _pUuid Process UUID.
+      /// \return The digest of the publishers with scope 'All' and the
+      /// digest of the publishers with scope 'Host'. The digest of a remote
+      /// process only has the first value, which covers all its publishers
+      /// that we know.
+      private: std::pair<uint64_t, uint64_t> Digest(
+        const std::string &_pUuid) const
+      {
+        std::pair<uint64_t, uint64_t> digest{0, 0};
+        std::map<std::string, std::vector<Pub>> nodes;
+        this->info.PublishersByProc(_pUuid, nodes);
+        for (const auto &topic : nodes)
+        {
+          for (const auto &node : topic.second)
+          {
+            const Scope_t scope = node.Options().Scope();
+            if (_pUuid != this->pUuid || scope == Scope_t::ALL)
+              digest.first += Hash(node);
+            else if (scope == Scope_t::HOST)
+              digest.second += Hash(node);
+          }
+        }
+        return digest;
+      }
+
+      /// \brief Get the key that identifies a publisher within its process.
+      /// \param[in] _pub The publisher.
+      /// \return The topic name and the node UUID.
+      private: static std::string SyncKey(const Pub &_pub)
+      {
+        return _pub.Topic() + '\0' + _pub.NUuid();
+      }
+
+      /// \brief Hash a publisher with 64-bit FNV-1a, which gives the same
+      /// value on every platform.
+      /// \param[in] _pub The publisher.
+      /// \return The hash of its topic, node UUID and address.
+      private: static uint64_t Hash(const Pub &_pub)
+      {
+        uint64_t hash = 14695981039346656037ull;
+        for (const std::string &field : {_pub.Topic(), _pub.NUuid(),
+                                         _pub.Addr()})
+        {
+          // The terminating null separates the fields.
+          for (std::size_t i = 0; i <= field.size(); ++i)
+          {
+            hash ^= static_cast<unsigned char>(field[i]);
+            hash *= 1099511628211ull;
+          }
+        }
+        return hash;
+      }
+
       /// \brief Calculate the next timeout. There are three main activities to
       /// perform by the discovery component:
       /// 1. Receive discovery messages.
@@ -771,6 +1083,8 @@ namespace ignition
 
           this->UpdateHeartbeat();
           this->UpdateActivity();
+          this->UpdateSync();
+          this->UpdateInit();
 
           // Is it time to exit?
           {
@@ -795,9 +1109,6 @@ namespace ignition
               reinterpret_cast<socklen_t *>(&addrLen));
         if (received > 0)
         {
-          uint16_t len = 0;
-          memcpy(&len, &rcvStr[0], sizeof(len));
-
           // Ignition Transport delimits each discovery message with a
           // frame_delimiter that contains byte size information.
           // A discovery message has the form:
@@ -815,23 +1126,41 @@ namespace ignition
           // words, the frame_delimiter contains a value that represents
           // the total size of only the frame_body.
           //
+          // Since the wire version 13, a datagram packs one or more
+          // discovery messages one after the other, see Pack().
+          //
           // It is possible that two incompatible versions of Ignition
-          // Transport exist on the same network. If we receive an
-          // unexpected size, then we ignore the message.
-
-          // If-condition for version 8+
-          if (len + sizeof(len) == received)
+          // Transport exist on the same network. If the frames don't fill
+          // the datagram exactly, then we ignore it.
+          std::vector<std::pair<char *, uint16_t>> frames;
+          uint16_t offset = 0;
+          while (offset < received)
           {
-            std::string srcAddr = inet_ntoa(clntAddr.sin_addr);
-            uint16_t srcPort = ntohs(clntAddr.sin_port);
+            uint16_t len = 0;
+            if (received - offset < static_cast<int>(sizeof(len)))
+              return;
+            memcpy(&len, &rcvStr[offset], sizeof(len));
+            offset += sizeof(len);
 
-            if (this->verbose)
-            {
-              std::cout << "\nReceived discovery update from "
-                << srcAddr << ": " << srcPort << std::endl;
-            }
+            if (len > received - offset)
+              return;
+            frames.push_back({rcvStr + offset, len});
+            offset += len;
+          }
+
+          std::string srcAddr = inet_ntoa(clntAddr.sin_addr);
+          uint16_t srcPort = ntohs(clntAddr.sin_port);
+
+          if (this->verbose)
+          {
+            std::cout << "\nReceived discovery update from "
+              << srcAddr << ": " << srcPort << std::endl;
+          }
 
-            this->DispatchDiscoveryMsg(srcAddr, rcvStr + sizeof(len), len);
+          for (const auto &frame : frames)
+          {
+            this->DispatchDiscoveryMsg(srcAddr, clntAddr, frame.first,
+              frame.second);
           }
         }
         else if (received < 0)
@@ -843,9 +1172,11 @@ namespace ignition
 
       /// \brief Parse a discovery message received via the UDP socket
       /// \param[in] _fromIp IP address of the message sender.
+      /// \param[in] _from Address and port of the message sender.
       /// \param[in] _msg Received message.
       /// \param[in] _len Entire length of the package in octets.
       private: void DispatchDiscoveryMsg(const std::string &_fromIp,
+                                         const sockaddr_in &_from,
                                          char *_msg, uint16_t _len)
       {
         ignition::msgs::Discovery msg;
@@ -869,18 +1200,26 @@ namespace ignition
         // Forwarding summary:
         //   - From a unicast peer  -> to multicast group (with NO_RELAY flag).
         //   - From multicast group -> to unicast peers (with RELAY flag).
+        //   - From a client of this discovery server -> to the other clients
+        //     interested in it.
 
+        // The server stores the message like the other processes, after
+        // forwarding it. Neither the servers nor their clients use relays.
+        if (this->server)
+        {
+          this->Route(_from, msg);
+        }
         // If the RELAY flag is set, this discovery message is coming via a
         // unicast transmission. In this case, we don't process it, we just
         // forward it to the multicast group, and it will be dispatched once
         // received there. Note that we also unset the RELAY flag and set the
         // NO_RELAY flag, to avoid forwarding the message anymore.
-        if (msg.has_flags() && msg.flags().relay())
+        else if (this->Multicast() && msg.has_flags() && msg.flags().relay())
         {
           // Unset the RELAY flag in the header and set the NO_RELAY.
           msg.mutable_flags()->set_relay(false);
           msg.mutable_flags()->set_no_relay(true);
-          this->SendMulticast(msg);
+          this->SendMulticast({msg});
 
           // A unicast peer contacted me. I need to save its address for
           // sending future messages in the future.
@@ -892,10 +1231,11 @@ namespace ignition
         // to all our relays. Note that this is the most common case, where we
         // receive a regular multicast message and we forward it to any remote
         // relays.
-        else if (!msg.has_flags() || !msg.flags().no_relay())
+        else if (this->Multicast() &&
+                 (!msg.has_flags() || !msg.flags().no_relay()))
         {
           msg.mutable_flags()->set_relay(true);
-          this->SendUnicast(msg);
+          this->SendUnicast({msg}, this->relayAddrs);
         }
 
         // Update timestamp and cache the callbacks.
@@ -903,9 +1243,11 @@ namespace ignition
         DiscoveryCallback<Pub> disconnectCb;
         DiscoveryCallback<Pub> registerCb;
         DiscoveryCallback<Pub> unregisterCb;
+        bool checkDigest;
         {
           std::lock_guard<std::mutex> lock(this->mutex);
           this->activity[recvPUuid] = std::chrono::steady_clock::now();
+          checkDigest = !this->filterByInterest && this->initialized;
           connectCb = this->connectionCb;
           disconnectCb = this->disconnectionCb;
           registerCb = this->registrationCb;
@@ -920,10 +1262,11 @@ namespace ignition
             Pub publisher;
             publisher.SetFromDiscovery(msg);
 
-            // Check scope of the topic.
+            // Check scope of the topic. The servers take care of the host
+            // scope, see Route().
             if ((publisher.Options().Scope() == Scope_t::PROCESS) ||
                 (publisher.Options().Scope() == Scope_t::HOST &&
-                 _fromIp != this->hostAddr))
+                 this->Multicast() && _fromIp != this->hostAddr))
             {
               return;
             }
@@ -932,7 +1275,25 @@ namespace ignition
             bool added;
             {
               std::lock_guard<std::mutex> lock(this->mutex);
+
+              // An answer to the query sent by Start().
+              if (!this->initialized)
+              {
+                Timestamp now = std::chrono::steady_clock::now();
+                if (this->timeLastAnswer == this->timeBootstrap)
+                  this->answerDelay = now - this->timeBootstrap;
+                this->timeLastAnswer = now;
+              }
+
+              if (!this->Interested(publisher.Topic()))
+                return;
+
               added = this->info.AddPublisher(publisher);
+
+              // Part of the answer to our request for all its topics.
+              auto sync = this->peerSyncs.find(recvPUuid);
+              if (sync != this->peerSyncs.end())
+                sync->second.seen.insert(SyncKey(publisher));
             }
 
             if (added && connectCb)
@@ -958,6 +1319,22 @@ namespace ignition
               break;
             }
 
+            // A peer asks a process, or everyone when it starts, for all its
+            // topics.
+            if (recvTopic.empty())
+            {
+              for (const auto &data : msg.header().data())
+              {
+                if (data.key() == kSyncKey && data.value_size() > 0 &&
+                    (data.value(0) == this->pUuid || data.value(0).empty()))
+                {
+                  std::lock_guard<std::mutex> lock(this->mutex);
+                  this->syncRequested = true;
+                }
+              }
+              break;
+            }
+
             // Check if at least one of my nodes advertises the topic requested.
             Addresses_M<Pub> addresses;
             {
@@ -971,6 +1348,7 @@ namespace ignition
                 break;
             }
 
+            std::vector<Pub> pubs;
             for (const auto &nodeInfo : addresses[this->pUuid])
             {
               // Check scope of the topic.
@@ -981,11 +1359,13 @@ namespace ignition
                 continue;
               }
 
-              // Answer an ADVERTISE message.
-              this->SendMsg(DestinationType::ALL,
-                  msgs::Discovery::ADVERTISE, nodeInfo);
+              pubs.push_back(nodeInfo);
             }
 
+            // Answer with ADVERTISE messages.
+            this->SendMsgs(DestinationType::ALL, msgs::Discovery::ADVERTISE,
+              pubs);
+
             break;
           }
           case msgs::Discovery::NEW_CONNECTION:
@@ -1012,7 +1392,16 @@ namespace ignition
           }
           case msgs::Discovery::HEARTBEAT:
           {
-            // The timestamp has already been updated.
+            // The timestamp has already been updated. The servers check the
+            // digests of their clients, which only know the topics that they
+            // are interested in, like the processes that filter by interest.
+            // While initializing, the peers are already answering the query
+            // sent by Start().
+            if (this->servers.empty() && checkDigest)
+            {
+              this->CheckDigest(msg, this->server || _fromIp == this->hostAddr,
+                disconnectCb);
+            }
             break;
           }
           case msgs::Discovery::BYE:
@@ -1021,6 +1410,7 @@ namespace ignition
             {
               std::lock_guard<std::mutex> lock(this->mutex);
               this->activity.erase(recvPUuid);
+              this->peerSyncs.erase(recvPUuid);
             }
 
             if (disconnectCb)
@@ -1045,14 +1435,21 @@ namespace ignition
             Pub publisher;
             publisher.SetFromDiscovery(msg);
 
-            // Check scope of the topic.
+            // Check scope of the topic. The servers take care of the host
+            // scope, see Route().
             if ((publisher.Options().Scope() == Scope_t::PROCESS) ||
                 (publisher.Options().Scope() == Scope_t::HOST &&
-                 _fromIp != this->hostAddr))
+                 this->Multicast() && _fromIp != this->hostAddr))
             {
               return;
             }
 
+            {
+              std::lock_guard<std::mutex> lock(this->mutex);
+              if (!this->Interested(publisher.Topic()))
+                return;
+            }
+
             if (disconnectCb)
             {
               // Notify the new disconnection.
@@ -1079,18 +1476,91 @@ namespace ignition
       /// \brief Broadcast a discovery message.
       /// \param[in] _type Message type.
       /// \param[in] _pub Publishers's information to send.
-      /// \param[in] _flags Optional flags. Currently, the flags are not used
-      /// but they will in the future for specifying things like compression,
-      /// or encryption.
       private: template<typename T>
       void SendMsg(const DestinationType &_destType,
                    const msgs::Discovery::Type _type,
                    const T &_pub) const
       {
-        ignition::msgs::Discovery discoveryMsg;
-        discoveryMsg.set_version(this->Version());
-        discoveryMsg.set_type(_type);
-        discoveryMsg.set_process_uuid(this->pUuid);
+        this->SendMsgs(_destType, _type, std::vector<T>{_pub});
+      }
+
+      /// \brief Broadcast a discovery message per publisher, packed in as
+      /// few datagrams as possible.
+      /// \param[in] _type Message type.
+      /// \param[in] _pubs Publishers's information to send.
+      private: template<typename T>
+      void SendMsgs(const DestinationType &_destType,
+                    const msgs::Discovery::Type _type,
+                    const std::vector<T> &_pubs) const
+      {
+        std::vector<msgs::Discovery> discoveryMsgs(_pubs.size());
+        for (std::size_t i = 0; i < _pubs.size(); ++i)
+        {
+          if (!this->FillMsg(_type, _pubs[i], discoveryMsgs[i]))
+            return;
+        }
+
+        if (discoveryMsgs.empty())
+          return;
+
+        if (this->server)
+        {
+          // A server forwards the messages of its clients, see Route(). It
+          // only sends its requests for all the topics of a client.
+          if (_type == msgs::Discovery::SUBSCRIBE)
+          {
+            std::map<std::string, std::vector<msgs::Discovery>> outgoing;
+            for (std::size_t i = 0; i < _pubs.size(); ++i)
+              outgoing[_pubs[i].PUuid()].push_back(discoveryMsgs[i]);
+            this->SendToClients(outgoing);
+          }
+        }
+        else if (!this->servers.empty())
+        {
+          this->SendUnicast(discoveryMsgs, this->servers);
+        }
+        else
+        {
+          if (_destType == DestinationType::MULTICAST ||
+              _destType == DestinationType::ALL)
+          {
+            this->SendMulticast(discoveryMsgs);
+          }
+
+          // Send the discovery messages to the unicast relays.
+          if (_destType == DestinationType::UNICAST ||
+              _destType == DestinationType::ALL)
+          {
+            // Set the RELAY flag in the header.
+            for (auto &discoveryMsg : discoveryMsgs)
+              discoveryMsg.mutable_flags()->set_relay(true);
+            this->SendUnicast(discoveryMsgs, this->relayAddrs);
+          }
+        }
+
+        if (this->verbose)
+        {
+          for (const auto &pub : _pubs)
+          {
+            std::cout << "\t* Sending " << msgs::ToString(_type)
+                      << " msg [" << pub.Topic() << "]" << std::endl;
+          }
+        }
+      }
+
+      /// \brief Fill a discovery message.
+      /// \param[in] _type Message type.
+      /// \param[in] _pub Publishers's information to send.
+      /// \param[out] _msg The message.
+      /// \return False if the message type is unknown.
+      private: template<typename T>
+      bool FillMsg(const msgs::Discovery::Type _type,
+                   const T &_pub,
+                   msgs::Discovery &_msg) const
+      {
+        _msg.set_version(this->Version());
+        _msg.set_type(_type);
+        _msg.set_process_uuid(this->pUuid);
 
         switch (_type)
         {
@@ -1099,131 +1569,154 @@ namespace ignition
           case msgs::Discovery::NEW_CONNECTION:
           case msgs::Discovery::END_CONNECTION:
           {
-            _pub.FillDiscovery(discoveryMsg);
+            _pub.FillDiscovery(_msg);
             break;
           }
           case msgs::Discovery::SUBSCRIBE:
           {
-            discoveryMsg.mutable_sub()->set_topic(_pub.Topic());
+            _msg.mutable_sub()->set_topic(_pub.Topic());
+
+            // Without topic, it asks the process _pub.PUuid() for all its
+            // topics.
+            if (_pub.Topic().empty())
+            {
+              msgs::Header::Map *data = _msg.mutable_header()->add_data();
+              data->set_key(kSyncKey);
+              data->add_value(_pub.PUuid());
+            }
             break;
           }
           case msgs::Discovery::HEARTBEAT:
+          {
+            std::pair<uint64_t, uint64_t> digest;
+            {
+              std::lock_guard<std::mutex> lock(this->mutex);
+              digest = this->Digest(this->pUuid);
+            }
+            msgs::Header::Map *data = _msg.mutable_header()->add_data();
+            data->set_key(kDigestKey);
+            data->add_value(std::to_string(digest.first));
+            data->add_value(std::to_string(digest.second));
+            break;
+          }
           case msgs::Discovery::BYE:
             break;
           default:
             std::cerr << "Discovery::SendMsg() error: Unrecognized message"
                       << " type [" << _type << "]" << std::endl;
-            return;
+            return false;
         }
 
-        if (_destType == DestinationType::MULTICAST ||
-            _destType == DestinationType::ALL)
-        {
-          this->SendMulticast(discoveryMsg);
-        }
+        return true;
+      }
 
-        // Send the discovery message to the unicast relays.
-        if (_destType == DestinationType::UNICAST ||
-            _destType == DestinationType::ALL)
+      /// \brief Pack discovery messages into datagrams. Each message is
+      /// preceded by its size, and a datagram takes messages until the next
+      /// one would exceed DatagramSize().
+      /// \param[in] _msgs Discovery messages.
+      /// \return The datagrams.
+      private: std::vector<std::string> Pack(
+        const std::vector<msgs::Discovery> &_msgs) const
+      {
+        uint16_t maxSize;
         {
-          // Set the RELAY flag in the header.
-          discoveryMsg.mutable_flags()->set_relay(true);
-          this->SendUnicast(discoveryMsg);
+          std::lock_guard<std::mutex> lock(this->mutex);
+          maxSize = this->datagramSize;
         }
 
-        if (this->verbose)
+        std::vector<std::string> datagrams;
+        std::string datagram;
+        for (const auto &msg : _msgs)
         {
-          std::cout << "\t* Sending " << msgs::ToString(_type)
-                    << " msg [" << _pub.Topic() << "]" << std::endl;
-        }
-      }
-
-      /// \brief Send a discovery message through all unicast relays.
-      /// \param[in] _msg Discovery message.
-      private: void SendUnicast(const msgs::Discovery &_msg) const
-      {
-        uint16_t msgSize;
+          uint16_t msgSize;
 
 #if GOOGLE_PROTOBUF_VERSION >= 3004000
-        size_t msgSizeFull = _msg.ByteSizeLong();
+          size_t msgSizeFull = msg.ByteSizeLong();
 #else
-        int msgSizeFull = _msg.ByteSize();
+          int msgSizeFull = msg.ByteSize();
 #endif
-        if (msgSizeFull + sizeof(msgSize) > this->kMaxRcvStr)
-        {
-          std::cerr << "Discovery message too large to send. Discovery won't "
-            << "work. This shouldn't happen.\n";
-          return;
+          if (msgSizeFull + sizeof(msgSize) > this->kMaxRcvStr)
+          {
+            std::cerr << "Discovery message too large to send. Discovery "
+              << "won't work. This shouldn't happen.\n";
+            continue;
+          }
+          msgSize = static_cast<uint16_t>(msgSizeFull);
+
+          const std::size_t frameSize = sizeof(msgSize) + msgSize;
+          if (!datagram.empty() &&
+              (datagram.size() + frameSize > maxSize ||
+               datagram.size() + frameSize > this->kMaxRcvStr))
+          {
+            datagrams.push_back(std::move(datagram));
+            datagram.clear();
+          }
+
+          const std::size_t offset = datagram.size();
+          datagram.resize(offset + frameSize);
+          memcpy(&datagram[offset], &msgSize, sizeof(msgSize));
+          if (!msg.SerializeToArray(&datagram[offset + sizeof(msgSize)],
+                msgSize))
+          {
+            std::cerr << "Discovery::Pack: Error serializing data."
+              << std::endl;
+            datagram.resize(offset);
+          }
         }
-        msgSize = msgSizeFull;
 
-        uint16_t totalSize = sizeof(msgSize) + msgSize;
-        char *buffer = static_cast<char *>(new char[totalSize]);
-        memcpy(&buffer[0], &msgSize, sizeof(msgSize));
+        if (!datagram.empty())
+          datagrams.push_back(std::move(datagram));
+
+        return datagrams;
+      }
 
-        if (_msg.SerializeToArray(buffer + sizeof(msgSize), msgSize))
+      /// \brief Send discovery messages to unicast addresses, e.g. the
+      /// relays.
+      /// \param[in] _msgs Discovery messages.
+      /// \param[in] _addrs Destination addresses.
+      private: void SendUnicast(const std::vector<msgs::Discovery> &_msgs,
+                                const std::vector<sockaddr_in> &_addrs) const
+      {
+        for (const std::string &datagram : this->Pack(_msgs))
         {
-          // Send the discovery message to the unicast relays.
-          for (const auto &sockAddr : this->relayAddrs)
+          // Send the discovery messages to the unicast addresses.
+          for (const auto &sockAddr : _addrs)
           {
             auto sent = sendto(this->sockets.at(0),
               reinterpret_cast<const raw_type *>(
-                reinterpret_cast<const unsigned char*>(buffer)),
-              totalSize, 0,
+                reinterpret_cast<const unsigned char*>(datagram.data())),
+              datagram.size(), 0,
               reinterpret_cast<const sockaddr *>(&sockAddr),
               sizeof(sockAddr));
 
-            if (sent != totalSize)
+            if (sent != static_cast<decltype(sent)>(datagram.size()))
             {
               std::cerr << "Exception sending a unicast message" << std::endl;
               break;
             }
           }
         }
-        else
-        {
-          std::cerr << "Discovery::SendUnicast: Error serializing data."
-            << std::endl;
-        }
-
-        delete [] buffer;
       }
 
-      /// \brief Send a discovery message through the multicast group.
-      /// \param[in] _msg Discovery message.
-      private: void SendMulticast(const msgs::Discovery &_msg) const
+      /// \brief Send discovery messages through the multicast group.
+      /// \param[in] _msgs Discovery messages.
+      private: void SendMulticast(
+        const std::vector<msgs::Discovery> &_msgs) const
       {
-        uint16_t msgSize;
-
-#if GOOGLE_PROTOBUF_VERSION >= 3004000
-        size_t msgSizeFull = _msg.ByteSizeLong();
-#else
-        int msgSizeFull = _msg.ByteSize();
-#endif
-        if (msgSizeFull + sizeof(msgSize) > this->kMaxRcvStr)
+        for (const std::string &datagram : this->Pack(_msgs))
         {
-          std::cerr << "Discovery message too large to send. Discovery won't "
-            << "work. This shouldn't happen.\n";
-          return;
-        }
-
-        msgSize = msgSizeFull;
-        uint16_t totalSize = sizeof(msgSize) + msgSize;
-        char *buffer = static_cast<char *>(new char[totalSize]);
-        memcpy(&buffer[0], &msgSize, sizeof(msgSize));
-
-        if (_msg.SerializeToArray(buffer + sizeof(msgSize), msgSize))
-        {
-          // Send the discovery message to the multicast group through all the
-          // sockets.
+          // Send the discovery messages to the multicast group through all
+          // the sockets.
           for (const auto &sock : this->Sockets())
           {
             errno = 0;
-            if (sendto(sock, reinterpret_cast<const raw_type *>(
-              reinterpret_cast<const unsigned char*>(buffer)),
-              totalSize, 0,
+            auto sent = sendto(sock, reinterpret_cast<const raw_type *>(
+              reinterpret_cast<const unsigned char*>(datagram.data())),
+              datagram.size(), 0,
               reinterpret_cast<const sockaddr *>(this->MulticastAddr()),
-              sizeof(*(this->MulticastAddr()))) != totalSize)
+              sizeof(*(this->MulticastAddr())));
+
+            if (sent != static_cast<decltype(sent)>(datagram.size()))
             {
               // Ignore EPERM and ENOBUFS errors.
               //
@@ -1242,13 +1735,220 @@ namespace ignition
             }
           }
         }
-        else
+      }
+
+      /// \brief Forward a message that a discovery server received from a
+      /// client to the other clients that need it:
+      ///   - ADVERTISE and UNADVERTISE to the clients interested in the topic.
+      ///   - SUBSCRIBE isn't forwarded. The server registers the interest of
+      ///     the client in the topic and answers with the publishers that it
+      ///     knows.
+      ///   - HEARTBEAT and BYE to the clients interested in any topic of the
+      ///     sender, and to the publishers of the topics that the sender
+      ///     asked for or connected to. Otherwise, they would expire it.
+      ///   - NEW_CONNECTION and END_CONNECTION to the publishers of the topic.
+      /// The topics with host scope only reach the clients with the same IP
+      /// address as the publisher.
+      /// \param[in] _from Address and port of the client.
+      /// \param[in] _msg The message.
+      private: void Route(const sockaddr_in &_from, msgs::Discovery _msg)
+      {
+        const std::string origin = _msg.process_uuid();
+        _msg.clear_flags();
+
+        std::map<std::string, std::vector<msgs::Discovery>> outgoing;
         {
-          std::cerr << "Discovery::SendMulticast: Error serializing data."
-            << std::endl;
+          std::lock_guard<std::mutex> lock(this->mutex);
+
+          Client &client = this->clients[origin];
+          client.addr = _from;
+
+          switch (_msg.type())
+          {
+            case msgs::Discovery::ADVERTISE:
+            case msgs::Discovery::UNADVERTISE:
+            {
+              Pub pub;
+              pub.SetFromDiscovery(_msg);
+              if (pub.Options().Scope() == Scope_t::PROCESS)
+                break;
+
+              for (const auto &other : this->clients)
+              {
+                if (other.first != origin &&
+                    other.second.topics.count(pub.Topic()) > 0 &&
+                    Reaches(pub, client, other.second))
+                {
+                  outgoing[other.first].push_back(_msg);
+                }
+              }
+              break;
+            }
+            case msgs::Discovery::SUBSCRIBE:
+            {
+              const std::string &topic = _msg.sub().topic();
+              if (topic.empty())
+                break;
+
+              client.topics.insert(topic);
+
+              Addresses_M<Pub> addresses;
+              if (!this->info.Publishers(topic, addresses))
+                break;
+
+              for (const auto &proc : addresses)
+              {
+                auto publisher = this->clients.find(proc.first);
+                if (proc.first == origin || publisher == this->clients.end())
+                  continue;
+
+                for (const auto &pub : proc.second)
+                {
+                  if (Reaches(pub, publisher->second, client))
+                  {
+                    outgoing[origin].push_back(
+                      this->ForwardedMsg(msgs::Discovery::ADVERTISE, pub));
+                  }
+                }
+              }
+              break;
+            }
+            case msgs::Discovery::HEARTBEAT:
+            case msgs::Discovery::BYE:
+            {
+              std::set<std::string> recipients;
+
+              // The clients interested in the topics of the sender.
+              std::map<std::string, std::vector<Pub>> nodes;
+              this->info.PublishersByProc(origin, nodes);
+              for (const auto &other : this->clients)
+              {
+                if (other.first == origin)
+                  continue;
+
+                for (const auto &topic : nodes)
+                {
+                  if (other.second.topics.count(topic.first) > 0)
+                  {
+                    recipients.insert(other.first);
+                    break;
+                  }
+                }
+              }
+
+              // The publishers of the topics that the sender uses.
+              std::set<std::string> topics = client.topics;
+              topics.insert(client.connections.begin(),
+                client.connections.end());
+              for (const auto &topic : topics)
+              {
+                Addresses_M<Pub> addresses;
+                this->info.Publishers(topic, addresses);
+                for (const auto &proc : addresses)
+                {
+                  if (proc.first != origin &&
+                      this->clients.count(proc.first) > 0)
+                  {
+                    recipients.insert(proc.first);
+                  }
+                }
+              }
+
+              for (const auto &recipient : recipients)
+                outgoing[recipient].push_back(_msg);
+
+              if (_msg.type() == msgs::Discovery::BYE)
+                this->clients.erase(origin);
+              break;
+            }
+            case msgs::Discovery::NEW_CONNECTION:
+            case msgs::Discovery::END_CONNECTION:
+            {
+              Pub pub;
+              pub.SetFromDiscovery(_msg);
+              if (_msg.type() == msgs::Discovery::NEW_CONNECTION)
+                client.connections.insert(pub.Topic());
+
+              Addresses_M<Pub> addresses;
+              this->info.Publishers(pub.Topic(), addresses);
+              for (const auto &proc : addresses)
+              {
+                if (proc.first != origin && this->clients.count(proc.first) > 0)
+                  outgoing[proc.first].push_back(_msg);
+              }
+              break;
+            }
+            default:
+              break;
+          }
         }
 
-        delete [] buffer;
+        this->SendToClients(outgoing);
+      }
+
+      /// \brief Send discovery messages to the clients of this server.
+      /// \param[in] _msgs The messages for each client, by process UUID.
+      private: void SendToClients(
+        const std::map<std::string, std::vector<msgs::Discovery>> &_msgs) const
+      {
+        for (const auto &entry : _msgs)
+        {
+          sockaddr_in addr;
+          {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            auto it = this->clients.find(entry.first);
+            if (it == this->clients.end())
+              continue;
+            addr = it->second.addr;
+          }
+
+          this->SendUnicast(entry.second, {addr});
+        }
+      }
+
+      /// \brief Build the message that a server sends on behalf of the
+      /// process of a publisher.
+      /// \param[in] _type Message type.
+      /// \param[in] _pub The publisher.
+      /// \return The message.
+      private: msgs::Discovery ForwardedMsg(const msgs::Discovery::Type _type,
+                                            const Pub &_pub) const
+      {
+        msgs::Discovery msg;
+        msg.set_version(this->Version());
+        msg.set_type(_type);
+        msg.set_process_uuid(_pub.PUuid());
+        _pub.FillDiscovery(msg);
+        return msg;
+      }
+
+      /// \brief Whether this process is interested in a topic. It must be
+      /// called with the mutex locked.
+      /// \param[in] _topic Topic name.
+      /// \return True if the discovery doesn't filter by interest, or the
+      /// topic was declared with AddInterest() or starts with a prefix
+      /// declared with AddInterestPrefix().
+      private: bool Interested(const std::string &_topic) const
+      {
+        if (!this->filterByInterest ||
+            this->interests.find(_topic) != this->interests.end())
+        {
+          return true;
+        }
+
+        for (const auto &prefix : this->interestPrefixes)
+        {
+          if (_topic.compare(0, prefix.size(), prefix) == 0)
+            return true;
+        }
+        return false;
+      }
+
+      /// \brief Whether this discovery uses multicast.
+      /// \return False for the discovery servers and their clients.
+      private: bool Multicast() const
+      {
+        return !this->server && this->servers.empty();
       }
 
       /// \brief Get the list of sockets used for discovery.
@@ -1265,14 +1965,13 @@ namespace ignition
         return &this->mcastAddr;
       }
 
-      /// \brief Get the discovery protocol version.
+      /// \brief Get the discovery protocol version. Processes with and
+      /// without topic statistics talk to each other, the statistics are
+      /// flagged in the header of every message.
       /// \return The discovery version.
       private: uint8_t Version() const
       {
-        static std::string ignStats;
-        static int topicStats =
-          (env("IGN_TRANSPORT_TOPIC_STATISTICS", ignStats) && ignStats == "1");
-        return this->kWireVersion + (topicStats * 100);
+        return this->kWireVersion;
       }
 
       /// \brief Register a new network interface in the discovery system.
@@ -1304,6 +2003,9 @@ namespace ignition
 
         this->sockets.push_back(sock);
 
+        if (!this->Multicast())
+          return true;
+
         // Join the multicast group. We have to do it for each network interface
         // but we can do it on the same socket. We will use the socket at
         // position 0 for receiving multicast information.
@@ -1357,6 +2059,12 @@ namespace ignition
       /// \sa SetMaxSilenceInterval.
       private: static const unsigned int kDefSilenceInterval = 3000;
 
+      /// \brief Default maximum datagram size (bytes). It fits in an
+      /// Ethernet frame (MTU of 1500 bytes) with the IP and UDP headers.
+      /// \sa DatagramSize.
+      /// \sa SetDatagramSize.
+      private: static const uint16_t kDefDatagramSize = 1472;
+
       /// \brief IP Address used for multicast.
       private: const std::string kMulticastGroup = "224.0.0.7";
 
@@ -1369,7 +2077,42 @@ namespace ignition
 
       /// \brief Wire protocol version. Bump up the version number if you modify
       /// the wire protocol (for discovery or message/service exchange).
-      private: static const uint8_t kWireVersion = 10;
+      private: static const uint8_t kWireVersion = 13;
+
+      /// \brief Key of the heartbeat header entry that stores the digests of
+      /// the topics of the sender, see Digest().
+      private: inline static const std::string kDigestKey = "digest";
+
+      /// \brief Key of the header entry of a SUBSCRIBE message without topic
+      /// that stores the UUID of the process asked for all its topics.
+      private: inline static const std::string kSyncKey = "sync";
+
+      /// \brief A client of a discovery server.
+      private: struct Client
+      {
+        /// \brief Address and port of the client.
+        public: sockaddr_in addr;
+
+        /// \brief Topics that the client asked for.
+        public: std::set<std::string> topics;
+
+        /// \brief Topics that the client registered a connection for. They
+        /// are kept until the client leaves.
+        public: std::set<std::string> connections;
+      };
+
+      /// \brief Whether a client can learn about a publisher with host scope.
+      /// \param[in] _pub The publisher.
+      /// \param[in] _publisher Client that advertised the publisher.
+      /// \param[in] _subscriber Client that wants to learn about it.
+      /// \return True if the topic doesn't have host scope or both clients
+      /// have the same IP address.
+      private: static bool Reaches(const Pub &_pub, const Client &_publisher,
+                                   const Client &_subscriber)
+      {
+        return _pub.Options().Scope() != Scope_t::HOST ||
+          _publisher.addr.sin_addr.s_addr == _subscriber.addr.sin_addr.s_addr;
+      }
 
       /// \brief Port used to broadcast the discovery messages.
       private: int port;
@@ -1398,6 +2141,11 @@ namespace ignition
       /// \sa SetHeartbeatInterval.
       private: unsigned int heartbeatInterval;
 
+      /// \brief Maximum datagram size (bytes).
+      /// \sa DatagramSize.
+      /// \sa SetDatagramSize.
+      private: uint16_t datagramSize;
+
       /// \brief Callback executed when new topics are discovered.
       private: DiscoveryCallback<Pub> connectionCb;
 
@@ -1424,6 +2172,29 @@ namespace ignition
       /// \brief Print discovery information to stdout.
       private: bool verbose;
 
+      /// \brief True if this discovery is a discovery server.
+      private: bool server;
+
+      /// \brief Addresses of the discovery servers of this process, from
+      /// IGN_DISCOVERY_SERVER. If there are servers, the discovery doesn't
+      /// use multicast.
+      private: std::vector<sockaddr_in> servers;
+
+      /// \brief Clients of this discovery server, by process UUID.
+      private: std::map<std::string, Client> clients;
+
+      /// \brief True if the topics without interest are dropped.
+      /// \sa SetFilterByInterest.
+      private: bool filterByInterest = false;
+
+      /// \brief Topics that this process is interested in.
+      /// \sa AddInterest.
+      private: std::set<std::string> interests;
+
+      /// \brief Prefixes of the topics that this process is interested in.
+      /// \sa AddInterestPrefix.
+      private: std::set<std::string> interestPrefixes;
+
       /// \brief UDP socket used for sending/receiving discovery messages.
       private: std::vector<int> sockets;
 
@@ -1445,18 +2216,48 @@ namespace ignition
       /// \brief Time at which the next activity check will be done.
       private: Timestamp timeNextActivity;
 
+      /// \brief A request for all the topics of a peer.
+      private: struct PeerSync
+      {
+        /// \brief Time of the request.
+        public: Timestamp requested;
+
+        /// \brief Publishers advertised since the request, see SyncKey().
+        public: std::set<std::string> seen;
+      };
+
+      /// \brief Our requests for all the topics of a peer whose digest
+      /// didn't match. The key is the process UUID of the peer.
+      private: std::map<std::string, PeerSync> peerSyncs;
+
+      /// \brief True when a peer asked for all our topics.
+      private: bool syncRequested = false;
+
+      /// \brief Time at which we advertised all our topics for the last
+      /// time.
+      private: Timestamp timeLastSync;
+
       /// \brief Mutex to guarantee exclusive access to the exit variable.
       private: std::mutex exitMutex;
 
-      /// \brief Once the discovery starts, it can take up to
-      /// HeartbeatInterval milliseconds to discover the existing nodes on the
-      /// network. This variable is 'false' during the first HeartbeatInterval
-      /// period and is set to 'true' after that.
+      /// \brief Once the discovery starts, it asks the peers for their
+      /// topics. This variable is 'false' until the answers stop arriving,
+      /// see UpdateInit().
       private: bool initialized;
 
       /// \brief Number of heartbeats sent while discovery is uninitialized.
       private: unsigned int numHeartbeatsUninitialized;
 
+      /// \brief Time at which Start() asked the peers for their topics.
+      private: Timestamp timeBootstrap;
+
+      /// \brief Time at which the last ADVERTISE message was received while
+      /// the discovery is uninitialized.
+      private: Timestamp timeLastAnswer;
+
+      /// \brief Time that the first answer to the query sent by Start() took.
+      private: Timestamp::duration answerDelay{0};
+
       /// \brief Used to block/unblock until the initialization phase finishes.
       private: mutable std::condition_variable initializedCv;
 
@@ -18,9 +18,11 @@
 #ifndef IGN_TRANSPORT_HANDLERSTORAGE_HH_
 #define IGN_TRANSPORT_HANDLERSTORAGE_HH_
 
+#include <atomic>
 #include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <utility>
 
 #include "ignition/transport/config.hh"
@@ -36,6 +38,11 @@ namespace ignition
     /// \class HandlerStorage HandlerStorage.hh
     /// ignition/transport/HandlerStorage.hh
     /// \brief Class to store and manage service call handlers.
+    ///
+    /// Topics are stored in a hash table. The handlers of each topic are
+    /// shared with the views returned by Handlers(const std::string &) and
+    /// only copied when they are modified while a view is in use, so reading
+    /// them doesn't copy anything.
     template<typename T> class HandlerStorage
     {
       /// \brief Stores all the service call data for each topic. The key of
@@ -46,8 +53,15 @@ namespace ignition
       using UUIDHandler_Collection_M = std::map<std::string, UUIDHandler_M>;
 
       /// \brief key is a topic name and value is UUIDHandler_M
-      using TopicServiceCalls_M =
-        std::map<std::string, UUIDHandler_Collection_M>;
+      using TopicServiceCalls_M = std::unordered_map<std::string,
+        std::shared_ptr<UUIDHandler_Collection_M>>;
+
+      /// \brief Read-only view of the handlers of a topic. The key is the
+      /// node UUID and the value is another map, where the key is the handler
+      /// UUID. The view doesn't change when handlers are added or removed
+      /// later.
+      public: using HandlersView =
+        std::shared_ptr<const UUIDHandler_Collection_M>;
 
       /// \brief Constructor.
       public: HandlerStorage() = default;
@@ -67,13 +81,26 @@ namespace ignition
         std::map<std::string,
           std::map<std::string, std::shared_ptr<T> >> &_handlers) const
       {
-        if (this->data.find(_topic) == this->data.end())
+        auto it = this->data.find(_topic);
+        if (it == this->data.end())
           return false;
 
-        _handlers = this->data.at(_topic);
+        _handlers = *it->second;
         return true;
       }
 
+      /// \brief Get a view of the handlers for a topic without copying them.
+      /// \param[in] _topic Topic name.
+      /// \return The handlers or nullptr if the topic doesn't have any.
+      public: HandlersView Handlers(const std::string &_topic) const
+      {
+        auto it = this->data.find(_topic);
+        if (it == this->data.end())
+          return nullptr;
+
+        return it->second;
+      }
+
       /// \brief Get the first handler for a topic that matches a specific pair
       /// of request/response types.
       /// \param[in] _topic Topic name.
@@ -86,11 +113,11 @@ namespace ignition
                                 const std::string &_repTypeName,
                                 std::shared_ptr<T> &_handler) const
       {
-        if (this->data.find(_topic) == this->data.end())
+        auto it = this->data.find(_topic);
+        if (it == this->data.end())
           return false;
 
-        const auto &m = this->data.at(_topic);
-        for (const auto &node : m)
+        for (const auto &node : *it->second)
         {
           for (const auto &handler : node.second)
           {
@@ -115,11 +142,11 @@ namespace ignition
                                 const std::string &_msgTypeName,
                                 std::shared_ptr<T> &_handler) const
       {
-        if (this->data.find(_topic) == this->data.end())
+        auto it = this->data.find(_topic);
+        if (it == this->data.end())
           return false;
 
-        const auto &m = this->data.at(_topic);
-        for (const auto &node : m)
+        for (const auto &node : *it->second)
         {
           for (const auto &handler : node.second)
           {
@@ -145,17 +172,20 @@ namespace ignition
                            const std::string &_hUuid,
                            std::shared_ptr<T> &_handler) const
       {
-        if (this->data.find(_topic) == this->data.end())
+        auto it = this->data.find(_topic);
+        if (it == this->data.end())
           return false;
 
-        auto const &m = this->data.at(_topic);
-        if (m.find(_nUuid) == m.end())
+        auto const &m = *it->second;
+        auto node = m.find(_nUuid);
+        if (node == m.end())
           return false;
 
-        if (m.at(_nUuid).find(_hUuid) == m.at(_nUuid).end())
+        auto handler = node->second.find(_hUuid);
+        if (handler == node->second.end())
           return false;
 
-        _handler = m.at(_nUuid).at(_hUuid);
+        _handler = handler->second;
         return true;
       }
 
@@ -168,16 +198,9 @@ namespace ignition
                               const std::string &_nUuid,
                               const std::shared_ptr<T> &_handler)
       {
-        // Create the topic entry.
-        if (this->data.find(_topic) == this->data.end())
-          this->data[_topic] = UUIDHandler_Collection_M();
-
-        // Create the Node UUID entry.
-        if (this->data[_topic].find(_nUuid) == this->data[_topic].end())
-          this->data[_topic][_nUuid] = UUIDHandler_M();
-
-        // Add/Replace the Req handler.
-        this->data[_topic][_nUuid].insert(
+        // Create the topic and the Node UUID entries if needed and
+        // add/replace the Req handler.
+        this->Modify(this->data[_topic])[_nUuid].insert(
           std::make_pair(_handler->HandlerUuid(), _handler));
       }
 
@@ -187,10 +210,11 @@ namespace ignition
       /// \return true if we have stored at least one request for the topic.
       public: bool HasHandlersForTopic(const std::string &_topic) const
       {
-        if (this->data.find(_topic) == this->data.end())
+        auto it = this->data.find(_topic);
+        if (it == this->data.end())
           return false;
 
-        return !this->data.at(_topic).empty();
+        return !it->second->empty();
       }
 
       /// \brief Check if a node has at least one handler.
@@ -200,11 +224,11 @@ namespace ignition
       public: bool HasHandlersForNode(const std::string &_topic,
                                       const std::string &_nUuid) const
       {
-        if (this->data.find(_topic) == this->data.end())
+        auto it = this->data.find(_topic);
+        if (it == this->data.end())
           return false;
 
-        return this->data.at(_topic).find(_nUuid) !=
-               this->data.at(_topic).end();
+        return it->second->find(_nUuid) != it->second->end();
       }
 
       /// \brief Remove a request handler. The node's uuid is used as a key to
@@ -217,20 +241,26 @@ namespace ignition
                                  const std::string &_nUuid,
                                  const std::string &_reqUuid)
       {
-        size_t counter = 0;
-        if (this->data.find(_topic) != this->data.end())
+        auto it = this->data.find(_topic);
+        if (it == this->data.end())
+          return false;
+
+        auto node = it->second->find(_nUuid);
+        if (node == it->second->end() ||
+            node->second.find(_reqUuid) == node->second.end())
         {
-          if (this->data[_topic].find(_nUuid) != this->data[_topic].end())
-          {
-            counter = this->data[_topic][_nUuid].erase(_reqUuid);
-            if (this->data[_topic][_nUuid].empty())
-              this->data[_topic].erase(_nUuid);
-            if (this->data[_topic].empty())
-              this->data.erase(_topic);
-          }
+          return false;
         }
 
-        return counter > 0;
+        auto &m = this->Modify(it->second);
+        node = m.find(_nUuid);
+        node->second.erase(_reqUuid);
+        if (node->second.empty())
+          m.erase(node);
+        if (m.empty())
+          this->data.erase(it);
+
+        return true;
       }
 
       /// \brief Remove all the handlers from a given node.
@@ -240,15 +270,45 @@ namespace ignition
       public: bool RemoveHandlersForNode(const std::string &_topic,
                                          const std::string &_nUuid)
       {
-        size_t counter = 0;
-        if (this->data.find(_topic) != this->data.end())
+        auto it = this->data.find(_topic);
+        if (it == this->data.end() ||
+            it->second->find(_nUuid) == it->second->end())
         {
-          counter = this->data[_topic].erase(_nUuid);
-          if (this->data[_topic].empty())
-            this->data.erase(_topic);
+          return false;
         }
 
-        return counter > 0;
+        auto &m = this->Modify(it->second);
+        m.erase(_nUuid);
+        if (m.empty())
+          this->data.erase(it);
+
+        return true;
+      }
+
+      /// \brief Get the handlers of a topic ready to be modified. They are
+      /// copied first if a view of them is in use.
+      /// \param[in, out] _handlers The handlers of the topic. Created if null.
+      /// \return The handlers.
+      private: UUIDHandler_Collection_M &Modify(
+        std::shared_ptr<UUIDHandler_Collection_M> &_handlers)
+      {
+        if (!_handlers)
+        {
+          _handlers = std::make_shared<UUIDHandler_Collection_M>();
+        }
+        else if (_handlers.use_count() > 1)
+        {
+          _handlers = std::make_shared<UUIDHandler_Collection_M>(*_handlers);
+        }
+        else
+        {
+          // New views are only created by Handlers(), which the caller
+          // serializes with the modifications, so the count can't grow
+          // behind our back. Synchronize with the threads that dropped their
+          // views, so they are done reading before we modify.
+          std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        return *_handlers;
       }
 
       /// \brief Stores all the service call data for each topic. The key of
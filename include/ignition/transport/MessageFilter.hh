@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef IGN_TRANSPORT_MESSAGEFILTER_HH_
+#define IGN_TRANSPORT_MESSAGEFILTER_HH_
+
+#include <memory>
+#include <string>
+
+#include "ignition/transport/config.hh"
+#include "ignition/transport/Export.hh"
+#include "ignition/transport/TransportTypes.hh"
+
+namespace ignition
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace IGNITION_TRANSPORT_VERSION_NAMESPACE {
+    //
+    class MessageFilterPrivate;
+
+    /// \class MessageFilter MessageFilter.hh
+    /// ignition/transport/MessageFilter.hh
+    /// \brief A set of conditions on the fields of a message. A message
+    /// matches the filter when it satisfies all of them.
+    ///
+    /// A subscription with a filter (see SubscribeOptions::SetFilter())
+    /// declares it to the publishers of other processes, which only send the
+    /// matching messages. E.g.:
+    ///
+    ///   MessageFilter filter;
+    ///   filter.AddCondition("header.stamp.sec", MessageFilter::Op::GREATER,
+    ///     "100");
+    ///   filter.AddCondition("pixel_format_type", MessageFilter::Op::EQUAL,
+    ///     "RGB_INT8");
+    class IGNITION_TRANSPORT_VISIBLE MessageFilter
+    {
+      /// \brief Comparison between a field and a value.
+      public: enum class Op
+      {
+        /// \brief The field is equal to the value.
+        EQUAL,
+        /// \brief The field is different from the value.
+        NOT_EQUAL,
+        /// \brief The field is lower than the value.
+        LESS,
+        /// \brief The field is lower than or equal to the value.
+        LESS_EQUAL,
+        /// \brief The field is greater than the value.
+        GREATER,
+        /// \brief The field is greater than or equal to the value.
+        GREATER_EQUAL
+      };
+
+      /// \brief Constructor. The filter doesn't have conditions.
+      public: MessageFilter();
+
+      /// \brief Copy constructor.
+      /// \param[in] _other MessageFilter to copy.
+      public: MessageFilter(const MessageFilter &_other);
+
+      /// \brief Destructor.
+      public: ~MessageFilter();
+
+      /// \brief Assignment operator.
+      /// \param[in] _other The other MessageFilter.
+      /// \return Reference to this MessageFilter.
+      public: MessageFilter &operator=(const MessageFilter &_other);
+
+      /// \brief Equality operator.
+      /// \param[in] _other The other MessageFilter.
+      /// \return True if both filters have the same conditions.
+      public: bool operator==(const MessageFilter &_other) const;
+
+      /// \brief Inequality operator.
+      /// \param[in] _other The other MessageFilter.
+      /// \return True if the filters have different conditions.
+      public: bool operator!=(const MessageFilter &_other) const;
+
+      /// \brief Add a condition.
+      /// \param[in] _field Name of a singular field of the message. The
+      /// fields of nested messages are separated by dots, e.g.
+      /// "header.stamp.sec".
+      /// \param[in] _op The comparison.
+      /// \param[in] _value The value to compare with. It's converted to the
+      /// type of the field: a number, "true" or "false" for booleans, or the
+      /// name or the number of an enum value. Strings are compared
+      /// lexicographically.
+      /// \return False if the field name is empty or the field name or the
+      /// value contain ASCII control characters.
+      public: bool AddCondition(const std::string &_field, const Op _op,
+                                const std::string &_value);
+
+      /// \brief Whether the filter has conditions.
+      /// \return True if every message matches the filter.
+      public: bool Empty() const;
+
+      /// \brief Check a message. A condition on a field that doesn't exist,
+      /// that is repeated or whose value can't be converted to the type of
+      /// the field is never satisfied.
+      /// \param[in] _msg The message.
+      /// \return True if the message satisfies all the conditions.
+      public: bool Matches(const ProtoMsg &_msg) const;
+
+      /// \brief Serialize the conditions. Filters with the same conditions
+      /// produce the same string.
+      /// \return The serialized filter, empty if there are no conditions.
+      public: std::string Serialize() const;
+
+      /// \brief Replace the conditions with serialized ones.
+      /// \param[in] _data String produced by Serialize().
+      /// \return False if the string is invalid, in which case the filter
+      /// is left empty.
+      public: bool Deserialize(const std::string &_data);
+
+#ifdef _WIN32
+// Disable warning C4251 which is triggered by
+// std::unique_ptr
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif
+      /// \internal
+      /// \brief Pointer to private data.
+      private: std::unique_ptr<MessageFilterPrivate> dataPtr;
+#ifdef _WIN32
+#pragma warning(pop)
+#endif
+    };
+    }
+  }
+}
+#endif
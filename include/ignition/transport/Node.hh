@@ -43,6 +43,7 @@
 #include "ignition/transport/Publisher.hh"
 #include "ignition/transport/RepHandler.hh"
 #include "ignition/transport/ReqHandler.hh"
+#include "ignition/transport/RequestFuture.hh"
 #include "ignition/transport/SubscribeOptions.hh"
 #include "ignition/transport/SubscriptionHandler.hh"
 #include "ignition/transport/TopicStatistics.hh"
@@ -111,6 +112,10 @@ namespace ignition
       ///      // Note that this version of Publish will copy the message
       ///      // when publishing to interprocess subscribers.
       ///      pub.Publish(msg);
+      ///
+      ///      // This version hands the message over, so subscribers within
+      ///      // the same process receive it without a copy.
+      ///      pub.Publish(std::make_unique<MsgType>(msg));
       ///    }
       public: class IGNITION_TRANSPORT_VISIBLE Publisher
       {
@@ -146,6 +151,40 @@ namespace ignition
         /// \return true when success.
         public: bool Publish(const ProtoMsg &_msg);
 
+        /// \brief Publish a message shared with the caller. Subscribers
+        /// within the same process receive this same instance instead of a
+        /// copy, so the message must not be modified after calling this
+        /// function.
+        /// \param[in] _msg A google::protobuf message.
+        /// \return true when success.
+        public: bool Publish(std::shared_ptr<const ProtoMsg> _msg);
+
+        /// \brief Publish a message handing over its ownership. Subscribers
+        /// within the same process receive this same instance instead of a
+        /// copy.
+        /// \param[in] _msg A google::protobuf message.
+        /// \return true when success.
+        public: template<typename MessageT>
+        bool Publish(std::unique_ptr<MessageT> _msg);
+
+        /// \brief Publish several messages at once. Subscribers are looked
+        /// up once for the whole batch, subscribers within the same process
+        /// receive the messages in a single step and the messages for remote
+        /// subscribers are sent in a burst. The messages are copied as in
+        /// Publish(const ProtoMsg &). For throttled publishers, the whole
+        /// batch counts as a single publication.
+        /// \param[in] _msgs The messages, in publication order. All of them
+        /// must be of the advertised type, otherwise none is published.
+        /// \return true when success.
+        public: bool PublishBatch(const std::vector<const ProtoMsg *> &_msgs);
+
+        /// \brief Publish several messages at once.
+        /// \param[in] _msgs The messages, in publication order.
+        /// \return true when success.
+        /// \sa PublishBatch(const std::vector<const ProtoMsg *> &)
+        public: template<typename MessageT>
+        bool PublishBatch(const std::vector<MessageT> &_msgs);
+
         /// \brief Publish a raw pre-serialized message.
         ///
         /// \warning This function is only intended for advanced users. The
@@ -171,6 +210,34 @@ namespace ignition
           const std::string &_msgData,
           const std::string &_msgType);
 
+        /// \brief Publish a raw pre-serialized message stored in a caller
+        /// provided buffer.
+        ///
+        /// \warning This function is only intended for advanced users. See
+        /// PublishRaw(const std::string &, const std::string &).
+        ///
+        /// The buffer is sent to remote subscribers without copying it, so it
+        /// must remain valid and unmodified until _onDone is called. Use
+        /// _onDone to reuse the buffer or to free it if its ownership was
+        /// handed over. _onDone is always called exactly once, either before
+        /// this function returns or later from a ZeroMQ thread, once the
+        /// message has been sent.
+        ///
+        /// \param[in] _msgData Pointer to the serialized google::protobuf
+        /// message.
+        /// \param[in] _msgSize Size of the serialized message (bytes).
+        /// \param[in] _msgType A std::string that contains the message type
+        /// name.
+        /// \param[in] _onDone Function called when the buffer isn't needed
+        /// anymore. If empty, the data is copied when needed and the buffer
+        /// can be reused as soon as this function returns.
+        /// \return true when success.
+        public: bool PublishRaw(
+          const char *_msgData,
+          const std::size_t _msgSize,
+          const std::string &_msgType,
+          std::function<void()> _onDone);
+
         /// \brief Check if message publication is throttled. If so, verify
         /// whether the next message should be published or not.
         ///
@@ -202,6 +269,9 @@ namespace ignition
 #pragma warning(disable: 4251)
 #endif
         private: std::shared_ptr<PublisherPrivate> dataPtr;
+
+        /// \brief Node::PublishBatch() needs access to the publishers.
+        private: friend Node;
 #ifdef _WIN32
 #pragma warning(pop)
 #endif
@@ -247,6 +317,19 @@ namespace ignition
       /// \return A vector containing all the topics advertised by this node.
       public: std::vector<std::string> AdvertisedTopics() const;
 
+      /// \brief Publish the same message on several topics at once. The
+      /// message is serialized and copied only once, subscribers within the
+      /// same process receive it in a single step and the messages for remote
+      /// subscribers are sent in a burst. Throttled publishers skip the
+      /// message if it's too early, as in Publisher::Publish().
+      /// \param[in] _publishers The publishers of the topics. All of them must
+      /// be valid and advertise the type of _msg, otherwise the message isn't
+      /// published at all.
+      /// \param[in] _msg A google::protobuf message.
+      /// \return true when success.
+      public: bool PublishBatch(const std::vector<Publisher> &_publishers,
+                                const ProtoMsg &_msg);
+
       /// \brief Subscribe to a topic registering a callback.
       /// Note that this callback does not include any message information.
       /// In this version the callback is a free function.
@@ -351,7 +434,12 @@ namespace ignition
       /// have an address for a particular topic yet).
       public: std::vector<std::string> SubscribedTopics() const;
 
-      /// \brief Unsubscribe from a topic.
+      /// \brief Unsubscribe from a topic. The messages waiting for the
+      /// callbacks of this node on the topic are discarded. If one of these
+      /// callbacks is running in a worker thread (see
+      /// NodeOptions::SetCallbackThreads() and SubscribeOptions::Queued()),
+      /// this call waits until it returns, unless it's called from that
+      /// callback.
       /// \param[in] _topic Topic name to be unsubscribed.
       /// \return true when successfully unsubscribed or false otherwise.
       public: bool Unsubscribe(const std::string &_topic);
@@ -654,6 +742,66 @@ namespace ignition
           ReplyT &_reply,
           bool &_result);
 
+      /// \brief Request a new service without blocking the caller.
+      /// The returned future can be waited on, cancelled, chained with
+      /// RequestFuture::Then() or awaited from a C++20 coroutine.
+      /// \param[in] _topic Service name requested.
+      /// \param[in] _request Protobuf message containing the request's
+      /// parameters.
+      /// \param[in] _timeout The request completes with
+      /// RequestStatus::TIMED_OUT if the response doesn't arrive within
+      /// '_timeout' ms.
+      /// \return A future for the response. If the request couldn't be sent,
+      /// the future is already completed with RequestStatus::NOT_SENT.
+      public: template<typename ReplyT, typename RequestT>
+      RequestFuture<ReplyT> RequestAsync(
+          const std::string &_topic,
+          const RequestT &_request,
+          const unsigned int _timeout);
+
+      /// \brief Request a new service without blocking the caller and
+      /// without deadline. The request stays pending until the response
+      /// arrives or the future is cancelled.
+      /// \param[in] _topic Service name requested.
+      /// \param[in] _request Protobuf message containing the request's
+      /// parameters.
+      /// \return A future for the response. If the request couldn't be sent,
+      /// the future is already completed with RequestStatus::NOT_SENT.
+      public: template<typename ReplyT, typename RequestT>
+      RequestFuture<ReplyT> RequestAsync(
+          const std::string &_topic,
+          const RequestT &_request);
+
+      /// \brief Request a service from all its responsers at once. The
+      /// request is sent to every process that advertises the service with
+      /// matching types, without waiting for the responses in between. A
+      /// responser within this process runs the request before returning.
+      /// This function doesn't wait for the discovery: only the responsers
+      /// already known receive the request. When the discovery only keeps
+      /// the services used by this process (see
+      /// IGN_TRANSPORT_DISCOVERY_INTEREST), the first call declares the
+      /// interest in the service and asks for its responsers, so they are
+      /// known by the following calls.
+      /// \param[in] _topic Service name requested.
+      /// \param[in] _request Protobuf message containing the request's
+      /// parameters.
+      /// \param[in] _timeout The request completes with
+      /// RequestStatus::TIMED_OUT if not enough responses arrive within
+      /// '_timeout' ms. The responses received so far are available in the
+      /// future.
+      /// \param[in] _replies Number of responses to wait for. 1 completes
+      /// the request with the first response. 0 waits for every responser.
+      /// \return A future for the responses, in order of arrival. It
+      /// completes with RequestStatus::SUCCEEDED once enough responses
+      /// arrived, whatever their result. If there's no responser, it's
+      /// already completed with RequestStatus::NOT_SENT.
+      public: template<typename ReplyT, typename RequestT>
+      RequestFuture<std::vector<ServiceReply<ReplyT>>> RequestAll(
+          const std::string &_topic,
+          const RequestT &_request,
+          const unsigned int _timeout,
+          const unsigned int _replies = 0);
+
       /// \brief Request a new service without waiting for response.
       /// \param[in] _topic Topic requested.
       /// \param[in] _request Protobuf message containing the request's
@@ -672,10 +820,17 @@ namespace ignition
       /// discovery is in its initialization phase.
       /// The value of the "heartbeatInterval" constant, with a default
       /// value of 1000 ms, sets the maximum blocking time period.
+      /// When IGN_TRANSPORT_DISCOVERY_INTEREST is set to "partition" or
+      /// "topic", the list only contains the topics that this process keeps.
+      /// Call NodeShared::EnableFullCatalog() first to get all of them. The
+      /// missing ones arrive with the next heartbeats of their publishers.
       /// \param[out] _topics List of advertised topics.
       public: void TopicList(std::vector<std::string> &_topics) const;
 
       /// \brief Get the information about a topic.
+      /// When IGN_TRANSPORT_DISCOVERY_INTEREST is set to "partition" or
+      /// "topic", only the topics that this process keeps have publishers.
+      /// Call NodeShared::EnableFullCatalog() first to see all of them.
       /// \param[in] _topic Name of the topic.
       /// \param[out] _publishers List of publishers on the topic
       /// \return False if unable to get topic info
@@ -687,10 +842,19 @@ namespace ignition
       /// discovery is in its initialization phase.
       /// The value of the "heartbeatInterval" constant, with a default
       /// value of 1000ms, sets the maximum blocking time period.
+      /// When IGN_TRANSPORT_DISCOVERY_INTEREST is set to "partition" or
+      /// "topic", the list only contains the services that this process
+      /// keeps. Call NodeShared::EnableFullCatalog() first to get all of
+      /// them. The missing ones arrive with the next heartbeats of their
+      /// repliers.
       /// \param[out] _services List of advertised services.
       public: void ServiceList(std::vector<std::string> &_services) const;
 
       /// \brief Get the information about a service.
+      /// When IGN_TRANSPORT_DISCOVERY_INTEREST is set to "partition" or
+      /// "topic", only the services that this process keeps have
+      /// publishers. Call NodeShared::EnableFullCatalog() first to see all
+      /// of them.
       /// \param[in] _service Name of the service.
       /// \param[out] _publishers List of publishers on the service.
       /// \return False if unable to get service info.
@@ -740,6 +904,13 @@ namespace ignition
       public: std::optional<TopicStatistics> TopicStats(
                   const std::string &_topic) const;
 
+      /// \brief Get the number of messages of a topic discarded by the
+      /// subscriptions of this node that have their own queue, because their
+      /// callbacks didn't keep up. See SubscribeOptions::SetHistory().
+      /// \param[in] _topic The name of the topic.
+      /// \return The number of messages dropped.
+      public: uint64_t DroppedMessages(const std::string &_topic) const;
+
       /// \brief Get a pointer to the shared node (singleton shared by all the
       /// nodes).
       /// \return The pointer to the shared node.
@@ -757,10 +928,26 @@ namespace ignition
       /// \return The set of advertised services.
       private: std::unordered_set<std::string> &SrvsAdvertised() const;
 
+      /// \brief Helper function for RequestAsync.
+      /// \param[in] _topic Service name requested.
+      /// \param[in] _request Protobuf message containing the request's
+      /// parameters.
+      /// \param[in] _timeout Deadline of the request in ms. or std::nullopt
+      /// for no deadline.
+      /// \return A future for the response.
+      private: template<typename ReplyT, typename RequestT>
+      RequestFuture<ReplyT> RequestAsyncHelper(
+          const std::string &_topic,
+          const RequestT &_request,
+          const std::optional<unsigned int> &_timeout);
+
       /// \brief Helper function for Subscribe.
       /// \param[in] _fullyQualifiedTopic Fully qualified topic name
+      /// \param[in] _handler Handler of the new subscription, already
+      /// stored.
       /// \return True on success.
-      private: bool SubscribeHelper(const std::string &_fullyQualifiedTopic);
+      private: bool SubscribeHelper(const std::string &_fullyQualifiedTopic,
+        const std::shared_ptr<SubscriptionHandlerBase> &_handler);
 
 #ifdef _WIN32
 // Disable warning C4251 which is triggered by
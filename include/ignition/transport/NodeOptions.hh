@@ -126,6 +126,28 @@ namespace ignition
       public: bool TopicRemap(const std::string &_fromTopic,
                               std::string &_toTopic) const;
 
+      /// \brief Get the number of threads requested for running the
+      /// callbacks of the messages received from other processes.
+      /// \return The number of threads. A value of 0 means that the callbacks
+      /// run in the thread that receives the messages.
+      /// \sa SetCallbackThreads.
+      public: unsigned int CallbackThreads() const;
+
+      /// \brief Set the number of threads used for running the callbacks of
+      /// the messages received from other processes. When greater than 0,
+      /// callbacks are executed by a pool of worker threads: callbacks of the
+      /// same topic run in order, one at a time, while callbacks of different
+      /// topics run in parallel. The pool is shared by all the nodes within
+      /// the same process and its size is the largest value requested by any
+      /// node. It never shrinks. At most #kDefaultCallbackQueueSize callbacks
+      /// are queued per topic, see IGN_TRANSPORT_CALLBACK_QUEUE_SIZE.
+      /// It's also possible to use the environment variable
+      /// IGN_TRANSPORT_CALLBACK_THREADS for setting this value.
+      /// \param[in] _threads The number of threads. A value of 0 (default)
+      /// runs the callbacks in the thread that receives the messages.
+      /// \sa CallbackThreads.
+      public: void SetCallbackThreads(const unsigned int _threads);
+
 #ifdef _WIN32
 // Disable warning C4251 which is triggered by
 // std::unique_ptr
@@ -26,11 +26,16 @@
 #pragma warning(pop)
 #endif
 
+#include <chrono>
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>  //NOLINT
 #include <optional>
 #include <string>
 #include <thread>
+#include <unordered_set>
 #include <vector>
 #include <map>
 
@@ -73,6 +78,15 @@ namespace ignition
       /// \brief Receive data and control messages.
       public: void RunReceptionTask();
 
+      /// \brief Run a function from the reception thread once a deadline
+      /// expires. The callback delays the reception of messages, so it
+      /// should be short and must not block.
+      /// \param[in] _deadline Time when the callback is executed.
+      /// \param[in] _cb The callback.
+      public: void ScheduleTimer(
+                  const std::chrono::steady_clock::time_point &_deadline,
+                  const std::function<void()> &_cb);
+
       /// \brief Publish data.
       /// \param[in] _topic Topic to be published.
       /// \param[in, out] _data Serialized data. Note that this buffer will be
@@ -83,12 +97,38 @@ namespace ignition
       /// deallocates the buffer containing the published data.
       /// \ref http://zeromq.org/blog:zero-copy
       /// \param[in] _msgType Message type in string format.
+      /// \param[in] _hint Opaque pointer passed to _ffn as its second
+      /// argument.
+      /// \param[in] _codec Identifier of the codec that compressed _data,
+      /// or 0 if it's not compressed. See Codec.
       /// \return true when success or false otherwise.
       public: bool Publish(const std::string &_topic,
                            char *_data,
                            const size_t _dataSize,
                            DeallocFunc *_ffn,
-                           const std::string &_msgType);
+                           const std::string &_msgType,
+                           void *_hint = nullptr,
+                           const uint8_t _codec = 0);
+
+      /// \brief Publish data to the subscribers running on the same host
+      /// that receive the data through shared memory. The data is serialized
+      /// directly into the shared memory segment and the subscribers only
+      /// receive a small notification through ZeroMQ.
+      /// \param[in] _topic Topic to be published.
+      /// \param[in] _dataSize Data size (bytes).
+      /// \param[in] _serializer Function that writes exactly _dataSize bytes
+      /// of serialized data into the buffer passed as argument. It should
+      /// return false on error.
+      /// \param[in] _streamId Stream identifier of the publisher, see
+      /// MessagePublisher::StreamId().
+      /// \param[in] _msgType Message type in string format if it isn't the
+      /// type advertised by the publisher, or empty.
+      /// \return true when success or false otherwise.
+      public: bool PublishShm(const std::string &_topic,
+                              const size_t _dataSize,
+                              const std::function<bool(char *)> &_serializer,
+                              const uint64_t _streamId,
+                              const std::string &_msgType = "");
 
       /// \brief Method in charge of receiving the topic updates.
       public: void RecvMsgUpdate();
@@ -99,15 +139,20 @@ namespace ignition
       /// CheckHandlerInfo(const std::string &_topic) const
       public: struct HandlerInfo
       {
-        /// \brief This is a map of the standard local callback handlers. The
-        /// key is the topic name, and the value is another map whose key is
-        /// the node UUID and whose value is a smart pointer to the handler.
-        public: std::map<std::string, ISubscriptionHandler_M> localHandlers;
-
-        /// \brief This is a map of the raw local callback handlers. The key is
-        /// the topic name, and the value is another map whose key is the node
-        /// UUID and whose value is a smart pointer to the handler.
-        public: std::map<std::string, RawSubscriptionHandler_M> rawHandlers;
+        /// \brief This is a view of the standard local callback handlers of
+        /// the topic, shared with localSubscribers. The key is the node UUID,
+        /// and the value is another map whose key is the handler UUID and
+        /// whose value is a smart pointer to the handler. Null if haveLocal
+        /// is false.
+        public: HandlerStorage<ISubscriptionHandler>::HandlersView
+                  localHandlers;
+
+        /// \brief This is a view of the raw local callback handlers of the
+        /// topic, shared with localSubscribers. The key is the node UUID, and
+        /// the value is another map whose key is the handler UUID and whose
+        /// value is a smart pointer to the handler. Null if haveRaw is false.
+        public: HandlerStorage<RawSubscriptionHandler>::HandlersView
+                  rawHandlers;
 
         /// \brief True iff there are any standard local subscribers.
         public: bool haveLocal;
@@ -115,6 +160,24 @@ namespace ignition
         /// \brief True iff there are any raw local subscribers
         public: bool haveRaw;
 
+        /// \brief True if the message was received through ZeroMQ from
+        /// another process. Those messages only reach the nodes that asked
+        /// the publisher for their stream.
+        // cppcheck-suppress unusedStructMember
+        public: bool remote = false;
+
+        /// \brief Identifier of the filter that the publisher applied to a
+        /// remote message (see MessagePublisher::Filter()), or 0 if it was
+        /// sent to the subscribers without filter.
+        // cppcheck-suppress unusedStructMember
+        public: uint64_t filterId = 0;
+
+        /// \brief UUID of the only node that gets the message, or empty.
+        /// It's set for the messages that a latched publisher replays to a
+        /// new remote node.
+        // cppcheck-suppress unusedStructMember
+        public: std::string targetNode;
+
         // Friendship. This allows HandlerInfo to be created by
         // CheckHandlerInfo()
         friend class NodeShared;
@@ -140,10 +203,22 @@ namespace ignition
       /// subscribers they have.
       public: struct SubscriberInfo : public HandlerInfo
       {
-        /// \brief True if this Publisher has any remote subscribers
+        /// \brief True if this Publisher has any remote subscribers that
+        /// receive the data through ZeroMQ.
         // cppcheck-suppress unusedStructMember
         public: bool haveRemote;
 
+        /// \brief True if this Publisher has any remote subscribers that
+        /// receive the data through shared memory.
+        // cppcheck-suppress unusedStructMember
+        public: bool haveShm;
+
+        /// \brief Filter keys of the remote subscribers that receive the data
+        /// through ZeroMQ and only want some of the messages. See
+        /// MessagePublisher::Filter(). haveRemote doesn't include them.
+        // cppcheck-suppress unusedStructMember
+        public: std::vector<std::string> remoteFilters;
+
         // Friendship declaration
         friend class NodeShared;
 
@@ -173,6 +248,20 @@ namespace ignition
         const std::string &_msgData,
         const HandlerInfo &_handlerInfo);
 
+      /// \brief Call the SubscriptionHandler callbacks (local and raw) for this
+      /// NodeShared. Raw callbacks receive a pointer to _msgData, so no copy
+      /// of the data is made for them.
+      /// \param[in] _info Message information.
+      /// \param[in] _msgData The raw serialized data for the message.
+      /// \param[in] _msgSize Size of the serialized data (bytes).
+      /// \param[in] _handlerInfo Information for the handlers of this node,
+      /// as generated by CheckHandlerInfo(const std::string&) const
+      public: void TriggerCallbacks(
+        const MessageInfo &_info,
+        const char *_msgData,
+        const size_t _msgSize,
+        const HandlerInfo &_handlerInfo);
+
       /// \brief Method in charge of receiving the control updates (when a new
       /// remote subscriber notifies its presence for example).
       /// ToDo: Remove this function when possible.
@@ -193,6 +282,28 @@ namespace ignition
                                          const std::string &_reqType,
                                          const std::string &_repType);
 
+      /// \brief Store a pending service call request. Besides the requests
+      /// member, the request is indexed by its handler UUID and queued until
+      /// it's sent, so neither receiving a response nor sending the pending
+      /// requests depends on the number of requests outstanding.
+      /// NodeShared::mutex must be locked.
+      /// \param[in] _topic Service name.
+      /// \param[in] _nUuid UUID of the node making the request.
+      /// \param[in] _handler Request handler.
+      public: void AddRequest(const std::string &_topic,
+                              const std::string &_nUuid,
+                              const IReqHandlerPtr &_handler);
+
+      /// \brief Remove a pending service call request. NodeShared::mutex
+      /// must be locked.
+      /// \param[in] _topic Service name.
+      /// \param[in] _nUuid UUID of the node making the request.
+      /// \param[in] _hUuid UUID of the request handler.
+      /// \return True if the request was found and removed.
+      public: bool RemoveRequest(const std::string &_topic,
+                                 const std::string &_nUuid,
+                                 const std::string &_hUuid);
+
       /// \brief Callback executed when the discovery detects new topics.
       /// \param[in] _pub Information of the publisher in charge of the topic.
       public: void OnNewConnection(const MessagePublisher &_pub);
@@ -236,6 +347,12 @@ namespace ignition
       /// \sa bool Discovery::Discover(const std::string &_topic) const
       public: bool DiscoverService(const std::string &_topic) const;
 
+      /// \brief Keep all the remote topics and services in the discovery,
+      /// even if IGN_TRANSPORT_DISCOVERY_INTEREST asks for dropping the ones
+      /// that this process doesn't use. The tools that list them need the
+      /// full catalog.
+      public: void EnableFullCatalog();
+
       /// \brief Pass through to bool Advertise(const Pub &_publisher)
       /// \param[in] _publisher Publisher's information to advertise.
       /// \return True if the method succeed or false otherwise
@@ -243,6 +360,21 @@ namespace ignition
       /// \sa Pass through to bool Advertise(const Pub &_publisher)
       public: bool AdvertisePublisher(const ServicePublisher &_publisher);
 
+      /// \brief Run the requests that a service replier receives from other
+      /// processes in a dedicated pool of worker threads, instead of the
+      /// reception thread.
+      /// \param[in] _hUuid UUID of the replier handler.
+      /// \param[in] _options Options of the service. Nothing is done if
+      /// AdvertiseServiceOptions::Threads() is 0.
+      public: void AddReplierWorkers(const std::string &_hUuid,
+                                     const AdvertiseServiceOptions &_options);
+
+      /// \brief Stop the worker threads of some service repliers. Waits for
+      /// the requests running, so NodeShared::mutex must not be locked.
+      /// \param[in] _hUuids UUIDs of the replier handlers.
+      public: void RemoveReplierWorkers(
+                  const std::vector<std::string> &_hUuids);
+
       /// \brief Get the capacity of the buffer (High Water Mark)
       /// that stores incoming Ignition Transport messages. Note that this is a
       /// global queue shared by all subscribers within the same process.
@@ -267,6 +399,33 @@ namespace ignition
       /// If your buffer reaches the maximum capacity data will be dropped.
       public: int SndHwm();
 
+      /// \brief Get the capacity of the queue that stores the messages
+      /// published to subscribers within the same process until their
+      /// callbacks run. Note that this is a global queue shared by all
+      /// publishers within the same process. With the default "grow" policy
+      /// of IGN_TRANSPORT_PUB_QUEUE_POLICY, the messages that don't fit wait
+      /// in an overflow list without limit. The default capacity is
+      /// contained in the #kDefaultPubQueueSize variable and it can be changed
+      /// with the IGN_TRANSPORT_PUB_QUEUE_SIZE environment variable.
+      /// \return The capacity of the queue (units are messages).
+      public: std::size_t PubQueueCapacity() const;
+
+      /// \brief Get the number of messages waiting in the queue of messages
+      /// published to subscribers within the same process.
+      /// \return The number of messages in the queue.
+      /// \sa PubQueueCapacity
+      public: std::size_t PubQueueDepth() const;
+
+      /// \brief Get the number of messages discarded because the queue of
+      /// messages published to subscribers within the same process was full.
+      /// By default, the messages that don't fit are kept aside and nothing
+      /// is discarded. Depending on IGN_TRANSPORT_PUB_QUEUE_POLICY, either
+      /// the oldest message in the queue or the new one is discarded, or
+      /// the publishers wait for room in the queue ("block").
+      /// \return The number of dropped messages.
+      /// \sa PubQueueCapacity
+      public: uint64_t PubQueueDropped() const;
+
       /// \brief Turn topic statistics on or off.
       /// \param[in] _topic The name of the topic on which to enable or disable
       /// statistics.
@@ -296,6 +455,14 @@ namespace ignition
       /// return false if any operation on a ZMQ socket triggered an exception.
       private: bool InitializeSockets();
 
+      /// \brief Send a service call response, connecting to the requester
+      /// if needed. NodeShared::mutex must be locked.
+      /// \param[in] _addr Address of the requester.
+      /// \param[in] _frames Frames of the response. The first one is the
+      /// socket identity of the requester.
+      private: void SendSrvResponse(const std::string &_addr,
+                                    std::vector<std::string> &&_frames);
+
       //////////////////////////////////////////////////
       /////// Declare here other member variables //////
       //////////////////////////////////////////////////
@@ -318,9 +485,19 @@ namespace ignition
       /// \brief thread in charge of receiving and handling incoming messages.
       public: std::thread threadReception;
 
-      /// \brief Mutex to guarantee exclusive access between all threads.
+      /// \brief Mutex to protect the service call handlers (repliers and
+      /// requests), the service connections and the per node bookkeeping.
+      /// The pub/sub state is protected by subscribersMutex and by the
+      /// mutexes in NodeSharedPrivate, so publishing and receiving messages
+      /// don't contend with service calls. When both are needed, lock this
+      /// mutex first.
       public: mutable std::recursive_mutex mutex;
 
+      /// \brief Mutex to protect localSubscribers and remoteSubscribers.
+      /// The lookups done to publish and receive messages take a shared lock.
+      /// Don't lock any other mutex nor call into discovery while holding it.
+      public: mutable std::shared_mutex subscribersMutex;
+
       /// \brief Port used by the message discovery layer.
       public: static const int kMsgDiscPort = 10317;
 
@@ -330,8 +507,8 @@ namespace ignition
       /// \brief Remote connections for pub/sub messages.
       private: TopicStorage<MessagePublisher> connections;
 
-      /// \brief List of connected zmq end points for request/response.
-      private: std::vector<std::string> srvConnections;
+      /// \brief Connected zmq end points for request/response.
+      private: std::unordered_set<std::string> srvConnections;
 
       /// \brief Remote subscribers.
       public: TopicStorage<MessagePublisher> remoteSubscribers;
@@ -20,6 +20,7 @@
 
 #include <ignition/msgs/discovery.pb.h>
 
+#include <cstdint>
 #include <iostream>
 #include <string>
 
@@ -235,6 +236,48 @@ namespace ignition
       /// \sa MsgTypeName.
       public: void SetMsgTypeName(const std::string &_msgTypeName);
 
+      /// \brief Get the identifier of the host whose shared memory can be
+      /// used to exchange data with this publisher. When advertised by a
+      /// publisher, it means that the publisher offers shared memory
+      /// delivery. When sent by a subscriber while registering, it means that
+      /// the subscriber will receive the data through shared memory.
+      /// \return The host identifier or empty if shared memory isn't used.
+      /// \sa SetShmHostId.
+      public: std::string ShmHostId() const;
+
+      /// \brief Set the identifier of the host whose shared memory can be
+      /// used to exchange data with this publisher.
+      /// \param[in] _hostId New host identifier. Empty disables shared memory.
+      /// \sa ShmHostId.
+      public: void SetShmHostId(const std::string &_hostId);
+
+      /// \brief Get the identifier that the publisher's process sends with
+      /// every message of this topic and type, instead of the sender's
+      /// address and the message type.
+      /// \return The stream identifier or 0 if unknown.
+      /// \sa SetStreamId.
+      public: uint64_t StreamId() const;
+
+      /// \brief Set the identifier that the publisher's process sends with
+      /// every message of this topic and type.
+      /// \param[in] _streamId New stream identifier.
+      /// \sa StreamId.
+      public: void SetStreamId(const uint64_t _streamId);
+
+      /// \brief Get the filter and the maximum rate that a subscriber
+      /// declares while registering. The publisher only sends it the messages
+      /// that pass them.
+      /// \return The filter key of the subscriber or empty if it wants every
+      /// message.
+      /// \sa SetFilter.
+      public: std::string Filter() const;
+
+      /// \brief Set the filter and the maximum rate that a subscriber
+      /// declares while registering.
+      /// \param[in] _filter New filter key. Empty to receive every message.
+      /// \sa Filter.
+      public: void SetFilter(const std::string &_filter);
+
       /// \brief Get the advertised options.
       /// \return The advertised options.
       /// \sa SetOptions.
@@ -300,10 +343,19 @@ namespace ignition
 
       /// \brief Message type advertised by this publisher.
       private: std::string msgTypeName;
+
+      /// \brief Host identifier used for shared memory delivery.
+      private: std::string shmHostId;
+
+      /// \brief Filter key declared by a subscriber.
+      private: std::string filter;
 #ifdef _WIN32
 #pragma warning(pop)
 #endif
 
+      /// \brief Stream identifier sent with every message.
+      private: uint64_t streamId = 0;
+
       /// \brief Advertise options (e.g.: msgsPerSec).
       private: AdvertiseMessageOptions msgOpts;
     };
@@ -106,6 +106,22 @@ namespace ignition
         this->requested = _value;
       }
 
+      /// \brief Get the address of the responser that must receive this
+      /// request.
+      /// \return The address or an empty string if any responser of the
+      /// service can receive it.
+      public: std::string Responser() const
+      {
+        return this->responser;
+      }
+
+      /// \brief Send this request to a specific responser.
+      /// \param[in] _addr Address of the responser's socket.
+      public: void Responser(const std::string &_addr)
+      {
+        this->responser = _addr;
+      }
+
       /// \brief Serialize the Req protobuf message stored.
       /// \param[out] _buffer The serialized data.
       /// \return True if the serialization succeed or false otherwise.
@@ -163,6 +179,10 @@ namespace ignition
 
       /// \brief Node UUID.
       private: std::string nUuid;
+
+      /// \brief Address of the responser that must receive this request or
+      /// empty if any responser can.
+      private: std::string responser;
 #ifdef _WIN32
 #pragma warning(pop)
 #endif
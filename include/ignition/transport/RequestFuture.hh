@@ -0,0 +1,459 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef IGN_TRANSPORT_REQUESTFUTURE_HH_
+#define IGN_TRANSPORT_REQUESTFUTURE_HH_
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#define IGN_TRANSPORT_HAVE_COROUTINES 1
+#endif
+
+#include "ignition/transport/config.hh"
+#include "ignition/transport/Export.hh"
+#include "ignition/transport/Publisher.hh"
+
+namespace ignition
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace IGNITION_TRANSPORT_VERSION_NAMESPACE {
+    //
+    /// \brief State of an asynchronous service request.
+    enum class RequestStatus
+    {
+      /// \brief The response hasn't arrived yet.
+      PENDING,
+      /// \brief The responser executed the request successfully.
+      SUCCEEDED,
+      /// \brief The responser executed the request but reported a failure.
+      FAILED,
+      /// \brief The deadline expired before the response arrived.
+      TIMED_OUT,
+      /// \brief The request was cancelled by the requester.
+      CANCELLED,
+      /// \brief The request couldn't be sent (e.g.: invalid service name or
+      /// the discovery service isn't running).
+      NOT_SENT
+    };
+
+    /// \class RequestState RequestFuture.hh
+    /// ignition/transport/RequestFuture.hh
+    /// \brief State shared between the requester of an asynchronous service
+    /// call and the code that completes it. The first completion wins: once
+    /// the state is not pending, it never changes again.
+    template<typename ReplyT> class RequestState
+    {
+      /// \brief Complete the request.
+      /// \param[in] _status Final status. It can't be PENDING.
+      /// \param[in] _reply The response.
+      /// \return True if the request was completed or false if it was
+      /// already completed.
+      public: bool Complete(const RequestStatus _status,
+                            const ReplyT &_reply = ReplyT())
+      {
+        std::vector<std::function<void()>> ready;
+        {
+          std::lock_guard<std::mutex> lk(this->mutex);
+          if (this->status != RequestStatus::PENDING)
+            return false;
+
+          this->reply = _reply;
+          this->status = _status;
+          this->cancelCb = nullptr;
+          ready.swap(this->continuations);
+        }
+
+        this->condition.notify_all();
+        for (auto &cb : ready)
+          cb();
+        return true;
+      }
+
+      /// \brief Cancel the request and execute the cancellation callback.
+      /// \param[in] _status Final status. TIMED_OUT is used when the
+      /// deadline expires.
+      /// \return True if the request was cancelled or false if it was
+      /// already completed.
+      public: bool Cancel(
+                  const RequestStatus _status = RequestStatus::CANCELLED)
+      {
+        std::function<void()> hook;
+        std::vector<std::function<void()>> ready;
+        {
+          std::lock_guard<std::mutex> lk(this->mutex);
+          if (this->status != RequestStatus::PENDING)
+            return false;
+
+          this->status = _status;
+          hook.swap(this->cancelCb);
+          ready.swap(this->continuations);
+        }
+
+        this->condition.notify_all();
+        if (hook)
+          hook();
+        for (auto &cb : ready)
+          cb();
+        return true;
+      }
+
+      /// \brief Register a function to execute when the request completes.
+      /// \param[in] _cb The function.
+      /// \return True if the function was registered or false if the request
+      /// was already completed. In that case the function is not executed.
+      public: bool AddContinuation(const std::function<void()> &_cb)
+      {
+        std::lock_guard<std::mutex> lk(this->mutex);
+        if (this->status != RequestStatus::PENDING)
+          return false;
+
+        this->continuations.push_back(_cb);
+        return true;
+      }
+
+      /// \brief Set the function executed when the request is cancelled,
+      /// replacing the previous one. If the request was already cancelled or
+      /// timed out, the function is executed right away.
+      /// \param[in] _cb The function.
+      public: void OnCancel(const std::function<void()> &_cb)
+      {
+        {
+          std::lock_guard<std::mutex> lk(this->mutex);
+          if (this->status == RequestStatus::PENDING)
+          {
+            this->cancelCb = _cb;
+            return;
+          }
+
+          if (this->status != RequestStatus::CANCELLED &&
+              this->status != RequestStatus::TIMED_OUT)
+          {
+            return;
+          }
+        }
+
+        _cb();
+      }
+
+      /// \brief Get the current status.
+      /// \return The status.
+      public: RequestStatus Status() const
+      {
+        std::lock_guard<std::mutex> lk(this->mutex);
+        return this->status;
+      }
+
+      /// \brief Get the response. Only meaningful once the request completed.
+      /// \return The response.
+      public: const ReplyT &Reply() const
+      {
+        return this->reply;
+      }
+
+      /// \brief Block the current thread until the request completes or the
+      /// timeout expires.
+      /// \param[in] _timeout Maximum waiting time.
+      /// \return True if the request completed or false otherwise.
+      public: bool WaitFor(const std::chrono::milliseconds &_timeout) const
+      {
+        std::unique_lock<std::mutex> lk(this->mutex);
+        return this->condition.wait_for(lk, _timeout, [this]
+        {
+          return this->status != RequestStatus::PENDING;
+        });
+      }
+
+      /// \brief Block the current thread until the request completes.
+      public: void Wait() const
+      {
+        std::unique_lock<std::mutex> lk(this->mutex);
+        this->condition.wait(lk, [this]
+        {
+          return this->status != RequestStatus::PENDING;
+        });
+      }
+
+      /// \brief Protects the members below.
+      private: mutable std::mutex mutex;
+
+      /// \brief Notified when the request completes.
+      private: mutable std::condition_variable condition;
+
+      /// \brief Current status.
+      private: RequestStatus status = RequestStatus::PENDING;
+
+      /// \brief The response.
+      private: ReplyT reply;
+
+      /// \brief Functions executed when the request completes.
+      private: std::vector<std::function<void()>> continuations;
+
+      /// \brief Function executed when the request is cancelled.
+      private: std::function<void()> cancelCb;
+    };
+
+    /// \class ServiceReply RequestFuture.hh
+    /// ignition/transport/RequestFuture.hh
+    /// \brief Response of one of the responsers of a service request sent
+    /// to all of them. See Node::RequestAll().
+    template<typename ReplyT> class ServiceReply
+    {
+      /// \brief The responser.
+      public: ServicePublisher responser;
+
+      /// \brief Result of the service call in the responser.
+      public: bool result = false;
+
+      /// \brief The response.
+      public: ReplyT reply;
+    };
+
+    /// \class RequestFuture RequestFuture.hh
+    /// ignition/transport/RequestFuture.hh
+    /// \brief Handle to the result of an asynchronous service request. See
+    /// Node::RequestAsync().
+    ///
+    /// The request can be waited on, cancelled, chained with Then() or, when
+    /// compiling with C++20 coroutines, awaited with co_await. The
+    /// continuations and the awaiting coroutines are resumed by the thread
+    /// that completes the request: the caller of Node::RequestAsync() when
+    /// the responser is in the same process or the reception thread of the
+    /// transport otherwise. They should be short and must not make blocking
+    /// service requests, as that would stall the reception of messages.
+    ///
+    /// Copies of a future refer to the same request.
+    template<typename ReplyT> class RequestFuture
+    {
+      /// \brief Type of the response.
+      public: using ReplyType = ReplyT;
+
+      /// \brief Default constructor. The future isn't valid.
+      public: RequestFuture() = default;
+
+      /// \brief Constructor.
+      /// \param[in] _state State of the request.
+      public: explicit RequestFuture(
+                  std::shared_ptr<RequestState<ReplyT>> _state)
+        : state(std::move(_state))
+      {
+      }
+
+      /// \brief Whether the future refers to a request.
+      /// \return True if valid or false otherwise.
+      public: bool Valid() const
+      {
+        return this->state != nullptr;
+      }
+
+      /// \brief Whether the request completed.
+      /// \return True if the request completed or false otherwise.
+      public: bool Ready() const
+      {
+        return this->Status() != RequestStatus::PENDING;
+      }
+
+      /// \brief Get the status of the request.
+      /// \return The status. An invalid future returns NOT_SENT.
+      public: RequestStatus Status() const
+      {
+        if (!this->state)
+          return RequestStatus::NOT_SENT;
+        return this->state->Status();
+      }
+
+      /// \brief Get the response. Only meaningful when Status() is
+      /// SUCCEEDED or FAILED.
+      /// \return The response.
+      public: const ReplyT &Reply() const
+      {
+        static const ReplyT kEmpty;
+        if (!this->Ready())
+          return kEmpty;
+        return this->state->Reply();
+      }
+
+      /// \brief Block the current thread until the request completes.
+      /// \return The final status.
+      public: RequestStatus Wait() const
+      {
+        if (this->state)
+          this->state->Wait();
+        return this->Status();
+      }
+
+      /// \brief Block the current thread until the request completes or the
+      /// timeout expires.
+      /// \param[in] _timeout Maximum waiting time in milliseconds.
+      /// \return True if the request completed or false otherwise.
+      public: bool WaitFor(const unsigned int _timeout) const
+      {
+        if (!this->state)
+          return true;
+        return this->state->WaitFor(std::chrono::milliseconds(_timeout));
+      }
+
+      /// \brief Cancel the request. A response arriving later is discarded.
+      /// \return True if the request was cancelled or false if it had
+      /// already completed.
+      public: bool Cancel()
+      {
+        if (!this->state)
+          return false;
+        return this->state->Cancel();
+      }
+
+      /// \brief Execute a function when the request completes, whatever its
+      /// status. If the request already completed, the function is executed
+      /// right away by the calling thread.
+      /// \param[in] _cb Function with the signature
+      /// R(const RequestFuture<ReplyT> &_done), where _done is this
+      /// request. R can be:
+      ///   * void: The returned future completes with the status and
+      ///     response of this request, after _cb returns.
+      ///   * RequestFuture<T>: Usually a new request. The returned future
+      ///     completes when that request completes.
+      /// \return A future for the chained operation. Cancelling it cancels
+      /// this request or, once _cb was executed, the request returned by _cb.
+      /// The function isn't executed if the returned future is cancelled
+      /// before this request completes.
+      public: template<typename F>
+      auto Then(F &&_cb) const
+      {
+        using ResultT = std::invoke_result_t<F, const RequestFuture &>;
+        using NextT = std::conditional_t<std::is_void_v<ResultT>,
+                                         RequestFuture, ResultT>;
+        using NextReplyT = typename NextT::ReplyType;
+
+        if (!this->state)
+          return NextT();
+
+        auto source = this->state;
+        auto next = std::make_shared<RequestState<NextReplyT>>();
+        next->OnCancel([source]{source->Cancel();});
+
+        std::function<void()> cont =
+          [source, next, cb = std::forward<F>(_cb)]() mutable
+        {
+          // The chained future was cancelled.
+          if (next->Status() != RequestStatus::PENDING)
+            return;
+
+          RequestFuture done(source);
+          if constexpr (std::is_void_v<ResultT>)
+          {
+            cb(done);
+            next->Complete(source->Status(), source->Reply());
+          }
+          else
+          {
+            auto inner = cb(done).state;
+            if (!inner)
+            {
+              next->Complete(RequestStatus::NOT_SENT);
+              return;
+            }
+
+            next->OnCancel([inner]{inner->Cancel();});
+            std::function<void()> forward = [inner, next]
+            {
+              next->Complete(inner->Status(), inner->Reply());
+            };
+            if (!inner->AddContinuation(forward))
+              forward();
+          }
+        };
+
+        if (!source->AddContinuation(cont))
+          cont();
+
+        return NextT(next);
+      }
+
+#ifdef IGN_TRANSPORT_HAVE_COROUTINES
+      /// \brief Awaiter used by co_await.
+      public: class Awaiter
+      {
+        /// \brief Constructor.
+        /// \param[in] _state State of the request.
+        public: explicit Awaiter(std::shared_ptr<RequestState<ReplyT>> _state)
+          : state(std::move(_state))
+        {
+        }
+
+        /// \brief Whether the coroutine can continue without suspending.
+        /// \return True if the request completed.
+        public: bool await_ready() const
+        {
+          return !this->state ||
+            this->state->Status() != RequestStatus::PENDING;
+        }
+
+        /// \brief Resume the coroutine when the request completes.
+        /// \param[in] _handle The suspended coroutine.
+        /// \return False if the request completed in the meantime, so the
+        /// coroutine continues right away.
+        public: bool await_suspend(std::coroutine_handle<> _handle)
+        {
+          return this->state->AddContinuation([_handle]{_handle.resume();});
+        }
+
+        /// \brief Value of the co_await expression.
+        /// \return The completed future.
+        public: RequestFuture await_resume() const
+        {
+          return RequestFuture(this->state);
+        }
+
+        /// \brief State of the request.
+        private: std::shared_ptr<RequestState<ReplyT>> state;
+      };
+
+      /// \brief Suspend a coroutine until the request completes. The
+      /// coroutine doesn't block any thread while suspended, so a single
+      /// thread can keep many requests in flight. The co_await expression
+      /// evaluates to the completed future.
+      /// \return The awaiter.
+      public: Awaiter operator co_await() const
+      {
+        return Awaiter(this->state);
+      }
+#endif
+
+      /// \brief Futures of other response types access the state when
+      /// chaining.
+      template<typename> friend class RequestFuture;
+
+      /// \brief State of the request.
+      private: std::shared_ptr<RequestState<ReplyT>> state;
+    };
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef IGN_TRANSPORT_SHAREDMEMORYRING_HH_
+#define IGN_TRANSPORT_SHAREDMEMORYRING_HH_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "ignition/transport/config.hh"
+#include "ignition/transport/Export.hh"
+
+namespace ignition
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace IGNITION_TRANSPORT_VERSION_NAMESPACE {
+    //
+    // Forward declarations.
+    class SharedMemoryRingPrivate;
+
+    /// \class SharedMemoryRing SharedMemoryRing.hh
+    /// ignition/transport/SharedMemoryRing.hh
+    /// \brief A ring of fixed size slots stored in a named shared memory
+    /// segment. It is used to hand serialized messages to subscribers running
+    /// on the same host without copying them through the network stack.
+    ///
+    /// A segment has a single writer: the process that created it. Any
+    /// number of processes can open the segment and read from it. A reader
+    /// acquires a slot using the sequence number that the writer returned when
+    /// the slot was committed and, while the slot is acquired, the writer
+    /// won't reuse it. The slot should be released as soon as the reader is
+    /// done with the data. The slots acquired by a reader that crashes are
+    /// given back to the writer when it runs out of slots (Linux only).
+    class IGNITION_TRANSPORT_VISIBLE SharedMemoryRing
+    {
+      /// \brief Default number of slots of a ring.
+      public: static const uint32_t kDefaultSlotCount = 8;
+
+      /// \brief Minimum size (bytes) of a slot.
+      public: static const uint64_t kMinSlotSize = 65536;
+
+      /// \brief Create a new shared memory segment. If a segment with the
+      /// same name already exists (e.g.: left behind by a process that
+      /// crashed), it is replaced.
+      /// \param[in] _name Name of the segment. It has to start with '/' and
+      /// contain no other '/' characters.
+      /// \param[in] _slotCount Number of slots.
+      /// \param[in] _slotSize Size of each slot (bytes).
+      /// \return A pointer to the new ring or nullptr if the segment couldn't
+      /// be created.
+      public: static std::unique_ptr<SharedMemoryRing> Create(
+                  const std::string &_name,
+                  const uint32_t _slotCount,
+                  const uint64_t _slotSize);
+
+      /// \brief Open an existing shared memory segment for reading.
+      /// \param[in] _name Name of the segment.
+      /// \return A pointer to the ring or nullptr if the segment couldn't be
+      /// opened.
+      public: static std::unique_ptr<SharedMemoryRing> Open(
+                  const std::string &_name);
+
+      /// \brief Whether shared memory is supported in this platform.
+      /// \return True if supported or false otherwise.
+      public: static bool Supported();
+
+      /// \brief Get an identifier of this host. Two processes can exchange
+      /// data through a shared memory ring if their host identifiers match:
+      /// they run on the same machine and boot, in the same IPC namespace and
+      /// as the same user.
+      /// \return The host identifier or an empty string if shared memory is
+      /// not supported.
+      public: static std::string HostId();
+
+      /// \brief Destructor. If this is the writer of the ring, the shared
+      /// memory segment is also removed. Processes that have the segment
+      /// already opened can still access it.
+      public: ~SharedMemoryRing();
+
+      /// \brief Get the name of the shared memory segment.
+      /// \return The segment name.
+      public: std::string Name() const;
+
+      /// \brief Get the number of slots.
+      /// \return The number of slots.
+      public: uint32_t SlotCount() const;
+
+      /// \brief Get the size of each slot.
+      /// \return The size of a slot (bytes).
+      public: uint64_t SlotSize() const;
+
+      /// \brief Reserve a slot for writing. Slots that are currently
+      /// acquired by a reader are skipped.
+      /// \param[in] _size Size of the data that will be written (bytes).
+      /// \param[out] _slot Index of the reserved slot.
+      /// \return A pointer to the start of the slot or nullptr if _size
+      /// doesn't fit in a slot, this isn't the writer of the ring or all the
+      /// slots are in use.
+      public: char *Reserve(const uint64_t _size, uint32_t &_slot);
+
+      /// \brief Make a reserved slot visible to the readers.
+      /// \param[in] _slot Index of the slot previously returned by Reserve().
+      /// \param[in] _size Size of the data written in the slot (bytes).
+      /// \return The sequence number that identifies the data or 0 on error.
+      public: uint64_t Commit(const uint32_t _slot, const uint64_t _size);
+
+      /// \brief Give up a slot previously returned by Reserve() without
+      /// publishing it.
+      /// \param[in] _slot Index of the slot.
+      public: void Abort(const uint32_t _slot);
+
+      /// \brief Acquire a slot for reading.
+      /// \param[in] _slot Index of the slot.
+      /// \param[in] _seq Sequence number returned by Commit().
+      /// \param[out] _data Pointer to the start of the data.
+      /// \param[out] _size Size of the data (bytes).
+      /// \return True if the slot was acquired. False if the slot index is
+      /// not valid or the data was already overwritten.
+      public: bool Acquire(const uint32_t _slot,
+                           const uint64_t _seq,
+                           const char *&_data,
+                           uint64_t &_size);
+
+      /// \brief Release a slot previously acquired with Acquire().
+      /// \param[in] _slot Index of the slot.
+      public: void Release(const uint32_t _slot);
+
+      /// \brief Constructor. Use Create() or Open() instead.
+      private: SharedMemoryRing();
+
+#ifdef _WIN32
+// Disable warning C4251 which is triggered by
+// std::unique_ptr
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif
+      /// \brief Private data pointer.
+      private: std::unique_ptr<SharedMemoryRingPrivate> dataPtr;
+#ifdef _WIN32
+#pragma warning(pop)
+#endif
+    };
+    }
+  }
+}
+#endif
@@ -23,6 +23,7 @@
 
 #include "ignition/transport/config.hh"
 #include "ignition/transport/Export.hh"
+#include "ignition/transport/MessageFilter.hh"
 
 namespace ignition
 {
@@ -38,6 +39,23 @@ namespace ignition
     /// \brief A class to provide different options for a subscription.
     class IGNITION_TRANSPORT_VISIBLE SubscribeOptions
     {
+      /// \brief What a subscription does with the messages that arrive while
+      /// its callback is busy.
+      public: enum class HistoryPolicy
+      {
+        /// \brief Keep every message, up to the queue depth. The messages
+        /// that arrive when the queue is full are discarded.
+        KEEP_ALL,
+
+        /// \brief Keep the last messages, up to the queue depth. The oldest
+        /// message is discarded when the queue is full.
+        KEEP_LAST,
+
+        /// \brief Keep only the latest message. The callback always gets
+        /// the freshest value, which suits topics that carry a state.
+        LATEST_ONLY
+      };
+
       /// \brief Constructor.
       public: SubscribeOptions();
 
@@ -66,6 +84,58 @@ namespace ignition
       /// \return The maximum number of messages per second.
       public: uint64_t MsgsPerSec() const;
 
+      /// \brief Set a filter on the content of the messages. Only the
+      /// messages that match it reach the callback. The publishers of other
+      /// processes apply the filter and the maximum rate (see
+      /// SetMsgsPerSec()) themselves, so they don't send the messages that
+      /// the subscription doesn't want. Raw subscriptions ignore the filter.
+      /// \param[in] _filter The filter.
+      /// \sa Filter
+      public: void SetFilter(const MessageFilter &_filter);
+
+      /// \brief Get the filter on the content of the messages.
+      /// \return The filter, empty by default.
+      /// \sa SetFilter
+      public: const MessageFilter &Filter() const;
+
+      /// \brief Set what the subscription does with the messages that arrive
+      /// while its callback is busy. With a queue (see Queued()), the
+      /// messages are buffered by the subscription and its callback runs in
+      /// a worker thread, so a slow callback doesn't hold back the other
+      /// subscriptions and only its own messages are discarded.
+      /// \param[in] _history The history policy.
+      /// \sa History
+      /// \sa SetQueueDepth
+      public: void SetHistory(const HistoryPolicy _history);
+
+      /// \brief Get what the subscription does with the messages that arrive
+      /// while its callback is busy.
+      /// \return The history policy, KEEP_ALL by default.
+      /// \sa SetHistory
+      public: HistoryPolicy History() const;
+
+      /// \brief Set the maximum number of messages buffered by the
+      /// subscription. It's ignored by LATEST_ONLY, and KEEP_LAST keeps at
+      /// least one message.
+      /// \param[in] _depth Maximum number of messages.
+      /// \sa QueueDepth
+      public: void SetQueueDepth(const uint64_t _depth);
+
+      /// \brief Get the maximum number of messages buffered by the
+      /// subscription.
+      /// \return The queue depth, 0 by default.
+      /// \sa SetQueueDepth
+      public: uint64_t QueueDepth() const;
+
+      /// \brief Whether the subscription has its own queue. That's the case
+      /// unless the history is KEEP_ALL with a queue depth of 0, the default,
+      /// where the callback runs as the messages arrive and they are only
+      /// buffered by the transport (see IGN_TRANSPORT_RCVHWM).
+      /// \return True when the subscription has its own queue.
+      /// \sa SetHistory
+      /// \sa SetQueueDepth
+      public: bool Queued() const;
+
 #ifdef _WIN32
 // Disable warning C4251 which is triggered by
 // std::unique_ptr
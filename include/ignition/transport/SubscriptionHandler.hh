@@ -33,8 +33,10 @@
 #endif
 
 #include <chrono>
+#include <cstdint>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 
@@ -54,6 +56,8 @@ namespace ignition
     // Inline bracket to help doxygen filtering.
     inline namespace IGNITION_TRANSPORT_VERSION_NAMESPACE {
     //
+    class SubscriptionQueue;
+
     /// \brief SubscriptionHandlerBase contains functions and data which are
     /// common to all SubscriptionHandler types.
     class IGNITION_TRANSPORT_VISIBLE SubscriptionHandlerBase
@@ -81,6 +85,22 @@ namespace ignition
       /// \return A string representation of the handler UUID.
       public: std::string HandlerUuid() const;
 
+      /// \brief Get the key that describes the filter and the maximum rate
+      /// of this subscription to the remote publishers.
+      /// \return The key, empty if the subscription wants every message.
+      public: const std::string &FilterKey() const;
+
+      /// \internal
+      /// \brief Get the queue of the subscription.
+      /// \return The queue, or null if the subscription doesn't have its own
+      /// queue (see SubscribeOptions::Queued()).
+      public: const std::shared_ptr<SubscriptionQueue> &Queue() const;
+
+      /// \brief Get the number of messages discarded by the queue of the
+      /// subscription because its callback didn't keep up.
+      /// \return The number of messages dropped.
+      public: uint64_t Dropped() const;
+
       /// \brief Check if message subscription is throttled. If so, verify
       /// whether the callback should be executed or not.
       /// \return true if the callback should be executed or false otherwise.
@@ -107,11 +127,41 @@ namespace ignition
 
       /// \brief Node UUID.
       private: std::string nUuid;
+
+      /// \brief Filter key of the subscription.
+      private: std::string filterKey;
+
+      /// \brief Queue of the subscription, if it has one.
+      private: std::shared_ptr<SubscriptionQueue> queue;
 #ifdef _WIN32
 #pragma warning(pop)
 #endif
     };
 
+    /// \internal
+    /// \brief Interface of the subscription handlers that parse a message
+    /// from a buffer without copying it first. It's separate from
+    /// ISubscriptionHandler so the virtual table of ISubscriptionHandler
+    /// doesn't change.
+    class IGNITION_TRANSPORT_VISIBLE InPlaceMsgParser
+    {
+      /// \brief Destructor.
+      public: virtual ~InPlaceMsgParser() = default;
+
+      /// \brief Create a specific protobuf message given a buffer with its
+      /// serialized data.
+      /// \param[in] _data The serialized data.
+      /// \param[in] _size Size of the serialized data (bytes).
+      /// \param[in] _type The data type.
+      /// \return Pointer to the specific protobuf message.
+      /// \sa ISubscriptionHandler::CreateMsg(const char *, const size_t,
+      /// const std::string &) const
+      public: virtual const std::shared_ptr<ProtoMsg> ParseMsg(
+        const char *_data,
+        const size_t _size,
+        const std::string &_type) const = 0;
+    };
+
     /// \class ISubscriptionHandler SubscriptionHandler.hh
     /// ignition/transport/SubscriptionHandler.hh
     /// \brief Interface class used to manage generic protobuf messages.
@@ -136,10 +186,13 @@ namespace ignition
       /// \brief Executes the local callback registered for this handler.
       /// \param[in] _msg Protobuf message received.
       /// \param[in] _info Message information (e.g.: topic name).
+      /// \param[in] _prefiltered True if the publisher already applied the
+      /// filter and the rate of this subscription to the message.
       /// \return True when success, false otherwise.
       public: virtual bool RunLocalCallback(
         const ProtoMsg &_msg,
-        const MessageInfo &_info) = 0;
+        const MessageInfo &_info,
+        const bool _prefiltered = false) = 0;
 
       /// \brief Create a specific protobuf message given its serialized data.
       /// \param[in] _data The serialized data.
@@ -148,6 +201,27 @@ namespace ignition
       public: virtual const std::shared_ptr<ProtoMsg> CreateMsg(
         const std::string &_data,
         const std::string &_type) const = 0;
+
+      /// \brief Create a specific protobuf message given a buffer with its
+      /// serialized data. The handlers that implement InPlaceMsgParser, as
+      /// SubscriptionHandler does, parse the data in place without copying it
+      /// and may return the same message object in consecutive calls if
+      /// nobody else holds a reference to it, so the message is only valid
+      /// while the returned pointer is alive. Other handlers get a copy of
+      /// the data in CreateMsg(const std::string &, const std::string &).
+      /// \param[in] _data The serialized data.
+      /// \param[in] _size Size of the serialized data (bytes).
+      /// \param[in] _type The data type.
+      /// \return Pointer to the specific protobuf message.
+      public: const std::shared_ptr<ProtoMsg> CreateMsg(
+        const char *_data,
+        const size_t _size,
+        const std::string &_type) const;
+
+      /// \brief The handler itself if it implements InPlaceMsgParser, or
+      /// null. It's set by the constructor of the handler, so CreateMsg()
+      /// doesn't look it up for every message.
+      protected: const InPlaceMsgParser *inPlaceParser = nullptr;
     };
 
     /// \class SubscriptionHandler SubscriptionHandler.hh
@@ -155,27 +229,49 @@ namespace ignition
     /// message. 'T' is the Protobuf message type that will be used for this
     /// particular handler.
     template <typename T> class SubscriptionHandler
-      : public ISubscriptionHandler
+      : public ISubscriptionHandler,
+        public InPlaceMsgParser
     {
       // Documentation inherited.
       public: explicit SubscriptionHandler(const std::string &_nUuid,
         const SubscribeOptions &_opts = SubscribeOptions())
         : ISubscriptionHandler(_nUuid, _opts)
       {
+        this->inPlaceParser = this;
       }
 
+      // Keep ISubscriptionHandler::CreateMsg(const char *, ...) visible.
+      public: using ISubscriptionHandler::CreateMsg;
+
       // Documentation inherited.
       public: const std::shared_ptr<ProtoMsg> CreateMsg(
         const std::string &_data,
+        const std::string &_type) const
+      {
+        return this->ParseMsg(_data.data(), _data.size(), _type);
+      }
+
+      // Documentation inherited.
+      public: const std::shared_ptr<ProtoMsg> ParseMsg(
+        const char *_data,
+        const size_t _size,
         const std::string &/*_type*/) const
       {
-        // Instantiate a specific protobuf message
-        auto msgPtr = std::make_shared<T>();
+        // Reuse the message created in the previous call if nobody else is
+        // using it. This avoids allocating the message, and the memory of its
+        // strings and repeated fields, for every message received.
+        std::shared_ptr<T> msgPtr;
+        {
+          std::lock_guard<std::mutex> lk(this->recycledMsgMutex);
+          if (!this->recycledMsg || this->recycledMsg.use_count() > 1)
+            this->recycledMsg = std::make_shared<T>();
+          msgPtr = this->recycledMsg;
+        }
 
         // Create the message using some serialized data
-        if (!msgPtr->ParseFromString(_data))
+        if (!msgPtr->ParseFromArray(_data, static_cast<int>(_size)))
         {
-          std::cerr << "SubscriptionHandler::CreateMsg() error: ParseFromString"
+          std::cerr << "SubscriptionHandler::CreateMsg() error: ParseFromArray"
                     << " failed" << std::endl;
         }
 
@@ -197,7 +293,8 @@ namespace ignition
 
       // Documentation inherited.
       public: bool RunLocalCallback(const ProtoMsg &_msg,
-                                    const MessageInfo &_info)
+                                    const MessageInfo &_info,
+                                    const bool _prefiltered = false)
       {
         // No callback stored.
         if (!this->cb)
@@ -207,9 +304,12 @@ namespace ignition
           return false;
         }
 
-        // Check the subscription throttling option.
-        if (!this->UpdateThrottling())
+        // Check the filter and the throttling option of the subscription.
+        if (!_prefiltered &&
+            (!this->opts.Filter().Matches(_msg) || !this->UpdateThrottling()))
+        {
           return true;
+        }
 
 #if GOOGLE_PROTOBUF_VERSION >= 3000000
         auto msgPtr = google::protobuf::down_cast<const T*>(&_msg);
@@ -223,51 +323,89 @@ namespace ignition
 
       /// \brief Callback to the function registered for this handler.
       private: MsgCallback<T> cb;
+
+      /// \brief Message returned by the last call to CreateMsg(). It's
+      /// reused when CreateMsg() is called again and nobody else holds it.
+      private: mutable std::shared_ptr<T> recycledMsg;
+
+      /// \brief Mutex to protect recycledMsg.
+      private: mutable std::mutex recycledMsgMutex;
     };
 
     /// \brief Specialized template when the user prefers a callbacks that
     /// accepts a generic google::protobuf::message instead of a specific type.
     template <> class SubscriptionHandler<ProtoMsg>
-      : public ISubscriptionHandler
+      : public ISubscriptionHandler,
+        public InPlaceMsgParser
     {
       // Documentation inherited.
       public: explicit SubscriptionHandler(const std::string &_nUuid,
         const SubscribeOptions &_opts = SubscribeOptions())
         : ISubscriptionHandler(_nUuid, _opts)
       {
+        this->inPlaceParser = this;
       }
 
+      // Keep ISubscriptionHandler::CreateMsg(const char *, ...) visible.
+      public: using ISubscriptionHandler::CreateMsg;
+
       // Documentation inherited.
       public: const std::shared_ptr<ProtoMsg> CreateMsg(
         const std::string &_data,
         const std::string &_type) const
       {
-        std::shared_ptr<google::protobuf::Message> msgPtr;
+        return this->ParseMsg(_data.data(), _data.size(), _type);
+      }
 
-        const google::protobuf::Descriptor *desc =
-          google::protobuf::DescriptorPool::generated_pool()
-            ->FindMessageTypeByName(_type);
+      // Documentation inherited.
+      public: const std::shared_ptr<ProtoMsg> ParseMsg(
+        const char *_data,
+        const size_t _size,
+        const std::string &_type) const
+      {
+        std::shared_ptr<google::protobuf::Message> msgPtr;
 
-        // First, check if we have the descriptor from the generated proto
-        // classes.
-        if (desc)
+        // Reuse the message created in the previous call if it has the same
+        // type and nobody else is using it.
         {
-          msgPtr.reset(google::protobuf::MessageFactory::generated_factory()
-            ->GetPrototype(desc)->New());
-        }
-        else
-        {
-          // Fallback on Ignition Msgs if the message type is not found.
-          msgPtr = ignition::msgs::Factory::New(_type);
+          std::lock_guard<std::mutex> lk(this->recycledMsgMutex);
+          if (this->recycledMsg && this->recycledMsg.use_count() == 1 &&
+              this->recycledMsg->GetDescriptor()->full_name() == _type)
+          {
+            msgPtr = this->recycledMsg;
+          }
         }
 
         if (!msgPtr)
-          return nullptr;
+        {
+          const google::protobuf::Descriptor *desc =
+            google::protobuf::DescriptorPool::generated_pool()
+              ->FindMessageTypeByName(_type);
+
+          // First, check if we have the descriptor from the generated proto
+          // classes.
+          if (desc)
+          {
+            msgPtr.reset(google::protobuf::MessageFactory::generated_factory()
+              ->GetPrototype(desc)->New());
+          }
+          else
+          {
+            // Fallback on Ignition Msgs if the message type is not found.
+            msgPtr = ignition::msgs::Factory::New(_type);
+          }
+
+          if (!msgPtr)
+            return nullptr;
+
+          std::lock_guard<std::mutex> lk(this->recycledMsgMutex);
+          this->recycledMsg = msgPtr;
+        }
 
         // Create the message using some serialized data
-        if (!msgPtr->ParseFromString(_data))
+        if (!msgPtr->ParseFromArray(_data, static_cast<int>(_size)))
         {
-          std::cerr << "CreateMsg() error: ParseFromString failed" << std::endl;
+          std::cerr << "CreateMsg() error: ParseFromArray failed" << std::endl;
           return nullptr;
         }
 
@@ -289,7 +427,8 @@ namespace ignition
 
       // Documentation inherited.
       public: bool RunLocalCallback(const ProtoMsg &_msg,
-                                    const MessageInfo &_info)
+                                    const MessageInfo &_info,
+                                    const bool _prefiltered = false)
       {
         // No callback stored.
         if (!this->cb)
@@ -299,9 +438,12 @@ namespace ignition
           return false;
         }
 
-        // Check the subscription throttling option.
-        if (!this->UpdateThrottling())
+        // Check the filter and the throttling option of the subscription.
+        if (!_prefiltered &&
+            (!this->opts.Filter().Matches(_msg) || !this->UpdateThrottling()))
+        {
           return true;
+        }
 
         this->cb(_msg, _info);
         return true;
@@ -309,6 +451,14 @@ namespace ignition
 
       /// \brief Callback to the function registered for this handler.
       private: MsgCallback<ProtoMsg> cb;
+
+      /// \brief Message returned by the last call to CreateMsg(). It's
+      /// reused when CreateMsg() is called again with the same type and
+      /// nobody else holds it.
+      private: mutable std::shared_ptr<ProtoMsg> recycledMsg;
+
+      /// \brief Mutex to protect recycledMsg.
+      private: mutable std::mutex recycledMsgMutex;
     };
 
     //////////////////////////////////////////////////
@@ -339,10 +489,13 @@ namespace ignition
       /// \param[in] _msgData Serialized string of message data
       /// \param[in] _size Number of bytes in the serialized message data
       /// \param[in] _info Meta-data for the message
+      /// \param[in] _prefiltered True if the publisher already applied the
+      /// rate of this subscription to the message.
       /// \return True if the callback was triggered, false if the callback was
       /// not set.
       public: bool RunRawCallback(const char *_msgData, const size_t _size,
-                                  const MessageInfo &_info);
+                                  const MessageInfo &_info,
+                                  const bool _prefiltered = false);
 
       /// \brief Destructor
       public: ~RawSubscriptionHandler();
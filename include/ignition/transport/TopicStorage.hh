@@ -19,8 +19,10 @@
 #define IGN_TRANSPORT_TOPICSTORAGE_HH_
 
 #include <algorithm>
+#include <functional>
 #include <map>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "ignition/transport/config.hh"
@@ -37,7 +39,9 @@ namespace ignition
     //
     /// \class TopicStorage TopicStorage.hh ignition/transport/TopicStorage.hh
     /// \brief Store address information about topics and provide convenient
-    /// methods for adding new topics, removing them, etc.
+    /// methods for adding new topics, removing them, etc. Topics are stored
+    /// in a hash table, so looking up a topic doesn't depend on the number of
+    /// topics.
     template<typename T> class TopicStorage
     {
       /// \brief Constructor.
@@ -52,15 +56,8 @@ namespace ignition
       /// was already stored).
       public: bool AddPublisher(const T &_publisher)
       {
-        // The topic does not exist.
-        if (this->data.find(_publisher.Topic()) == this->data.end())
-        {
-          // VS2013 is buggy with initializer list here {}
-          this->data[_publisher.Topic()] =
-            std::map<std::string, std::vector<T>>();
-        }
-
-        // Check if the process uuid exists.
+        // Check if the process uuid exists. The topic is created if it does
+        // not exist.
         auto &m = this->data[_publisher.Topic()];
         if (m.find(_publisher.PUuid()) != m.end())
         {
@@ -100,13 +97,12 @@ namespace ignition
       public: bool HasTopic(const std::string &_topic,
                             const std::string &_type) const
       {
-        if (!this->HasTopic(_topic))
+        auto it = this->data.find(_topic);
+        if (it == this->data.end())
           return false;
 
-        // m is {pUUID=>std::vector<Publisher>}.
-        auto &m = this->data.at(_topic);
-
-        for (auto const &procs : m)
+        // it->second is {pUUID=>std::vector<Publisher>}.
+        for (auto const &procs : it->second)
         {
           // Vector of publishers for a given topic and pUuid.
           auto &v = procs.second;
@@ -125,6 +121,36 @@ namespace ignition
         return false;
       }
 
+      /// \brief Return if there is any publisher stored for the given topic and
+      /// type that also satisfies a condition.
+      /// \param[in] _topic Topic name.
+      /// \param[in] _type Topic type.
+      /// \param[in] _cond Function evaluated on every publisher of the topic
+      /// and type. It should return true if the publisher is a match.
+      /// \return True if there is at least one matching entry.
+      public: bool HasTopic(const std::string &_topic,
+                            const std::string &_type,
+                            const std::function<bool(const T &)> &_cond) const
+      {
+        auto it = this->data.find(_topic);
+        if (it == this->data.end())
+          return false;
+
+        for (auto const &procs : it->second)
+        {
+          for (auto const &pub : procs.second)
+          {
+            if ((pub.MsgTypeName() == _type ||
+                 pub.MsgTypeName() == kGenericMessageType) && _cond(pub))
+            {
+              return true;
+            }
+          }
+        }
+
+        return false;
+      }
+
       /// \brief Return if there is any publisher stored for the given topic and
       /// process UUID.
       /// \param[in] _topic Topic name.
@@ -134,11 +160,11 @@ namespace ignition
       public: bool HasAnyPublishers(const std::string &_topic,
                                     const std::string &_pUuid) const
       {
-        if (!this->HasTopic(_topic))
+        auto it = this->data.find(_topic);
+        if (it == this->data.end())
           return false;
 
-        return this->data.at(_topic).find(_pUuid) !=
-               this->data.at(_topic).end();
+        return it->second.find(_pUuid) != it->second.end();
       }
 
       /// \brief Return if the requested publisher's address is stored.
@@ -172,18 +198,19 @@ namespace ignition
                              T &_publisher) const
       {
         // Topic not found.
-        if (this->data.find(_topic) == this->data.end())
+        auto it = this->data.find(_topic);
+        if (it == this->data.end())
           return false;
 
-        // m is {pUUID=>Publisher}.
-        auto &m = this->data.at(_topic);
+        // it->second is {pUUID=>Publisher}.
+        auto proc = it->second.find(_pUuid);
 
         // pUuid not found.
-        if (m.find(_pUuid) == m.end())
+        if (proc == it->second.end())
           return false;
 
         // Vector of 0MQ known addresses for a given topic and pUuid.
-        auto &v = m.at(_pUuid);
+        auto &v = proc->second;
         auto found = std::find_if(v.begin(), v.end(),
           [&](const T &_pub)
           {
@@ -207,10 +234,11 @@ namespace ignition
       public: bool Publishers(const std::string &_topic,
                              std::map<std::string, std::vector<T>> &_info) const
       {
-        if (!this->HasTopic(_topic))
+        auto it = this->data.find(_topic);
+        if (it == this->data.end())
           return false;
 
-        _info = this->data.at(_topic);
+        _info = it->second;
         return true;
       }
 
@@ -226,16 +254,18 @@ namespace ignition
         size_t counter = 0;
 
         // Iterate over all the topics.
-        if (this->data.find(_topic) != this->data.end())
+        auto it = this->data.find(_topic);
+        if (it != this->data.end())
         {
           // m is {pUUID=>Publisher}.
-          auto &m = this->data[_topic];
+          auto &m = it->second;
 
           // The pUuid exists.
-          if (m.find(_pUuid) != m.end())
+          auto proc = m.find(_pUuid);
+          if (proc != m.end())
           {
             // Vector of 0MQ known addresses for a given topic and pUuid.
-            auto &v = m[_pUuid];
+            auto &v = proc->second;
             auto priorSize = v.size();
             v.erase(std::remove_if(v.begin(), v.end(),
               [&](const T &_pub)
@@ -246,10 +276,10 @@ namespace ignition
             counter = priorSize - v.size();
 
             if (v.empty())
-              m.erase(_pUuid);
+              m.erase(proc);
 
             if (m.empty())
-              this->data.erase(_topic);
+              this->data.erase(it);
           }
         }
 
@@ -270,7 +300,7 @@ namespace ignition
           auto &m = it->second;
           counter += m.erase(_pUuid);
           if (m.empty())
-            this->data.erase(it++);
+            it = this->data.erase(it);
           else
             ++it;
         }
@@ -335,11 +365,13 @@ namespace ignition
       }
 
       /// \brief Get the list of topics currently stored.
-      /// \param[out] _topics List of stored topics.
+      /// \param[out] _topics List of stored topics, in alphabetical order.
       public: void TopicList(std::vector<std::string> &_topics) const
       {
+        const auto first = static_cast<std::ptrdiff_t>(_topics.size());
         for (auto const &topic : this->data)
           _topics.push_back(topic.first);
+        std::sort(_topics.begin() + first, _topics.end());
       }
 
       /// \brief Print all the information for debugging purposes.
@@ -364,7 +396,7 @@ namespace ignition
 
       /// \brief The keys are topics. The values are another map, where the key
       /// is the process UUID and the value a vector of publishers.
-      private: std::map<std::string,
+      private: std::unordered_map<std::string,
                         std::map<std::string, std::vector<T>>> data;
     };
     }
@@ -180,6 +180,16 @@ namespace ignition
     /// \brief The high water mark of the send message buffer.
     /// \sa NodeShared::SndHwm
     const int kDefaultSndHwm = 1000;
+
+    /// \brief The capacity of the queue of messages published to
+    /// subscribers within the same process.
+    /// \sa NodeShared::PubQueueCapacity
+    const int kDefaultPubQueueSize = 10000;
+
+    /// \brief The maximum number of subscriber callbacks queued for each
+    /// topic when the callbacks run on worker threads.
+    /// \sa NodeOptions::SetCallbackThreads
+    const int kDefaultCallbackQueueSize = 1000;
     }
   }
 }
@@ -18,13 +18,39 @@
 #ifndef IGNITION_TRANSPORT_DETAIL_NODE_HH_
 #define IGNITION_TRANSPORT_DETAIL_NODE_HH_
 
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace ignition
 {
   namespace transport
   {
+    //////////////////////////////////////////////////
+    template<typename MessageT>
+    bool Node::Publisher::Publish(std::unique_ptr<MessageT> _msg)
+    {
+      return this->Publish(std::shared_ptr<const ProtoMsg>(std::move(_msg)));
+    }
+
+    //////////////////////////////////////////////////
+    template<typename MessageT>
+    bool Node::Publisher::PublishBatch(const std::vector<MessageT> &_msgs)
+    {
+      std::vector<const ProtoMsg *> msgs;
+      msgs.reserve(_msgs.size());
+      for (const MessageT &msg : _msgs)
+        msgs.push_back(&msg);
+      return this->PublishBatch(msgs);
+    }
+
     //////////////////////////////////////////////////
     template<typename MessageT>
     Node::Publisher Node::Advertise(
@@ -137,10 +163,14 @@ namespace ignition
       // associated with a topic. When the receiving thread gets new data,
       // it will recover the subscription handler associated to the topic and
       // will invoke the callback.
-      this->Shared()->localSubscribers.normal.AddHandler(
-        fullyQualifiedTopic, this->NodeUuid(), subscrHandlerPtr);
+      {
+        std::lock_guard<std::shared_mutex> subscribersLk(
+          this->Shared()->subscribersMutex);
+        this->Shared()->localSubscribers.normal.AddHandler(
+          fullyQualifiedTopic, this->NodeUuid(), subscrHandlerPtr);
+      }
 
-      return this->SubscribeHelper(fullyQualifiedTopic);
+      return this->SubscribeHelper(fullyQualifiedTopic, subscrHandlerPtr);
     }
 
     //////////////////////////////////////////////////
@@ -259,6 +289,11 @@ namespace ignition
       this->Shared()->repliers.AddHandler(
         fullyQualifiedTopic, this->NodeUuid(), repHandlerPtr);
 
+      // Requests for services with their own threads don't block the
+      // reception thread.
+      this->Shared()->AddReplierWorkers(repHandlerPtr->HandlerUuid(),
+        _options);
+
       // Notify the discovery service to register and advertise my responser.
       ServicePublisher publisher(fullyQualifiedTopic,
         this->Shared()->myReplierAddress,
@@ -447,7 +482,7 @@ namespace ignition
         std::lock_guard<std::recursive_mutex> lk(this->Shared()->mutex);
 
         // Store the request handler.
-        this->Shared()->requests.AddHandler(
+        this->Shared()->AddRequest(
           fullyQualifiedTopic, this->NodeUuid(), reqHandlerPtr);
 
         // If the responser's address is known, make the request.
@@ -556,7 +591,7 @@ namespace ignition
       }
 
       // Store the request handler.
-      this->Shared()->requests.AddHandler(
+      this->Shared()->AddRequest(
         fullyQualifiedTopic, this->NodeUuid(), reqHandlerPtr);
 
       // If the responser's address is known, make the request.
@@ -575,6 +610,8 @@ namespace ignition
                     << topic
                     << "]. Did you forget to start the discovery service?"
                     << std::endl;
+          this->Shared()->RemoveRequest(fullyQualifiedTopic,
+            this->NodeUuid(), reqHandlerPtr->HandlerUuid());
           return false;
         }
       }
@@ -582,9 +619,14 @@ namespace ignition
       // Wait until the REP is available.
       bool executed = reqHandlerPtr->WaitUntil(lk, _timeout);
 
-      // The request was not executed.
+      // The request was not executed. Forget it, a late response is
+      // discarded.
       if (!executed)
+      {
+        this->Shared()->RemoveRequest(fullyQualifiedTopic,
+          this->NodeUuid(), reqHandlerPtr->HandlerUuid());
         return false;
+      }
 
       // The request was executed but did not succeed.
       if (!reqHandlerPtr->Result())
@@ -618,6 +660,365 @@ namespace ignition
       return this->Request(_topic, req, _timeout, _reply, _result);
     }
 
+    //////////////////////////////////////////////////
+    template<typename ReplyT, typename RequestT>
+    RequestFuture<ReplyT> Node::RequestAsync(
+      const std::string &_topic,
+      const RequestT &_request,
+      const unsigned int _timeout)
+    {
+      return this->RequestAsyncHelper<ReplyT>(_topic, _request, _timeout);
+    }
+
+    //////////////////////////////////////////////////
+    template<typename ReplyT, typename RequestT>
+    RequestFuture<ReplyT> Node::RequestAsync(
+      const std::string &_topic,
+      const RequestT &_request)
+    {
+      return this->RequestAsyncHelper<ReplyT>(
+        _topic, _request, std::nullopt);
+    }
+
+    //////////////////////////////////////////////////
+    template<typename ReplyT, typename RequestT>
+    RequestFuture<ReplyT> Node::RequestAsyncHelper(
+      const std::string &_topic,
+      const RequestT &_request,
+      const std::optional<unsigned int> &_timeout)
+    {
+      auto state = std::make_shared<RequestState<ReplyT>>();
+      RequestFuture<ReplyT> future(state);
+
+      // Topic remapping.
+      std::string topic = _topic;
+      this->Options().TopicRemap(_topic, topic);
+
+      std::string fullyQualifiedTopic;
+      if (!TopicUtils::FullyQualifiedName(this->Options().Partition(),
+        this->Options().NameSpace(), topic, fullyQualifiedTopic))
+      {
+        std::cerr << "Service [" << topic << "] is not valid." << std::endl;
+        state->Complete(RequestStatus::NOT_SENT);
+        return future;
+      }
+
+      bool localResponserFound;
+      IRepHandlerPtr repHandler;
+      {
+        std::lock_guard<std::recursive_mutex> lk(this->Shared()->mutex);
+        localResponserFound = this->Shared()->repliers.FirstHandler(
+              fullyQualifiedTopic,
+              RequestT().GetTypeName(),
+              ReplyT().GetTypeName(),
+              repHandler);
+      }
+
+      // If the responser is within my process.
+      if (localResponserFound)
+      {
+        // There is a responser in my process, let's use it.
+        ReplyT rep;
+        bool result = repHandler->RunLocalCallback(_request, rep);
+        state->Complete(
+          result ? RequestStatus::SUCCEEDED : RequestStatus::FAILED, rep);
+        return future;
+      }
+
+      // Create a new request handler.
+      std::shared_ptr<ReqHandler<RequestT, ReplyT>> reqHandlerPtr(
+        new ReqHandler<RequestT, ReplyT>(this->NodeUuid()));
+
+      // Insert the request's parameters.
+      reqHandlerPtr->SetMessage(&_request);
+
+      // The response completes the future. It's discarded if the request
+      // was cancelled or timed out before.
+      reqHandlerPtr->SetCallback(
+        [state](const ReplyT &_rep, const bool _result)
+        {
+          state->Complete(
+            _result ? RequestStatus::SUCCEEDED : RequestStatus::FAILED, _rep);
+        });
+
+      // Forget the request when it's cancelled or times out.
+      NodeShared *shared = this->Shared();
+      std::string nUuid = this->NodeUuid();
+      std::string hUuid = reqHandlerPtr->HandlerUuid();
+      state->OnCancel([shared, fullyQualifiedTopic, nUuid, hUuid]
+        {
+          std::lock_guard<std::recursive_mutex> lk(shared->mutex);
+          shared->RemoveRequest(fullyQualifiedTopic, nUuid, hUuid);
+        });
+
+      {
+        std::lock_guard<std::recursive_mutex> lk(this->Shared()->mutex);
+
+        // Store the request handler.
+        this->Shared()->AddRequest(
+          fullyQualifiedTopic, this->NodeUuid(), reqHandlerPtr);
+
+        // If the responser's address is known, make the request.
+        SrvAddresses_M addresses;
+        if (this->Shared()->TopicPublishers(fullyQualifiedTopic, addresses))
+        {
+          this->Shared()->SendPendingRemoteReqs(fullyQualifiedTopic,
+            RequestT().GetTypeName(), ReplyT().GetTypeName());
+        }
+        else
+        {
+          // Discover the service responser.
+          if (!this->Shared()->DiscoverService(fullyQualifiedTopic))
+          {
+            std::cerr << "Node::RequestAsync(): Error discovering service ["
+                      << topic
+                      << "]. Did you forget to start the discovery service?"
+                      << std::endl;
+            this->Shared()->RemoveRequest(
+              fullyQualifiedTopic, nUuid, hUuid);
+            state->Complete(RequestStatus::NOT_SENT);
+            return future;
+          }
+        }
+      }
+
+      // The reception thread expires the request once the deadline passes,
+      // without blocking anybody in the meantime.
+      if (_timeout)
+      {
+        std::weak_ptr<RequestState<ReplyT>> weakState = state;
+        shared->ScheduleTimer(
+          std::chrono::steady_clock::now() +
+            std::chrono::milliseconds(*_timeout),
+          [weakState]
+          {
+            if (auto expired = weakState.lock())
+              expired->Cancel(RequestStatus::TIMED_OUT);
+          });
+      }
+
+      return future;
+    }
+
+    //////////////////////////////////////////////////
+    template<typename ReplyT, typename RequestT>
+    RequestFuture<std::vector<ServiceReply<ReplyT>>> Node::RequestAll(
+      const std::string &_topic,
+      const RequestT &_request,
+      const unsigned int _timeout,
+      const unsigned int _replies)
+    {
+      using RepliesT = std::vector<ServiceReply<ReplyT>>;
+      auto state = std::make_shared<RequestState<RepliesT>>();
+      RequestFuture<RepliesT> future(state);
+
+      // Topic remapping.
+      std::string topic = _topic;
+      this->Options().TopicRemap(_topic, topic);
+
+      std::string fullyQualifiedTopic;
+      if (!TopicUtils::FullyQualifiedName(this->Options().Partition(),
+        this->Options().NameSpace(), topic, fullyQualifiedTopic))
+      {
+        std::cerr << "Service [" << topic << "] is not valid." << std::endl;
+        state->Complete(RequestStatus::NOT_SENT);
+        return future;
+      }
+
+      NodeShared *shared = this->Shared();
+      std::string nUuid = this->NodeUuid();
+      const std::string reqType = RequestT().GetTypeName();
+      const std::string repType = ReplyT().GetTypeName();
+
+      // Declare the interest in the service before looking up its
+      // responsers, so the discovery keeps them when it only stores the
+      // services used by this process. It also asks the other processes for
+      // the service. The ones that didn't answer yet aren't waited for.
+      shared->DiscoverService(fullyQualifiedTopic);
+
+      // The responser within my process, if any, runs the request directly.
+      IRepHandlerPtr repHandler;
+      std::string repNUuid;
+      {
+        std::lock_guard<std::recursive_mutex> lk(shared->mutex);
+        std::map<std::string, std::map<std::string, IRepHandlerPtr>> local;
+        shared->repliers.Handlers(fullyQualifiedTopic, local);
+        for (const auto &node : local)
+        {
+          for (const auto &handler : node.second)
+          {
+            if (!repHandler &&
+                handler.second->ReqTypeName() == reqType &&
+                handler.second->RepTypeName() == repType)
+            {
+              repHandler = handler.second;
+              repNUuid = node.first;
+            }
+          }
+        }
+      }
+
+      // A single request per remote process offering the service with these
+      // types.
+      std::optional<ServicePublisher> localResponser;
+      std::vector<ServicePublisher> responsers;
+      SrvAddresses_M addresses;
+      shared->TopicPublishers(fullyQualifiedTopic, addresses);
+      for (const auto &proc : addresses)
+      {
+        for (const auto &pub : proc.second)
+        {
+          if (pub.ReqTypeName() != reqType || pub.RepTypeName() != repType)
+            continue;
+
+          if (proc.first == shared->pUuid)
+          {
+            if (repHandler && pub.NUuid() == repNUuid)
+              localResponser = pub;
+            continue;
+          }
+
+          if (std::none_of(responsers.begin(), responsers.end(),
+                [&pub](const ServicePublisher &_r)
+                {
+                  return _r.Addr() == pub.Addr();
+                }))
+          {
+            responsers.push_back(pub);
+          }
+        }
+      }
+
+      if (repHandler && !localResponser)
+      {
+        localResponser = ServicePublisher(fullyQualifiedTopic,
+          shared->myReplierAddress, shared->replierId.ToString(),
+          shared->pUuid, repNUuid, reqType, repType,
+          AdvertiseServiceOptions());
+      }
+
+      const std::size_t total = responsers.size() + (repHandler ? 1u : 0u);
+      if (total == 0)
+      {
+        state->Complete(RequestStatus::NOT_SENT);
+        return future;
+      }
+
+      // Responses collected so far.
+      struct Gather
+      {
+        std::mutex mutex;
+        RepliesT replies;
+        std::size_t quorum;
+
+        // UUIDs of the request handlers waiting for a response.
+        std::vector<std::string> waiting;
+      };
+      auto gather = std::make_shared<Gather>();
+      gather->quorum = total;
+      if (_replies > 0 && _replies < total)
+        gather->quorum = _replies;
+
+      // Stop waiting: forget the handlers that didn't receive a response and
+      // complete the request, unless it was already completed.
+      std::function<void(const RequestStatus)> finish =
+        [state, gather, shared, fullyQualifiedTopic, nUuid](
+          const RequestStatus _status)
+        {
+          std::vector<std::string> waiting;
+          RepliesT replies;
+          {
+            std::lock_guard<std::mutex> lk(gather->mutex);
+            waiting.swap(gather->waiting);
+            replies = gather->replies;
+          }
+
+          {
+            std::lock_guard<std::recursive_mutex> lk(shared->mutex);
+            for (const auto &hUuid : waiting)
+              shared->RemoveRequest(fullyQualifiedTopic, nUuid, hUuid);
+          }
+
+          state->Complete(_status, replies);
+        };
+      state->OnCancel([finish]{finish(RequestStatus::CANCELLED);});
+
+      if (repHandler)
+      {
+        ServiceReply<ReplyT> reply;
+        reply.responser = *localResponser;
+        reply.result = repHandler->RunLocalCallback(_request, reply.reply);
+        gather->replies.push_back(reply);
+
+        // Enough with the local response.
+        if (gather->replies.size() >= gather->quorum)
+        {
+          finish(RequestStatus::SUCCEEDED);
+          return future;
+        }
+      }
+
+      std::vector<std::shared_ptr<ReqHandler<RequestT, ReplyT>>> handlers;
+      for (const auto &responser : responsers)
+      {
+        std::shared_ptr<ReqHandler<RequestT, ReplyT>> reqHandlerPtr(
+          new ReqHandler<RequestT, ReplyT>(nUuid));
+        reqHandlerPtr->SetMessage(&_request);
+        reqHandlerPtr->Responser(responser.Addr());
+
+        std::string hUuid = reqHandlerPtr->HandlerUuid();
+        reqHandlerPtr->SetCallback(
+          [gather, finish, responser, hUuid](
+            const ReplyT &_rep, const bool _result)
+          {
+            bool done;
+            {
+              std::lock_guard<std::mutex> lk(gather->mutex);
+              auto it = std::find(
+                gather->waiting.begin(), gather->waiting.end(), hUuid);
+
+              // The request already completed.
+              if (it == gather->waiting.end())
+                return;
+
+              gather->waiting.erase(it);
+              ServiceReply<ReplyT> reply;
+              reply.responser = responser;
+              reply.result = _result;
+              reply.reply = _rep;
+              gather->replies.push_back(reply);
+              done = gather->replies.size() >= gather->quorum;
+            }
+
+            if (done)
+              finish(RequestStatus::SUCCEEDED);
+          });
+
+        gather->waiting.push_back(hUuid);
+        handlers.push_back(reqHandlerPtr);
+      }
+
+      {
+        std::lock_guard<std::recursive_mutex> lk(shared->mutex);
+
+        // Store the request handlers and send all of them back to back.
+        for (const auto &reqHandlerPtr : handlers)
+        {
+          shared->AddRequest(
+            fullyQualifiedTopic, nUuid, reqHandlerPtr);
+        }
+
+        shared->SendPendingRemoteReqs(fullyQualifiedTopic, reqType, repType);
+      }
+
+      shared->ScheduleTimer(
+        std::chrono::steady_clock::now() +
+          std::chrono::milliseconds(_timeout),
+        [finish]{finish(RequestStatus::TIMED_OUT);});
+
+      return future;
+    }
+
     //////////////////////////////////////////////////
     template<typename RequestT>
     bool Node::Request(
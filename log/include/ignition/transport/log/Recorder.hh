@@ -95,6 +95,9 @@ namespace ignition
         ///       These subscriptions will be kept until this is destructed.
         ///       New topics that match the pattern will be added as they
         ///       appear, including while recording is active.
+        /// \note The process keeps all the topics of the network from now
+        ///       on, even if IGN_TRANSPORT_DISCOVERY_INTEREST is set. See
+        ///       NodeShared::EnableFullCatalog().
         /// \return number of topics subscribed or negative number on error
         public: int64_t AddTopic(const std::regex &_topic);
 
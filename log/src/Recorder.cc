@@ -34,6 +34,7 @@
 #include <ignition/transport/log/Recorder.hh>
 #include <ignition/transport/MessageInfo.hh>
 #include <ignition/transport/Node.hh>
+#include <ignition/transport/NodeShared.hh>
 #include <ignition/transport/TransportTypes.hh>
 
 #include "Console.hh"
@@ -303,6 +304,10 @@ RecorderError Recorder::Implementation::AddTopic(const std::string &_topic)
 //////////////////////////////////////////////////
 int64_t Recorder::Implementation::AddTopic(const std::regex &_pattern)
 {
+  // The pattern may match topics that this process wouldn't keep, see
+  // IGN_TRANSPORT_DISCOVERY_INTEREST.
+  NodeShared::Instance()->EnableFullCatalog();
+
   int numSubscriptions = 0;
   std::vector<std::string> allTopics;
   this->node.TopicList(allTopics);
@@ -18,6 +18,7 @@
 #include <cstdint>
 #include <cstring>
 #include <iostream>
+#include <string>
 
 #include "ignition/transport/AdvertiseOptions.hh"
 #include "ignition/transport/Helpers.hh"
@@ -57,6 +58,18 @@ namespace ignition
 
       /// \brief Default message publication rate.
       public: uint64_t msgsPerSec = kUnthrottled;
+
+      /// \brief Name of the codec or empty when not compressing.
+      public: std::string compression;
+
+      /// \brief Compression level.
+      public: int compressionLevel = 0;
+
+      /// \brief Minimum size of a message to compress it.
+      public: uint64_t compressionThreshold = 1024;
+
+      /// \brief Number of messages kept for the late subscribers.
+      public: uint64_t latchDepth = 0;
     };
 
     /// \internal
@@ -68,6 +81,12 @@ namespace ignition
 
       /// \brief Destructor.
       public: virtual ~AdvertiseServiceOptionsPrivate() = default;
+
+      /// \brief Number of worker threads dedicated to the service.
+      public: unsigned int threads = 0;
+
+      /// \brief Maximum number of requests queued or running.
+      public: unsigned int maxInFlight = 0;
     };
     }
   }
@@ -148,6 +167,9 @@ AdvertiseMessageOptions &AdvertiseMessageOptions::operator=(
 {
   AdvertiseOptions::operator=(_other);
   this->SetMsgsPerSec(_other.MsgsPerSec());
+  this->SetCompression(_other.Compression(), _other.CompressionLevel());
+  this->SetCompressionThreshold(_other.CompressionThreshold());
+  this->SetLatchDepth(_other.LatchDepth());
   return *this;
 }
 
@@ -156,7 +178,11 @@ bool AdvertiseMessageOptions::operator==(
   const AdvertiseMessageOptions &_other) const
 {
   return AdvertiseOptions::operator==(_other) &&
-         this->MsgsPerSec() == _other.MsgsPerSec();
+         this->MsgsPerSec() == _other.MsgsPerSec() &&
+         this->Compression() == _other.Compression() &&
+         this->CompressionLevel() == _other.CompressionLevel() &&
+         this->CompressionThreshold() == _other.CompressionThreshold() &&
+         this->LatchDepth() == _other.LatchDepth();
 }
 
 //////////////////////////////////////////////////
@@ -184,6 +210,56 @@ void AdvertiseMessageOptions::SetMsgsPerSec(const uint64_t _newMsgsPerSec)
   this->dataPtr->msgsPerSec = _newMsgsPerSec;
 }
 
+//////////////////////////////////////////////////
+std::string AdvertiseMessageOptions::Compression() const
+{
+  return this->dataPtr->compression;
+}
+
+//////////////////////////////////////////////////
+int AdvertiseMessageOptions::CompressionLevel() const
+{
+  return this->dataPtr->compressionLevel;
+}
+
+//////////////////////////////////////////////////
+void AdvertiseMessageOptions::SetCompression(const std::string &_codec,
+  const int _level)
+{
+  this->dataPtr->compression = _codec;
+  this->dataPtr->compressionLevel = _level;
+}
+
+//////////////////////////////////////////////////
+uint64_t AdvertiseMessageOptions::CompressionThreshold() const
+{
+  return this->dataPtr->compressionThreshold;
+}
+
+//////////////////////////////////////////////////
+void AdvertiseMessageOptions::SetCompressionThreshold(const uint64_t _bytes)
+{
+  this->dataPtr->compressionThreshold = _bytes;
+}
+
+//////////////////////////////////////////////////
+bool AdvertiseMessageOptions::Latched() const
+{
+  return this->LatchDepth() > 0;
+}
+
+//////////////////////////////////////////////////
+uint64_t AdvertiseMessageOptions::LatchDepth() const
+{
+  return this->dataPtr->latchDepth;
+}
+
+//////////////////////////////////////////////////
+void AdvertiseMessageOptions::SetLatchDepth(const uint64_t _depth)
+{
+  this->dataPtr->latchDepth = _depth;
+}
+
 //////////////////////////////////////////////////
 AdvertiseServiceOptions::AdvertiseServiceOptions()
   : AdvertiseOptions(),
@@ -209,6 +285,8 @@ AdvertiseServiceOptions &AdvertiseServiceOptions::operator=(
   const AdvertiseServiceOptions &_other)
 {
   AdvertiseOptions::operator=(_other);
+  this->SetThreads(_other.Threads());
+  this->SetMaxInFlight(_other.MaxInFlight());
   return *this;
 }
 
@@ -216,7 +294,9 @@ AdvertiseServiceOptions &AdvertiseServiceOptions::operator=(
 bool AdvertiseServiceOptions::operator==(
   const AdvertiseServiceOptions &_other) const
 {
-  return AdvertiseOptions::operator==(_other);
+  return AdvertiseOptions::operator==(_other) &&
+         this->Threads() == _other.Threads() &&
+         this->MaxInFlight() == _other.MaxInFlight();
 }
 
 //////////////////////////////////////////////////
@@ -225,3 +305,27 @@ bool AdvertiseServiceOptions::operator!=(
 {
   return !(*this == _other);
 }
+
+//////////////////////////////////////////////////
+unsigned int AdvertiseServiceOptions::Threads() const
+{
+  return this->dataPtr->threads;
+}
+
+//////////////////////////////////////////////////
+void AdvertiseServiceOptions::SetThreads(const unsigned int _threads)
+{
+  this->dataPtr->threads = _threads;
+}
+
+//////////////////////////////////////////////////
+unsigned int AdvertiseServiceOptions::MaxInFlight() const
+{
+  return this->dataPtr->maxInFlight;
+}
+
+//////////////////////////////////////////////////
+void AdvertiseServiceOptions::SetMaxInFlight(const unsigned int _maxInFlight)
+{
+  this->dataPtr->maxInFlight = _maxInFlight;
+}
@@ -102,6 +102,11 @@ TEST(AdvertiseOptionsTest, msgDefConstructor)
   EXPECT_EQ(opts.Scope(), Scope_t::ALL);
   EXPECT_FALSE(opts.Throttled());
   EXPECT_EQ(opts.MsgsPerSec(), kUnthrottled);
+  EXPECT_TRUE(opts.Compression().empty());
+  EXPECT_EQ(opts.CompressionLevel(), 0);
+  EXPECT_EQ(opts.CompressionThreshold(), 1024u);
+  EXPECT_FALSE(opts.Latched());
+  EXPECT_EQ(opts.LatchDepth(), 0u);
 }
 
 //////////////////////////////////////////////////
@@ -111,6 +116,9 @@ TEST(AdvertiseOptionsTest, msgCopyConstructor)
   AdvertiseMessageOptions opts1;
   opts1.SetScope(Scope_t::HOST);
   opts1.SetMsgsPerSec(10u);
+  opts1.SetCompression("zstd", 3);
+  opts1.SetCompressionThreshold(256u);
+  opts1.SetLatchDepth(2u);
   AdvertiseMessageOptions opts2(opts1);
   EXPECT_EQ(opts1, opts2);
 }
@@ -123,6 +131,9 @@ TEST(AdvertiseOptionsTest, msgAssignmentOp)
   AdvertiseMessageOptions opts2;
   opts1.SetScope(Scope_t::PROCESS);
   opts1.SetMsgsPerSec(10u);
+  opts1.SetCompression("zstd", 3);
+  opts1.SetCompressionThreshold(256u);
+  opts1.SetLatchDepth(2u);
   opts2 = opts1;
   EXPECT_EQ(opts1, opts2);
 }
@@ -141,6 +152,19 @@ TEST(AdvertiseOptionsTest, msgEqualityOp)
   opts2.SetMsgsPerSec(10u);
   EXPECT_TRUE(opts1 == opts2);
   EXPECT_FALSE(opts1 != opts2);
+
+  opts1.SetCompression("zstd");
+  EXPECT_TRUE(opts1 != opts2);
+  opts2.SetCompression("zstd", 3);
+  EXPECT_TRUE(opts1 != opts2);
+  opts1.SetCompression("zstd", 3);
+  EXPECT_TRUE(opts1 == opts2);
+  opts1.SetCompressionThreshold(256u);
+  EXPECT_TRUE(opts1 != opts2);
+  opts2.SetCompressionThreshold(256u);
+  EXPECT_TRUE(opts1 == opts2);
+  opts1.SetLatchDepth(1u);
+  EXPECT_TRUE(opts1 != opts2);
 }
 
 //////////////////////////////////////////////////
@@ -166,6 +190,31 @@ TEST(AdvertiseOptionsTest, msgStreamInsertion)
     "\tThrottled? Yes\n"
     "\tRate: 10 msgs/sec\n";
   EXPECT_EQ(output.str(), expectedOutput);
+
+  output.clear();
+  output.str("");
+  opts.SetCompression("zstd", 3);
+  output << opts;
+  expectedOutput =
+    "Advertise options:\n"
+    "\tScope: All\n"
+    "\tThrottled? Yes\n"
+    "\tRate: 10 msgs/sec\n"
+    "\tCompression: zstd (level 3, from 1024 bytes)\n";
+  EXPECT_EQ(output.str(), expectedOutput);
+
+  output.clear();
+  output.str("");
+  opts.SetLatchDepth(1u);
+  output << opts;
+  expectedOutput =
+    "Advertise options:\n"
+    "\tScope: All\n"
+    "\tThrottled? Yes\n"
+    "\tRate: 10 msgs/sec\n"
+    "\tCompression: zstd (level 3, from 1024 bytes)\n"
+    "\tLatch depth: 1\n";
+  EXPECT_EQ(output.str(), expectedOutput);
 }
 
 //////////////////////////////////////////////////
@@ -184,6 +233,23 @@ TEST(AdvertiseOptionsTest, msgAccessors)
   opts.SetMsgsPerSec(10u);
   EXPECT_EQ(opts.MsgsPerSec(), 10u);
   EXPECT_TRUE(opts.Throttled());
+
+  // Compression.
+  opts.SetCompression("lz4", 9);
+  EXPECT_EQ(opts.Compression(), "lz4");
+  EXPECT_EQ(opts.CompressionLevel(), 9);
+  opts.SetCompression("");
+  EXPECT_TRUE(opts.Compression().empty());
+  EXPECT_EQ(opts.CompressionLevel(), 0);
+  opts.SetCompressionThreshold(0u);
+  EXPECT_EQ(opts.CompressionThreshold(), 0u);
+
+  // Latch depth.
+  opts.SetLatchDepth(5u);
+  EXPECT_EQ(opts.LatchDepth(), 5u);
+  EXPECT_TRUE(opts.Latched());
+  opts.SetLatchDepth(0u);
+  EXPECT_FALSE(opts.Latched());
 }
 
 //////////////////////////////////////////////////
@@ -192,6 +258,8 @@ TEST(AdvertiseOptionsTest, srvDefConstructor)
 {
   AdvertiseServiceOptions opts;
   EXPECT_EQ(opts.Scope(), Scope_t::ALL);
+  EXPECT_EQ(opts.Threads(), 0u);
+  EXPECT_EQ(opts.MaxInFlight(), 0u);
 }
 
 //////////////////////////////////////////////////
@@ -200,6 +268,8 @@ TEST(AdvertiseOptionsTest, srvCopyConstructor)
 {
   AdvertiseServiceOptions opts1;
   opts1.SetScope(Scope_t::HOST);
+  opts1.SetThreads(2u);
+  opts1.SetMaxInFlight(4u);
   AdvertiseServiceOptions opts2(opts1);
   EXPECT_EQ(opts1, opts2);
 }
@@ -211,6 +281,8 @@ TEST(AdvertiseOptionsTest, srvAssignmentOp)
   AdvertiseServiceOptions opts1;
   AdvertiseServiceOptions opts2;
   opts1.SetScope(Scope_t::PROCESS);
+  opts1.SetThreads(2u);
+  opts1.SetMaxInFlight(4u);
   opts2 = opts1;
   EXPECT_EQ(opts1, opts2);
 }
@@ -227,6 +299,14 @@ TEST(AdvertiseOptionsTest, srvEqualityOp)
   opts2.SetScope(Scope_t::PROCESS);
   EXPECT_TRUE(opts1 == opts2);
   EXPECT_FALSE(opts1 != opts2);
+  opts1.SetThreads(2u);
+  EXPECT_FALSE(opts1 == opts2);
+  opts2.SetThreads(2u);
+  EXPECT_TRUE(opts1 == opts2);
+  opts1.SetMaxInFlight(4u);
+  EXPECT_FALSE(opts1 == opts2);
+  opts2.SetMaxInFlight(4u);
+  EXPECT_TRUE(opts1 == opts2);
 }
 
 //////////////////////////////////////////////////
@@ -240,6 +320,17 @@ TEST(AdvertiseOptionsTest, srvStreamInsertion)
     "Advertise options:\n"
     "\tScope: All\n";
   EXPECT_EQ(output.str(), expectedOutput);
+
+  opts.SetThreads(2u);
+  opts.SetMaxInFlight(4u);
+  std::ostringstream threadsOutput;
+  threadsOutput << opts;
+  expectedOutput =
+    "Advertise options:\n"
+    "\tScope: All\n"
+    "\tThreads: 2\n"
+    "\tMax in-flight requests: 4\n";
+  EXPECT_EQ(threadsOutput.str(), expectedOutput);
 }
 
 //////////////////////////////////////////////////
@@ -251,6 +342,14 @@ TEST(AdvertiseOptionsTest, srvAccessors)
   EXPECT_EQ(opts.Scope(), Scope_t::ALL);
   opts.SetScope(Scope_t::HOST);
   EXPECT_EQ(opts.Scope(), Scope_t::HOST);
+
+  // Threads.
+  opts.SetThreads(3u);
+  EXPECT_EQ(opts.Threads(), 3u);
+
+  // Max in-flight requests.
+  opts.SetMaxInFlight(5u);
+  EXPECT_EQ(opts.MaxInFlight(), 5u);
 }
 
 //////////////////////////////////////////////////
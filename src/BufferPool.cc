@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <cstring>
+
+#include "BufferPool.hh"
+
+using namespace ignition;
+using namespace transport;
+
+//////////////////////////////////////////////////
+BufferPool::BufferPool()
+{
+  // Releasing a buffer never allocates.
+  for (auto &freeList : this->freeLists)
+    freeList.reserve(kMaxFreeBuffers);
+}
+
+//////////////////////////////////////////////////
+BufferPool::~BufferPool()
+{
+  for (auto &freeList : this->freeLists)
+  {
+    for (char *block : freeList)
+      delete[] block;
+  }
+}
+
+//////////////////////////////////////////////////
+char *BufferPool::Acquire(const std::size_t _size)
+{
+  // Find the smallest size class that fits.
+  uint32_t sizeClass = 0;
+  std::size_t classSize = kMinBufferSize;
+  while (classSize < _size && sizeClass < kSizeClasses)
+  {
+    classSize *= 2;
+    ++sizeClass;
+  }
+
+  char *block = nullptr;
+  if (sizeClass >= kSizeClasses)
+  {
+    sizeClass = kUnpooled;
+    classSize = _size;
+  }
+  else
+  {
+    std::lock_guard<std::mutex> lk(this->mutex);
+    auto &freeList = this->freeLists[sizeClass];
+    if (!freeList.empty())
+    {
+      block = freeList.back();
+      freeList.pop_back();
+    }
+  }
+
+  if (!block)
+  {
+    block = new char[kHeaderSize + classSize];
+    memcpy(block, &sizeClass, sizeof(sizeClass));
+
+    std::lock_guard<std::mutex> lk(this->mutex);
+    ++this->allocations;
+  }
+
+  return block + kHeaderSize;
+}
+
+//////////////////////////////////////////////////
+void BufferPool::Release(const char *_buffer)
+{
+  if (!_buffer)
+    return;
+
+  char *block = const_cast<char *>(_buffer) - kHeaderSize;
+  uint32_t sizeClass;
+  memcpy(&sizeClass, block, sizeof(sizeClass));
+
+  if (sizeClass < kSizeClasses)
+  {
+    std::lock_guard<std::mutex> lk(this->mutex);
+    auto &freeList = this->freeLists[sizeClass];
+    if (freeList.size() < kMaxFreeBuffers)
+    {
+      freeList.push_back(block);
+      return;
+    }
+  }
+
+  delete[] block;
+}
+
+//////////////////////////////////////////////////
+void BufferPool::Deallocate(void *_buffer, void *_hint)
+{
+  static_cast<BufferPool *>(_hint)->Release(static_cast<char *>(_buffer));
+}
+
+//////////////////////////////////////////////////
+uint64_t BufferPool::Allocations() const
+{
+  std::lock_guard<std::mutex> lk(this->mutex);
+  return this->allocations;
+}
+
+//////////////////////////////////////////////////
+std::size_t BufferPool::FreeBuffers() const
+{
+  std::lock_guard<std::mutex> lk(this->mutex);
+  std::size_t count = 0;
+  for (const auto &freeList : this->freeLists)
+    count += freeList.size();
+  return count;
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef IGN_TRANSPORT_BUFFERPOOL_HH_
+#define IGN_TRANSPORT_BUFFERPOOL_HH_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "ignition/transport/config.hh"
+#include "ignition/transport/Export.hh"
+
+namespace ignition
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace IGNITION_TRANSPORT_VERSION_NAMESPACE {
+    //
+    /// \internal
+    /// \brief A pool of buffers used to serialize outgoing messages. Buffers
+    /// are grouped in power of two size classes, so a stream of messages of
+    /// similar size keeps reusing the same few buffers instead of allocating
+    /// a new one per message. Buffers can be released from any thread, e.g.:
+    /// the ZeroMQ I/O thread when a message has been sent.
+    class IGNITION_TRANSPORT_VISIBLE BufferPool
+    {
+      /// \brief Size of the smallest size class (bytes).
+      public: static const std::size_t kMinBufferSize = 64;
+
+      /// \brief Size of the largest size class (bytes). Larger buffers are
+      /// allocated and freed every time.
+      public: static const std::size_t kMaxBufferSize = 16 * 1024 * 1024;
+
+      /// \brief Maximum number of free buffers kept per size class.
+      public: static const std::size_t kMaxFreeBuffers = 16;
+
+      /// \brief Constructor.
+      public: BufferPool();
+
+      /// \brief Destructor. Frees the buffers in the pool. Buffers still in
+      /// use must be released before destroying the pool.
+      public: ~BufferPool();
+
+      /// \brief Get a buffer.
+      /// \param[in] _size Minimum size of the buffer (bytes).
+      /// \return Pointer to the buffer. It has to be returned with Release().
+      public: char *Acquire(const std::size_t _size);
+
+      /// \brief Return a buffer obtained with Acquire() to the pool.
+      /// \param[in] _buffer The buffer.
+      public: void Release(const char *_buffer);
+
+      /// \brief ZeroMQ deallocation function that returns a buffer to the
+      /// pool passed as hint.
+      /// \param[in] _buffer The buffer.
+      /// \param[in] _hint Pointer to the BufferPool.
+      public: static void Deallocate(void *_buffer, void *_hint);
+
+      /// \brief Get the number of buffers allocated from the heap so far.
+      /// \return The number of allocations.
+      public: uint64_t Allocations() const;
+
+      /// \brief Get the number of free buffers in the pool.
+      /// \return The number of free buffers.
+      public: std::size_t FreeBuffers() const;
+
+      /// \brief Number of size classes.
+      private: static const std::size_t kSizeClasses = 19;
+
+      /// \brief Index used for buffers that don't belong to a size class.
+      private: static const uint32_t kUnpooled = UINT32_MAX;
+
+      /// \brief Bytes reserved before each buffer to store its size class.
+      /// It keeps the buffer aligned as if returned by new.
+      private: static const std::size_t kHeaderSize =
+        alignof(std::max_align_t);
+
+      /// \brief Protects the free lists and the counters.
+      private: mutable std::mutex mutex;
+
+      /// \brief Free buffers of each size class. The pointers point to the
+      /// start of the allocation, including the header.
+      private: std::array<std::vector<char *>, kSizeClasses> freeLists;
+
+      /// \brief Number of buffers allocated from the heap.
+      private: uint64_t allocations = 0;
+    };
+    }
+  }
+}
+#endif
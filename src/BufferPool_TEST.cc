@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "BufferPool.hh"
+
+using namespace ignition;
+using namespace transport;
+
+//////////////////////////////////////////////////
+TEST(BufferPoolTest, Reuse)
+{
+  BufferPool pool;
+  EXPECT_EQ(0u, pool.Allocations());
+  EXPECT_EQ(0u, pool.FreeBuffers());
+
+  char *buffer = pool.Acquire(100u);
+  ASSERT_NE(nullptr, buffer);
+  memset(buffer, 'a', 100u);
+  EXPECT_EQ(1u, pool.Allocations());
+  pool.Release(buffer);
+  EXPECT_EQ(1u, pool.FreeBuffers());
+
+  // Same size class.
+  char *other = pool.Acquire(128u);
+  EXPECT_EQ(buffer, other);
+  EXPECT_EQ(1u, pool.Allocations());
+  EXPECT_EQ(0u, pool.FreeBuffers());
+
+  // Different size class.
+  char *large = pool.Acquire(129u);
+  EXPECT_NE(other, large);
+  EXPECT_EQ(2u, pool.Allocations());
+
+  // ZeroMQ deallocation function.
+  BufferPool::Deallocate(other, &pool);
+  BufferPool::Deallocate(large, &pool);
+  EXPECT_EQ(2u, pool.FreeBuffers());
+
+  // A steady stream of messages doesn't allocate.
+  for (int i = 0; i < 100; ++i)
+    pool.Release(pool.Acquire(200u));
+  EXPECT_EQ(2u, pool.Allocations());
+
+  // Releasing null is a no-op.
+  pool.Release(nullptr);
+}
+
+//////////////////////////////////////////////////
+TEST(BufferPoolTest, Limits)
+{
+  BufferPool pool;
+
+  // Buffers larger than the largest size class aren't pooled.
+  char *huge = pool.Acquire(BufferPool::kMaxBufferSize + 1u);
+  ASSERT_NE(nullptr, huge);
+  huge[BufferPool::kMaxBufferSize] = 'a';
+  pool.Release(huge);
+  EXPECT_EQ(0u, pool.FreeBuffers());
+
+  char *largest = pool.Acquire(BufferPool::kMaxBufferSize);
+  pool.Release(largest);
+  EXPECT_EQ(1u, pool.FreeBuffers());
+
+  // Only a few free buffers are kept per size class.
+  std::vector<char *> buffers;
+  for (std::size_t i = 0; i < 2 * BufferPool::kMaxFreeBuffers; ++i)
+    buffers.push_back(pool.Acquire(10u));
+  for (char *buffer : buffers)
+    pool.Release(buffer);
+  EXPECT_EQ(BufferPool::kMaxFreeBuffers + 1u, pool.FreeBuffers());
+}
+
+//////////////////////////////////////////////////
+/// \brief Buffers can be released from another thread.
+TEST(BufferPoolTest, Threads)
+{
+  BufferPool pool;
+  std::vector<char *> buffers;
+  for (int i = 0; i < 1000; ++i)
+    buffers.push_back(pool.Acquire(64u));
+
+  std::thread releaser([&pool, &buffers]()
+  {
+    for (char *buffer : buffers)
+      pool.Release(buffer);
+  });
+
+  for (int i = 0; i < 1000; ++i)
+    pool.Release(pool.Acquire(1000u));
+
+  releaser.join();
+  EXPECT_EQ(BufferPool::kMaxFreeBuffers + 1u, pool.FreeBuffers());
+  EXPECT_EQ(1001u, pool.Allocations());
+}
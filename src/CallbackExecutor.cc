@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <utility>
+
+#include "CallbackExecutor.hh"
+
+using namespace ignition;
+using namespace transport;
+
+//////////////////////////////////////////////////
+CallbackExecutor::CallbackExecutor(const unsigned int _threads,
+  const size_t _maxPerKey, const QueueOverflowPolicy _policy)
+  : maxPerKey(_maxPerKey),
+    policy(_policy)
+{
+  this->Grow(_threads);
+}
+
+//////////////////////////////////////////////////
+CallbackExecutor::~CallbackExecutor()
+{
+  {
+    std::lock_guard<std::mutex> lk(this->mutex);
+    this->exit = true;
+  }
+  this->cv.notify_all();
+  this->done.notify_all();
+
+  for (auto &worker : this->workers)
+  {
+    if (worker.joinable())
+      worker.join();
+  }
+}
+
+//////////////////////////////////////////////////
+unsigned int CallbackExecutor::Threads() const
+{
+  std::lock_guard<std::mutex> lk(this->mutex);
+  return static_cast<unsigned int>(this->workers.size());
+}
+
+//////////////////////////////////////////////////
+void CallbackExecutor::Grow(const unsigned int _threads)
+{
+  std::lock_guard<std::mutex> lk(this->mutex);
+  while (this->workers.size() < _threads)
+    this->workers.emplace_back(&CallbackExecutor::Work, this);
+}
+
+//////////////////////////////////////////////////
+bool CallbackExecutor::Post(const std::string &_key,
+  std::function<void()> _task)
+{
+  // The discarded task is destroyed after releasing the lock, it might own
+  // resources whose destructors take other locks.
+  std::function<void()> discarded;
+  {
+    std::unique_lock<std::mutex> lk(this->mutex);
+    while (this->maxPerKey > 0 &&
+           this->policy != QueueOverflowPolicy::GROW &&
+           this->strands[_key].tasks.size() >= this->maxPerKey)
+    {
+      if (this->policy == QueueOverflowPolicy::DROP_OLDEST)
+      {
+        Strand &strand = this->strands[_key];
+        discarded = std::move(strand.tasks.front());
+        strand.tasks.pop_front();
+        --this->pending;
+        ++this->dropped;
+        break;
+      }
+
+      if (this->policy == QueueOverflowPolicy::DROP_NEWEST ||
+          this->exit || this->InWorker())
+      {
+        discarded = std::move(_task);
+        ++this->dropped;
+        return false;
+      }
+
+      // BLOCK. The strand might be removed while waiting, so it's looked
+      // up again.
+      this->done.wait(lk);
+    }
+
+    Strand &strand = this->strands[_key];
+    strand.tasks.push_back(std::move(_task));
+    ++this->pending;
+
+    // The strand is already being processed, the worker will pick the new
+    // task when it's done with the current one.
+    if (strand.scheduled)
+      return true;
+
+    strand.scheduled = true;
+    this->ready.push_back(_key);
+  }
+  this->cv.notify_one();
+  return true;
+}
+
+//////////////////////////////////////////////////
+void CallbackExecutor::Wait(const std::string &_key)
+{
+  std::unique_lock<std::mutex> lk(this->mutex);
+  auto it = this->strands.find(_key);
+  if (it == this->strands.end() ||
+      it->second.runner == std::thread::id() ||
+      it->second.runner == std::this_thread::get_id())
+  {
+    return;
+  }
+
+  // Wait for the task running now. The strand might be removed and created
+  // again in the meantime, so the task is recognized by its identifier.
+  const uint64_t target = it->second.running;
+  this->done.wait(lk, [&]
+  {
+    it = this->strands.find(_key);
+    return this->exit || it == this->strands.end() ||
+      it->second.running != target;
+  });
+}
+
+//////////////////////////////////////////////////
+size_t CallbackExecutor::Pending() const
+{
+  std::lock_guard<std::mutex> lk(this->mutex);
+  return this->pending;
+}
+
+//////////////////////////////////////////////////
+uint64_t CallbackExecutor::Dropped() const
+{
+  std::lock_guard<std::mutex> lk(this->mutex);
+  return this->dropped;
+}
+
+//////////////////////////////////////////////////
+bool CallbackExecutor::InWorker() const
+{
+  const auto self = std::this_thread::get_id();
+  return std::any_of(this->workers.begin(), this->workers.end(),
+    [&self](const std::thread &_worker)
+    {
+      return _worker.get_id() == self;
+    });
+}
+
+//////////////////////////////////////////////////
+void CallbackExecutor::Work()
+{
+  std::unique_lock<std::mutex> lk(this->mutex);
+  while (true)
+  {
+    this->cv.wait(lk, [this]
+    {
+      return this->exit || !this->ready.empty();
+    });
+
+    if (this->exit)
+      return;
+
+    std::string key = std::move(this->ready.front());
+    this->ready.pop_front();
+
+    auto it = this->strands.find(key);
+    std::function<void()> task = std::move(it->second.tasks.front());
+    it->second.tasks.pop_front();
+    it->second.runner = std::this_thread::get_id();
+    it->second.running = ++this->lastTaskId;
+    --this->pending;
+
+    lk.unlock();
+    // A producer blocked on a full strand might fit now.
+    this->done.notify_all();
+    try
+    {
+      task();
+    }
+    catch (...)
+    {
+      std::cerr << "Exception occurred in a callback on topic [" << key
+                << "]" << std::endl;
+    }
+    // Destroy the task before reporting it as finished, so its captures
+    // are released when Wait() returns.
+    task = nullptr;
+    lk.lock();
+
+    // Only one task of a strand runs at a time, so the strand is still
+    // there. Put it back at the end of the ready queue to be fair with the
+    // rest of the keys.
+    it = this->strands.find(key);
+    it->second.runner = std::thread::id();
+    it->second.running = 0;
+    this->done.notify_all();
+    if (it->second.tasks.empty())
+    {
+      this->strands.erase(it);
+    }
+    else
+    {
+      this->ready.push_back(std::move(key));
+      this->cv.notify_one();
+    }
+  }
+}
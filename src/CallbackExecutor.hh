@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef IGN_TRANSPORT_CALLBACKEXECUTOR_HH_
+#define IGN_TRANSPORT_CALLBACKEXECUTOR_HH_
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ignition/transport/config.hh"
+#include "ignition/transport/Export.hh"
+#include "MpscQueue.hh"
+
+namespace ignition
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace IGNITION_TRANSPORT_VERSION_NAMESPACE {
+    //
+    /// \internal
+    /// \brief A pool of worker threads that runs subscriber callbacks.
+    /// Every task is posted with a key (the topic name). Tasks that share a
+    /// key are executed one at a time and in the same order they were posted,
+    /// while tasks with different keys run in parallel. A slow callback only
+    /// delays the messages of its own topic. The number of tasks queued for
+    /// a key can be bounded, so a slow callback doesn't make the memory grow
+    /// without limit.
+    class IGNITION_TRANSPORT_VISIBLE CallbackExecutor
+    {
+      /// \brief Constructor.
+      /// \param[in] _threads Number of worker threads.
+      /// \param[in] _maxPerKey Maximum number of tasks not started yet for
+      /// every key. 0 means unlimited.
+      /// \param[in] _policy What to do when a task is posted for a key that
+      /// already has _maxPerKey tasks pending. GROW ignores the limit.
+      public: explicit CallbackExecutor(const unsigned int _threads,
+        const size_t _maxPerKey = 0,
+        const QueueOverflowPolicy _policy = QueueOverflowPolicy::DROP_OLDEST);
+
+      /// \brief Destructor. Pending tasks are discarded and the worker
+      /// threads are joined.
+      public: ~CallbackExecutor();
+
+      /// \brief Get the number of worker threads.
+      /// \return The number of worker threads.
+      public: unsigned int Threads() const;
+
+      /// \brief Increase the number of worker threads. The pool never
+      /// shrinks, so this has no effect if _threads is not greater than
+      /// Threads().
+      /// \param[in] _threads New number of worker threads.
+      public: void Grow(const unsigned int _threads);
+
+      /// \brief Queue a task. If the key already has the maximum number of
+      /// tasks pending, the overflow policy is applied. The BLOCK policy
+      /// behaves as DROP_NEWEST when called from a worker thread, because
+      /// waiting for itself would never end.
+      /// \param[in] _key Tasks with the same key run sequentially.
+      /// \param[in] _task The task.
+      /// \return True if the task was queued or false if it was discarded.
+      public: bool Post(const std::string &_key, std::function<void()> _task);
+
+      /// \brief Wait until no task of a key is running. Tasks posted while
+      /// waiting are not waited for. It returns immediately when called
+      /// from the worker that runs the task of the key.
+      /// \param[in] _key The key.
+      public: void Wait(const std::string &_key);
+
+      /// \brief Get the number of tasks queued that haven't started yet.
+      /// \return The number of pending tasks.
+      public: size_t Pending() const;
+
+      /// \brief Get the number of tasks discarded because of the overflow
+      /// policy.
+      /// \return The number of tasks discarded.
+      public: uint64_t Dropped() const;
+
+      /// \brief Check if the calling thread is one of the workers.
+      /// \return True if called from a worker thread.
+      /// \note The mutex must be locked.
+      private: bool InWorker() const;
+
+      /// \brief Function executed by every worker thread.
+      private: void Work();
+
+      /// \brief Tasks queued for a key.
+      private: struct Strand
+               {
+                 /// \brief Tasks not started yet.
+                 public: std::deque<std::function<void()>> tasks;
+
+                 /// \brief True while a worker is running a task of this
+                 /// strand or the strand is waiting in the ready queue.
+                 public: bool scheduled = false;
+
+                 /// \brief Worker running a task of this strand, if any.
+                 public: std::thread::id runner;
+
+                 /// \brief Identifier of the task running, or 0.
+                 public: uint64_t running = 0;
+               };
+
+      /// \brief Protects all the member variables below.
+      private: mutable std::mutex mutex;
+
+      /// \brief Used to wake up the workers.
+      private: std::condition_variable cv;
+
+      /// \brief Notified every time a worker finishes a task or removes
+      /// tasks from a full strand.
+      private: std::condition_variable done;
+
+      /// \brief Strands indexed by key.
+      private: std::map<std::string, Strand> strands;
+
+      /// \brief Keys of the strands that have tasks ready to run.
+      private: std::deque<std::string> ready;
+
+      /// \brief Number of tasks queued that haven't started yet.
+      private: size_t pending = 0;
+
+      /// \brief Identifier of the last task started. The identifiers are
+      /// unique across strands, so they survive the removal of a strand.
+      private: uint64_t lastTaskId = 0;
+
+      /// \brief Maximum number of pending tasks per key (0 is unlimited).
+      private: const size_t maxPerKey;
+
+      /// \brief Policy applied when a strand is full.
+      private: const QueueOverflowPolicy policy;
+
+      /// \brief Number of tasks discarded.
+      private: uint64_t dropped = 0;
+
+      /// \brief Worker threads.
+      private: std::vector<std::thread> workers;
+
+      /// \brief When true, the workers finish.
+      private: bool exit = false;
+    };
+    }
+  }
+}
+#endif
@@ -0,0 +1,276 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "CallbackExecutor.hh"
+
+using namespace ignition;
+using namespace transport;
+
+//////////////////////////////////////////////////
+/// \brief Wait until a condition is true or a timeout expires.
+template<typename Pred>
+bool waitFor(Pred _pred)
+{
+  for (int i = 0; i < 500 && !_pred(); ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  return _pred();
+}
+
+//////////////////////////////////////////////////
+TEST(CallbackExecutorTest, Grow)
+{
+  CallbackExecutor executor(2u);
+  EXPECT_EQ(2u, executor.Threads());
+
+  executor.Grow(1u);
+  EXPECT_EQ(2u, executor.Threads());
+
+  executor.Grow(4u);
+  EXPECT_EQ(4u, executor.Threads());
+}
+
+//////////////////////////////////////////////////
+/// \brief Tasks with the same key keep their order.
+TEST(CallbackExecutorTest, Ordering)
+{
+  CallbackExecutor executor(4u);
+
+  std::mutex mutex;
+  std::vector<int> foo;
+  std::vector<int> bar;
+  for (int i = 0; i < 100; ++i)
+  {
+    executor.Post("/foo", [&, i]
+    {
+      std::lock_guard<std::mutex> lk(mutex);
+      foo.push_back(i);
+    });
+    executor.Post("/bar", [&, i]
+    {
+      std::lock_guard<std::mutex> lk(mutex);
+      bar.push_back(i);
+    });
+  }
+
+  EXPECT_TRUE(waitFor([&]
+  {
+    std::lock_guard<std::mutex> lk(mutex);
+    return foo.size() == 100u && bar.size() == 100u;
+  }));
+
+  for (int i = 0; i < 100; ++i)
+  {
+    EXPECT_EQ(i, foo[i]);
+    EXPECT_EQ(i, bar[i]);
+  }
+  EXPECT_EQ(0u, executor.Pending());
+}
+
+//////////////////////////////////////////////////
+/// \brief A blocked key doesn't delay the rest of the keys.
+TEST(CallbackExecutorTest, NoHeadOfLineBlocking)
+{
+  CallbackExecutor executor(2u);
+
+  std::atomic<bool> release{false};
+  std::atomic<int> slowCounter{0};
+  std::atomic<int> fastCounter{0};
+
+  executor.Post("/slow", [&]
+  {
+    while (!release)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    ++slowCounter;
+  });
+  executor.Post("/slow", [&]{++slowCounter;});
+
+  for (int i = 0; i < 10; ++i)
+    executor.Post("/fast", [&]{++fastCounter;});
+
+  EXPECT_TRUE(waitFor([&]{return fastCounter == 10;}));
+  EXPECT_EQ(0, slowCounter);
+
+  release = true;
+  EXPECT_TRUE(waitFor([&]{return slowCounter == 2;}));
+}
+
+//////////////////////////////////////////////////
+/// \brief An exception in a task doesn't kill the worker.
+TEST(CallbackExecutorTest, Exception)
+{
+  CallbackExecutor executor(1u);
+  std::atomic<int> counter{0};
+
+  executor.Post("/foo", []{throw std::runtime_error("error");});
+  executor.Post("/foo", [&]{++counter;});
+
+  EXPECT_TRUE(waitFor([&]{return counter == 1;}));
+}
+
+//////////////////////////////////////////////////
+/// \brief A full key discards its oldest or its newest task.
+TEST(CallbackExecutorTest, Bounded)
+{
+  for (auto policy : {QueueOverflowPolicy::DROP_OLDEST,
+                      QueueOverflowPolicy::DROP_NEWEST})
+  {
+    CallbackExecutor executor(1u, 2u, policy);
+
+    std::atomic<bool> release{false};
+    std::mutex mutex;
+    std::vector<int> values;
+
+    executor.Post("/foo", [&]
+    {
+      while (!release)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    });
+    EXPECT_TRUE(waitFor([&]{return executor.Pending() == 0u;}));
+
+    for (int i = 0; i < 4; ++i)
+    {
+      executor.Post("/foo", [&, i]
+      {
+        std::lock_guard<std::mutex> lk(mutex);
+        values.push_back(i);
+      });
+    }
+    EXPECT_EQ(2u, executor.Pending());
+    EXPECT_EQ(2u, executor.Dropped());
+
+    // Other keys have their own bound.
+    EXPECT_TRUE(executor.Post("/bar", []{}));
+
+    release = true;
+    EXPECT_TRUE(waitFor([&]
+    {
+      std::lock_guard<std::mutex> lk(mutex);
+      return values.size() == 2u;
+    }));
+
+    if (policy == QueueOverflowPolicy::DROP_OLDEST)
+      EXPECT_EQ((std::vector<int>{2, 3}), values);
+    else
+      EXPECT_EQ((std::vector<int>{0, 1}), values);
+  }
+}
+
+//////////////////////////////////////////////////
+/// \brief Wait() returns when the running task of a key finishes.
+TEST(CallbackExecutorTest, Wait)
+{
+  CallbackExecutor executor(2u);
+
+  // Nothing to wait for.
+  executor.Wait("/foo");
+
+  std::atomic<bool> started{false};
+  std::atomic<bool> finished{false};
+  executor.Post("/foo", [&]
+  {
+    started = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    finished = true;
+  });
+  EXPECT_TRUE(waitFor([&]{return started.load();}));
+
+  executor.Wait("/foo");
+  EXPECT_TRUE(finished);
+
+  // A task waiting for its own key doesn't deadlock.
+  std::atomic<bool> self{false};
+  executor.Post("/bar", [&]
+  {
+    executor.Wait("/bar");
+    self = true;
+  });
+  EXPECT_TRUE(waitFor([&]{return self.load();}));
+}
+
+//////////////////////////////////////////////////
+/// \brief Wait() doesn't wait for the tasks posted later, even if the key
+/// runs out of tasks and gets new ones in the meantime.
+TEST(CallbackExecutorTest, WaitSteadyTraffic)
+{
+  CallbackExecutor executor(2u);
+
+  // A few tasks run in a row. The last one lasts until we wait for it.
+  std::atomic<bool> waiting{false};
+  std::atomic<bool> lastDestroyed{false};
+  for (int i = 0; i < 4; ++i)
+    executor.Post("/foo", []{});
+  std::shared_ptr<void> onDestroy(nullptr, [&](void *){lastDestroyed = true;});
+  executor.Post("/foo", [onDestroy, &waiting]
+  {
+    while (!waiting)
+      std::this_thread::yield();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  });
+  onDestroy.reset();
+
+  // Then, a new task is posted as soon as the previous one is destroyed,
+  // which races with the removal of the key.
+  std::atomic<bool> stop{false};
+  std::thread feeder([&]
+  {
+    while (!lastDestroyed)
+    {
+      // Spin.
+    }
+
+    while (!stop)
+    {
+      std::atomic<bool> destroyed{false};
+      std::shared_ptr<void> task(nullptr, [&](void *){destroyed = true;});
+      executor.Post("/foo", [task]
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      });
+      task.reset();
+      while (!destroyed)
+      {
+        // Spin.
+      }
+    }
+  });
+
+  std::thread waiter([&]
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    waiting = true;
+  });
+
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_TRUE(waitFor([&]{return executor.Pending() == 0u;}));
+  executor.Wait("/foo");
+  EXPECT_LT(std::chrono::steady_clock::now() - start,
+    std::chrono::milliseconds(1000));
+
+  stop = true;
+  feeder.join();
+  waiter.join();
+}
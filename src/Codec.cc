@@ -0,0 +1,344 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <array>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ignition/transport/Codec.hh"
+#include "ignition/transport/config.hh"
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef HAVE_LZ4
+#include <lz4.h>
+#include <lz4hc.h>
+#endif
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+using namespace ignition;
+using namespace transport;
+
+namespace
+{
+  /// \brief Largest message that we accept to decompress. It protects the
+  /// subscribers against corrupt size fields.
+  constexpr uint64_t kMaxDecompressedSize = uint64_t(1) << 31;
+
+  /// \brief Size of the uncompressed size stored before the data by the
+  /// codecs that don't keep it.
+  constexpr std::size_t kSizePrefix = 8;
+
+  //////////////////////////////////////////////////
+  /// \brief Store the uncompressed size at the beginning of a buffer.
+  /// \param[in] _size Uncompressed size.
+  /// \param[out] _out Buffer with at least kSizePrefix bytes.
+  void writeSize(const uint64_t _size, std::string &_out)
+  {
+    for (std::size_t i = 0; i < kSizePrefix; ++i)
+      _out[i] = static_cast<char>((_size >> (8 * i)) & 0xFF);
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Read the uncompressed size stored by writeSize().
+  /// \param[in] _data Compressed buffer.
+  /// \param[in] _size Size of the compressed buffer.
+  /// \param[out] _result Uncompressed size.
+  /// \return True if the size is present and acceptable.
+  bool readSize(const char *_data, const std::size_t _size, uint64_t &_result)
+  {
+    if (_size < kSizePrefix)
+      return false;
+
+    _result = 0;
+    for (std::size_t i = 0; i < kSizePrefix; ++i)
+    {
+      _result |= static_cast<uint64_t>(
+        static_cast<unsigned char>(_data[i])) << (8 * i);
+    }
+    return _result <= kMaxDecompressedSize;
+  }
+
+#ifdef HAVE_ZLIB
+  /// \brief Deflate through zlib. Good ratio, moderate speed, available
+  /// almost everywhere.
+  class ZlibCodec : public Codec
+  {
+    // Documentation inherited.
+    public: std::string Name() const override
+    {
+      return "zlib";
+    }
+
+    // Documentation inherited.
+    public: uint8_t Id() const override
+    {
+      return 1;
+    }
+
+    // Documentation inherited.
+    public: bool Compress(const char *_data, const std::size_t _size,
+                          const int _level, std::string &_out) const override
+    {
+      uLongf outSize = compressBound(static_cast<uLong>(_size));
+      _out.resize(kSizePrefix + outSize);
+      writeSize(_size, _out);
+
+      auto dst = reinterpret_cast<Bytef *>(&_out[kSizePrefix]);
+      auto src = reinterpret_cast<const Bytef *>(_data);
+      const int level = _level == 0 ? Z_DEFAULT_COMPRESSION : _level;
+      if (compress2(dst, &outSize, src, static_cast<uLong>(_size), level) !=
+          Z_OK)
+      {
+        return false;
+      }
+
+      _out.resize(kSizePrefix + outSize);
+      return true;
+    }
+
+    // Documentation inherited.
+    public: bool Decompress(const char *_data, const std::size_t _size,
+                            std::string &_out) const override
+    {
+      uint64_t expected;
+      if (!readSize(_data, _size, expected))
+        return false;
+
+      _out.resize(expected);
+      uLongf outSize = static_cast<uLongf>(expected);
+      auto dst = reinterpret_cast<Bytef *>(&_out[0]);
+      auto src = reinterpret_cast<const Bytef *>(_data + kSizePrefix);
+      return uncompress(dst, &outSize, src,
+                 static_cast<uLong>(_size - kSizePrefix)) == Z_OK &&
+             outSize == expected;
+    }
+  };
+#endif
+
+#ifdef HAVE_LZ4
+  /// \brief LZ4 block compression. Very fast, lower ratio. A level above 0
+  /// selects the slower high compression mode.
+  class Lz4Codec : public Codec
+  {
+    // Documentation inherited.
+    public: std::string Name() const override
+    {
+      return "lz4";
+    }
+
+    // Documentation inherited.
+    public: uint8_t Id() const override
+    {
+      return 2;
+    }
+
+    // Documentation inherited.
+    public: bool Compress(const char *_data, const std::size_t _size,
+                          const int _level, std::string &_out) const override
+    {
+      if (_size > LZ4_MAX_INPUT_SIZE)
+        return false;
+
+      const int srcSize = static_cast<int>(_size);
+      const int bound = LZ4_compressBound(srcSize);
+      _out.resize(kSizePrefix + bound);
+      writeSize(_size, _out);
+
+      char *dst = &_out[kSizePrefix];
+      const int outSize = _level > 0 ?
+        LZ4_compress_HC(_data, dst, srcSize, bound, _level) :
+        LZ4_compress_default(_data, dst, srcSize, bound);
+      if (outSize <= 0)
+        return false;
+
+      _out.resize(kSizePrefix + outSize);
+      return true;
+    }
+
+    // Documentation inherited.
+    public: bool Decompress(const char *_data, const std::size_t _size,
+                            std::string &_out) const override
+    {
+      uint64_t expected;
+      if (!readSize(_data, _size, expected) || expected > LZ4_MAX_INPUT_SIZE)
+        return false;
+
+      _out.resize(expected);
+      const int outSize = LZ4_decompress_safe(_data + kSizePrefix, &_out[0],
+        static_cast<int>(_size - kSizePrefix), static_cast<int>(expected));
+      return outSize >= 0 && static_cast<uint64_t>(outSize) == expected;
+    }
+  };
+#endif
+
+#ifdef HAVE_ZSTD
+  /// \brief Zstandard. Better ratio than zlib at LZ4-like speeds with the
+  /// low levels.
+  class ZstdCodec : public Codec
+  {
+    // Documentation inherited.
+    public: std::string Name() const override
+    {
+      return "zstd";
+    }
+
+    // Documentation inherited.
+    public: uint8_t Id() const override
+    {
+      return 3;
+    }
+
+    // Documentation inherited.
+    public: bool Compress(const char *_data, const std::size_t _size,
+                          const int _level, std::string &_out) const override
+    {
+      _out.resize(ZSTD_compressBound(_size));
+      const std::size_t outSize =
+        ZSTD_compress(&_out[0], _out.size(), _data, _size, _level);
+      if (ZSTD_isError(outSize))
+        return false;
+
+      _out.resize(outSize);
+      return true;
+    }
+
+    // Documentation inherited.
+    public: bool Decompress(const char *_data, const std::size_t _size,
+                            std::string &_out) const override
+    {
+      // The frames produced by ZSTD_compress() store the original size.
+      const unsigned long long expected =
+        ZSTD_getFrameContentSize(_data, _size);
+      if (expected == ZSTD_CONTENTSIZE_UNKNOWN ||
+          expected == ZSTD_CONTENTSIZE_ERROR ||
+          expected > kMaxDecompressedSize)
+      {
+        return false;
+      }
+
+      _out.resize(expected);
+      const std::size_t outSize =
+        ZSTD_decompress(&_out[0], _out.size(), _data, _size);
+      return !ZSTD_isError(outSize) && outSize == expected;
+    }
+  };
+#endif
+
+  /// \brief Process-wide list of codecs.
+  class Registry
+  {
+    /// \brief Constructor. Registers the codecs built into the library.
+    public: Registry()
+    {
+#ifdef HAVE_ZLIB
+      this->Add(std::make_shared<ZlibCodec>());
+#endif
+#ifdef HAVE_LZ4
+      this->Add(std::make_shared<Lz4Codec>());
+#endif
+#ifdef HAVE_ZSTD
+      this->Add(std::make_shared<ZstdCodec>());
+#endif
+    }
+
+    /// \brief Add a codec.
+    /// \param[in] _codec The codec.
+    /// \return False if the codec is invalid or clashes with another one.
+    public: bool Add(std::shared_ptr<const Codec> _codec)
+    {
+      if (!_codec || _codec->Id() == 0 || _codec->Name().empty())
+        return false;
+
+      std::lock_guard<std::mutex> lk(this->mutex);
+      if (this->byId[_codec->Id()] || this->byName.count(_codec->Name()) > 0)
+        return false;
+
+      this->byId[_codec->Id()] = _codec;
+      this->byName[_codec->Name()] = std::move(_codec);
+      return true;
+    }
+
+    /// \brief Protects the codec lists.
+    public: std::mutex mutex;
+
+    /// \brief Codecs indexed by name.
+    public: std::map<std::string, std::shared_ptr<const Codec>> byName;
+
+    /// \brief Codecs indexed by identifier.
+    public: std::array<std::shared_ptr<const Codec>, 256> byId;
+  };
+
+  //////////////////////////////////////////////////
+  /// \brief Get the codec registry.
+  /// \return The registry.
+  Registry &registry()
+  {
+    static Registry instance;
+    return instance;
+  }
+}
+
+//////////////////////////////////////////////////
+Codec::~Codec()
+{
+}
+
+//////////////////////////////////////////////////
+bool Codec::Register(std::shared_ptr<const Codec> _codec)
+{
+  return registry().Add(std::move(_codec));
+}
+
+//////////////////////////////////////////////////
+std::shared_ptr<const Codec> Codec::Find(const std::string &_name)
+{
+  auto &reg = registry();
+  std::lock_guard<std::mutex> lk(reg.mutex);
+  auto it = reg.byName.find(_name);
+  if (it == reg.byName.end())
+    return nullptr;
+  return it->second;
+}
+
+//////////////////////////////////////////////////
+std::shared_ptr<const Codec> Codec::Find(const uint8_t _id)
+{
+  auto &reg = registry();
+  std::lock_guard<std::mutex> lk(reg.mutex);
+  return reg.byId[_id];
+}
+
+//////////////////////////////////////////////////
+std::vector<std::string> Codec::Names()
+{
+  auto &reg = registry();
+  std::lock_guard<std::mutex> lk(reg.mutex);
+  std::vector<std::string> names;
+  for (const auto &entry : reg.byName)
+    names.push_back(entry.first);
+  return names;
+}
@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <memory>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "ignition/transport/Codec.hh"
+
+using namespace ignition;
+using namespace transport;
+
+//////////////////////////////////////////////////
+/// \brief Codec that stores the data reversed.
+class ReverseCodec : public Codec
+{
+  /// \brief Constructor.
+  /// \param[in] _name Codec name.
+  /// \param[in] _id Codec identifier.
+  public: ReverseCodec(const std::string &_name, const uint8_t _id)
+    : name(_name), id(_id)
+  {
+  }
+
+  // Documentation inherited.
+  public: std::string Name() const override
+  {
+    return this->name;
+  }
+
+  // Documentation inherited.
+  public: uint8_t Id() const override
+  {
+    return this->id;
+  }
+
+  // Documentation inherited.
+  public: bool Compress(const char *_data, const std::size_t _size,
+                        const int, std::string &_out) const override
+  {
+    _out.assign(_data, _size);
+    _out.assign(_out.rbegin(), _out.rend());
+    return true;
+  }
+
+  // Documentation inherited.
+  public: bool Decompress(const char *_data, const std::size_t _size,
+                          std::string &_out) const override
+  {
+    return this->Compress(_data, _size, 0, _out);
+  }
+
+  /// \brief Codec name.
+  private: std::string name;
+
+  /// \brief Codec identifier.
+  private: uint8_t id;
+};
+
+//////////////////////////////////////////////////
+/// \brief Check that every available codec restores the data.
+TEST(CodecTest, RoundTrip)
+{
+  // Compressible data: a repeated pattern with some noise.
+  std::string data;
+  for (int i = 0; i < 10000; ++i)
+    data.push_back(static_cast<char>((i % 64 == 0) ? i * 7 : i % 8));
+
+  for (const auto &name : Codec::Names())
+  {
+    auto codec = Codec::Find(name);
+    ASSERT_NE(nullptr, codec) << name;
+    EXPECT_EQ(codec, Codec::Find(codec->Id())) << name;
+
+    for (int level : {0, 1, 9})
+    {
+      std::string compressed;
+      ASSERT_TRUE(codec->Compress(data.data(), data.size(), level,
+        compressed)) << name;
+      EXPECT_LT(compressed.size(), data.size()) << name;
+
+      std::string restored;
+      ASSERT_TRUE(codec->Decompress(compressed.data(), compressed.size(),
+        restored)) << name;
+      EXPECT_EQ(data, restored) << name;
+
+      // Truncated data is rejected.
+      EXPECT_FALSE(codec->Decompress(compressed.data(), compressed.size() / 2,
+        restored)) << name;
+    }
+
+    // Empty data.
+    std::string compressed;
+    std::string restored = "x";
+    ASSERT_TRUE(codec->Compress("", 0, 0, compressed)) << name;
+    EXPECT_TRUE(codec->Decompress(compressed.data(), compressed.size(),
+      restored)) << name;
+    EXPECT_TRUE(restored.empty()) << name;
+  }
+}
+
+//////////////////////////////////////////////////
+/// \brief Check the registration of custom codecs.
+TEST(CodecTest, Register)
+{
+  EXPECT_EQ(nullptr, Codec::Find("reverse"));
+  EXPECT_EQ(nullptr, Codec::Find(Codec::kFirstUserId));
+
+  auto codec = std::make_shared<ReverseCodec>("reverse", Codec::kFirstUserId);
+  EXPECT_TRUE(Codec::Register(codec));
+  EXPECT_EQ(codec, Codec::Find("reverse"));
+  EXPECT_EQ(codec, Codec::Find(Codec::kFirstUserId));
+
+  // Clashing names or identifiers.
+  EXPECT_FALSE(Codec::Register(codec));
+  EXPECT_FALSE(Codec::Register(
+    std::make_shared<ReverseCodec>("reverse", Codec::kFirstUserId + 1)));
+  EXPECT_FALSE(Codec::Register(
+    std::make_shared<ReverseCodec>("other", Codec::kFirstUserId)));
+  EXPECT_EQ(nullptr, Codec::Find("other"));
+
+  // Invalid codecs.
+  EXPECT_FALSE(Codec::Register(nullptr));
+  EXPECT_FALSE(Codec::Register(std::make_shared<ReverseCodec>("zero", 0)));
+  EXPECT_FALSE(Codec::Register(
+    std::make_shared<ReverseCodec>("", Codec::kFirstUserId + 1)));
+
+  std::string out;
+  EXPECT_TRUE(Codec::Find("reverse")->Compress("abc", 3, 0, out));
+  EXPECT_EQ("cba", out);
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -150,6 +150,7 @@ TEST(DiscoveryTest, TestBasicAPI)
   unsigned int newSilenceInterval    = 100;
   unsigned int newActivityInterval   = 200;
   unsigned int newHeartbeatInterval  = 400;
+  uint16_t newDatagramSize           = 9000;
 
   // Create a discovery node.
   Discovery<MessagePublisher> discovery(pUuid1, g_msgPort);
@@ -157,10 +158,12 @@ TEST(DiscoveryTest, TestBasicAPI)
   discovery.SetSilenceInterval(newSilenceInterval);
   discovery.SetActivityInterval(newActivityInterval);
   discovery.SetHeartbeatInterval(newHeartbeatInterval);
+  discovery.SetDatagramSize(newDatagramSize);
 
   EXPECT_EQ(discovery.SilenceInterval(), newSilenceInterval);
   EXPECT_EQ(discovery.ActivityInterval(), newActivityInterval);
   EXPECT_EQ(discovery.HeartbeatInterval(), newHeartbeatInterval);
+  EXPECT_EQ(discovery.DatagramSize(), newDatagramSize);
 
   EXPECT_NE(discovery.HostAddr(), "");
 }
@@ -337,6 +340,73 @@ TEST(DiscoveryTest, TestDiscover)
   EXPECT_FALSE(disconnectionExecuted);
 }
 
+//////////////////////////////////////////////////
+/// \brief Check that a discovery node learns the topics advertised before it
+/// started, without calling Discover(), when the digest in the heartbeats of
+/// the other node doesn't match what it knows.
+TEST(DiscoveryTest, TestDigestSync)
+{
+  reset();
+
+  // Create one discovery node and advertise a topic.
+  MsgDiscovery discovery1(pUuid1, g_msgPort);
+  discovery1.Start();
+
+  MessagePublisher publisher(g_topic, addr1, ctrl1, pUuid1, nUuid1, "t",
+    AdvertiseMessageOptions());
+  EXPECT_TRUE(discovery1.Advertise(publisher));
+
+  // Create a second discovery node that did not see the previous ADV message.
+  MsgDiscovery discovery2(pUuid2, g_msgPort);
+  discovery2.ConnectionsCb(onDiscoveryResponse);
+  discovery2.Start();
+
+  // The query sent at startup or the next heartbeat of the first node,
+  // which reveals the mismatch.
+  waitForCallback(4 * MaxIters, Nap, connectionExecuted);
+  EXPECT_TRUE(connectionExecuted);
+  EXPECT_FALSE(disconnectionExecuted);
+
+  MsgAddresses_M addresses;
+  EXPECT_TRUE(discovery2.Publishers(g_topic, addresses));
+  EXPECT_NE(addresses.find(pUuid1), addresses.end());
+}
+
+//////////////////////////////////////////////////
+/// \brief Check that a discovery node asks for the existing topics when it
+/// starts, and that it's initialized before the next heartbeat.
+TEST(DiscoveryTest, TestBootstrap)
+{
+  reset();
+
+  const unsigned int heartbeatInterval = 5000;
+
+  MsgDiscovery discovery1(pUuid1, g_msgPort);
+  discovery1.SetHeartbeatInterval(heartbeatInterval);
+  discovery1.Start();
+
+  MessagePublisher publisher(g_topic, addr1, ctrl1, pUuid1, nUuid1, "t",
+    AdvertiseMessageOptions());
+  EXPECT_TRUE(discovery1.Advertise(publisher));
+
+  MsgDiscovery discovery2(pUuid2, g_msgPort);
+  discovery2.SetHeartbeatInterval(heartbeatInterval);
+  discovery2.ConnectionsCb(onDiscoveryResponse);
+
+  auto start = std::chrono::steady_clock::now();
+  discovery2.Start();
+  discovery2.WaitForInit();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  EXPECT_LT(std::chrono::duration_cast<std::chrono::milliseconds>(
+    elapsed).count(), heartbeatInterval);
+  EXPECT_TRUE(connectionExecuted);
+
+  MsgAddresses_M addresses;
+  EXPECT_TRUE(discovery2.Publishers(g_topic, addresses));
+  EXPECT_NE(addresses.find(pUuid1), addresses.end());
+}
+
 //////////////////////////////////////////////////
 /// \brief Check that the discovery triggers the disconnection callback after
 /// an unadvertise.
@@ -484,6 +554,199 @@ TEST(DiscoveryTest, TestTwoPublishersSameTopic)
   EXPECT_EQ(g_counter, 2);
 }
 
+//////////////////////////////////////////////////
+/// \brief Check that the answer to a discovery request with many publishers,
+/// packed in several datagrams, is fully received.
+TEST(DiscoveryTest, TestBatchedAdvertise)
+{
+  reset();
+
+  const int kNumPublishers = 50;
+
+  // Create one discovery node with small datagrams and advertise the same
+  // topic from many nodes.
+  MsgDiscovery discovery1(pUuid1, g_msgPort);
+  discovery1.SetDatagramSize(512);
+  discovery1.Start();
+
+  for (int i = 0; i < kNumPublishers; ++i)
+  {
+    MessagePublisher publisher(g_topic, addr1, ctrl1, pUuid1,
+      transport::Uuid().ToString(), "t", AdvertiseMessageOptions());
+    EXPECT_TRUE(discovery1.Advertise(publisher));
+  }
+
+  // Create a second discovery node that did not see the previous ADV
+  // messages.
+  MsgDiscovery discovery2(pUuid2, g_msgPort);
+  discovery2.Start();
+  discovery2.ConnectionsCb(onDiscoveryResponseMultiple);
+
+  // Request the discovery of a topic.
+  EXPECT_TRUE(discovery2.Discover(g_topic));
+
+  int i = 0;
+  while (i < MaxIters && g_counter < kNumPublishers)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(Nap));
+    ++i;
+  }
+
+  EXPECT_TRUE(connectionExecuted);
+  EXPECT_FALSE(disconnectionExecuted);
+  EXPECT_EQ(g_counter, kNumPublishers);
+
+  MsgAddresses_M addresses;
+  EXPECT_TRUE(discovery2.Publishers(g_topic, addresses));
+  EXPECT_EQ(addresses[pUuid1].size(), static_cast<size_t>(kNumPublishers));
+}
+
+//////////////////////////////////////////////////
+/// \brief Check that the clients of a discovery server learn about the
+/// topics that they ask for, and only about them.
+TEST(DiscoveryTest, TestServer)
+{
+  reset();
+
+  MsgDiscovery server(transport::Uuid().ToString(), g_msgPort, false, true);
+  server.Start();
+
+  // The clients talk to the server through the loopback interface.
+  setenv("IGN_DISCOVERY_SERVER", "127.0.0.1", 1);
+  MsgDiscovery discovery1(pUuid1, g_msgPort);
+  MsgDiscovery discovery2(pUuid2, g_msgPort);
+  MsgDiscovery discovery3(transport::Uuid().ToString(), g_msgPort);
+  unsetenv("IGN_DISCOVERY_SERVER");
+
+  discovery1.Start();
+  discovery2.Start();
+  discovery3.Start();
+
+  MessagePublisher publisher(g_topic, addr1, ctrl1, pUuid1, nUuid1, "t",
+    AdvertiseMessageOptions());
+  EXPECT_TRUE(discovery1.Advertise(publisher));
+
+  // The third client isn't interested in the topic.
+  bool otherExecuted = false;
+  discovery3.ConnectionsCb([&otherExecuted](const MessagePublisher &)
+  {
+    otherExecuted = true;
+  });
+
+  discovery2.ConnectionsCb(onDiscoveryResponse);
+  discovery2.DisconnectionsCb(onDisconnection);
+  waitForCallback(MaxIters, Nap, connectionExecuted);
+  EXPECT_FALSE(connectionExecuted);
+
+  // The server answers with the publishers that it knows.
+  EXPECT_TRUE(discovery2.Discover(g_topic));
+  waitForCallback(MaxIters, Nap, connectionExecuted);
+  EXPECT_TRUE(connectionExecuted);
+
+  // And forwards the later changes.
+  EXPECT_TRUE(discovery1.Unadvertise(g_topic, nUuid1));
+  waitForCallback(MaxIters, Nap, disconnectionExecuted);
+  EXPECT_TRUE(disconnectionExecuted);
+
+  EXPECT_FALSE(otherExecuted);
+}
+
+//////////////////////////////////////////////////
+/// \brief Check that a discovery node that filters by interest only keeps
+/// the topics that it's interested in.
+TEST(DiscoveryTest, TestFilterByInterest)
+{
+  reset();
+
+  const std::string otherTopic = g_topic + "_other";
+  const std::string prefixTopic = g_topic + "_prefix";
+
+  MsgDiscovery discovery1(pUuid1, g_msgPort);
+  MsgDiscovery discovery2(pUuid2, g_msgPort);
+
+  EXPECT_FALSE(discovery2.FilterByInterest());
+  discovery2.SetFilterByInterest(true);
+  EXPECT_TRUE(discovery2.FilterByInterest());
+  discovery2.AddInterest(g_topic);
+  discovery2.AddInterestPrefix(prefixTopic);
+
+  int otherCounter = 0;
+  discovery2.ConnectionsCb(
+    [&otherCounter](const MessagePublisher &_publisher)
+    {
+      if (_publisher.Topic() == g_topic)
+        connectionExecuted = true;
+      else if (_publisher.PUuid() == pUuid1)
+        ++otherCounter;
+    });
+
+  discovery1.Start();
+  discovery2.Start();
+
+  for (const auto &topic : {otherTopic, prefixTopic + "/a", g_topic})
+  {
+    MessagePublisher publisher(topic, addr1, ctrl1, pUuid1, nUuid1, "t",
+      AdvertiseMessageOptions());
+    EXPECT_TRUE(discovery1.Advertise(publisher));
+  }
+
+  waitForCallback(MaxIters, Nap, connectionExecuted);
+  EXPECT_TRUE(connectionExecuted);
+
+  // Only the topic with the prefix is also kept.
+  EXPECT_EQ(1, otherCounter);
+  MsgAddresses_M addresses;
+  EXPECT_TRUE(discovery2.Publishers(prefixTopic + "/a", addresses));
+  EXPECT_FALSE(discovery2.Publishers(otherTopic, addresses));
+}
+
+//////////////////////////////////////////////////
+/// \brief Check that the publishers of a discovery server keep hearing from
+/// the clients that only subscribe, past the silence interval.
+TEST(DiscoveryTest, TestServerSubscriberActivity)
+{
+  reset();
+
+  MsgDiscovery server(transport::Uuid().ToString(), g_msgPort, false, true);
+  server.Start();
+
+  setenv("IGN_DISCOVERY_SERVER", "127.0.0.1", 1);
+  DiscoveryDerived<MessagePublisher> discovery1(pUuid1, g_msgPort);
+  MsgDiscovery discovery2(pUuid2, g_msgPort);
+  unsetenv("IGN_DISCOVERY_SERVER");
+
+  const unsigned int silenceInterval = 1000;
+  discovery1.SetSilenceInterval(silenceInterval);
+  discovery2.SetHeartbeatInterval(200);
+
+  bool subscriberExpired = false;
+  discovery1.DisconnectionsCb(
+    [&subscriberExpired](const MessagePublisher &_pub)
+    {
+      if (_pub.PUuid() == pUuid2)
+        subscriberExpired = true;
+    });
+
+  discovery1.Start();
+  discovery2.Start();
+
+  MessagePublisher publisher(g_topic, addr1, ctrl1, pUuid1, nUuid1, "t",
+    AdvertiseMessageOptions());
+  EXPECT_TRUE(discovery1.Advertise(publisher));
+
+  discovery2.ConnectionsCb(onDiscoveryResponse);
+  EXPECT_TRUE(discovery2.Discover(g_topic));
+  waitForCallback(MaxIters, Nap, connectionExecuted);
+  EXPECT_TRUE(connectionExecuted);
+
+  // The subscriber doesn't advertise anything, but its heartbeats reach the
+  // publisher through the server.
+  std::this_thread::sleep_for(std::chrono::milliseconds(
+    2 * silenceInterval));
+  discovery1.TestActivity(pUuid2, true);
+  EXPECT_FALSE(subscriberExpired);
+}
+
 //////////////////////////////////////////////////
 /// \brief Check that a discovery service sends messages if there are
 /// topics or services advertised in its process.
@@ -239,6 +239,102 @@ TEST(RepStorageTest, SubStorageNoCallbacks)
   EXPECT_EQ(handler->HandlerUuid(), sub1HandlerPtr->HandlerUuid());
 }
 
+//////////////////////////////////////////////////
+/// \brief Check that the views returned by Handlers() share the stored
+/// handlers and don't change when the storage is modified.
+TEST(RepStorageTest, SubStorageViews)
+{
+  transport::HandlerStorage<transport::ISubscriptionHandler> subs;
+  EXPECT_EQ(nullptr, subs.Handlers(topic));
+
+  auto handler1 = std::make_shared<
+    transport::SubscriptionHandler<ignition::msgs::Int32>>(nUuid1);
+  auto handler2 = std::make_shared<
+    transport::SubscriptionHandler<ignition::msgs::Int32>>(nUuid2);
+  subs.AddHandler(topic, nUuid1, handler1);
+
+  auto view1 = subs.Handlers(topic);
+  ASSERT_NE(nullptr, view1);
+  EXPECT_EQ(view1, subs.Handlers(topic));
+  ASSERT_EQ(1u, view1->size());
+  EXPECT_EQ(handler1, view1->at(nUuid1).at(handler1->HandlerUuid()));
+
+  // Modifying the storage doesn't change the view in use.
+  subs.AddHandler(topic, nUuid2, handler2);
+  EXPECT_EQ(1u, view1->size());
+
+  auto view2 = subs.Handlers(topic);
+  ASSERT_NE(nullptr, view2);
+  EXPECT_EQ(2u, view2->size());
+
+  view1.reset();
+  view2.reset();
+
+  // Without views in use, the handlers are modified in place.
+  const auto *stored = subs.Handlers(topic).get();
+  EXPECT_TRUE(subs.RemoveHandlersForNode(topic, nUuid1));
+  EXPECT_EQ(stored, subs.Handlers(topic).get());
+  EXPECT_EQ(1u, subs.Handlers(topic)->size());
+
+  EXPECT_TRUE(subs.RemoveHandler(topic, nUuid2, handler2->HandlerUuid()));
+  EXPECT_EQ(nullptr, subs.Handlers(topic));
+  EXPECT_FALSE(subs.HasHandlersForTopic(topic));
+}
+
+//////////////////////////////////////////////////
+/// \brief Check that CreateMsg() parses in place and reuses the message
+/// object only when nobody else holds it.
+TEST(RepStorageTest, SubCreateMsgReuse)
+{
+  ignition::msgs::Int32 msg;
+  msg.set_data(5);
+  const std::string data = msg.SerializeAsString();
+
+  transport::SubscriptionHandler<ignition::msgs::Int32> handler(nUuid1);
+  auto msg1 = handler.CreateMsg(data.data(), data.size(), msg.GetTypeName());
+  ASSERT_NE(nullptr, msg1);
+  EXPECT_EQ(5, static_cast<ignition::msgs::Int32 *>(msg1.get())->data());
+
+  // The first message is still in use, so a new one is created.
+  msg.set_data(6);
+  const std::string data2 = msg.SerializeAsString();
+  auto msg2 = handler.CreateMsg(data2, msg.GetTypeName());
+  ASSERT_NE(nullptr, msg2);
+  EXPECT_NE(msg1.get(), msg2.get());
+  EXPECT_EQ(5, static_cast<ignition::msgs::Int32 *>(msg1.get())->data());
+  EXPECT_EQ(6, static_cast<ignition::msgs::Int32 *>(msg2.get())->data());
+
+  // Once released, the last message is reused.
+  transport::ProtoMsg *last = msg2.get();
+  msg1.reset();
+  msg2.reset();
+  auto msg3 = handler.CreateMsg(data.data(), data.size(), msg.GetTypeName());
+  EXPECT_EQ(last, msg3.get());
+  EXPECT_EQ(5, static_cast<ignition::msgs::Int32 *>(msg3.get())->data());
+
+  // Generic handlers only reuse the message if the type matches.
+  transport::SubscriptionHandler<transport::ProtoMsg> genericHandler(nUuid1);
+  auto generic1 = genericHandler.CreateMsg(data.data(), data.size(),
+    msg.GetTypeName());
+  ASSERT_NE(nullptr, generic1);
+  generic1.reset();
+
+  ignition::msgs::StringMsg strMsg;
+  strMsg.set_data("hello");
+  const std::string strData = strMsg.SerializeAsString();
+  auto generic2 = genericHandler.CreateMsg(strData.data(), strData.size(),
+    strMsg.GetTypeName());
+  ASSERT_NE(nullptr, generic2);
+  EXPECT_EQ(strMsg.GetTypeName(), generic2->GetTypeName());
+  generic2.reset();
+
+  auto generic3 = genericHandler.CreateMsg(strData.data(), strData.size(),
+    strMsg.GetTypeName());
+  ASSERT_NE(nullptr, generic3);
+  EXPECT_EQ("hello",
+    static_cast<ignition::msgs::StringMsg *>(generic3.get())->data());
+}
+
 //////////////////////////////////////////////////
 int main(int argc, char **argv)
 {
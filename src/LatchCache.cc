@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <algorithm>
+#include <utility>
+
+#include "LatchCache.hh"
+
+using namespace ignition;
+using namespace transport;
+
+//////////////////////////////////////////////////
+LatchCache::LatchCache(const uint64_t _depth, const uint64_t _streamId)
+  : depth(std::max<uint64_t>(_depth, 1)),
+    streamId(_streamId)
+{
+}
+
+//////////////////////////////////////////////////
+void LatchCache::Push(const char *_data, const std::size_t _size,
+  const std::string &_msgType)
+{
+  // Copy the data before taking the lock.
+  Entry entry;
+  entry.data = std::make_shared<const std::string>(_data, _size);
+  entry.msgType = _msgType;
+  entry.streamId = this->streamId;
+
+  std::lock_guard<std::mutex> lk(this->mutex);
+  if (this->entries.size() >= this->depth)
+    this->entries.pop_front();
+  this->entries.push_back(std::move(entry));
+}
+
+//////////////////////////////////////////////////
+std::vector<LatchCache::Entry> LatchCache::Entries() const
+{
+  std::lock_guard<std::mutex> lk(this->mutex);
+  return std::vector<Entry>(this->entries.begin(), this->entries.end());
+}
+
+//////////////////////////////////////////////////
+uint64_t LatchCache::Depth() const
+{
+  return this->depth;
+}
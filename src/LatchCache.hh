@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef IGN_TRANSPORT_LATCHCACHE_HH_
+#define IGN_TRANSPORT_LATCHCACHE_HH_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "ignition/transport/config.hh"
+#include "ignition/transport/Export.hh"
+
+namespace ignition
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace IGNITION_TRANSPORT_VERSION_NAMESPACE {
+    //
+    /// \internal
+    /// \brief The last messages of a latched publisher (see
+    /// AdvertiseMessageOptions::SetLatchDepth()), kept serialized to replay
+    /// them to the subscribers that join later.
+    class IGNITION_TRANSPORT_VISIBLE LatchCache
+    {
+      /// \brief A message kept.
+      public: struct Entry
+              {
+                /// \brief Serialized message. It's shared with the replays
+                /// in progress.
+                public: std::shared_ptr<const std::string> data;
+
+                /// \brief Message type name.
+                public: std::string msgType;
+
+                /// \brief Stream identifier of the publisher (see
+                /// MessagePublisher::StreamId()).
+                public: uint64_t streamId = 0;
+              };
+
+      /// \brief Constructor.
+      /// \param[in] _depth Maximum number of messages kept.
+      /// \param[in] _streamId Stream identifier of the publisher.
+      public: LatchCache(const uint64_t _depth, const uint64_t _streamId);
+
+      /// \brief Keep a message, dropping the oldest one if the cache is full.
+      /// \param[in] _data Serialized message.
+      /// \param[in] _size Size of the serialized message (bytes).
+      /// \param[in] _msgType Message type name.
+      public: void Push(const char *_data, const std::size_t _size,
+                        const std::string &_msgType);
+
+      /// \brief Get the messages kept.
+      /// \return The messages, oldest first.
+      public: std::vector<Entry> Entries() const;
+
+      /// \brief Get the maximum number of messages kept.
+      /// \return The depth of the cache.
+      public: uint64_t Depth() const;
+
+      /// \brief Protects the entries.
+      private: mutable std::mutex mutex;
+
+      /// \brief Messages kept, oldest first.
+      private: std::deque<Entry> entries;
+
+      /// \brief Maximum number of messages kept.
+      private: uint64_t depth;
+
+      /// \brief Stream identifier of the publisher.
+      private: uint64_t streamId;
+    };
+    }
+  }
+}
+#endif
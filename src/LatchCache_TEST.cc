@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "LatchCache.hh"
+
+using namespace ignition;
+using namespace transport;
+
+//////////////////////////////////////////////////
+/// \brief The cache keeps the last messages, oldest first.
+TEST(LatchCacheTest, Depth)
+{
+  LatchCache cache(2, 7u);
+  EXPECT_EQ(2u, cache.Depth());
+  EXPECT_TRUE(cache.Entries().empty());
+
+  const std::string msgs[] = {"first", "second", "third"};
+  for (const std::string &msg : msgs)
+    cache.Push(msg.data(), msg.size(), "ignition.msgs.StringMsg");
+
+  std::vector<LatchCache::Entry> entries = cache.Entries();
+  ASSERT_EQ(2u, entries.size());
+  EXPECT_EQ("second", *entries[0].data);
+  EXPECT_EQ("third", *entries[1].data);
+  EXPECT_EQ("ignition.msgs.StringMsg", entries[1].msgType);
+  EXPECT_EQ(7u, entries[1].streamId);
+
+  // A cache keeps at least one message.
+  LatchCache single(0, 7u);
+  EXPECT_EQ(1u, single.Depth());
+}
+
+//////////////////////////////////////////////////
+/// \brief The entries taken stay valid while the cache changes, and keep
+/// the type of each message.
+TEST(LatchCacheTest, Entries)
+{
+  LatchCache cache(1, 7u);
+  const std::string data("\0\1\2", 3);
+  cache.Push(data.data(), data.size(), "ignition.msgs.Bytes");
+  std::vector<LatchCache::Entry> entries = cache.Entries();
+
+  cache.Push("x", 1, "ignition.msgs.StringMsg");
+  ASSERT_EQ(1u, entries.size());
+  EXPECT_EQ(data, *entries[0].data);
+  EXPECT_EQ("ignition.msgs.Bytes", entries[0].msgType);
+
+  entries = cache.Entries();
+  ASSERT_EQ(1u, entries.size());
+  EXPECT_EQ("x", *entries[0].data);
+  EXPECT_EQ("ignition.msgs.StringMsg", entries[0].msgType);
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,371 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifdef _MSC_VER
+#pragma warning(push, 0)
+#endif
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/message.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "ignition/transport/Helpers.hh"
+#include "ignition/transport/MessageFilter.hh"
+
+#include "MessageFilterPrivate.hh"
+
+using namespace ignition;
+using namespace transport;
+
+namespace
+{
+  /// \brief Separates the field, the comparison and the value of a
+  /// serialized condition.
+  constexpr char kFieldSeparator = '\x1f';
+
+  /// \brief Separates the serialized conditions.
+  constexpr char kConditionSeparator = '\x1e';
+
+  /// \brief Separates the rate from the filter in a subscription key.
+  constexpr char kRateSeparator = '\x1d';
+
+  //////////////////////////////////////////////////
+  /// \brief Check that a string doesn't contain the separators.
+  /// \param[in] _text The string.
+  /// \return True if the string has no ASCII control characters.
+  bool validText(const std::string &_text)
+  {
+    for (const char c : _text)
+    {
+      if (static_cast<unsigned char>(c) < 0x20 || c == '\x7f')
+        return false;
+    }
+    return true;
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Convert a string to a signed integer.
+  /// \param[in] _text The string.
+  /// \param[out] _result The number.
+  /// \return False if the string isn't an integer.
+  bool toInt(const std::string &_text, int64_t &_result)
+  {
+    if (_text.empty())
+      return false;
+    char *end = nullptr;
+    errno = 0;
+    _result = std::strtoll(_text.c_str(), &end, 10);
+    return errno == 0 && *end == '\0';
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Convert a string to an unsigned integer.
+  /// \param[in] _text The string.
+  /// \param[out] _result The number.
+  /// \return False if the string isn't a non-negative integer.
+  bool toUint(const std::string &_text, uint64_t &_result)
+  {
+    if (_text.empty() || _text[0] == '-')
+      return false;
+    char *end = nullptr;
+    errno = 0;
+    _result = std::strtoull(_text.c_str(), &end, 10);
+    return errno == 0 && *end == '\0';
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Convert a string to a floating point number.
+  /// \param[in] _text The string.
+  /// \param[out] _result The number.
+  /// \return False if the string isn't a number.
+  bool toDouble(const std::string &_text, double &_result)
+  {
+    if (_text.empty())
+      return false;
+    char *end = nullptr;
+    errno = 0;
+    _result = std::strtod(_text.c_str(), &end);
+    return errno == 0 && *end == '\0';
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Compare two values.
+  /// \param[in] _a The value of the field.
+  /// \param[in] _op The comparison.
+  /// \param[in] _b The value of the condition.
+  /// \return The result of the comparison.
+  template<typename T>
+  bool compare(const T &_a, const MessageFilter::Op _op, const T &_b)
+  {
+    switch (_op)
+    {
+      case MessageFilter::Op::EQUAL:
+        return _a == _b;
+      case MessageFilter::Op::NOT_EQUAL:
+        return _a != _b;
+      case MessageFilter::Op::LESS:
+        return _a < _b;
+      case MessageFilter::Op::LESS_EQUAL:
+        return _a <= _b;
+      case MessageFilter::Op::GREATER:
+        return _a > _b;
+      case MessageFilter::Op::GREATER_EQUAL:
+        return _a >= _b;
+      default:
+        return false;
+    }
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Check a condition.
+  /// \param[in] _msg The message.
+  /// \param[in] _cond The condition.
+  /// \return True if the message satisfies the condition.
+  bool satisfies(const ProtoMsg &_msg,
+    const MessageFilterPrivate::Condition &_cond)
+  {
+    using google::protobuf::FieldDescriptor;
+
+    // Walk down the nested messages.
+    const ProtoMsg *msg = &_msg;
+    const FieldDescriptor *field = nullptr;
+    std::size_t start = 0;
+    while (true)
+    {
+      const std::size_t dot = _cond.field.find('.', start);
+      field = msg->GetDescriptor()->FindFieldByName(
+        _cond.field.substr(start, dot - start));
+      if (!field || field->is_repeated())
+        return false;
+
+      if (dot == std::string::npos)
+        break;
+
+      if (field->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE)
+        return false;
+      msg = &msg->GetReflection()->GetMessage(*msg, field);
+      start = dot + 1;
+    }
+
+    const auto *reflection = msg->GetReflection();
+    const std::string &value = _cond.value;
+    int64_t i;
+    uint64_t u;
+    double d;
+    switch (field->cpp_type())
+    {
+      case FieldDescriptor::CPPTYPE_INT32:
+        return toInt(value, i) &&
+          compare<int64_t>(reflection->GetInt32(*msg, field), _cond.op, i);
+      case FieldDescriptor::CPPTYPE_INT64:
+        return toInt(value, i) &&
+          compare<int64_t>(reflection->GetInt64(*msg, field), _cond.op, i);
+      case FieldDescriptor::CPPTYPE_UINT32:
+        return toUint(value, u) &&
+          compare<uint64_t>(reflection->GetUInt32(*msg, field), _cond.op, u);
+      case FieldDescriptor::CPPTYPE_UINT64:
+        return toUint(value, u) &&
+          compare<uint64_t>(reflection->GetUInt64(*msg, field), _cond.op, u);
+      case FieldDescriptor::CPPTYPE_DOUBLE:
+        return toDouble(value, d) &&
+          compare<double>(reflection->GetDouble(*msg, field), _cond.op, d);
+      case FieldDescriptor::CPPTYPE_FLOAT:
+        return toDouble(value, d) &&
+          compare<double>(reflection->GetFloat(*msg, field), _cond.op, d);
+      case FieldDescriptor::CPPTYPE_BOOL:
+      {
+        if (value == "true" || value == "1")
+          i = 1;
+        else if (value == "false" || value == "0")
+          i = 0;
+        else
+          return false;
+        return compare<int64_t>(reflection->GetBool(*msg, field), _cond.op, i);
+      }
+      case FieldDescriptor::CPPTYPE_ENUM:
+      {
+        const auto *enumValue = field->enum_type()->FindValueByName(value);
+        if (enumValue)
+          i = enumValue->number();
+        else if (!toInt(value, i))
+          return false;
+        return compare<int64_t>(reflection->GetEnum(*msg, field)->number(),
+          _cond.op, i);
+      }
+      case FieldDescriptor::CPPTYPE_STRING:
+        return compare<std::string>(reflection->GetString(*msg, field),
+          _cond.op, value);
+      default:
+        return false;
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+MessageFilter::MessageFilter()
+  : dataPtr(new MessageFilterPrivate())
+{
+}
+
+//////////////////////////////////////////////////
+MessageFilter::MessageFilter(const MessageFilter &_other)
+  : MessageFilter()
+{
+  (*this) = _other;
+}
+
+//////////////////////////////////////////////////
+MessageFilter::~MessageFilter()
+{
+}
+
+//////////////////////////////////////////////////
+MessageFilter &MessageFilter::operator=(const MessageFilter &_other)
+{
+  this->dataPtr->conditions = _other.dataPtr->conditions;
+  return *this;
+}
+
+//////////////////////////////////////////////////
+bool MessageFilter::operator==(const MessageFilter &_other) const
+{
+  return this->dataPtr->conditions == _other.dataPtr->conditions;
+}
+
+//////////////////////////////////////////////////
+bool MessageFilter::operator!=(const MessageFilter &_other) const
+{
+  return !(*this == _other);
+}
+
+//////////////////////////////////////////////////
+bool MessageFilter::AddCondition(const std::string &_field, const Op _op,
+  const std::string &_value)
+{
+  if (_field.empty() || !validText(_field) || !validText(_value))
+    return false;
+
+  MessageFilterPrivate::Condition cond{_field, _op, _value};
+  auto &conditions = this->dataPtr->conditions;
+  auto it = std::lower_bound(conditions.begin(), conditions.end(), cond);
+  if (it == conditions.end() || !(*it == cond))
+    conditions.insert(it, std::move(cond));
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool MessageFilter::Empty() const
+{
+  return this->dataPtr->conditions.empty();
+}
+
+//////////////////////////////////////////////////
+bool MessageFilter::Matches(const ProtoMsg &_msg) const
+{
+  for (const auto &cond : this->dataPtr->conditions)
+  {
+    if (!satisfies(_msg, cond))
+      return false;
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+std::string MessageFilter::Serialize() const
+{
+  std::string data;
+  for (const auto &cond : this->dataPtr->conditions)
+  {
+    if (!data.empty())
+      data.push_back(kConditionSeparator);
+    data.append(cond.field).push_back(kFieldSeparator);
+    data.append(std::to_string(static_cast<int>(cond.op)))
+      .push_back(kFieldSeparator);
+    data.append(cond.value);
+  }
+  return data;
+}
+
+//////////////////////////////////////////////////
+bool MessageFilter::Deserialize(const std::string &_data)
+{
+  this->dataPtr->conditions.clear();
+  if (_data.empty())
+    return true;
+
+  for (const std::string &condition : split(_data, kConditionSeparator))
+  {
+    const std::vector<std::string> parts = split(condition, kFieldSeparator);
+    int64_t op;
+    if (parts.size() != 3 || !toInt(parts[1], op) ||
+        op < static_cast<int64_t>(Op::EQUAL) ||
+        op > static_cast<int64_t>(Op::GREATER_EQUAL) ||
+        !this->AddCondition(parts[0], static_cast<Op>(op), parts[2]))
+    {
+      this->dataPtr->conditions.clear();
+      return false;
+    }
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+std::string MessageFilterPrivate::SubscriptionKey(
+  const MessageFilter &_filter, const uint64_t _msgsPerSec)
+{
+  if (_filter.Empty() && _msgsPerSec == kUnthrottled)
+    return "";
+
+  return std::to_string(_msgsPerSec) + kRateSeparator + _filter.Serialize();
+}
+
+//////////////////////////////////////////////////
+bool MessageFilterPrivate::ParseSubscriptionKey(const std::string &_key,
+  MessageFilter &_filter, uint64_t &_msgsPerSec)
+{
+  const std::size_t separator = _key.find(kRateSeparator);
+  if (separator == std::string::npos)
+    return false;
+
+  return toUint(_key.substr(0, separator), _msgsPerSec) &&
+    _msgsPerSec > 0 &&
+    _filter.Deserialize(_key.substr(separator + 1));
+}
+
+//////////////////////////////////////////////////
+uint64_t MessageFilterPrivate::SubscriptionId(const std::string &_key)
+{
+  if (_key.empty())
+    return 0;
+
+  // 64-bit FNV-1a.
+  uint64_t hash = 14695981039346656037ull;
+  for (const char c : _key)
+  {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ull;
+  }
+  return hash == 0 ? 1 : hash;
+}
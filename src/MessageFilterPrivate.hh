@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef IGN_TRANSPORT_MESSAGEFILTERPRIVATE_HH_
+#define IGN_TRANSPORT_MESSAGEFILTERPRIVATE_HH_
+
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "ignition/transport/config.hh"
+#include "ignition/transport/Export.hh"
+#include "ignition/transport/MessageFilter.hh"
+
+namespace ignition
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace IGNITION_TRANSPORT_VERSION_NAMESPACE {
+    //
+    /// \internal
+    /// \brief Private data for the MessageFilter class.
+    ///
+    /// It also builds the key that describes a subscription to the remote
+    /// publishers: its filter and its maximum rate. The publisher sends the
+    /// messages selected for each key through a separate stream, which only
+    /// the subscribers with that key receive.
+    class IGNITION_TRANSPORT_VISIBLE MessageFilterPrivate
+    {
+      /// \brief A condition on a field.
+      public: struct Condition
+      {
+        /// \brief Field path.
+        public: std::string field;
+
+        /// \brief Comparison.
+        public: MessageFilter::Op op;
+
+        /// \brief Value to compare with.
+        public: std::string value;
+
+        /// \brief Less than operator, to keep the conditions sorted.
+        /// \param[in] _other The other condition.
+        /// \return True if this condition goes first.
+        public: bool operator<(const Condition &_other) const
+        {
+          return std::tie(this->field, this->op, this->value) <
+            std::tie(_other.field, _other.op, _other.value);
+        }
+
+        /// \brief Equality operator.
+        /// \param[in] _other The other condition.
+        /// \return True if both conditions are the same.
+        public: bool operator==(const Condition &_other) const
+        {
+          return std::tie(this->field, this->op, this->value) ==
+            std::tie(_other.field, _other.op, _other.value);
+        }
+      };
+
+      /// \brief Get the key that describes a subscription to the remote
+      /// publishers.
+      /// \param[in] _filter Filter of the subscription.
+      /// \param[in] _msgsPerSec Maximum rate of the subscription.
+      /// \return The key, empty if the subscription wants every message.
+      public: static std::string SubscriptionKey(const MessageFilter &_filter,
+                                                 const uint64_t _msgsPerSec);
+
+      /// \brief Parse a key produced by SubscriptionKey().
+      /// \param[in] _key The key.
+      /// \param[out] _filter Filter of the subscription.
+      /// \param[out] _msgsPerSec Maximum rate of the subscription.
+      /// \return False if the key is invalid.
+      public: static bool ParseSubscriptionKey(const std::string &_key,
+                                               MessageFilter &_filter,
+                                               uint64_t &_msgsPerSec);
+
+      /// \brief Get a short identifier of a key, sent with the messages
+      /// selected for it. It's the same in every process.
+      /// \param[in] _key The key.
+      /// \return The identifier, 0 for the empty key.
+      public: static uint64_t SubscriptionId(const std::string &_key);
+
+      /// \brief Conditions, sorted and without duplicates.
+      public: std::vector<Condition> conditions;
+    };
+    }
+  }
+}
+#endif
@@ -0,0 +1,223 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <cstdint>
+#include <string>
+#include <ignition/msgs.hh>
+
+#include "ignition/transport/Helpers.hh"
+#include "ignition/transport/MessageFilter.hh"
+#include "gtest/gtest.h"
+#include "MessageFilterPrivate.hh"
+
+using namespace ignition;
+using namespace transport;
+
+using Op = MessageFilter::Op;
+
+//////////////////////////////////////////////////
+/// \brief Check the comparisons of numbers.
+TEST(MessageFilterTest, Numbers)
+{
+  msgs::Vector3d msg;
+  msg.set_x(2.5);
+
+  MessageFilter filter;
+  EXPECT_TRUE(filter.Empty());
+  EXPECT_TRUE(filter.Matches(msg));
+
+  struct Case
+  {
+    Op op;
+    std::string value;
+    bool expected;
+  };
+  const Case cases[] =
+  {
+    {Op::EQUAL, "2.5", true},
+    {Op::EQUAL, "2", false},
+    {Op::NOT_EQUAL, "2", true},
+    {Op::LESS, "3", true},
+    {Op::LESS, "2.5", false},
+    {Op::LESS_EQUAL, "2.5", true},
+    {Op::GREATER, "2.5", false},
+    {Op::GREATER, "-1e3", true},
+    {Op::GREATER_EQUAL, "2.5", true},
+    {Op::EQUAL, "abc", false},
+  };
+  for (const Case &c : cases)
+  {
+    MessageFilter single;
+    EXPECT_TRUE(single.AddCondition("x", c.op, c.value));
+    EXPECT_FALSE(single.Empty());
+    EXPECT_EQ(c.expected, single.Matches(msg)) << c.value;
+  }
+
+  // All the conditions must hold.
+  EXPECT_TRUE(filter.AddCondition("x", Op::GREATER, "2"));
+  EXPECT_TRUE(filter.AddCondition("y", Op::EQUAL, "0"));
+  EXPECT_TRUE(filter.Matches(msg));
+  msg.set_y(1);
+  EXPECT_FALSE(filter.Matches(msg));
+}
+
+//////////////////////////////////////////////////
+/// \brief Check nested fields and the other field types.
+TEST(MessageFilterTest, FieldTypes)
+{
+  msgs::Image msg;
+  msg.mutable_header()->mutable_stamp()->set_sec(100);
+  msg.set_width(640);
+  msg.set_pixel_format_type(msgs::PixelFormatType::RGB_INT8);
+
+  auto matches = [&msg](const std::string &_field, const Op _op,
+    const std::string &_value)
+  {
+    MessageFilter filter;
+    EXPECT_TRUE(filter.AddCondition(_field, _op, _value));
+    return filter.Matches(msg);
+  };
+
+  // Nested messages.
+  EXPECT_TRUE(matches("header.stamp.sec", Op::GREATER, "99"));
+  EXPECT_FALSE(matches("header.stamp.sec", Op::GREATER, "100"));
+  EXPECT_TRUE(matches("header.stamp.nsec", Op::EQUAL, "0"));
+
+  // Unsigned integers.
+  EXPECT_TRUE(matches("width", Op::EQUAL, "640"));
+  EXPECT_FALSE(matches("width", Op::GREATER, "-1"));
+
+  // Enums, by name or number.
+  EXPECT_TRUE(matches("pixel_format_type", Op::EQUAL, "RGB_INT8"));
+  EXPECT_FALSE(matches("pixel_format_type", Op::EQUAL, "L_INT8"));
+  EXPECT_TRUE(matches("pixel_format_type", Op::EQUAL,
+    std::to_string(msgs::PixelFormatType::RGB_INT8)));
+
+  // Fields that can't be compared.
+  EXPECT_FALSE(matches("unknown", Op::NOT_EQUAL, "0"));
+  EXPECT_FALSE(matches("width.sec", Op::NOT_EQUAL, "0"));
+  EXPECT_FALSE(matches("header.data", Op::NOT_EQUAL, "0"));
+  EXPECT_FALSE(matches("header", Op::NOT_EQUAL, "0"));
+
+  // Strings.
+  msgs::StringMsg str;
+  str.set_data("camera");
+  MessageFilter strFilter;
+  EXPECT_TRUE(strFilter.AddCondition("data", Op::EQUAL, "camera"));
+  EXPECT_TRUE(strFilter.Matches(str));
+  EXPECT_TRUE(strFilter.AddCondition("data", Op::LESS, "lidar"));
+  EXPECT_TRUE(strFilter.Matches(str));
+  str.set_data("sonar");
+  EXPECT_FALSE(strFilter.Matches(str));
+
+  // Booleans.
+  msgs::Boolean boolean;
+  boolean.set_data(true);
+  MessageFilter boolFilter;
+  EXPECT_TRUE(boolFilter.AddCondition("data", Op::EQUAL, "true"));
+  EXPECT_TRUE(boolFilter.Matches(boolean));
+  boolean.set_data(false);
+  EXPECT_FALSE(boolFilter.Matches(boolean));
+}
+
+//////////////////////////////////////////////////
+/// \brief Check the serialization and the comparison of filters.
+TEST(MessageFilterTest, Serialize)
+{
+  MessageFilter filter1;
+  EXPECT_TRUE(filter1.Serialize().empty());
+  EXPECT_TRUE(filter1.AddCondition("x", Op::LESS, "1"));
+  EXPECT_TRUE(filter1.AddCondition("header.stamp.sec", Op::GREATER, "5"));
+
+  // The order of the conditions and duplicates don't matter.
+  MessageFilter filter2;
+  EXPECT_NE(filter1, filter2);
+  EXPECT_TRUE(filter2.AddCondition("header.stamp.sec", Op::GREATER, "5"));
+  EXPECT_TRUE(filter2.AddCondition("x", Op::LESS, "1"));
+  EXPECT_TRUE(filter2.AddCondition("x", Op::LESS, "1"));
+  EXPECT_EQ(filter1, filter2);
+  EXPECT_EQ(filter1.Serialize(), filter2.Serialize());
+
+  MessageFilter filter3;
+  EXPECT_TRUE(filter3.Deserialize(filter1.Serialize()));
+  EXPECT_EQ(filter1, filter3);
+
+  MessageFilter filter4(filter3);
+  EXPECT_EQ(filter1, filter4);
+  filter4 = MessageFilter();
+  EXPECT_TRUE(filter4.Empty());
+
+  // Invalid conditions.
+  EXPECT_FALSE(filter4.AddCondition("", Op::EQUAL, "1"));
+  EXPECT_FALSE(filter4.AddCondition("x\x1f", Op::EQUAL, "1"));
+  EXPECT_FALSE(filter4.AddCondition("x", Op::EQUAL, "1\n"));
+  EXPECT_TRUE(filter4.Empty());
+
+  // Invalid serialized data.
+  EXPECT_FALSE(filter3.Deserialize("x"));
+  EXPECT_TRUE(filter3.Empty());
+  EXPECT_FALSE(filter3.Deserialize("x\x1f" "9\x1f" "1"));
+  EXPECT_FALSE(filter3.Deserialize("x\x1f" "0\x1f" "1\x1e"));
+  EXPECT_TRUE(filter3.Deserialize(""));
+}
+
+//////////////////////////////////////////////////
+/// \brief Check the keys that describe the subscriptions to the publishers.
+TEST(MessageFilterTest, SubscriptionKey)
+{
+  MessageFilter filter;
+  EXPECT_TRUE(MessageFilterPrivate::SubscriptionKey(filter,
+    kUnthrottled).empty());
+  EXPECT_EQ(0u, MessageFilterPrivate::SubscriptionId(""));
+
+  MessageFilter parsed;
+  uint64_t msgsPerSec = 0;
+  const std::string rateKey = MessageFilterPrivate::SubscriptionKey(filter, 10);
+  EXPECT_FALSE(rateKey.empty());
+  EXPECT_TRUE(MessageFilterPrivate::ParseSubscriptionKey(rateKey, parsed,
+    msgsPerSec));
+  EXPECT_TRUE(parsed.Empty());
+  EXPECT_EQ(10u, msgsPerSec);
+
+  EXPECT_TRUE(filter.AddCondition("x", Op::GREATER, "1"));
+  const std::string key =
+    MessageFilterPrivate::SubscriptionKey(filter, kUnthrottled);
+  EXPECT_TRUE(MessageFilterPrivate::ParseSubscriptionKey(key, parsed,
+    msgsPerSec));
+  EXPECT_EQ(filter, parsed);
+  EXPECT_EQ(kUnthrottled, msgsPerSec);
+
+  // The identifiers are stable and tell the keys apart.
+  EXPECT_NE(0u, MessageFilterPrivate::SubscriptionId(key));
+  EXPECT_EQ(MessageFilterPrivate::SubscriptionId(key),
+    MessageFilterPrivate::SubscriptionId(
+      MessageFilterPrivate::SubscriptionKey(parsed, kUnthrottled)));
+  EXPECT_NE(MessageFilterPrivate::SubscriptionId(key),
+    MessageFilterPrivate::SubscriptionId(rateKey));
+
+  EXPECT_FALSE(MessageFilterPrivate::ParseSubscriptionKey("x", parsed,
+    msgsPerSec));
+  EXPECT_FALSE(MessageFilterPrivate::ParseSubscriptionKey("0\x1d", parsed,
+    msgsPerSec));
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
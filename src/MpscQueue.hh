@@ -0,0 +1,395 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef IGN_TRANSPORT_MPSCQUEUE_HH_
+#define IGN_TRANSPORT_MPSCQUEUE_HH_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "ignition/transport/config.hh"
+
+namespace ignition
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace IGNITION_TRANSPORT_VERSION_NAMESPACE {
+    //
+    /// \internal
+    /// \brief What to do when pushing into a full queue.
+    enum class QueueOverflowPolicy
+    {
+      /// \brief Discard the oldest element of the queue.
+      DROP_OLDEST,
+
+      /// \brief Wait until there's room in the queue.
+      BLOCK,
+
+      /// \brief Discard the element being pushed.
+      DROP_NEWEST,
+
+      /// \brief Keep the element in an overflow list without limit. Nothing
+      /// is discarded and nobody waits.
+      GROW
+    };
+
+    /// \internal
+    /// \brief A bounded queue with many producers and a single consumer.
+    /// Push() and Pop() don't take any lock. A mutex is only used for
+    /// sleeping: by the consumer when the queue is empty and by the producers
+    /// when the queue is full and the policy is BLOCK. With the GROW policy,
+    /// the elements that don't fit go to an overflow list protected by the
+    /// mutex, until the consumer empties it.
+    ///
+    /// Each cell of the ring stores a sequence number that tells whether the
+    /// cell is ready to be written or read in the current lap, so producers
+    /// only compete on a single compare-and-swap of the write position.
+    template<typename T>
+    class MpscQueue
+    {
+      /// \brief Constructor.
+      /// \param[in] _capacity Maximum number of elements. The minimum
+      /// capacity is 2, smaller values are rounded up.
+      /// \param[in] _policy What to do when pushing into a full queue.
+      public: MpscQueue(const std::size_t _capacity,
+                        const QueueOverflowPolicy _policy)
+        : capacity(std::max<std::size_t>(_capacity, 2u)),
+          policy(_policy),
+          cells(new Cell[this->capacity])
+      {
+        for (std::size_t i = 0; i < this->capacity; ++i)
+          this->cells[i].seq.store(i, std::memory_order_relaxed);
+      }
+
+      /// \brief Get the maximum number of elements, without counting the
+      /// overflow list of the GROW policy.
+      /// \return The capacity of the queue.
+      public: std::size_t Capacity() const
+      {
+        return this->capacity;
+      }
+
+      /// \brief Get the overflow policy.
+      /// \return The overflow policy.
+      public: QueueOverflowPolicy Policy() const
+      {
+        return this->policy;
+      }
+
+      /// \brief Get the number of elements in the queue. The value is only an
+      /// approximation while other threads are pushing or popping.
+      /// \return The number of elements.
+      public: std::size_t Size() const
+      {
+        const std::size_t head =
+          this->dequeuePos.load(std::memory_order_relaxed);
+        const std::size_t tail =
+          this->enqueuePos.load(std::memory_order_relaxed);
+        const std::size_t overflowed =
+          this->overflowSize.load(std::memory_order_relaxed);
+        if (tail <= head)
+          return overflowed;
+        return std::min(tail - head, this->capacity) + overflowed;
+      }
+
+      /// \brief Get the number of elements discarded because the queue was
+      /// full.
+      /// \return The number of dropped elements.
+      public: uint64_t Dropped() const
+      {
+        return this->dropped.load(std::memory_order_relaxed);
+      }
+
+      /// \brief Push an element applying the overflow policy if the queue is
+      /// full.
+      /// \param[in] _value Element to push.
+      /// \param[in] _mayBlock When false, the BLOCK policy behaves as
+      /// DROP_NEWEST. Used to avoid a deadlock when the consumer thread
+      /// pushes into its own queue.
+      /// \return True if the element was queued or false if it was discarded.
+      public: bool Push(T &&_value, const bool _mayBlock = true)
+      {
+        // The elements go after the overflow list while it has any, so they
+        // keep their order.
+        while ((this->policy == QueueOverflowPolicy::GROW &&
+                this->overflowSize.load() > 0) || !this->TryPush(_value))
+        {
+          if (this->closed.load())
+            return false;
+
+          if (this->policy == QueueOverflowPolicy::GROW)
+          {
+            std::lock_guard<std::mutex> lk(this->mutex);
+            this->overflow.push_back(std::move(_value));
+            this->overflowSize.fetch_add(1);
+            break;
+          }
+          else if (this->policy == QueueOverflowPolicy::DROP_OLDEST)
+          {
+            T oldest;
+            if (this->TryPop(oldest))
+              this->dropped.fetch_add(1, std::memory_order_relaxed);
+          }
+          else if (this->policy == QueueOverflowPolicy::BLOCK && _mayBlock)
+          {
+            this->blockedProducers.fetch_add(1);
+            {
+              std::unique_lock<std::mutex> lk(this->mutex);
+              this->spaceAvailable.wait_for(lk, kBlockTimeout, [this]
+              {
+                return this->Size() < this->capacity || this->closed.load();
+              });
+            }
+            this->blockedProducers.fetch_sub(1);
+          }
+          else
+          {
+            this->dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+          }
+        }
+
+        // Wake up the consumer if it's sleeping.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (this->consumerWaiting.load(std::memory_order_relaxed))
+        {
+          std::lock_guard<std::mutex> lk(this->mutex);
+          this->dataAvailable.notify_one();
+        }
+        return true;
+      }
+
+      /// \brief Pop the oldest element.
+      /// \param[out] _value The element.
+      /// \return True if an element was popped or false if the queue was
+      /// empty.
+      public: bool Pop(T &_value)
+      {
+        if (!this->TryPop(_value) && !this->PopOverflow(_value))
+          return false;
+
+        if (this->blockedProducers.load() > 0)
+        {
+          std::lock_guard<std::mutex> lk(this->mutex);
+          this->spaceAvailable.notify_all();
+        }
+        return true;
+      }
+
+      /// \brief Wait until the queue is not empty, the queue is closed or a
+      /// timeout expires. Only the consumer should call this function.
+      /// \param[in] _timeout Maximum time to wait.
+      /// \return True if the queue is not empty.
+      public: template<typename Rep, typename Period>
+              bool Wait(const std::chrono::duration<Rep, Period> &_timeout)
+      {
+        std::unique_lock<std::mutex> lk(this->mutex);
+        this->consumerWaiting.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        this->dataAvailable.wait_for(lk, _timeout, [this]
+        {
+          return !this->Empty() || this->closed.load();
+        });
+        this->consumerWaiting.store(false, std::memory_order_relaxed);
+        return !this->Empty();
+      }
+
+      /// \brief Wake up the consumer and the blocked producers. Further
+      /// pushes into a full queue are discarded.
+      public: void Close()
+      {
+        std::lock_guard<std::mutex> lk(this->mutex);
+        this->closed = true;
+        this->dataAvailable.notify_all();
+        this->spaceAvailable.notify_all();
+      }
+
+      /// \brief Try to push an element without waiting.
+      /// \param[in, out] _value Element to push. It's moved into the queue
+      /// only on success.
+      /// \return True on success or false if the queue is full.
+      private: bool TryPush(T &_value)
+      {
+        Cell *cell;
+        std::size_t pos = this->enqueuePos.load(std::memory_order_relaxed);
+        while (true)
+        {
+          cell = &this->cells[pos % this->capacity];
+          const std::size_t seq = cell->seq.load(std::memory_order_acquire);
+          const intptr_t diff =
+            static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+          if (diff == 0)
+          {
+            if (this->enqueuePos.compare_exchange_weak(
+                  pos, pos + 1, std::memory_order_relaxed))
+            {
+              break;
+            }
+          }
+          else if (diff < 0)
+          {
+            return false;
+          }
+          else
+          {
+            pos = this->enqueuePos.load(std::memory_order_relaxed);
+          }
+        }
+
+        cell->value = std::move(_value);
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+      }
+
+      /// \brief Try to pop an element without waiting. Producers also call
+      /// this function to implement DROP_OLDEST, so it's safe to call it
+      /// concurrently.
+      /// \param[out] _value The element.
+      /// \return True on success or false if the queue is empty.
+      private: bool TryPop(T &_value)
+      {
+        Cell *cell;
+        std::size_t pos = this->dequeuePos.load(std::memory_order_relaxed);
+        while (true)
+        {
+          cell = &this->cells[pos % this->capacity];
+          const std::size_t seq = cell->seq.load(std::memory_order_acquire);
+          const intptr_t diff =
+            static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+          if (diff == 0)
+          {
+            if (this->dequeuePos.compare_exchange_weak(
+                  pos, pos + 1, std::memory_order_relaxed))
+            {
+              break;
+            }
+          }
+          else if (diff < 0)
+          {
+            return false;
+          }
+          else
+          {
+            pos = this->dequeuePos.load(std::memory_order_relaxed);
+          }
+        }
+
+        _value = std::move(cell->value);
+        cell->seq.store(pos + this->capacity, std::memory_order_release);
+        return true;
+      }
+
+      /// \brief Pop the oldest element of the overflow list. The ring is
+      /// only used again once the list is empty, so its elements are older.
+      /// \param[out] _value The element.
+      /// \return True on success or false if the list is empty.
+      private: bool PopOverflow(T &_value)
+      {
+        if (this->overflowSize.load() == 0)
+          return false;
+
+        std::lock_guard<std::mutex> lk(this->mutex);
+        if (this->overflow.empty())
+          return false;
+        _value = std::move(this->overflow.front());
+        this->overflow.pop_front();
+        this->overflowSize.fetch_sub(1);
+        return true;
+      }
+
+      /// \brief Whether the next cell to read has been written and the
+      /// overflow list is empty.
+      /// \return True if the queue is empty.
+      private: bool Empty() const
+      {
+        const std::size_t pos =
+          this->dequeuePos.load(std::memory_order_relaxed);
+        const Cell &cell = this->cells[pos % this->capacity];
+        return cell.seq.load(std::memory_order_acquire) != pos + 1 &&
+          this->overflowSize.load() == 0;
+      }
+
+      /// \brief A slot of the ring.
+      private: struct Cell
+               {
+                 /// \brief Position of the cell in the sequence of writes and
+                 /// reads.
+                 public: std::atomic<std::size_t> seq;
+
+                 /// \brief The stored element.
+                 public: T value;
+               };
+
+      /// \brief Maximum time a blocked producer sleeps before checking the
+      /// queue again.
+      private: static constexpr std::chrono::milliseconds kBlockTimeout{10};
+
+      /// \brief Maximum number of elements.
+      private: const std::size_t capacity;
+
+      /// \brief Overflow policy.
+      private: const QueueOverflowPolicy policy;
+
+      /// \brief The ring of cells.
+      private: std::unique_ptr<Cell[]> cells;
+
+      /// \brief Next position to write. Kept on its own cache line to avoid
+      /// false sharing with the consumer.
+      private: alignas(64) std::atomic<std::size_t> enqueuePos{0};
+
+      /// \brief Next position to read.
+      private: alignas(64) std::atomic<std::size_t> dequeuePos{0};
+
+      /// \brief Number of elements discarded because the queue was full.
+      private: alignas(64) std::atomic<uint64_t> dropped{0};
+
+      /// \brief True while the consumer is sleeping in Wait().
+      private: std::atomic<bool> consumerWaiting{false};
+
+      /// \brief Number of producers waiting for room in the queue.
+      private: std::atomic<int> blockedProducers{0};
+
+      /// \brief True after Close().
+      private: std::atomic<bool> closed{false};
+
+      /// \brief Elements that didn't fit in the ring, with the GROW policy.
+      private: std::deque<T> overflow;
+
+      /// \brief Number of elements in the overflow list.
+      private: std::atomic<std::size_t> overflowSize{0};
+
+      /// \brief Mutex used for sleeping, and to protect the overflow list.
+      private: std::mutex mutex;
+
+      /// \brief Signaled when an element is pushed.
+      private: std::condition_variable dataAvailable;
+
+      /// \brief Signaled when an element is popped.
+      private: std::condition_variable spaceAvailable;
+    };
+    }
+  }
+}
+#endif
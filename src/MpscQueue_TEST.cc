@@ -0,0 +1,213 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "MpscQueue.hh"
+
+using namespace ignition;
+using namespace transport;
+
+//////////////////////////////////////////////////
+TEST(MpscQueueTest, PushPop)
+{
+  MpscQueue<std::unique_ptr<int>> queue(3u, QueueOverflowPolicy::BLOCK);
+  EXPECT_EQ(3u, queue.Capacity());
+  EXPECT_EQ(QueueOverflowPolicy::BLOCK, queue.Policy());
+  EXPECT_EQ(0u, queue.Size());
+
+  std::unique_ptr<int> value;
+  EXPECT_FALSE(queue.Pop(value));
+  EXPECT_FALSE(queue.Wait(std::chrono::milliseconds(1)));
+
+  // Wrap around the ring a few times.
+  for (int i = 0; i < 10; ++i)
+  {
+    EXPECT_TRUE(queue.Push(std::make_unique<int>(i)));
+    EXPECT_TRUE(queue.Push(std::make_unique<int>(i + 100)));
+    EXPECT_EQ(2u, queue.Size());
+    EXPECT_TRUE(queue.Wait(std::chrono::milliseconds(1)));
+
+    ASSERT_TRUE(queue.Pop(value));
+    EXPECT_EQ(i, *value);
+    ASSERT_TRUE(queue.Pop(value));
+    EXPECT_EQ(i + 100, *value);
+    EXPECT_EQ(0u, queue.Size());
+  }
+  EXPECT_EQ(0u, queue.Dropped());
+}
+
+//////////////////////////////////////////////////
+TEST(MpscQueueTest, DropNewest)
+{
+  MpscQueue<int> queue(2u, QueueOverflowPolicy::DROP_NEWEST);
+  EXPECT_TRUE(queue.Push(1));
+  EXPECT_TRUE(queue.Push(2));
+  EXPECT_FALSE(queue.Push(3));
+  EXPECT_EQ(1u, queue.Dropped());
+  EXPECT_EQ(2u, queue.Size());
+
+  int value;
+  ASSERT_TRUE(queue.Pop(value));
+  EXPECT_EQ(1, value);
+  ASSERT_TRUE(queue.Pop(value));
+  EXPECT_EQ(2, value);
+}
+
+//////////////////////////////////////////////////
+TEST(MpscQueueTest, DropOldest)
+{
+  MpscQueue<int> queue(2u, QueueOverflowPolicy::DROP_OLDEST);
+  EXPECT_TRUE(queue.Push(1));
+  EXPECT_TRUE(queue.Push(2));
+  EXPECT_TRUE(queue.Push(3));
+  EXPECT_EQ(1u, queue.Dropped());
+  EXPECT_EQ(2u, queue.Size());
+
+  int value;
+  ASSERT_TRUE(queue.Pop(value));
+  EXPECT_EQ(2, value);
+  ASSERT_TRUE(queue.Pop(value));
+  EXPECT_EQ(3, value);
+}
+
+//////////////////////////////////////////////////
+TEST(MpscQueueTest, Grow)
+{
+  MpscQueue<int> queue(2u, QueueOverflowPolicy::GROW);
+  for (int i = 0; i < 5; ++i)
+    EXPECT_TRUE(queue.Push(std::move(i)));
+  EXPECT_EQ(0u, queue.Dropped());
+  EXPECT_EQ(5u, queue.Size());
+  EXPECT_TRUE(queue.Wait(std::chrono::milliseconds(1)));
+
+  // The elements that didn't fit keep their order, also with the ones
+  // pushed while the overflow list isn't empty.
+  int value;
+  ASSERT_TRUE(queue.Pop(value));
+  EXPECT_EQ(0, value);
+  EXPECT_TRUE(queue.Push(5));
+  for (int i = 1; i < 6; ++i)
+  {
+    ASSERT_TRUE(queue.Pop(value));
+    EXPECT_EQ(i, value);
+  }
+  EXPECT_FALSE(queue.Pop(value));
+  EXPECT_EQ(0u, queue.Size());
+
+  // The ring is used again.
+  EXPECT_TRUE(queue.Push(6));
+  ASSERT_TRUE(queue.Pop(value));
+  EXPECT_EQ(6, value);
+}
+
+//////////////////////////////////////////////////
+TEST(MpscQueueTest, Block)
+{
+  MpscQueue<int> queue(0u, QueueOverflowPolicy::BLOCK);
+  EXPECT_EQ(2u, queue.Capacity());
+  EXPECT_TRUE(queue.Push(0));
+  EXPECT_TRUE(queue.Push(1));
+
+  // Never block if not allowed.
+  EXPECT_FALSE(queue.Push(2, false));
+  EXPECT_EQ(1u, queue.Dropped());
+
+  std::atomic<bool> pushed{false};
+  std::thread producer([&]()
+  {
+    EXPECT_TRUE(queue.Push(3));
+    pushed = true;
+  });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(pushed);
+
+  int value;
+  ASSERT_TRUE(queue.Pop(value));
+  EXPECT_EQ(0, value);
+  producer.join();
+  EXPECT_TRUE(pushed);
+  ASSERT_TRUE(queue.Pop(value));
+  EXPECT_EQ(1, value);
+
+  // Close() releases the blocked producers.
+  EXPECT_TRUE(queue.Push(4));
+  std::thread closed([&]()
+  {
+    EXPECT_FALSE(queue.Push(5));
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  queue.Close();
+  closed.join();
+}
+
+//////////////////////////////////////////////////
+/// \brief Several producers and one consumer. Every element is received and
+/// the elements of each producer keep their order.
+/// \param[in] _policy Overflow policy of the queue.
+void multipleProducers(const QueueOverflowPolicy _policy)
+{
+  const int kProducers = 4;
+  const int kElements = 20000;
+  MpscQueue<int> queue(64u, _policy);
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; ++p)
+  {
+    producers.emplace_back([&queue, p]()
+    {
+      for (int i = 0; i < kElements; ++i)
+        queue.Push(p * kElements + i);
+    });
+  }
+
+  std::vector<int> last(kProducers, -1);
+  int received = 0;
+  while (received < kProducers * kElements)
+  {
+    if (!queue.Wait(std::chrono::seconds(5)))
+      break;
+
+    int value;
+    while (queue.Pop(value))
+    {
+      const int p = value / kElements;
+      EXPECT_GT(value % kElements, last[p]);
+      last[p] = value % kElements;
+      ++received;
+    }
+  }
+
+  for (auto &producer : producers)
+    producer.join();
+
+  EXPECT_EQ(kProducers * kElements, received);
+  EXPECT_EQ(0u, queue.Dropped());
+}
+
+//////////////////////////////////////////////////
+TEST(MpscQueueTest, MultipleProducers)
+{
+  multipleProducers(QueueOverflowPolicy::BLOCK);
+  multipleProducers(QueueOverflowPolicy::GROW);
+}
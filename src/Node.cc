@@ -15,21 +15,28 @@
  *
 */
 #include <ignition/msgs/discovery.pb.h>
+#include <ignition/msgs/Factory.hh>
 #include <ignition/msgs/statistic.pb.h>
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <csignal>
 #include <condition_variable>
 #include <iostream>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>  //NOLINT
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+#include "ignition/transport/Codec.hh"
 #include "ignition/transport/Helpers.hh"
+#include "ignition/transport/MessageFilter.hh"
 #include "ignition/transport/MessageInfo.hh"
 #include "ignition/transport/Node.hh"
 #include "ignition/transport/NodeOptions.hh"
@@ -38,8 +45,11 @@
 #include "ignition/transport/TransportTypes.hh"
 #include "ignition/transport/Uuid.hh"
 
+#include "LatchCache.hh"
+#include "MessageFilterPrivate.hh"
 #include "NodePrivate.hh"
 #include "NodeSharedPrivate.hh"
+#include "RcuCell.hh"
 
 #ifdef _MSC_VER
 #pragma warning(disable: 4503)
@@ -101,6 +111,27 @@ namespace ignition
       g_shutdown_cv.wait(lk, []{return g_shutdown;});
     }
 
+    //////////////////////////////////////////////////
+    /// \brief Append the handlers of a node to a list.
+    /// \param[in] _view Handlers of a topic.
+    /// \param[in] _nUuid Node UUID.
+    /// \param[in, out] _handlers The list.
+    template<typename HandlersView>
+    static void collectNodeHandlers(const HandlersView &_view,
+      const std::string &_nUuid,
+      std::vector<std::shared_ptr<SubscriptionHandlerBase>> &_handlers)
+    {
+      if (!_view)
+        return;
+
+      auto it = _view->find(_nUuid);
+      if (it == _view->end())
+        return;
+
+      for (const auto &handler : it->second)
+        _handlers.push_back(handler.second);
+    }
+
     //////////////////////////////////////////////////
     /// \internal
     /// \brief Private data for Node::Publisher class.
@@ -116,7 +147,9 @@ namespace ignition
       /// \param[in] _publisher The message publisher.
       public: explicit PublisherPrivate(const MessagePublisher &_publisher)
         : shared(NodeShared::Instance()),
-          publisher(_publisher)
+          publisher(_publisher),
+          topic(_publisher.Topic()),
+          streamId(_publisher.StreamId())
       {
       }
 
@@ -175,6 +208,263 @@ namespace ignition
           std::cerr << "~PublisherPrivate() Error unadvertising topic ["
                     << this->publisher.Topic() << "]" << std::endl;
         }
+
+        // Remove the shared memory ring if this was the last publisher of the
+        // topic in this process.
+        MsgAddresses_M addresses;
+        this->shared->dataPtr->msgDiscovery->Publishers(
+          this->publisher.Topic(), addresses);
+        if (addresses.find(this->shared->pUuid) == addresses.end())
+        {
+          std::lock_guard<std::mutex> shmLk(this->shared->dataPtr->shmMutex);
+          this->shared->dataPtr->shmWriters.erase(this->publisher.Topic());
+        }
+
+        // Stop replaying the messages of this publisher.
+        if (this->latch)
+        {
+          std::lock_guard<std::mutex> latchLk(
+            this->shared->dataPtr->latchMutex);
+          auto &latchCaches = this->shared->dataPtr->latchCaches;
+          auto it = latchCaches.find(this->publisher.Topic());
+          if (it != latchCaches.end())
+          {
+            auto &caches = it->second;
+            caches.erase(std::remove(caches.begin(), caches.end(),
+              this->latch), caches.end());
+            if (caches.empty())
+              latchCaches.erase(it);
+          }
+        }
+      }
+
+      /// \brief Subscribers of the topic at some point in time.
+      public: struct SubscriberSnapshot
+              {
+                /// \brief Value of NodeSharedPrivate::subscribersEpoch when
+                /// the subscribers were looked up.
+                public: uint64_t epoch = 0;
+
+                /// \brief The subscribers.
+                public: NodeShared::SubscriberInfo info;
+              };
+
+      /// \brief Get the subscribers of the topic. They're only looked up
+      /// again if a subscriber was added or removed anywhere since the last
+      /// call, so a stable set of subscribers takes no lock.
+      /// \param[in] _guard Read guard of subscriberCache. The returned
+      /// reference is valid while the guard exists.
+      /// \return The subscribers.
+      public: const NodeShared::SubscriberInfo &Subscribers(
+        const RcuCell<SubscriberSnapshot>::ReadGuard &_guard)
+      {
+        const uint64_t epoch = this->shared->dataPtr->subscribersEpoch.load();
+        const SubscriberSnapshot *snapshot = _guard.Get();
+        if (snapshot && snapshot->epoch == epoch)
+          return snapshot->info;
+
+        // The new snapshot is labeled with the epoch read before looking up
+        // the subscribers. If they change in the meantime, the next call
+        // looks them up again.
+        std::unique_ptr<SubscriberSnapshot> fresh(new SubscriberSnapshot);
+        fresh->epoch = epoch;
+        fresh->info = this->shared->CheckSubscriberInfo(
+          this->publisher.Topic(), this->publisher.MsgTypeName());
+        const NodeShared::SubscriberInfo &info = fresh->info;
+        this->subscriberCache.Update(std::move(fresh));
+        return info;
+      }
+
+      /// \brief A message waiting to be sent to remote subscribers.
+      public: struct RemoteMsg
+              {
+                /// \brief Topic frame. It's the topic name, unless the
+                /// message goes to the stream of a filter.
+                public: const std::string *frame;
+
+                /// \brief Stream identifier of the publisher.
+                public: uint64_t streamId;
+
+                /// \brief Serialized message.
+                public: char *data;
+
+                /// \brief Size of the serialized message (bytes).
+                public: std::size_t size;
+
+                /// \brief Function that releases the data once sent.
+                public: DeallocFunc *deallocator;
+
+                /// \brief Hint passed to the deallocator.
+                public: void *hint;
+
+                /// \brief Message type name if it isn't the advertised type,
+                /// or empty.
+                public: std::string msgType;
+
+                /// \brief Identifier of the codec that compressed the data,
+                /// or 0.
+                public: uint8_t codec;
+              };
+
+      /// \brief Messages published together. Subscribers are resolved once
+      /// per topic, the local deliveries are queued as a single element of
+      /// the publish queue and the remote sends happen under a single lock.
+      public: struct Batch
+              {
+                /// \brief Subscribers of the topic being published.
+                public: const NodeShared::SubscriberInfo *subscribers =
+                          nullptr;
+
+                /// \brief True if the same message is published on several
+                /// topics. It's then serialized and copied only once.
+                public: bool sameMsg = false;
+
+                /// \brief Serialized message, when sameMsg is true.
+                public: std::shared_ptr<const char> sharedBuffer;
+
+                /// \brief Copy of the message for the local subscribers, when
+                /// sameMsg is true.
+                public: std::shared_ptr<const ProtoMsg> msgCopy;
+
+                /// \brief Local deliveries. The rest of the deliveries are
+                /// chained to the first one.
+                public: std::unique_ptr<NodeSharedPrivate::PublishMsgDetails>
+                          localDetails;
+
+                /// \brief Messages for the remote subscribers.
+                public: std::vector<RemoteMsg> remoteMsgs;
+              };
+
+      /// \brief Publish a message.
+      /// \param[in] _msg The message.
+      /// \param[in] _sharedMsg If not null, the same message as _msg, owned
+      /// by a shared pointer. Local subscribers receive it instead of a copy.
+      /// \param[in, out] _batch If not null, the message is added to this
+      /// batch instead of being sent right away. Throttling is up to the
+      /// caller and the subscribers are taken from the batch.
+      /// \return true when success.
+      public: bool Publish(const ProtoMsg &_msg,
+                           const std::shared_ptr<const ProtoMsg> &_sharedMsg,
+                           Batch *_batch = nullptr);
+
+      /// \brief Send the messages accumulated in a batch.
+      /// \param[in] _shared The object shared by all the nodes.
+      /// \param[in, out] _batch The batch. It's empty after the call.
+      /// \return true when success.
+      public: static bool Flush(NodeShared *_shared, Batch &_batch);
+
+      /// \brief Push the local deliveries of a message into the publish
+      /// queue.
+      /// \param[in] _shared The object shared by all the nodes.
+      /// \param[in] _msgDetails The deliveries.
+      public: static void EnqueueLocal(NodeShared *_shared,
+        std::unique_ptr<NodeSharedPrivate::PublishMsgDetails> _msgDetails);
+
+      /// \brief Publish a raw pre-serialized message.
+      /// \param[in] _msgData The serialized message.
+      /// \param[in] _msgSize Size of the serialized message (bytes).
+      /// \param[in] _msgType The message type name.
+      /// \param[in] _onDone See Node::Publisher::PublishRaw(). If empty, the
+      /// data is copied for remote subscribers.
+      /// \return true when success.
+      public: bool PublishRaw(const char *_msgData,
+                              const std::size_t _msgSize,
+                              const std::string &_msgType,
+                              std::function<void()> _onDone);
+
+      /// \brief Compress a message for the remote subscribers, if the
+      /// publisher compresses its messages and the message is large enough.
+      /// \param[in] _data The serialized message.
+      /// \param[in] _size Size of the serialized message (bytes).
+      /// \return The compressed message, or null when the message should be
+      /// sent uncompressed.
+      public: std::unique_ptr<std::string> Compress(const char *_data,
+                                                    const std::size_t _size)
+      {
+        if (!this->codec || _size < this->compressionThreshold)
+          return nullptr;
+
+        std::unique_ptr<std::string> compressed(new std::string);
+        if (!this->codec->Compress(_data, _size, this->compressionLevel,
+              *compressed))
+        {
+          std::cerr << "Node::Publisher::Publish(): Error compressing data "
+                    << "with codec [" << this->codec->Name() << "]"
+                    << std::endl;
+          return nullptr;
+        }
+
+        // Not worth it for data that doesn't compress.
+        if (compressed->size() >= _size)
+          return nullptr;
+
+        return compressed;
+      }
+
+      /// \brief Messages selected by a filter of the remote subscribers.
+      public: struct FilterStream
+              {
+                /// \brief Conditions on the messages.
+                public: MessageFilter filter;
+
+                /// \brief Minimum period between two messages in
+                /// nanoseconds, or 0.
+                public: double periodNs = 0.0;
+
+                /// \brief Time when the last message was sent.
+                public: Timestamp lastSent;
+
+                /// \brief Topic frame of the messages.
+                public: std::string frame;
+
+                /// \brief False if the filter couldn't be parsed.
+                public: bool valid = true;
+              };
+
+      /// \brief Select the filter streams that get a message.
+      /// \param[in] _filters Filter keys of the remote subscribers, see
+      /// NodeShared::SubscriberInfo::remoteFilters.
+      /// \param[in] _msg The message, or null if it's not available. Then,
+      /// it doesn't satisfy any condition.
+      /// \return Topic frames of the streams that get the message.
+      public: std::vector<const std::string *> FilterStreams(
+        const std::vector<std::string> &_filters, const ProtoMsg *_msg);
+
+      /// \brief Send a serialized message to the remote subscribers.
+      /// \param[in] _data Serialized message, released with _deallocator.
+      /// \param[in] _size Size of the data (bytes).
+      /// \param[in] _deallocator Function that releases the data once sent.
+      /// \param[in] _hint Hint passed to the deallocator.
+      /// \param[in] _msgType Message type name if it isn't the advertised
+      /// type, or empty.
+      /// \param[in] _codec Identifier of the codec that compressed the data,
+      /// or 0.
+      /// \param[in] _unfiltered True to send it to the subscribers without
+      /// filter.
+      /// \param[in] _frames Topic frames of the filter streams that get it.
+      /// \param[in, out] _batch If not null, the messages are added to this
+      /// batch instead of being sent right away.
+      /// \return true when success.
+      public: bool SendRemote(char *_data, const std::size_t _size,
+                              DeallocFunc *_deallocator, void *_hint,
+                              const std::string &_msgType,
+                              const uint8_t _codec, const bool _unfiltered,
+                              const std::vector<const std::string *> &_frames,
+                              Batch *_batch);
+
+      /// \brief Deallocator of the data shared by several messages sent by
+      /// ZeroMQ.
+      /// \param[in] _hint A std::shared_ptr<const char> on the data.
+      public: static void ReleaseShared(void *, void *_hint)
+      {
+        delete static_cast<std::shared_ptr<const char> *>(_hint);
+      }
+
+      /// \brief Deallocator of the compressed messages sent by ZeroMQ.
+      /// \param[in] _hint The std::string created by Compress().
+      public: static void DeleteCompressed(void *, void *_hint)
+      {
+        delete static_cast<std::string *>(_hint);
       }
 
       /// \brief Create a MessageInfo object for this Publisher
@@ -198,6 +488,14 @@ namespace ignition
       /// \brief The message publisher.
       public: MessagePublisher publisher;
 
+      /// \brief Fully qualified topic name. It's the frame of the messages
+      /// sent to the remote subscribers.
+      public: std::string topic;
+
+      /// \brief Stream identifier assigned when the topic was advertised.
+      /// It's sent with every message instead of the topic and type.
+      public: uint64_t streamId = 0;
+
       /// \brief Timestamp of the last callback executed.
       public: Timestamp lastCbTimestamp;
 
@@ -205,8 +503,30 @@ namespace ignition
       /// message in nanoseconds.
       public: double periodNs = 0.0;
 
+      /// \brief Codec that compresses the messages sent to other processes,
+      /// or null.
+      public: std::shared_ptr<const Codec> codec;
+
+      /// \brief Compression level.
+      public: int compressionLevel = 0;
+
+      /// \brief Minimum size of a message to compress it.
+      public: uint64_t compressionThreshold = 0;
+
+      /// \brief Streams of the filters of the remote subscribers, indexed by
+      /// filter key. A topic has few distinct filters, so they're kept while
+      /// the publisher exists.
+      public: std::unordered_map<std::string, FilterStream> filterStreams;
+
+      /// \brief Last messages published, replayed to the new subscribers,
+      /// or null if the publisher isn't latched.
+      public: std::shared_ptr<LatchCache> latch;
+
       /// \brief Mutex to protect the node::publisher from race conditions.
       public: mutable std::mutex mutex;
+
+      /// \brief Subscribers of the topic, as of the last publication.
+      public: RcuCell<SubscriberSnapshot> subscriberCache;
     };
     }
   }
@@ -227,6 +547,25 @@ Node::Publisher::Publisher(const MessagePublisher &_publisher)
     this->dataPtr->periodNs =
       1e9 / this->dataPtr->publisher.Options().MsgsPerSec();
   }
+
+  const AdvertiseMessageOptions &opts = this->dataPtr->publisher.Options();
+  if (!opts.Compression().empty())
+  {
+    this->dataPtr->codec = Codec::Find(opts.Compression());
+    this->dataPtr->compressionLevel = opts.CompressionLevel();
+    this->dataPtr->compressionThreshold = opts.CompressionThreshold();
+  }
+
+  // Keep the last messages for the subscribers that join later.
+  if (opts.Latched())
+  {
+    this->dataPtr->latch = std::make_shared<LatchCache>(opts.LatchDepth(),
+      this->dataPtr->streamId);
+    NodeSharedPrivate *shared = this->dataPtr->shared->dataPtr.get();
+    std::lock_guard<std::mutex> lk(shared->latchMutex);
+    shared->latchCaches[this->dataPtr->publisher.Topic()].push_back(
+      this->dataPtr->latch);
+  }
 }
 
 //////////////////////////////////////////////////
@@ -259,7 +598,8 @@ bool Node::Publisher::HasConnections() const
   const std::string &topic = publisher.Topic();
   const std::string &msgType = publisher.MsgTypeName();
 
-  std::lock_guard<std::recursive_mutex> lk(this->dataPtr->shared->mutex);
+  std::shared_lock<std::shared_mutex> lk(
+    this->dataPtr->shared->subscribersMutex);
 
   /// \todo(anyone): Checking "remoteSubscribers.HasTopic()" will return
   /// true even
@@ -277,27 +617,183 @@ bool Node::Publisher::Publish(const ProtoMsg &_msg)
   if (!this->Valid())
     return false;
 
+  return this->dataPtr->Publish(_msg, nullptr);
+}
+
+//////////////////////////////////////////////////
+bool Node::Publisher::Publish(std::shared_ptr<const ProtoMsg> _msg)
+{
+  if (!this->Valid())
+    return false;
+
+  if (!_msg)
+  {
+    std::cerr << "Node::Publisher::Publish(): NULL message" << std::endl;
+    return false;
+  }
+
+  return this->dataPtr->Publish(*_msg, _msg);
+}
+
+//////////////////////////////////////////////////
+bool Node::Publisher::PublishBatch(const std::vector<const ProtoMsg *> &_msgs)
+{
+  if (!this->Valid())
+    return false;
+
+  // Validate the whole batch first, so it's either published or not.
   const std::string &publisherMsgType = this->dataPtr->publisher.MsgTypeName();
+  for (const ProtoMsg *msg : _msgs)
+  {
+    if (!msg)
+    {
+      std::cerr << "Node::Publisher::PublishBatch(): NULL message"
+                << std::endl;
+      return false;
+    }
+
+    if (publisherMsgType != msg->GetTypeName())
+    {
+      std::cerr << "Node::Publisher::PublishBatch() Type mismatch.\n"
+                << "\t* Type advertised: " << publisherMsgType
+                << "\n\t* Type published: " << msg->GetTypeName()
+                << std::endl;
+      return false;
+    }
+  }
+
+  // The whole batch counts as a single publication.
+  if (_msgs.empty() || !this->dataPtr->UpdateThrottling())
+    return true;
+
+  auto guard = this->dataPtr->subscriberCache.Read();
+  PublisherPrivate::Batch batch;
+  batch.subscribers = &this->dataPtr->Subscribers(guard);
+
+  bool result = true;
+  for (const ProtoMsg *msg : _msgs)
+  {
+    if (!this->dataPtr->Publish(*msg, nullptr, &batch))
+    {
+      result = false;
+      break;
+    }
+  }
+
+  return PublisherPrivate::Flush(this->dataPtr->shared, batch) && result;
+}
+
+//////////////////////////////////////////////////
+bool Node::PublishBatch(const std::vector<Node::Publisher> &_publishers,
+  const ProtoMsg &_msg)
+{
+  NodeShared *shared = this->Shared();
+  const std::string msgType = _msg.GetTypeName();
+
+  for (const Node::Publisher &pub : _publishers)
+  {
+    if (!pub.Valid())
+      return false;
+
+    const std::string &publisherMsgType = pub.dataPtr->publisher.MsgTypeName();
+    if (publisherMsgType != msgType)
+    {
+      std::cerr << "Node::PublishBatch() Type mismatch on topic ["
+                << pub.dataPtr->publisher.Topic() << "].\n"
+                << "\t* Type advertised: " << publisherMsgType
+                << "\n\t* Type published: " << msgType << std::endl;
+      return false;
+    }
+  }
+
+  Node::PublisherPrivate::Batch batch;
+  batch.sameMsg = true;
+
+  bool result = true;
+  for (const Node::Publisher &pub : _publishers)
+  {
+    // Each publisher keeps its own throttling.
+    if (!pub.dataPtr->UpdateThrottling())
+      continue;
+
+    auto guard = pub.dataPtr->subscriberCache.Read();
+    batch.subscribers = &pub.dataPtr->Subscribers(guard);
+
+    if (!pub.dataPtr->Publish(_msg, nullptr, &batch))
+    {
+      result = false;
+      break;
+    }
+  }
+
+  return Node::PublisherPrivate::Flush(shared, batch) && result;
+}
+
+//////////////////////////////////////////////////
+bool Node::PublisherPrivate::Flush(NodeShared *_shared, Batch &_batch)
+{
+  if (_batch.localDetails)
+    EnqueueLocal(_shared, std::move(_batch.localDetails));
+
+  bool result = true;
+  if (!_batch.remoteMsgs.empty())
+  {
+    for (const RemoteMsg &msg : _batch.remoteMsgs)
+    {
+      result = _shared->dataPtr->SendMsg(*msg.frame, msg.streamId, msg.data,
+        msg.size, msg.deallocator, msg.msgType, msg.hint, msg.codec) &&
+        result;
+    }
+    _batch.remoteMsgs.clear();
+  }
+
+  return result;
+}
+
+//////////////////////////////////////////////////
+void Node::PublisherPrivate::EnqueueLocal(NodeShared *_shared,
+  std::unique_ptr<NodeSharedPrivate::PublishMsgDetails> _msgDetails)
+{
+  // A callback publishing from the publish thread can't wait for room in
+  // the queue, as it's the one that would make room.
+  NodeSharedPrivate *sharedPrivate = _shared->dataPtr.get();
+  const std::string topic = _msgDetails->info.Topic();
+  const bool mayBlock =
+    std::this_thread::get_id() != sharedPrivate->pubThread.get_id();
+  if (!sharedPrivate->pubQueue->Push(std::move(_msgDetails), mayBlock) &&
+      _shared->verbose)
+  {
+    std::cout << "Node::Publisher::Publish(): Local publish queue full, "
+              << "dropping message on topic [" << topic << "]"
+              << std::endl;
+  }
+}
+
+//////////////////////////////////////////////////
+bool Node::PublisherPrivate::Publish(const ProtoMsg &_msg,
+    const std::shared_ptr<const ProtoMsg> &_sharedMsg, Batch *_batch)
+{
+  const std::string &publisherMsgType = this->publisher.MsgTypeName();
 
   // Check that the msg type matches the topic type previously advertised.
   if (publisherMsgType != _msg.GetTypeName())
   {
     std::cerr << "Node::Publisher::Publish() Type mismatch.\n"
               << "\t* Type advertised: "
-              << this->dataPtr->publisher.MsgTypeName()
+              << this->publisher.MsgTypeName()
               << "\n\t* Type published: " << _msg.GetTypeName() << std::endl;
     return false;
   }
 
   // Check the publication throttling option.
-  if (!this->UpdateThrottling())
+  if (!_batch && !this->UpdateThrottling())
     return true;
 
-  const std::string &publisherTopic = this->dataPtr->publisher.Topic();
+  const std::string &publisherTopic = this->publisher.Topic();
 
+  auto guard = this->subscriberCache.Read();
   const NodeShared::SubscriberInfo &subscribers =
-      this->dataPtr->shared->CheckSubscriberInfo(
-        publisherTopic, publisherMsgType);
+    _batch ? *_batch->subscribers : this->Subscribers(guard);
 
   // The serialized message size and buffer.
 #if GOOGLE_PROTOBUF_VERSION >= 3004000
@@ -306,23 +802,62 @@ bool Node::Publisher::Publish(const ProtoMsg &_msg)
   const std::size_t msgSize = static_cast<std::size_t>(_msg.ByteSize());
 #endif
   char *msgBuffer = nullptr;
+  BufferPool *pool = &this->shared->dataPtr->bufferPool;
+
+  // When there are local raw subscribers, they share the serialized buffer
+  // with ZeroMQ instead of getting their own copy. The last one done with it
+  // returns it to the pool. The same happens when the message goes to
+  // several topics of a batch.
+  std::shared_ptr<const char> sharedBuffer;
+  const bool sameMsg = _batch && _batch->sameMsg;
+
+  // The filters of the remote subscribers that want this message.
+  std::vector<const std::string *> filterFrames;
+  if (!subscribers.remoteFilters.empty())
+    filterFrames = this->FilterStreams(subscribers.remoteFilters, &_msg);
+  const bool haveRemote = subscribers.haveRemote || !filterFrames.empty();
 
   // Only serialize the message if we have a raw subscriber or a remote
-  // subscriber.
-  if (subscribers.haveRaw || subscribers.haveRemote)
+  // subscriber, or if the message is kept for the later subscribers.
+  if (subscribers.haveRaw || haveRemote || this->latch)
   {
-    // Allocate the buffer to store the serialized data.
-    msgBuffer = static_cast<char *>(new char[msgSize]);
-
-    // Fail out early if we are unable to serialize the message. We do not
-    // want to send a corrupt/bad message to some subscribers and not others.
-    if (!_msg.SerializeToArray(msgBuffer, msgSize))
+    if (sameMsg && _batch->sharedBuffer)
     {
-      delete[] msgBuffer;
-      std::cerr << "Node::Publisher::Publish(): Error serializing data"
-                << std::endl;
-      return false;
+      // Already serialized for another topic of the batch.
+      sharedBuffer = _batch->sharedBuffer;
+      msgBuffer = const_cast<char *>(sharedBuffer.get());
+    }
+    else
+    {
+      // Get a buffer to store the serialized data. A stream of messages of
+      // similar size keeps reusing the same buffers.
+      msgBuffer = pool->Acquire(msgSize);
+
+      // Fail out early if we are unable to serialize the message. We do not
+      // want to send a corrupt/bad message to some subscribers and not
+      // others.
+      if (!_msg.SerializeToArray(msgBuffer, msgSize))
+      {
+        pool->Release(msgBuffer);
+        std::cerr << "Node::Publisher::Publish(): Error serializing data"
+                  << std::endl;
+        return false;
+      }
+
+      if (subscribers.haveRaw || sameMsg)
+      {
+        sharedBuffer.reset(msgBuffer, [pool](const char *_buffer)
+        {
+          pool->Release(_buffer);
+        });
+      }
+
+      if (sameMsg)
+        _batch->sharedBuffer = sharedBuffer;
     }
+
+    if (this->latch)
+      this->latch->Push(msgBuffer, msgSize, publisherMsgType);
   }
 
   // Local and raw subscribers.
@@ -335,17 +870,14 @@ bool Node::Publisher::Publish(const ProtoMsg &_msg)
     // This must be a shared pointer so that we can pass it to
     // multiple threads below, and then allow this function to go
     // out of scope.
-    pubMsgDetails->info.SetTopicAndPartition(this->dataPtr->publisher.Topic());
-    pubMsgDetails->info.SetType(this->dataPtr->publisher.MsgTypeName());
+    pubMsgDetails->info.SetTopicAndPartition(this->publisher.Topic());
+    pubMsgDetails->info.SetType(this->publisher.MsgTypeName());
     pubMsgDetails->info.SetIntraProcess(true);
 
-    pubMsgDetails->msgCopy.reset(_msg.New());
-    pubMsgDetails->msgCopy->CopyFrom(_msg);
-
     if (subscribers.haveLocal)
     {
       for (const std::pair<std::string, ISubscriptionHandler_M> &node :
-           subscribers.localHandlers)
+           *subscribers.localHandlers)
       {
         for (const std::pair<std::string, ISubscriptionHandlerPtr> &handler :
              node.second)
@@ -366,11 +898,31 @@ bool Node::Publisher::Publish(const ProtoMsg &_msg)
           pubMsgDetails->localHandlers.push_back(handler.second);
         }
       }
+
+      // Local handlers receive the caller's message if it was handed over.
+      // Otherwise, the message is copied so the caller can reuse it right
+      // away.
+      if (_sharedMsg)
+      {
+        pubMsgDetails->msgCopy = _sharedMsg;
+      }
+      else if (sameMsg && _batch->msgCopy)
+      {
+        pubMsgDetails->msgCopy = _batch->msgCopy;
+      }
+      else if (!pubMsgDetails->localHandlers.empty())
+      {
+        std::shared_ptr<ProtoMsg> msgCopy(_msg.New());
+        msgCopy->CopyFrom(_msg);
+        pubMsgDetails->msgCopy = std::move(msgCopy);
+        if (sameMsg)
+          _batch->msgCopy = pubMsgDetails->msgCopy;
+      }
     }
 
     if (subscribers.haveRaw)
     {
-      for (auto &node : subscribers.rawHandlers)
+      for (auto &node : *subscribers.rawHandlers)
       {
         for (auto &handler : node.second)
         {
@@ -389,13 +941,8 @@ bool Node::Publisher::Publish(const ProtoMsg &_msg)
             continue;
           }
 
-          if (!pubMsgDetails->sharedBuffer)
-          {
-            pubMsgDetails->msgSize = msgSize;
-            // If the sharedBuffer has not been created, do so now.
-            pubMsgDetails->sharedBuffer.reset(new char[msgSize]);
-            memcpy(pubMsgDetails->sharedBuffer.get(), msgBuffer, msgSize);
-          }
+          pubMsgDetails->msgSize = msgSize;
+          pubMsgDetails->sharedBuffer = sharedBuffer;
           pubMsgDetails->rawHandlers.push_back(rawHandler);
         }
       }
@@ -403,37 +950,181 @@ bool Node::Publisher::Publish(const ProtoMsg &_msg)
 
     // Add the publish message details to the publish queue. The message
     // will be published asynchronously to the local and raw callbacks.
+    // The messages of a batch are queued together.
+    if (!_batch)
+      EnqueueLocal(this->shared, std::move(pubMsgDetails));
+    else if (!_batch->localDetails)
+      _batch->localDetails = std::move(pubMsgDetails);
+    else
+      _batch->localDetails->batch.push_back(std::move(pubMsgDetails));
+  }
+
+  // Returns the serialized buffer to the pool if it's not shared and it
+  // doesn't go to ZeroMQ.
+  auto releaseBuffer = [&sharedBuffer, &msgBuffer, pool]()
+  {
+    if (!sharedBuffer)
+      pool->Release(msgBuffer);
+    msgBuffer = nullptr;
+  };
+
+  // Handle subscribers running on the same host. The message is serialized
+  // directly into shared memory.
+  if (subscribers.haveShm)
+  {
+    if (!this->shared->PublishShm(publisherTopic, msgSize,
+          [&_msg, msgSize](char *_buffer)
+          {
+            return _msg.SerializeToArray(_buffer, static_cast<int>(msgSize));
+          }, this->streamId))
     {
-      std::unique_lock<std::mutex> queueLock(
-          this->dataPtr->shared->dataPtr->pubThreadMutex);
-      this->dataPtr->shared->dataPtr->pubQueue.push(std::move(pubMsgDetails));
+      releaseBuffer();
+      std::cerr << "Node::Publisher::Publish(): Error publishing data "
+                << "through shared memory" << std::endl;
+      return false;
     }
-
-    this->dataPtr->shared->dataPtr->signalNewPub.notify_one();
   }
 
   // Handle remote subscribers.
-  if (subscribers.haveRemote)
+  if (!haveRemote)
   {
-    // Zmq will call this lambda when the message is published.
-    // We use it to deallocate the buffer.
-    auto myDeallocator = [](void *_buffer, void *)
+    releaseBuffer();
+    return true;
+  }
+
+  // Zmq returns the buffer to the pool when the message is published.
+  DeallocFunc *deallocator = &BufferPool::Deallocate;
+  void *hint = pool;
+  std::size_t dataSize = msgSize;
+  uint8_t codecId = 0;
+  if (auto compressed = this->Compress(msgBuffer, msgSize))
+  {
+    // The compressed copy is sent instead of the serialized message.
+    releaseBuffer();
+    codecId = this->codec->Id();
+    msgBuffer = &(*compressed)[0];
+    dataSize = compressed->size();
+    deallocator = &PublisherPrivate::DeleteCompressed;
+    hint = compressed.release();
+  }
+  else if (sharedBuffer)
+  {
+    // Zmq drops its reference on the shared buffer instead.
+    deallocator = &PublisherPrivate::ReleaseShared;
+    hint = new std::shared_ptr<const char>(sharedBuffer);
+  }
+
+  return this->SendRemote(msgBuffer, dataSize, deallocator, hint, "",
+    codecId, subscribers.haveRemote, filterFrames, _batch);
+}
+
+//////////////////////////////////////////////////
+std::vector<const std::string *> Node::PublisherPrivate::FilterStreams(
+  const std::vector<std::string> &_filters, const ProtoMsg *_msg)
+{
+  std::vector<const std::string *> frames;
+  const Timestamp now = std::chrono::steady_clock::now();
+
+  std::lock_guard<std::mutex> lk(this->mutex);
+  for (const std::string &key : _filters)
+  {
+    auto it = this->filterStreams.find(key);
+    if (it == this->filterStreams.end())
     {
-      delete[] reinterpret_cast<char*>(_buffer);
-    };
+      FilterStream stream;
+      uint64_t msgsPerSec = kUnthrottled;
+      if (!MessageFilterPrivate::ParseSubscriptionKey(key, stream.filter,
+            msgsPerSec))
+      {
+        std::cerr << "Node::Publisher::Publish(): Ignoring invalid filter "
+                  << "of a subscriber of topic [" << this->publisher.Topic()
+                  << "]" << std::endl;
+        stream.valid = false;
+      }
+      else if (msgsPerSec != kUnthrottled)
+      {
+        stream.periodNs = 1e9 / msgsPerSec;
+      }
+      stream.lastSent = Timestamp(std::chrono::seconds{0});
+      stream.frame = NodeSharedPrivate::FilterFrame(
+        MessageFilterPrivate::SubscriptionId(key), this->publisher.Topic());
+      it = this->filterStreams.emplace(key, std::move(stream)).first;
+    }
 
-    if (!this->dataPtr->shared->Publish(this->dataPtr->publisher.Topic(),
-          msgBuffer, msgSize, myDeallocator, _msg.GetTypeName()))
+    FilterStream &stream = it->second;
+    if (!stream.valid)
+      continue;
+
+    if (!stream.filter.Empty() && (!_msg || !stream.filter.Matches(*_msg)))
+      continue;
+
+    if (stream.periodNs > 0)
     {
-      return false;
+      if (std::chrono::duration_cast<std::chrono::nanoseconds>(
+            now - stream.lastSent).count() < stream.periodNs)
+      {
+        continue;
+      }
+      stream.lastSent = now;
     }
+
+    frames.push_back(&stream.frame);
+  }
+
+  return frames;
+}
+
+//////////////////////////////////////////////////
+bool Node::PublisherPrivate::SendRemote(char *_data, const std::size_t _size,
+  DeallocFunc *_deallocator, void *_hint, const std::string &_msgType,
+  const uint8_t _codec, const bool _unfiltered,
+  const std::vector<const std::string *> &_frames, Batch *_batch)
+{
+  std::vector<const std::string *> frames;
+  frames.reserve(_frames.size() + 1);
+  if (_unfiltered)
+    frames.push_back(&this->topic);
+  frames.insert(frames.end(), _frames.begin(), _frames.end());
+
+  if (frames.empty())
+  {
+    _deallocator(_data, _hint);
+    return true;
   }
-  else
+
+  // The streams share the data, which is released after the last send.
+  std::shared_ptr<const char> owner;
+  if (frames.size() > 1)
   {
-    delete[] msgBuffer;
+    owner.reset(_data, [_deallocator, _hint](const char *_buffer)
+    {
+      _deallocator(const_cast<char *>(_buffer), _hint);
+    });
   }
 
-  return true;
+  bool result = true;
+  for (const std::string *frame : frames)
+  {
+    DeallocFunc *deallocator = _deallocator;
+    void *hint = _hint;
+    if (owner)
+    {
+      deallocator = &PublisherPrivate::ReleaseShared;
+      hint = new std::shared_ptr<const char>(owner);
+    }
+
+    if (_batch)
+    {
+      _batch->remoteMsgs.push_back({frame, this->streamId, _data, _size,
+        deallocator, hint, _msgType, _codec});
+      continue;
+    }
+
+    result = this->shared->dataPtr->SendMsg(*frame, this->streamId, _data,
+      _size, deallocator, _msgType, hint, _codec) && result;
+  }
+
+  return result;
 }
 
 //////////////////////////////////////////////////
@@ -444,24 +1135,81 @@ bool Node::Publisher::PublishRaw(
   if (!this->dataPtr->Valid())
     return false;
 
-  const std::string &publisherMsgType = this->dataPtr->publisher.MsgTypeName();
+  return this->dataPtr->PublishRaw(_msgData.data(), _msgData.size(),
+    _msgType, nullptr);
+}
+
+//////////////////////////////////////////////////
+bool Node::Publisher::PublishRaw(
+    const char *_msgData,
+    const std::size_t _msgSize,
+    const std::string &_msgType,
+    std::function<void()> _onDone)
+{
+  bool result = false;
+  if (this->dataPtr->Valid())
+  {
+    result = this->dataPtr->PublishRaw(_msgData, _msgSize, _msgType,
+      _onDone);
+  }
+  else if (_onDone)
+  {
+    _onDone();
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////
+bool Node::PublisherPrivate::PublishRaw(
+    const char *_msgData,
+    const std::size_t _msgSize,
+    const std::string &_msgType,
+    std::function<void()> _onDone)
+{
+  // Tells the caller that the buffer isn't needed anymore, unless it went to
+  // ZeroMQ.
+  auto done = [&_onDone]()
+  {
+    if (_onDone)
+      _onDone();
+  };
+
+  const std::string &publisherMsgType = this->publisher.MsgTypeName();
 
   if (publisherMsgType  != _msgType && publisherMsgType != kGenericMessageType)
   {
     std::cerr << "Node::Publisher::PublishRaw() type mismatch.\n"
               << "\t* Type advertised: "
-              << this->dataPtr->publisher.MsgTypeName()
+              << this->publisher.MsgTypeName()
               << "\n\t* Type published: " << _msgType << std::endl;
+    done();
     return false;
   }
 
-  if (!this->dataPtr->UpdateThrottling())
+  if (!this->UpdateThrottling())
+  {
+    done();
     return true;
+  }
 
-  const std::string &topic = this->dataPtr->publisher.Topic();
+  if (this->latch)
+    this->latch->Push(_msgData, _msgSize, _msgType);
 
+  const std::string &topic = this->topic;
+
+  // The type travels with the message only when a generic publisher sends a
+  // type other than the advertised one. Otherwise, the stream tells it.
+  const std::string sentType =
+    _msgType == publisherMsgType ? std::string() : _msgType;
+
+  // The cached subscribers are looked up with the advertised type, so they
+  // can't be used by generic publishers sending other types.
+  auto guard = this->subscriberCache.Read();
+  NodeShared::SubscriberInfo resolved;
+  if (_msgType != publisherMsgType)
+    resolved = this->shared->CheckSubscriberInfo(topic, _msgType);
   const NodeShared::SubscriberInfo &subscribers =
-      this->dataPtr->shared->CheckSubscriberInfo(topic, _msgType);
+    _msgType == publisherMsgType ? this->Subscribers(guard) : resolved;
 
   MessageInfo info;
   info.SetTopicAndPartition(topic);
@@ -469,30 +1217,77 @@ bool Node::Publisher::PublishRaw(
   info.SetIntraProcess(true);
 
   // Trigger local subscribers.
-  this->dataPtr->shared->TriggerCallbacks(info, _msgData, subscribers);
+  this->shared->TriggerCallbacks(info, _msgData, _msgSize, subscribers);
+
+  // Subscribers running on the same host.
+  if (subscribers.haveShm)
+  {
+    if (!this->shared->PublishShm(topic, _msgSize,
+          [_msgData, _msgSize](char *_buffer)
+          {
+            memcpy(_buffer, _msgData, _msgSize);
+            return true;
+          }, this->streamId, sentType))
+    {
+      done();
+      return false;
+    }
+  }
+
+  // The filters of the remote subscribers that want this message. Their
+  // conditions need the message, which is parsed only for them.
+  std::vector<const std::string *> filterFrames;
+  if (!subscribers.remoteFilters.empty())
+  {
+    std::unique_ptr<ProtoMsg> msg = ignition::msgs::Factory::New(_msgType);
+    if (msg && !msg->ParseFromArray(_msgData, static_cast<int>(_msgSize)))
+      msg.reset();
+    filterFrames = this->FilterStreams(subscribers.remoteFilters, msg.get());
+  }
 
   // Remote subscribers. Note that the data is already presumed to be
   // serialized, so we just pass it along for publication.
-  if (subscribers.haveRemote)
+  if (!subscribers.haveRemote && filterFrames.empty())
+  {
+    done();
+    return true;
+  }
+
+  // A compressed copy is sent instead of the caller's buffer, which isn't
+  // needed anymore.
+  if (auto compressed = this->Compress(_msgData, _msgSize))
   {
-    const std::size_t msgSize = _msgData.size();
-    char *msgBuffer = static_cast<char *>(new char[msgSize]);
-    memcpy(msgBuffer, _msgData.c_str(), msgSize);
-    auto myDeallocator = [](void *_buffer, void * /*_hint*/)
+    done();
+    char *data = &(*compressed)[0];
+    const std::size_t dataSize = compressed->size();
+    return this->SendRemote(data, dataSize,
+      &PublisherPrivate::DeleteCompressed, compressed.release(), sentType,
+      this->codec->Id(), subscribers.haveRemote, filterFrames, nullptr);
+  }
+
+  // ZeroMQ sends the caller's buffer and calls _onDone when it's done with
+  // it.
+  if (_onDone)
+  {
+    auto onDoneDeallocator = [](void *, void *_hint)
     {
-      delete[] reinterpret_cast<char*>(_buffer);
+      std::unique_ptr<std::function<void()>> onDone(
+        static_cast<std::function<void()> *>(_hint));
+      (*onDone)();
     };
 
-    // Note: This will copy _msgData (i.e. not zero copy)
-    if (!this->dataPtr->shared->Publish(
-          this->dataPtr->publisher.Topic(),
-          msgBuffer, msgSize, myDeallocator, _msgType))
-    {
-      return false;
-    }
+    return this->SendRemote(const_cast<char *>(_msgData), _msgSize,
+      onDoneDeallocator, new std::function<void()>(std::move(_onDone)),
+      sentType, 0, subscribers.haveRemote, filterFrames, nullptr);
   }
 
-  return true;
+  // The caller may reuse its buffer as soon as we return, so the data is
+  // copied into a pooled buffer that ZeroMQ returns to the pool once sent.
+  BufferPool *pool = &this->shared->dataPtr->bufferPool;
+  char *msgBuffer = pool->Acquire(_msgSize);
+  memcpy(msgBuffer, _msgData, _msgSize);
+  return this->SendRemote(msgBuffer, _msgSize, &BufferPool::Deallocate, pool,
+    sentType, 0, subscribers.haveRemote, filterFrames, nullptr);
 }
 
 //////////////////////////////////////////////////
@@ -517,6 +1312,16 @@ Node::Node(const NodeOptions &_options)
 
   // Save the options.
   this->dataPtr->options = _options;
+
+  this->dataPtr->shared->dataPtr->AddPartitionInterest(_options.Partition());
+
+  // Run the subscriber callbacks on a pool of worker threads. The pool is
+  // shared by all the nodes of the process.
+  if (_options.CallbackThreads() > 0)
+  {
+    this->dataPtr->shared->dataPtr->EnableCallbackExecutor(
+      _options.CallbackThreads());
+  }
 }
 
 //////////////////////////////////////////////////
@@ -607,27 +1412,77 @@ bool Node::Unsubscribe(const std::string &_topic)
     return false;
   }
 
-  std::lock_guard<std::recursive_mutex> lk(this->dataPtr->shared->mutex);
+  // Handlers removed, to wait for their callbacks.
+  std::vector<std::shared_ptr<SubscriptionHandlerBase>> removed;
 
-  // Remove the subscribers for the given topic that belong to this node.
-  this->dataPtr->shared->localSubscribers.RemoveHandlersForNode(
-        fullyQualifiedTopic, this->dataPtr->nUuid);
+  std::unique_lock<std::recursive_mutex> lk(this->dataPtr->shared->mutex);
 
   // Remove the topic from the list of subscribed topics in this node.
   this->dataPtr->topicsSubscribed.erase(fullyQualifiedTopic);
 
-  // Remove the filter for this topic if I am the last subscriber.
-  if (!this->dataPtr->shared->localSubscribers
-      .HasSubscriber(fullyQualifiedTopic))
   {
+    std::lock_guard<std::mutex> connectionsLk(
+      this->dataPtr->shared->dataPtr->connectionsMutex);
+
+    // Remove the subscribers for the given topic that belong to this node.
+    bool lastSubscriber;
+    {
+      std::lock_guard<std::shared_mutex> subscribersLk(
+        this->dataPtr->shared->subscribersMutex);
+      auto &subscribers = this->dataPtr->shared->localSubscribers;
+      collectNodeHandlers(subscribers.normal.Handlers(fullyQualifiedTopic),
+        this->dataPtr->nUuid, removed);
+      collectNodeHandlers(subscribers.raw.Handlers(fullyQualifiedTopic),
+        this->dataPtr->nUuid, removed);
+      this->dataPtr->shared->localSubscribers.RemoveHandlersForNode(
+            fullyQualifiedTopic, this->dataPtr->nUuid);
+      lastSubscriber = !this->dataPtr->shared->localSubscribers
+        .HasSubscriber(fullyQualifiedTopic);
+    }
+    ++this->dataPtr->shared->dataPtr->subscribersEpoch;
+
+    // Remove the filter for this topic if I am the last subscriber.
+    if (lastSubscriber)
+    {
+      const std::string shmTopic =
+        NodeSharedPrivate::kShmTopicPrefix + fullyQualifiedTopic;
+#ifdef IGN_CPPZMQ_POST_4_7_0
+      this->dataPtr->shared->dataPtr->subscriber->set(
+        zmq::sockopt::unsubscribe, fullyQualifiedTopic);
+      this->dataPtr->shared->dataPtr->subscriber->set(
+        zmq::sockopt::unsubscribe, shmTopic);
+#else
+      this->dataPtr->shared->dataPtr->subscriber->setsockopt(
+        ZMQ_UNSUBSCRIBE, fullyQualifiedTopic.data(),
+        fullyQualifiedTopic.size());
+      this->dataPtr->shared->dataPtr->subscriber->setsockopt(
+        ZMQ_UNSUBSCRIBE, shmTopic.data(), shmTopic.size());
+#endif
+
+      // Forget about the publishers that delivered through shared memory.
+      this->dataPtr->shared->dataPtr->shmPublishers.erase(
+        fullyQualifiedTopic);
+
+      // And stop receiving the streams of our filters.
+      auto &filterFrames = this->dataPtr->shared->dataPtr->filterFrames;
+      for (const std::string &frame : filterFrames[fullyQualifiedTopic])
+      {
 #ifdef IGN_CPPZMQ_POST_4_7_0
-    this->dataPtr->shared->dataPtr->subscriber->set(
-      zmq::sockopt::unsubscribe, fullyQualifiedTopic);
+        this->dataPtr->shared->dataPtr->subscriber->set(
+          zmq::sockopt::unsubscribe, frame);
 #else
-    this->dataPtr->shared->dataPtr->subscriber->setsockopt(
-      ZMQ_UNSUBSCRIBE, fullyQualifiedTopic.data(), fullyQualifiedTopic.size());
+        this->dataPtr->shared->dataPtr->subscriber->setsockopt(
+          ZMQ_UNSUBSCRIBE, frame.data(), frame.size());
 #endif
+      }
+      filterFrames.erase(fullyQualifiedTopic);
+    }
   }
+  lk.unlock();
+
+  // The callbacks might take the locks released above.
+  this->dataPtr->shared->dataPtr->WaitForCallbacks(fullyQualifiedTopic,
+    removed);
 
   // Notify to the publishers that I am no longer interested in the topic.
   MsgAddresses_M addresses;
@@ -682,23 +1537,39 @@ bool Node::UnadvertiseSrv(const std::string &_topic)
     return false;
   }
 
-  std::lock_guard<std::recursive_mutex> lk(this->dataPtr->shared->mutex);
+  std::vector<std::string> hUuids;
+  bool result;
+  {
+    std::lock_guard<std::recursive_mutex> lk(this->dataPtr->shared->mutex);
 
-  // Remove the topic from the list of advertised topics in this node.
-  this->dataPtr->srvsAdvertised.erase(fullyQualifiedTopic);
+    // Remove the topic from the list of advertised topics in this node.
+    this->dataPtr->srvsAdvertised.erase(fullyQualifiedTopic);
 
-  // Remove all the REP handlers for this node.
-  this->dataPtr->shared->repliers.RemoveHandlersForNode(
-    fullyQualifiedTopic, this->dataPtr->nUuid);
+    // Remove all the REP handlers for this node.
+    auto handlers =
+      this->dataPtr->shared->repliers.Handlers(fullyQualifiedTopic);
+    if (handlers)
+    {
+      auto it = handlers->find(this->dataPtr->nUuid);
+      if (it != handlers->end())
+      {
+        for (const auto &handler : it->second)
+          hUuids.push_back(handler.first);
+      }
+    }
+    this->dataPtr->shared->repliers.RemoveHandlersForNode(
+      fullyQualifiedTopic, this->dataPtr->nUuid);
 
-  // Notify the discovery service to unregister and unadvertise my services.
-  if (!this->dataPtr->shared->dataPtr->srvDiscovery->Unadvertise(
-        fullyQualifiedTopic, this->dataPtr->nUuid))
-  {
-    return false;
+    // Notify the discovery service to unregister and unadvertise my services.
+    result = this->dataPtr->shared->dataPtr->srvDiscovery->Unadvertise(
+      fullyQualifiedTopic, this->dataPtr->nUuid);
   }
 
-  return true;
+  // Wait for the requests running in the service threads. This can't be done
+  // while holding the mutex, the callbacks might need it.
+  this->dataPtr->shared->RemoveReplierWorkers(hUuids);
+
+  return result;
 }
 
 //////////////////////////////////////////////////
@@ -783,10 +1654,14 @@ bool Node::SubscribeRaw(
 
   std::lock_guard<std::recursive_mutex> lk(this->dataPtr->shared->mutex);
 
-  this->dataPtr->shared->localSubscribers.raw.AddHandler(
-        fullyQualifiedTopic, this->dataPtr->nUuid, handlerPtr);
+  {
+    std::lock_guard<std::shared_mutex> subscribersLk(
+      this->dataPtr->shared->subscribersMutex);
+    this->dataPtr->shared->localSubscribers.raw.AddHandler(
+          fullyQualifiedTopic, this->dataPtr->nUuid, handlerPtr);
+  }
 
-  return this->dataPtr->SubscribeHelper(fullyQualifiedTopic);
+  return this->SubscribeHelper(fullyQualifiedTopic, handlerPtr);
 }
 
 //////////////////////////////////////////////////
@@ -813,6 +1688,45 @@ std::optional<TopicStatistics> Node::TopicStats(
   return this->dataPtr->shared->TopicStats(fullyQualifiedTopic);
 }
 
+//////////////////////////////////////////////////
+uint64_t Node::DroppedMessages(const std::string &_topic) const
+{
+  std::string fullyQualifiedTopic;
+  std::string topic = _topic;
+  this->Options().TopicRemap(_topic, topic);
+
+  if (!TopicUtils::FullyQualifiedName(this->Options().Partition(),
+    this->Options().NameSpace(), topic, fullyQualifiedTopic))
+  {
+    return 0;
+  }
+
+  uint64_t dropped = 0;
+  auto addDropped = [this, &dropped](const auto &_handlers)
+  {
+    if (!_handlers)
+      return;
+
+    auto node = _handlers->find(this->dataPtr->nUuid);
+    if (node == _handlers->end())
+      return;
+
+    for (const auto &handler : node->second)
+    {
+      if (handler.second)
+        dropped += handler.second->Dropped();
+    }
+  };
+
+  std::shared_lock<std::shared_mutex> lk(
+    this->dataPtr->shared->subscribersMutex);
+  addDropped(this->dataPtr->shared->localSubscribers.normal.Handlers(
+    fullyQualifiedTopic));
+  addDropped(this->dataPtr->shared->localSubscribers.raw.Handlers(
+    fullyQualifiedTopic));
+  return dropped;
+}
+
 //////////////////////////////////////////////////
 bool Node::EnableStats(const std::string &_topic, bool _enable,
     const std::string &_publicationTopic, uint64_t _publicationRate)
@@ -1000,6 +1914,30 @@ Node::Publisher Node::Advertise(const std::string &_topic,
       "unused",
       this->Shared()->pUuid, this->NodeUuid(), _msgTypeName, _options);
 
+  // Offer shared memory delivery to the subscribers running on this host.
+  if (this->Shared()->dataPtr->shmEnabled &&
+      _options.Scope() != Scope_t::PROCESS)
+  {
+    publisher.SetShmHostId(this->Shared()->dataPtr->shmHostId);
+  }
+
+  // The codec must exist here. The subscribers check it on their side.
+  if (!_options.Compression().empty() && !Codec::Find(_options.Compression()))
+  {
+    std::cerr << "Node::Advertise(): Unknown compression codec ["
+              << _options.Compression() << "] for topic [" << topic << "]"
+              << std::endl;
+    return Publisher();
+  }
+
+  // The messages published only carry this identifier. The subscribers learn
+  // the topic, type and address that it stands for through the discovery.
+  {
+    std::lock_guard<std::mutex> pubLk(this->Shared()->dataPtr->publisherMutex);
+    publisher.SetStreamId(this->Shared()->dataPtr->StreamId(
+      fullyQualifiedTopic, _msgTypeName));
+  }
+
   if (!this->Shared()->dataPtr->msgDiscovery->Advertise(publisher))
   {
     std::cerr << "Node::Advertise(): Error advertising topic ["
@@ -1015,10 +1953,14 @@ Node::Publisher Node::Advertise(const std::string &_topic,
 //////////////////////////////////////////////////
 bool NodePrivate::SubscribeHelper(const std::string &_fullyQualifiedTopic)
 {
+  // The caller just added a subscription handler.
+  ++this->shared->dataPtr->subscribersEpoch;
+
   // Add the topic to the list of subscribed topics (if it was not before).
   this->topicsSubscribed.insert(_fullyQualifiedTopic);
 
   // Discover the list of nodes that publish on the topic.
+  this->shared->dataPtr->msgDiscovery->AddInterest(_fullyQualifiedTopic);
   if (!this->shared->dataPtr->msgDiscovery->Discover(_fullyQualifiedTopic))
   {
     std::cerr << "Node::Subscribe(): Error discovering topic ["
@@ -1032,7 +1974,26 @@ bool NodePrivate::SubscribeHelper(const std::string &_fullyQualifiedTopic)
 }
 
 /////////////////////////////////////////////////
-bool Node::SubscribeHelper(const std::string &_fullyQualifiedTopic)
+bool Node::SubscribeHelper(const std::string &_fullyQualifiedTopic,
+  const std::shared_ptr<SubscriptionHandlerBase> &_handler)
 {
+  // Replay the messages of the latched publishers of this process. The
+  // handler is already stored, so a message published concurrently might
+  // be received twice, but the last one received is the last one published.
+  // The caller holds the shared mutex, so the replay doesn't wait for room
+  // in the publish queue.
+  NodeSharedPrivate *shared = this->Shared()->dataPtr.get();
+  for (auto &details : shared->LatchedDeliveries(_fullyQualifiedTopic,
+         _handler))
+  {
+    if (!shared->pubQueue->Push(std::move(details), false) &&
+        this->Shared()->verbose)
+    {
+      std::cout << "Node::Subscribe(): Local publish queue full, dropping "
+                << "latched message on topic [" << _fullyQualifiedTopic
+                << "]" << std::endl;
+    }
+  }
+
   return this->dataPtr->SubscribeHelper(_fullyQualifiedTopic);
 }
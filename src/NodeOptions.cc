@@ -15,6 +15,7 @@
  *
 */
 
+#include <exception>
 #include <iostream>
 #include <string>
 
@@ -35,6 +36,33 @@ NodeOptions::NodeOptions()
   std::string ignPartition;
   if (env("IGN_PARTITION", ignPartition))
     this->SetPartition(ignPartition);
+
+  // Check if the environment variable IGN_TRANSPORT_CALLBACK_THREADS is
+  // present.
+  std::string ignCallbackThreads;
+  if (env("IGN_TRANSPORT_CALLBACK_THREADS", ignCallbackThreads))
+  {
+    try
+    {
+      int threads = std::stoi(ignCallbackThreads);
+      if (threads < 0)
+      {
+        std::cerr << "Unable to convert IGN_TRANSPORT_CALLBACK_THREADS value ["
+                  << ignCallbackThreads << "] to a non-negative number. "
+                  << "Using [0] instead." << std::endl;
+      }
+      else
+      {
+        this->SetCallbackThreads(static_cast<unsigned int>(threads));
+      }
+    }
+    catch (std::exception &_e)
+    {
+      std::cerr << "Unable to convert IGN_TRANSPORT_CALLBACK_THREADS value ["
+                << ignCallbackThreads << "] to an integer number. Using [0] "
+                << "instead." << std::endl;
+    }
+  }
 }
 
 //////////////////////////////////////////////////
@@ -55,6 +83,7 @@ NodeOptions &NodeOptions::operator=(const NodeOptions &_other)
   this->SetNameSpace(_other.NameSpace());
   this->SetPartition(_other.Partition());
   this->dataPtr->topicsRemap = _other.dataPtr->topicsRemap;
+  this->dataPtr->callbackThreads = _other.dataPtr->callbackThreads;
   return *this;
 }
 
@@ -134,3 +163,15 @@ bool NodeOptions::TopicRemap(const std::string &_fromTopic,
 
   return topicIt != this->dataPtr->topicsRemap.end();
 }
+
+//////////////////////////////////////////////////
+unsigned int NodeOptions::CallbackThreads() const
+{
+  return this->dataPtr->callbackThreads;
+}
+
+//////////////////////////////////////////////////
+void NodeOptions::SetCallbackThreads(const unsigned int _threads)
+{
+  this->dataPtr->callbackThreads = _threads;
+}
@@ -50,6 +50,9 @@ namespace ignition
       /// \brief Table of remappings. The key is the original topic name and
       /// its value is the new topic name to be used instead.
       public: std::map<std::string, std::string> topicsRemap;
+
+      /// \brief Number of threads used for running subscriber callbacks.
+      public: unsigned int callbackThreads = 0;
     };
     }
   }
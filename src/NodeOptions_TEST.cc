@@ -72,6 +72,32 @@ TEST(NodeOptionsTest, accessors)
   EXPECT_EQ(opts.Partition(), defaultPartition);
   EXPECT_TRUE(opts.SetPartition(aPartition));
   EXPECT_EQ(opts.Partition(), aPartition);
+
+  // Callback threads.
+  EXPECT_EQ(0u, opts.CallbackThreads());
+  opts.SetCallbackThreads(4u);
+  EXPECT_EQ(4u, opts.CallbackThreads());
+  transport::NodeOptions opts2(opts);
+  EXPECT_EQ(4u, opts2.CallbackThreads());
+}
+
+//////////////////////////////////////////////////
+/// \brief Check that IGN_TRANSPORT_CALLBACK_THREADS is used.
+TEST(NodeOptionsTest, ignCallbackThreads)
+{
+  setenv("IGN_TRANSPORT_CALLBACK_THREADS", "3", 1);
+  transport::NodeOptions opts;
+  EXPECT_EQ(3u, opts.CallbackThreads());
+
+  setenv("IGN_TRANSPORT_CALLBACK_THREADS", "-1", 1);
+  transport::NodeOptions opts2;
+  EXPECT_EQ(0u, opts2.CallbackThreads());
+
+  setenv("IGN_TRANSPORT_CALLBACK_THREADS", "invalid", 1);
+  transport::NodeOptions opts3;
+  EXPECT_EQ(0u, opts3.CallbackThreads());
+
+  unsetenv("IGN_TRANSPORT_CALLBACK_THREADS");
 }
 
 //////////////////////////////////////////////////
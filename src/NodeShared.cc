@@ -23,12 +23,19 @@
 #pragma warning(pop)
 #endif
 
+#include <algorithm>
+#include <cerrno>
 #include <chrono>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <functional>
+#include <iomanip>
 #include <map>
 #include <mutex>
+#include <set>
 #include <shared_mutex>  //NOLINT
+#include <sstream>
 #include <string>
 #include <thread>
 #include <vector>
@@ -44,16 +51,21 @@
 #endif
 
 #include "ignition/transport/AdvertiseOptions.hh"
+#include "ignition/transport/Codec.hh"
 #include "ignition/transport/Discovery.hh"
 #include "ignition/transport/Helpers.hh"
 #include "ignition/transport/NodeShared.hh"
 #include "ignition/transport/RepHandler.hh"
 #include "ignition/transport/ReqHandler.hh"
+#include "ignition/transport/SharedMemoryRing.hh"
 #include "ignition/transport/SubscriptionHandler.hh"
+#include "ignition/transport/TopicUtils.hh"
 #include "ignition/transport/TransportTypes.hh"
 #include "ignition/transport/Uuid.hh"
 
+#include "MessageFilterPrivate.hh"
 #include "NodeSharedPrivate.hh"
+#include "SubscriptionQueue.hh"
 
 #ifdef _MSC_VER
 # pragma warning(disable: 4503)
@@ -91,6 +103,76 @@ bool userPass(std::string &_user, std::string &_pass)
   return true;
 }
 
+//////////////////////////////////////////////////
+// Helper to read the capacity of a queue from an environment variable.
+// _default is returned if the variable isn't set or it isn't valid.
+int queueSizeFromEnv(const char *_name, const int _default)
+{
+  std::string value;
+  if (!env(_name, value))
+    return _default;
+
+  int size = _default;
+  try
+  {
+    size = std::stoi(value);
+  }
+  catch (std::invalid_argument &_e)
+  {
+    std::cerr << "Unable to convert " << _name << " value ["
+              << value << "] to an integer number. Using ["
+              << size << "] instead." << std::endl;
+  }
+  catch (std::out_of_range &_e)
+  {
+    std::cerr << "Unable to convert " << _name << " value ["
+              << value << "] to an integer number. This number is "
+              << "out of range. Using [" << size << "] instead."
+              << std::endl;
+  }
+  if (size <= 0)
+  {
+    size = _default;
+    std::cerr << _name << " value [" << value << "] is not a positive "
+              << "number. Using [" << size << "] instead." << std::endl;
+  }
+  return size;
+}
+
+//////////////////////////////////////////////////
+// Helper to read the overflow policy of a queue from an environment
+// variable. _default is returned if the variable isn't set or it isn't valid.
+QueueOverflowPolicy queuePolicyFromEnv(const char *_name,
+  const QueueOverflowPolicy _default)
+{
+  const std::map<std::string, QueueOverflowPolicy> kPolicies =
+  {
+    {"block", QueueOverflowPolicy::BLOCK},
+    {"drop_oldest", QueueOverflowPolicy::DROP_OLDEST},
+    {"drop_newest", QueueOverflowPolicy::DROP_NEWEST},
+    {"grow", QueueOverflowPolicy::GROW}
+  };
+
+  std::string value;
+  if (!env(_name, value))
+    return _default;
+
+  auto it = kPolicies.find(value);
+  if (it != kPolicies.end())
+    return it->second;
+
+  std::string defaultName;
+  for (const auto &policy : kPolicies)
+  {
+    if (policy.second == _default)
+      defaultName = policy.first;
+  }
+  std::cerr << "Unknown " << _name << " value [" << value << "]. Valid "
+            << "values are [block], [drop_oldest], [drop_newest] and [grow]. "
+            << "Using [" << defaultName << "] instead." << std::endl;
+  return _default;
+}
+
 //////////////////////////////////////////////////
 // Helper to send messages
 #ifdef IGN_ZMQ_POST_4_3_1
@@ -148,6 +230,27 @@ std::string receiveHelper(zmq::socket_t &_socket)
   return std::string(reinterpret_cast<char *>(msg.data()), msg.size());
 }
 
+//////////////////////////////////////////////////
+// Helper to receive a message frame without copying it.
+bool receiveFrame(zmq::socket_t &_socket, zmq::message_t &_msg)
+{
+#ifdef IGN_ZMQ_POST_4_3_1
+  if (!_socket.recv(_msg))
+#else
+  if (!_socket.recv(&_msg, 0))
+#endif
+    return false;
+
+  return true;
+}
+
+//////////////////////////////////////////////////
+// Helper to get the content of a message frame as a string.
+std::string frameToString(const zmq::message_t &_msg)
+{
+  return std::string(static_cast<const char *>(_msg.data()), _msg.size());
+}
+
 //////////////////////////////////////////////////
 // Helper to send an authentication error. This is used by basic
 // authentication.
@@ -167,6 +270,415 @@ void sendAuthErrorHelper(zmq::socket_t &_socket, const std::string &_err)
 #endif
 }
 
+//////////////////////////////////////////////////
+// Helper to build the notification sent to shared memory subscribers. It
+// contains the slot index, the sequence number and the name of the ring.
+std::string shmNotification(const std::string &_ringName,
+    const uint32_t _slot, const uint64_t _seq)
+{
+  std::string data(sizeof(_slot) + sizeof(_seq), '\0');
+  memcpy(&data[0], &_slot, sizeof(_slot));
+  memcpy(&data[sizeof(_slot)], &_seq, sizeof(_seq));
+  return data + _ringName;
+}
+
+//////////////////////////////////////////////////
+// Helper to parse a notification built with shmNotification().
+bool parseShmNotification(const char *_data, const size_t _size,
+    std::string &_ringName, uint32_t &_slot, uint64_t &_seq)
+{
+  if (_size <= sizeof(_slot) + sizeof(_seq))
+    return false;
+
+  memcpy(&_slot, _data, sizeof(_slot));
+  memcpy(&_seq, _data + sizeof(_slot), sizeof(_seq));
+  _ringName.assign(_data + sizeof(_slot) + sizeof(_seq),
+    _size - sizeof(_slot) - sizeof(_seq));
+  return true;
+}
+
+//////////////////////////////////////////////////
+// Helper that keeps a shared memory slot acquired while its message is
+// delivered. The slot is released when the lease goes away, also if the
+// callback executor discards the task that delivers the message.
+class ShmLease
+{
+  public: ShmLease(std::shared_ptr<SharedMemoryRing> _ring,
+                   const uint32_t _slot)
+    : ring(std::move(_ring)), slot(_slot)
+  {
+  }
+
+  public: ShmLease(const ShmLease &) = delete;
+
+  public: ShmLease &operator=(const ShmLease &) = delete;
+
+  public: ~ShmLease()
+  {
+    this->ring->Release(this->slot);
+  }
+
+  private: std::shared_ptr<SharedMemoryRing> ring;
+
+  private: uint32_t slot;
+};
+
+//////////////////////////////////////////////////
+// Helper to restore a message payload compressed by the publisher. _data and
+// _size are updated to point to the decompressed data, stored in _buffer.
+// Returns false if the payload can't be decompressed.
+bool decompressPayload(const Codec *_codec, const std::string &_topic,
+    const char *&_data, size_t &_size, std::string &_buffer)
+{
+  if (!_codec)
+    return true;
+
+  if (!_codec->Decompress(_data, _size, _buffer))
+  {
+    std::cerr << "Unable to decompress a message received on topic ["
+              << _topic << "] with codec [" << _codec->Name() << "]"
+              << std::endl;
+    return false;
+  }
+
+  _data = _buffer.data();
+  _size = _buffer.size();
+  return true;
+}
+
+//////////////////////////////////////////////////
+// Helper to send a service call request or response through a ROUTER socket
+// with ZMQ_ROUTER_MANDATORY set. Returns false if the peer can't receive it
+// yet because the connection handshake is not done, or because its queue is
+// full. Other errors throw zmq::error_t.
+bool sendSrvFrames(zmq::socket_t &_socket,
+    const std::vector<std::string> &_frames)
+{
+  for (size_t i = 0; i < _frames.size(); ++i)
+  {
+    zmq::message_t msg(_frames[i].data(), _frames[i].size());
+    const bool more = i + 1 < _frames.size();
+    bool sent;
+    try
+    {
+#ifdef IGN_ZMQ_POST_4_3_1
+      sent = _socket.send(msg,
+        more ? zmq::send_flags::sndmore : zmq::send_flags::none).has_value();
+#else
+      sent = _socket.send(msg, more ? ZMQ_SNDMORE : 0);
+#endif
+    }
+    catch(const zmq::error_t &_error)
+    {
+      // The peer is only rejected when routing the first frame.
+      if (i == 0 && _error.num() == EHOSTUNREACH)
+        return false;
+      throw;
+    }
+
+    if (!sent && i == 0)
+      return false;
+  }
+
+  return true;
+}
+
+//////////////////////////////////////////////////
+// Helper to receive the connection events of a socket in _monitor. Returns
+// false if the events are not available.
+bool monitorSocket(zmq::socket_t &_socket, zmq::socket_t &_monitor,
+    const std::string &_addr)
+{
+#ifdef ZMQ_EVENT_HANDSHAKE_SUCCEEDED
+  const int events = ZMQ_EVENT_HANDSHAKE_SUCCEEDED;
+#else
+  const int events = ZMQ_EVENT_CONNECTED;
+#endif
+  if (zmq_socket_monitor(static_cast<void *>(_socket), _addr.c_str(),
+        events) != 0)
+  {
+    return false;
+  }
+
+  int lingerVal = 0;
+#ifdef IGN_CPPZMQ_POST_4_7_0
+  _monitor.set(zmq::sockopt::linger, lingerVal);
+#else
+  _monitor.setsockopt(ZMQ_LINGER, &lingerVal, sizeof(lingerVal));
+#endif
+  _monitor.connect(_addr.c_str());
+  return true;
+}
+
+//////////////////////////////////////////////////
+// Helper to discard the messages waiting in a socket, e.g.: the events
+// received by a socket monitor.
+void drainMonitor(zmq::socket_t &_monitor)
+{
+  zmq::message_t event;
+  try
+  {
+#ifdef IGN_ZMQ_POST_4_3_1
+    while (_monitor.recv(event, zmq::recv_flags::dontwait))
+#else
+    while (_monitor.recv(&event, ZMQ_DONTWAIT))
+#endif
+    {
+    }
+  }
+  catch(const zmq::error_t &)
+  {
+  }
+}
+
+//////////////////////////////////////////////////
+// Helper to look up again the handlers of a message whose callbacks were
+// deferred to the callback executor. The handlers removed in the meantime
+// are skipped, so Node::Unsubscribe() only has to wait for the callback
+// running.
+NodeShared::HandlerInfo currentHandlers(const NodeShared &_shared,
+  const std::string &_topic, const NodeShared::HandlerInfo &_queued)
+{
+  NodeShared::HandlerInfo handlerInfo = _shared.CheckHandlerInfo(_topic);
+  handlerInfo.remote = _queued.remote;
+  handlerInfo.filterId = _queued.filterId;
+  handlerInfo.targetNode = _queued.targetNode;
+  return handlerInfo;
+}
+
+//////////////////////////////////////////////////
+/// \brief Get the filter key that a node declares to the publishers of a
+/// topic. It's the key shared by all the handlers of the node. If they have
+/// different keys, the node receives every message and each handler applies
+/// its own filter.
+/// \param[in] _handlerInfo Handlers of the topic.
+/// \param[in] _nUuid Node UUID.
+/// \return The filter key, empty if the node wants every message.
+std::string nodeFilterKey(const NodeShared::HandlerInfo &_handlerInfo,
+    const std::string &_nUuid)
+{
+  const std::string *key = nullptr;
+  bool sameKey = true;
+  auto check = [&](const auto &_handlers)
+  {
+    if (!_handlers)
+      return;
+
+    auto node = _handlers->find(_nUuid);
+    if (node == _handlers->end())
+      return;
+
+    for (const auto &handler : node->second)
+    {
+      if (!handler.second)
+        continue;
+      if (!key)
+        key = &handler.second->FilterKey();
+      else
+        sameKey = sameKey && *key == handler.second->FilterKey();
+    }
+  };
+  check(_handlerInfo.localHandlers);
+  check(_handlerInfo.rawHandlers);
+
+  return key && sameKey ? *key : std::string();
+}
+
+//////////////////////////////////////////////////
+/// \brief Check whether a node gets a message. The messages received from
+/// other processes only reach the nodes that asked the publisher for their
+/// stream: the stream of their filter, or the one without filter. The
+/// messages replayed by a latched publisher only reach their target node.
+/// \param[in] _handlerInfo Handlers of the topic and origin of the message.
+/// \param[in] _nUuid Node UUID.
+/// \param[out] _prefiltered True if the publisher already applied the
+/// filter of the node.
+/// \return True if the node gets the message.
+bool nodeGetsMessage(const NodeShared::HandlerInfo &_handlerInfo,
+    const std::string &_nUuid, bool &_prefiltered)
+{
+  _prefiltered = false;
+  if (!_handlerInfo.targetNode.empty())
+    return _nUuid == _handlerInfo.targetNode;
+
+  if (!_handlerInfo.remote)
+    return true;
+
+  const std::string key = nodeFilterKey(_handlerInfo, _nUuid);
+  _prefiltered = !key.empty();
+  return MessageFilterPrivate::SubscriptionId(key) == _handlerInfo.filterId;
+}
+
+//////////////////////////////////////////////////
+/// \brief Parse the topic frame of a message selected by a filter.
+/// \param[in, out] _topicData Topic frame, moved to the topic name.
+/// \param[in, out] _topicSize Size of the topic frame, reduced to the size
+/// of the topic name.
+/// \param[out] _filterId Identifier of the filter.
+/// \return False if the frame doesn't carry a filter identifier.
+bool parseFilterFrame(const char *&_topicData, size_t &_topicSize,
+    uint64_t &_filterId)
+{
+  const std::string &prefix = NodeSharedPrivate::kFilterTopicPrefix;
+  const size_t headerSize = prefix.size() + NodeSharedPrivate::kFilterIdDigits;
+  if (_topicSize <= headerSize || _topicData[headerSize] != ':' ||
+      prefix.compare(0, prefix.size(), _topicData, prefix.size()) != 0)
+  {
+    return false;
+  }
+
+  const std::string digits(_topicData + prefix.size(),
+    NodeSharedPrivate::kFilterIdDigits);
+  char *end = nullptr;
+  _filterId = std::strtoull(digits.c_str(), &end, 16);
+  if (*end != '\0' || _filterId == 0)
+    return false;
+
+  _topicData += headerSize + 1;
+  _topicSize -= headerSize + 1;
+  return true;
+}
+
+//////////////////////////////////////////////////
+/// \brief Parse the topic frame of a message replayed to one of our nodes
+/// by a latched publisher.
+/// \param[in] _pUuid Our process UUID.
+/// \param[in, out] _topicData Topic frame, moved to the topic name.
+/// \param[in, out] _topicSize Size of the topic frame, reduced to the size
+/// of the topic name.
+/// \param[out] _nUuid UUID of the target node.
+/// \return False if the frame isn't a replay for this process.
+bool parseLatchFrame(const std::string &_pUuid, const char *&_topicData,
+    size_t &_topicSize, std::string &_nUuid)
+{
+  const std::string prefix =
+    NodeSharedPrivate::kLatchTopicPrefix + _pUuid + ":";
+  if (_topicSize <= prefix.size() ||
+      prefix.compare(0, prefix.size(), _topicData, prefix.size()) != 0)
+  {
+    return false;
+  }
+
+  const char *node = _topicData + prefix.size();
+  const char *end = _topicData + _topicSize;
+  const char *colon = std::find(node, end, ':');
+  if (colon == end || colon == node)
+    return false;
+
+  _nUuid.assign(node, colon);
+  _topicSize -= static_cast<size_t>(colon + 1 - _topicData);
+  _topicData = colon + 1;
+  return true;
+}
+
+//////////////////////////////////////////////////
+// Helper to run the raw callbacks.
+void triggerRawCallbacks(NodeSharedPrivate *_shared, const MessageInfo &_info,
+    const char *_msgData, const size_t _msgSize,
+    const NodeShared::HandlerInfo &_handlerInfo)
+{
+  for (const auto &node : *_handlerInfo.rawHandlers)
+  {
+    bool prefiltered;
+    if (!nodeGetsMessage(_handlerInfo, node.first, prefiltered))
+      continue;
+
+    for (const auto &handler : node.second)
+    {
+      const RawSubscriptionHandlerPtr &rawHandler = handler.second;
+      if (rawHandler)
+      {
+        if (rawHandler->TypeName() == _info.Type() ||
+            rawHandler->TypeName() == kGenericMessageType)
+        {
+          if (!rawHandler->Queue())
+          {
+            rawHandler->RunRawCallback(_msgData, _msgSize, _info,
+              prefiltered);
+            continue;
+          }
+
+          // The data is only valid during this call, so the queue gets a
+          // copy.
+          RawSubscriptionHandler *h = rawHandler.get();
+          _shared->QueueDelivery(rawHandler,
+            [h, data = std::string(_msgData, _msgSize), _info, prefiltered]()
+            {
+              h->RunRawCallback(data.data(), data.size(), _info, prefiltered);
+            });
+        }
+      }
+      else
+        std::cerr << "Raw subscription handler is NULL" << std::endl;
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+// Helper to run the local callbacks.
+void triggerLocalCallbacks(NodeSharedPrivate *_shared,
+    const MessageInfo &_info, const char *_msgData, const size_t _msgSize,
+    const NodeShared::HandlerInfo &_handlerInfo)
+{
+  // This will be instantiated by the first suitable handler that we
+  // encounter. If there is no suitable handler, then we can avoid
+  // deserializing the message altogether.
+  std::shared_ptr<ProtoMsg> msg;
+
+  for (const auto &node : *_handlerInfo.localHandlers)
+  {
+    bool prefiltered;
+    if (!nodeGetsMessage(_handlerInfo, node.first, prefiltered))
+      continue;
+
+    for (const auto &handler : node.second)
+    {
+      const ISubscriptionHandlerPtr &localHandler = handler.second;
+      if (localHandler)
+      {
+        if (localHandler->TypeName() == _info.Type() ||
+            localHandler->TypeName() == kGenericMessageType)
+        {
+          if (!msg)
+          {
+            // If the message has not been deserialized yet, do it now since
+            // we have allegedly found a subscriber which should be able to
+            // do it.
+            msg = localHandler->CreateMsg(_msgData, _msgSize, _info.Type());
+
+            if (!msg)
+            {
+              // If the message could not be created, then none of the
+              // handlers in this process will be able to create it, because
+              // protobuf has access to all message types that the current
+              // process is linked to. If CreateMsg(~,~,~) fails, then we may
+              // as well quit.
+              return;
+            }
+          }
+
+          if (!localHandler->Queue())
+          {
+            localHandler->RunLocalCallback(*msg, _info, prefiltered);
+            continue;
+          }
+
+          // The queue holds a reference, so the handler doesn't recycle the
+          // message while it's queued.
+          ISubscriptionHandler *h = localHandler.get();
+          _shared->QueueDelivery(localHandler,
+            [h, msg, _info, prefiltered]()
+            {
+              h->RunLocalCallback(*msg, _info, prefiltered);
+            });
+        }
+      }
+      else
+        std::cerr << "Local subscription handler is NULL" << std::endl;
+    }
+  }
+}
+
 //////////////////////////////////////////////////
 NodeShared *NodeShared::Instance()
 {
@@ -224,6 +736,31 @@ NodeShared::NodeShared()
   this->dataPtr->topicStatsEnabled =
     (env("IGN_TRANSPORT_TOPIC_STATISTICS", ignStats) && ignStats == "1");
 
+  // Shared memory delivery is enabled by default if supported. Set
+  // IGN_TRANSPORT_SHM=0 to disable it.
+  std::string ignShm;
+  this->dataPtr->shmEnabled = SharedMemoryRing::Supported() &&
+    !(env("IGN_TRANSPORT_SHM", ignShm) && ignShm == "0");
+  if (this->dataPtr->shmEnabled)
+    this->dataPtr->shmHostId = SharedMemoryRing::HostId();
+  this->dataPtr->shmEnabled = !this->dataPtr->shmHostId.empty();
+
+  // Queue for the messages published to local subscribers.
+  const int pubQueueSize = queueSizeFromEnv("IGN_TRANSPORT_PUB_QUEUE_SIZE",
+    kDefaultPubQueueSize);
+  const QueueOverflowPolicy pubQueuePolicy = queuePolicyFromEnv(
+    "IGN_TRANSPORT_PUB_QUEUE_POLICY", QueueOverflowPolicy::GROW);
+
+  // Bound of the callbacks queued for each topic by the callback executor.
+  this->dataPtr->callbackQueueSize = queueSizeFromEnv(
+    "IGN_TRANSPORT_CALLBACK_QUEUE_SIZE", kDefaultCallbackQueueSize);
+  this->dataPtr->callbackQueuePolicy = queuePolicyFromEnv(
+    "IGN_TRANSPORT_CALLBACK_QUEUE_POLICY", QueueOverflowPolicy::DROP_OLDEST);
+
+  this->dataPtr->pubQueue.reset(
+    new MpscQueue<std::unique_ptr<NodeSharedPrivate::PublishMsgDetails>>(
+      static_cast<std::size_t>(pubQueueSize), pubQueuePolicy));
+
   // My process UUID.
   Uuid uuid;
   this->pUuid = uuid.ToString();
@@ -234,6 +771,29 @@ NodeShared::NodeShared()
   this->dataPtr->srvDiscovery.reset(
       new SrvDiscovery(this->pUuid, this->kSrvDiscPort));
 
+  // By default, the discovery keeps all the remote topics and services.
+  std::string ignInterest;
+  if (env("IGN_TRANSPORT_DISCOVERY_INTEREST", ignInterest))
+  {
+    using DiscoveryInterest = NodeSharedPrivate::DiscoveryInterest;
+    if (ignInterest == "partition")
+      this->dataPtr->discoveryInterest = DiscoveryInterest::PARTITION;
+    else if (ignInterest == "topic")
+      this->dataPtr->discoveryInterest = DiscoveryInterest::TOPIC;
+    else if (ignInterest != "all")
+    {
+      std::cerr << "Unknown IGN_TRANSPORT_DISCOVERY_INTEREST value ["
+                << ignInterest << "]. Valid values are [all], [partition] "
+                << "and [topic]. Using [all] instead." << std::endl;
+    }
+  }
+  if (this->dataPtr->discoveryInterest !=
+      NodeSharedPrivate::DiscoveryInterest::ALL)
+  {
+    this->dataPtr->msgDiscovery->SetFilterByInterest(true);
+    this->dataPtr->srvDiscovery->SetFilterByInterest(true);
+  }
+
   // Initialize the 0MQ objects.
   if (!this->InitializeSockets())
     return;
@@ -292,13 +852,39 @@ NodeShared::~NodeShared()
   this->dataPtr->exit = true;
 
   // Notify the local pubthread and join.
-  this->dataPtr->signalNewPub.notify_all();
-  this->dataPtr->pubThread.join();
+  this->dataPtr->pubQueue->Close();
+  if (this->dataPtr->pubThread.joinable())
+    this->dataPtr->pubThread.join();
 
   // Wait for the service thread before exit.
   if (this->threadReception.joinable())
     this->threadReception.join();
 
+  // No more callbacks will be posted, wait for the ones running. The
+  // executors are destroyed without holding the mutex, as the callbacks may
+  // still queue messages for subscriptions with their own queue.
+  {
+    std::unique_ptr<CallbackExecutor> callbackExecutor;
+    std::unique_ptr<CallbackExecutor> queueExecutor;
+    {
+      std::lock_guard<std::mutex> lk(this->dataPtr->callbackExecutorMutex);
+      callbackExecutor = std::move(this->dataPtr->callbackExecutor);
+      queueExecutor = std::move(this->dataPtr->queueExecutor);
+    }
+    callbackExecutor.reset();
+    queueExecutor.reset();
+  }
+
+  // No more service requests will be posted, wait for the ones running.
+  {
+    std::map<std::string, std::shared_ptr<NodeSharedPrivate::SrvWorkers>>
+      workers;
+    {
+      std::lock_guard<std::mutex> lk(this->dataPtr->srvWorkersMutex);
+      workers.swap(this->dataPtr->srvWorkers);
+    }
+  }
+
   // Wait for the authentication thread before exit.
   if (this->dataPtr->accessControlThread.joinable())
     this->dataPtr->accessControlThread.join();
@@ -314,12 +900,18 @@ void NodeShared::RunReceptionTask()
     {
       {static_cast<void*>(*this->dataPtr->subscriber), 0, ZMQ_POLLIN, 0},
       {static_cast<void*>(*this->dataPtr->replier), 0, ZMQ_POLLIN, 0},
-      {static_cast<void*>(*this->dataPtr->responseReceiver), 0, ZMQ_POLLIN, 0}
+      {static_cast<void*>(*this->dataPtr->responseReceiver), 0, ZMQ_POLLIN, 0},
+      {static_cast<void*>(*this->dataPtr->requesterMonitor), 0, ZMQ_POLLIN, 0},
+      {static_cast<void*>(*this->dataPtr->replierMonitor), 0, ZMQ_POLLIN, 0},
+      {static_cast<void*>(*this->dataPtr->srvWakeReceiver), 0, ZMQ_POLLIN, 0}
     };
+    int timeout =
+      this->dataPtr->TimersTimeout(std::chrono::steady_clock::now());
+    if (this->dataPtr->hasPendingSrvMsgs)
+      timeout = std::min(timeout, NodeSharedPrivate::kSrvRetryTimeout);
     try
     {
-      zmq::poll(&items[0], sizeof(items) / sizeof(items[0]),
-                NodeSharedPrivate::Timeout);
+      zmq::poll(&items[0], sizeof(items) / sizeof(items[0]), timeout);
     }
     catch(...)
     {
@@ -333,158 +925,429 @@ void NodeShared::RunReceptionTask()
       this->RecvSrvRequest();
     if (items[2].revents & ZMQ_POLLIN)
       this->RecvSrvResponse();
+
+    // A service call connection is ready, send the messages waiting for it.
+    if (items[3].revents & ZMQ_POLLIN)
+      drainMonitor(*this->dataPtr->requesterMonitor);
+    if (items[4].revents & ZMQ_POLLIN)
+      drainMonitor(*this->dataPtr->replierMonitor);
+
+    // Send the responses of the services running in worker threads.
+    if (items[5].revents & ZMQ_POLLIN)
+    {
+      drainMonitor(*this->dataPtr->srvWakeReceiver);
+
+      std::vector<NodeSharedPrivate::PendingSrvMsg> responses;
+      {
+        std::lock_guard<std::mutex> lk(this->dataPtr->srvResponsesMutex);
+        responses.swap(this->dataPtr->srvResponses);
+      }
+
+      std::lock_guard<std::recursive_mutex> lock(this->mutex);
+      for (auto &response : responses)
+        this->SendSrvResponse(response.addr, std::move(response.frames));
+    }
+    if (this->dataPtr->hasPendingSrvMsgs)
+    {
+      std::lock_guard<std::recursive_mutex> lock(this->mutex);
+      this->dataPtr->RetryPendingSrvMsgs();
+    }
+
+    // Run the timers that expired.
+    for (auto &cb :
+         this->dataPtr->ExpiredTimers(std::chrono::steady_clock::now()))
+    {
+      cb();
+    }
   }
 }
 
+//////////////////////////////////////////////////
+void NodeShared::ScheduleTimer(
+  const std::chrono::steady_clock::time_point &_deadline,
+  const std::function<void()> &_cb)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->timersMutex);
+  this->dataPtr->timers.emplace(_deadline, _cb);
+}
+
 //////////////////////////////////////////////////
 bool NodeShared::Publish(
     const std::string &_topic,
     char *_data,
     const size_t _dataSize, DeallocFunc *_ffn,
-    const std::string &_msgType)
+    const std::string &_msgType,
+    void *_hint,
+    const uint8_t _codec)
 {
-  try
+  uint64_t streamId = 0;
   {
-    // Create the messages.
-    // Note that we use zero copy for passing the message data (msg2).
-    zmq::message_t msg0(_topic.data(), _topic.size()),
-                   msg1(this->myAddress.data(), this->myAddress.size()),
-                   msg2(_data, _dataSize, _ffn, nullptr),
-                   msg3(_msgType.data(), _msgType.size());
+    std::lock_guard<std::mutex> lk(this->dataPtr->publisherMutex);
+    streamId = this->dataPtr->StreamId(_topic, _msgType);
+  }
 
-    // Send the messages
-    std::lock_guard<std::recursive_mutex> lock(this->mutex);
+  return this->dataPtr->SendMsg(_topic, streamId, _data, _dataSize, _ffn,
+    "", _hint, _codec);
+}
 
-#ifdef IGN_ZMQ_POST_4_3_1
-    this->dataPtr->publisher->send(msg0, zmq::send_flags::sndmore);
-    this->dataPtr->publisher->send(msg1, zmq::send_flags::sndmore);
-    this->dataPtr->publisher->send(msg2, zmq::send_flags::sndmore);
-#else
-    this->dataPtr->publisher->send(msg0, ZMQ_SNDMORE);
-    this->dataPtr->publisher->send(msg1, ZMQ_SNDMORE);
-    this->dataPtr->publisher->send(msg2, ZMQ_SNDMORE);
-#endif
+//////////////////////////////////////////////////
+bool NodeShared::PublishShm(
+    const std::string &_topic,
+    const size_t _dataSize,
+    const std::function<bool(char *)> &_serializer,
+    const uint64_t _streamId,
+    const std::string &_msgType)
+{
+  std::shared_ptr<SharedMemoryRing> ring;
+  char *buffer = nullptr;
+  uint32_t slot = 0;
+
+  {
+    std::lock_guard<std::mutex> lk(this->dataPtr->shmMutex);
 
-    if (this->dataPtr->topicStatsEnabled)
+    std::shared_ptr<SharedMemoryRing> &current =
+      this->dataPtr->shmWriters[_topic];
+
+    // Create the ring the first time, or replace it by a larger one if the
+    // data doesn't fit. Subscribers that still use the old ring keep it
+    // mapped until they switch to the new one.
+    if (!current || _dataSize > current->SlotSize())
     {
-      // Create publication metadata.
-      PublicationMetadata meta;
-      // Send the sequence number, which can be used to detect dropped
-      // messages.
-      meta.seq = this->dataPtr->topicPubSeq[_topic]++;
-      // Send the publication time.
-      meta.stamp = std::chrono::duration_cast<std::chrono::milliseconds>(
-          std::chrono::steady_clock::now().time_since_epoch()).count();
-      zmq::message_t msg4(&meta, sizeof(meta));
-#ifdef IGN_ZMQ_POST_4_3_1
-      this->dataPtr->publisher->send(msg3, zmq::send_flags::sndmore);
-      this->dataPtr->publisher->send(msg4, zmq::send_flags::none);
-#else
-      this->dataPtr->publisher->send(msg3, ZMQ_SNDMORE);
-      this->dataPtr->publisher->send(msg4, 0);
-#endif
+      uint64_t slotSize = SharedMemoryRing::kMinSlotSize;
+      if (current)
+        slotSize = current->SlotSize();
+      while (slotSize < _dataSize)
+        slotSize *= 2;
+
+      std::ostringstream name;
+      name << "/ign-" << std::hex << std::setw(8) << std::setfill('0')
+           << (std::hash<std::string>()(this->pUuid + _topic) & 0xffffffff)
+           << "-" << this->dataPtr->shmRingCount++;
+
+      std::shared_ptr<SharedMemoryRing> newRing = SharedMemoryRing::Create(
+        name.str(), SharedMemoryRing::kDefaultSlotCount, slotSize);
+      if (!newRing)
+        return false;
+
+      current = newRing;
     }
-    else
+
+    ring = current;
+    buffer = ring->Reserve(_dataSize, slot);
+  }
+
+  // All the slots are being read by slow subscribers. Drop the message, as
+  // ZeroMQ would do when reaching the high water mark.
+  if (!buffer)
+  {
+    if (this->verbose)
     {
-#ifdef IGN_ZMQ_POST_4_3_1
-      this->dataPtr->publisher->send(msg3, zmq::send_flags::none);
-#else
-      this->dataPtr->publisher->send(msg3, 0);
-#endif
+      std::cout << "NodeShared::PublishShm(): No free slots for ["
+                << _topic << "], dropping message" << std::endl;
     }
+    return true;
   }
-  catch(const zmq::error_t& ze)
+
+  // Serialize the data directly into shared memory.
+  if (!_serializer(buffer))
   {
-     std::cerr << "NodeShared::Publish() Error: " << ze.what() << std::endl;
-     return false;
+    ring->Abort(slot);
+    return false;
   }
 
-  return true;
+  uint64_t seq = ring->Commit(slot, _dataSize);
+  if (seq == 0)
+    return false;
+
+  // Notify the subscribers. The notification is sent through the regular
+  // publisher socket, so it shares the ordering and the high water mark of
+  // the rest of the messages.
+  const std::string notification = shmNotification(ring->Name(), slot, seq);
+  char *notificationBuffer = new char[notification.size()];
+  memcpy(notificationBuffer, notification.data(), notification.size());
+
+  auto myDeallocator = [](void *_buffer, void *)
+  {
+    delete[] reinterpret_cast<char*>(_buffer);
+  };
+
+  return this->dataPtr->SendMsg(NodeSharedPrivate::kShmTopicPrefix + _topic,
+    _streamId, notificationBuffer, notification.size(), myDeallocator,
+    _msgType, nullptr);
 }
 
 //////////////////////////////////////////////////
 void NodeShared::RecvMsgUpdate()
 {
-  zmq::message_t msg(0);
+  // The frames are kept alive until the callbacks are done, so the payload
+  // is handed to the handlers without copying it.
+  zmq::message_t topicFrame;
+  zmq::message_t headerFrame;
+  auto dataFrame = std::make_shared<zmq::message_t>();
+  zmq::message_t typeFrame;
   std::string topic;
-  std::string sender;
-  std::string data;
   std::string msgType;
   HandlerInfo handlerInfo;
+  bool shm = false;
+  std::shared_ptr<SharedMemoryRing> ring;
+  uint32_t slot = 0;
+  uint64_t seq = 0;
+  uint8_t codecId = 0;
+  uint64_t filterId = 0;
+  std::string targetNode;
+  std::function<void(const TopicStatistics &_stats)> statsCb;
+  std::optional<TopicStatistics> stats;
 
   {
-    std::lock_guard<std::recursive_mutex> lock(this->mutex);
+    std::lock_guard<std::mutex> lock(this->dataPtr->connectionsMutex);
 
     try
     {
-#ifdef IGN_ZMQ_POST_4_3_1
-      if (!this->dataPtr->subscriber->recv(msg))
-#else
-      if (!this->dataPtr->subscriber->recv(&msg, 0))
-#endif
+      if (!receiveFrame(*this->dataPtr->subscriber, topicFrame) ||
+          !receiveFrame(*this->dataPtr->subscriber, headerFrame) ||
+          !receiveFrame(*this->dataPtr->subscriber, *dataFrame) ||
+          (dataFrame->more() &&
+           !receiveFrame(*this->dataPtr->subscriber, typeFrame)))
+      {
         return;
-      topic = std::string(reinterpret_cast<char *>(msg.data()), msg.size());
+      }
+    }
+    catch(const zmq::error_t &_error)
+    {
+      std::cerr << "Error: " << _error.what() << std::endl;
+      return;
+    }
 
-      // TODO(caguero): Use this as extra metadata for the subscriber.
-#ifdef IGN_ZMQ_POST_4_3_1
-      if (!this->dataPtr->subscriber->recv(msg))
-#else
-      if (!this->dataPtr->subscriber->recv(&msg, 0))
-#endif
-        return;
-      sender = std::string(reinterpret_cast<char *>(msg.data()), msg.size());
+    // Check if this is a notification of data available in shared memory.
+    const char *topicData = static_cast<const char *>(topicFrame.data());
+    size_t topicSize = topicFrame.size();
+    const std::string &shmPrefix = NodeSharedPrivate::kShmTopicPrefix;
+    if (topicSize >= shmPrefix.size() &&
+        shmPrefix.compare(0, shmPrefix.size(), topicData,
+          shmPrefix.size()) == 0)
+    {
+      shm = true;
+      topicData += shmPrefix.size();
+      topicSize -= shmPrefix.size();
+    }
+    else if (!parseLatchFrame(this->pUuid, topicData, topicSize, targetNode))
+    {
+      // Or a message selected by the filter of some of our subscribers, if
+      // it's not a replay of a latched publisher for one of our nodes.
+      parseFilterFrame(topicData, topicSize, filterId);
+    }
 
-#ifdef IGN_ZMQ_POST_4_3_1
-      if (!this->dataPtr->subscriber->recv(msg))
-#else
-      if (!this->dataPtr->subscriber->recv(&msg, 0))
-#endif
-        return;
-      data = std::string(reinterpret_cast<char *>(msg.data()), msg.size());
+    // Parse the header. The statistics fields might not be there.
+    MsgHeader header;
+    if (headerFrame.size() < MsgHeader::kBaseSize)
+      return;
+    memcpy(&header, headerFrame.data(),
+      std::min(headerFrame.size(), sizeof(header)));
+    if (header.version != MsgHeader::kVersion)
+      return;
 
-#ifdef IGN_ZMQ_POST_4_3_1
-      if (!this->dataPtr->subscriber->recv(msg))
-#else
-      if (!this->dataPtr->subscriber->recv(&msg, 0))
-#endif
+    // Find out who sent the message and its type. The stream is known since
+    // we connected to the publisher.
+    auto stream = this->dataPtr->remoteStreams.find(header.streamId);
+    if (stream == this->dataPtr->remoteStreams.end() ||
+        stream->second.topic.size() != topicSize ||
+        stream->second.topic.compare(0, topicSize, topicData, topicSize) != 0)
+    {
+      if (this->verbose)
+      {
+        std::cout << "Discarding message from an unknown publisher"
+                  << std::endl;
+      }
+      return;
+    }
+    topic = stream->second.topic;
+    msgType = stream->second.msgType;
+    if ((header.flags & MsgHeader::kTypeFlag) && typeFrame.size() > 0)
+      msgType = frameToString(typeFrame);
+    codecId = header.codec;
+    const std::string &sender = stream->second.sender;
+
+    // Check if we receive this topic through shared memory from the sender.
+    bool shmPublisher = false;
+    auto shmPubs = this->dataPtr->shmPublishers.find(topic);
+    if (shmPubs != this->dataPtr->shmPublishers.end())
+      shmPublisher = shmPubs->second.find(sender) != shmPubs->second.end();
+
+    if (shm)
+    {
+      std::string ringName;
+      if (!shmPublisher ||
+          !parseShmNotification(static_cast<const char *>(dataFrame->data()),
+            dataFrame->size(), ringName, slot, seq))
+      {
         return;
-      msgType = std::string(reinterpret_cast<char *>(msg.data()), msg.size());
+      }
 
-      if (this->dataPtr->topicStatsEnabled)
+      // Open the ring the first time, or when the publisher replaced it.
+      std::shared_ptr<SharedMemoryRing> &reader =
+        this->dataPtr->shmReaders[sender + topic];
+      if (!reader || reader->Name() != ringName)
+        reader = SharedMemoryRing::Open(ringName);
+      if (!reader)
       {
-#ifdef IGN_ZMQ_POST_4_3_1
-        if (!this->dataPtr->subscriber->recv(msg))
-#else
-        if (!this->dataPtr->subscriber->recv(&msg, 0))
-#endif
-          return;
-        PublicationMetadata *meta =
-          reinterpret_cast<PublicationMetadata *>(msg.data());
-
-        // Update topic statistics.
-        if (this->dataPtr->enabledTopicStatistics.find(topic) !=
-            this->dataPtr->enabledTopicStatistics.end())
+        std::cerr << "Unable to open shared memory [" << ringName
+                  << "] for topic [" << topic << "]. Receiving the data "
+                  << "from [" << sender << "] through TCP instead."
+                  << std::endl;
+        this->dataPtr->shmReaders.erase(sender + topic);
+        this->dataPtr->shmUnreachable.insert(sender);
+
+        // Connect again to the publishers of this process, which registers
+        // our nodes without the shared memory host id. It's done from
+        // another thread, as it takes connectionsMutex.
+        std::vector<MessagePublisher> pubs;
+        std::map<std::string, std::vector<MessagePublisher>> topicPubs;
+        this->connections.Publishers(topic, topicPubs);
+        for (const auto &proc : topicPubs)
         {
-          this->dataPtr->topicStats[topic].Update(sender,
-              meta->stamp, meta->seq);
-          this->dataPtr->enabledTopicStatistics[topic](
-              this->dataPtr->topicStats[topic]);
+          for (const auto &pub : proc.second)
+          {
+            if (pub.Addr() == sender)
+              pubs.push_back(pub);
+          }
         }
+        for (auto &shmPubs : this->dataPtr->shmPublishers)
+          shmPubs.second.erase(sender);
+
+        this->ScheduleTimer(std::chrono::steady_clock::now(),
+          [this, pubs]()
+          {
+            for (const auto &pub : pubs)
+              this->OnNewConnection(pub);
+          });
+        return;
       }
+      ring = reader;
     }
-    catch(const zmq::error_t &_error)
+    else if (shmPublisher && targetNode.empty())
     {
-      std::cerr << "Error: " << _error.what() << std::endl;
+      // This publisher delivers to us through shared memory. The message was
+      // sent over TCP for another subscriber. The replays are only sent over
+      // TCP.
       return;
     }
 
-    handlerInfo = this->CheckHandlerInfo(topic);
+    // The streams of the filters and the replays skip messages and have
+    // their own sequence numbers, so only the complete stream is accounted.
+    if (this->dataPtr->topicStatsEnabled && filterId == 0 &&
+        targetNode.empty() &&
+        (header.flags & MsgHeader::kStatsFlag) &&
+        headerFrame.size() >= sizeof(header))
+    {
+      std::lock_guard<std::mutex> statsLock(this->dataPtr->statsMutex);
+      auto statsIt = this->dataPtr->enabledTopicStatistics.find(topic);
+      if (statsIt != this->dataPtr->enabledTopicStatistics.end())
+      {
+        TopicStatistics &current = this->dataPtr->topicStats[topic];
+        current.Update(sender, header.stamp, header.seq);
+        statsCb = statsIt->second;
+        stats.emplace(current);
+      }
+    }
+  }
+
+  // Update topic statistics. The callback runs without the locks, so it can
+  // publish the statistics or query them.
+  if (stats)
+    statsCb(*stats);
+
+  // The messages delivered through shared memory are never compressed.
+  std::shared_ptr<const Codec> codec;
+  if (codecId != 0 && !shm)
+  {
+    codec = Codec::Find(codecId);
+    if (!codec)
+    {
+      if (this->verbose)
+      {
+        std::cout << "Discarding message on topic [" << topic
+                  << "] compressed with unknown codec ["
+                  << static_cast<int>(codecId) << "]" << std::endl;
+      }
+      return;
+    }
   }
 
+  handlerInfo = this->CheckHandlerInfo(topic);
+  handlerInfo.remote = !shm;
+  handlerInfo.filterId = filterId;
+  handlerInfo.targetNode = targetNode;
+
   MessageInfo info;
   info.SetTopicAndPartition(topic);
   info.SetType(msgType);
-  this->TriggerCallbacks(info, data, handlerInfo);
+
+  const char *msgData = static_cast<const char *>(dataFrame->data());
+  size_t msgSize = dataFrame->size();
+
+  // The data stays in shared memory while the callbacks run, even if they
+  // are deferred to the callback executor. The publisher skips the slots that
+  // are still acquired, so a slow subscriber only makes the publisher drop
+  // messages, as ZeroMQ does when reaching the high water mark.
+  std::shared_ptr<ShmLease> lease;
+  if (shm)
+  {
+    uint64_t shmSize = 0;
+    if (!ring->Acquire(slot, seq, msgData, shmSize))
+    {
+      // The data was overwritten before we got to it.
+      return;
+    }
+    msgSize = static_cast<size_t>(shmSize);
+    lease = std::make_shared<ShmLease>(ring, slot);
+  }
+
+  // The executor lives until this thread finishes, so it's used without
+  // holding the mutex. Post() might wait for room, and the callbacks take
+  // the mutex to queue messages for subscriptions with their own queue.
+  CallbackExecutor *executor = nullptr;
+  {
+    std::lock_guard<std::mutex> lk(this->dataPtr->callbackExecutorMutex);
+    executor = this->dataPtr->callbackExecutor.get();
+  }
+
+  if (executor)
+  {
+    if (shm)
+    {
+      executor->Post(topic,
+        [this, topic, info, lease, msgData, msgSize, handlerInfo]()
+        {
+          this->TriggerCallbacks(info, msgData, msgSize,
+            currentHandlers(*this, topic, handlerInfo));
+        });
+    }
+    else
+    {
+      // The task owns the frame, so the data outlives this function. A
+      // compressed payload is restored by the worker, which keeps the
+      // reception thread free for the next message.
+      executor->Post(topic,
+        [this, topic, info, dataFrame, codec, msgData, msgSize, handlerInfo]()
+        {
+          const char *data = msgData;
+          size_t size = msgSize;
+          std::string buffer;
+          if (decompressPayload(codec.get(), topic, data, size, buffer))
+          {
+            this->TriggerCallbacks(info, data, size,
+              currentHandlers(*this, topic, handlerInfo));
+          }
+        });
+    }
+    return;
+  }
+
+  std::string buffer;
+  if (!decompressPayload(codec.get(), topic, msgData, msgSize, buffer))
+    return;
+
+  this->TriggerCallbacks(info, msgData, msgSize, handlerInfo);
 }
 
 //////////////////////////////////////////////////
@@ -493,13 +1356,13 @@ NodeShared::HandlerInfo NodeShared::CheckHandlerInfo(
 {
   HandlerInfo info;
 
-  std::lock_guard<std::recursive_mutex> lk(this->mutex);
+  std::shared_lock<std::shared_mutex> lk(this->subscribersMutex);
 
-  info.haveLocal = this->localSubscribers.normal.Handlers(
-        _topic, info.localHandlers);
+  info.localHandlers = this->localSubscribers.normal.Handlers(_topic);
+  info.haveLocal = info.localHandlers != nullptr;
 
-  info.haveRaw = this->localSubscribers.raw.Handlers(
-        _topic, info.rawHandlers);
+  info.rawHandlers = this->localSubscribers.raw.Handlers(_topic);
+  info.haveRaw = info.rawHandlers != nullptr;
 
   return info;
 }
@@ -511,16 +1374,39 @@ NodeShared::SubscriberInfo NodeShared::CheckSubscriberInfo(
 {
   SubscriberInfo info;
 
-  std::lock_guard<std::recursive_mutex> lk(this->mutex);
+  std::shared_lock<std::shared_mutex> lk(this->subscribersMutex);
 
-  info.haveLocal = this->localSubscribers.normal.Handlers(
-        _topic, info.localHandlers);
+  info.localHandlers = this->localSubscribers.normal.Handlers(_topic);
+  info.haveLocal = info.localHandlers != nullptr;
 
-  info.haveRaw = this->localSubscribers.raw.Handlers(
-        _topic, info.rawHandlers);
+  info.rawHandlers = this->localSubscribers.raw.Handlers(_topic);
+  info.haveRaw = info.rawHandlers != nullptr;
 
-  info.haveRemote = this->remoteSubscribers.HasTopic(
-        _topic, _msgType);
+  // Remote subscribers that registered with a shared memory host id
+  // receive the data through shared memory. The others receive it through
+  // ZeroMQ, in the stream of their filter if they declared one. The
+  // condition never holds, so every subscriber is visited.
+  info.haveRemote = false;
+  info.haveShm = false;
+  const bool shmEnabled = this->dataPtr->shmEnabled;
+  this->remoteSubscribers.HasTopic(_topic, _msgType,
+    [&info, shmEnabled](const MessagePublisher &_pub)
+    {
+      if (shmEnabled && !_pub.ShmHostId().empty())
+      {
+        info.haveShm = true;
+      }
+      else if (_pub.Filter().empty())
+      {
+        info.haveRemote = true;
+      }
+      else if (std::find(info.remoteFilters.begin(), info.remoteFilters.end(),
+                 _pub.Filter()) == info.remoteFilters.end())
+      {
+        info.remoteFilters.push_back(_pub.Filter());
+      }
+      return false;
+    });
 
   return info;
 }
@@ -531,73 +1417,27 @@ void NodeShared::TriggerCallbacks(
     const std::string &_msgData,
     const HandlerInfo &_handlerInfo)
 {
-  if (!_handlerInfo.haveLocal && !_handlerInfo.haveRaw)
-    return;
+  this->TriggerCallbacks(_info, _msgData.data(), _msgData.size(),
+    _handlerInfo);
+}
 
+//////////////////////////////////////////////////
+void NodeShared::TriggerCallbacks(
+    const MessageInfo &_info,
+    const char *_msgData,
+    const size_t _msgSize,
+    const HandlerInfo &_handlerInfo)
+{
   if (_handlerInfo.haveRaw)
   {
-    for (const auto &node : _handlerInfo.rawHandlers)
-    {
-      for (const auto &handler : node.second)
-      {
-        const RawSubscriptionHandlerPtr &rawHandler = handler.second;
-        if (rawHandler)
-        {
-          if (rawHandler->TypeName() == _info.Type() ||
-              rawHandler->TypeName() == kGenericMessageType)
-          {
-            rawHandler->RunRawCallback(_msgData.c_str(), _msgData.size(),
-                _info);
-          }
-        }
-        else
-          std::cerr << "Raw subscription handler is NULL" << std::endl;
-      }
-    }
+    triggerRawCallbacks(this->dataPtr.get(), _info, _msgData, _msgSize,
+      _handlerInfo);
   }
 
   if (_handlerInfo.haveLocal)
   {
-    // This will be instantiated by the first suitable handler that we
-    // encounter. If there is no suitable handler, then we can avoid
-    // deserializing the message altogether.
-    std::shared_ptr<ProtoMsg> msg;
-
-    for (const auto &node : _handlerInfo.localHandlers)
-    {
-      for (const auto &handler : node.second)
-      {
-        const ISubscriptionHandlerPtr &localHandler = handler.second;
-        if (localHandler)
-        {
-          if (localHandler->TypeName() == _info.Type() ||
-              localHandler->TypeName() == kGenericMessageType)
-          {
-            if (!msg)
-            {
-              // If the message has not been deserialized yet, do it now since
-              // we have allegedly found a subscriber which should be able to
-              // do it.
-              msg = localHandler->CreateMsg(_msgData, _info.Type());
-
-              if (!msg)
-              {
-                // If the message could not be created, then none of the
-                // handlers in this process will be able to create it, because
-                // protobuf has access to all message types that the current
-                // process is linked to. If CreateMsg(~,~) fails, then we may
-                // as well quit.
-                return;
-              }
-            }
-
-            localHandler->RunLocalCallback(*msg, _info);
-          }
-        }
-        else
-          std::cerr << "Local subscription handler is NULL" << std::endl;
-      }
-    }
+    triggerLocalCallbacks(this->dataPtr.get(), _info, _msgData, _msgSize,
+      _handlerInfo);
   }
 }
 
@@ -717,103 +1557,132 @@ void NodeShared::RecvSrvRequest()
   // Get the REP handler.
   if (hasHandler)
   {
-    // Run the service call and get the results.
-    bool result = repHandler->RunCallback(req, rep);
-
     // If 'reptype' is msgs::Empty", this is a oneway request
     // and we don't send response
-    if (repType == ignition::msgs::Empty().GetTypeName())
+    const bool oneway = repType == ignition::msgs::Empty().GetTypeName();
+
+    // The service has its own worker threads. The response is sent by the
+    // reception thread once ready, as the sockets are not thread safe.
+    auto workers = this->dataPtr->ReplierWorkers(repHandler->HandlerUuid());
+    if (workers)
     {
+      if (workers->maxInFlight > 0 &&
+          workers->inFlight >= workers->maxInFlight)
+      {
+        if (this->verbose)
+        {
+          std::cout << "Too many requests in flight for service [" << topic
+                    << "]. Rejecting request" << std::endl;
+        }
+
+        if (!oneway)
+        {
+          std::lock_guard<std::recursive_mutex> lock(this->mutex);
+          this->SendSrvResponse(sender,
+            {dstId, topic, nodeUuid, reqUuid, "", "0"});
+        }
+        return;
+      }
+
+      // The workers are joined before being destroyed, so the task can use
+      // them without keeping them alive.
+      ++workers->inFlight;
+      NodeSharedPrivate::SrvWorkers *w = workers.get();
+      NodeSharedPrivate *shared = this->dataPtr.get();
+      std::vector<std::string> frames = {dstId, topic, nodeUuid, reqUuid};
+      workers->executor->Post(reqUuid,
+        [w, shared, repHandler, oneway, sender, frames, req]() mutable
+        {
+          std::string response;
+          bool ok = repHandler->RunCallback(req, response);
+          --w->inFlight;
+
+          if (oneway)
+            return;
+
+          frames.push_back(std::move(response));
+          frames.push_back(ok ? "1" : "0");
+          shared->QueueSrvResponse(sender, std::move(frames));
+        });
       return;
     }
 
+    // Run the service call and get the results.
+    bool result = repHandler->RunCallback(req, rep);
+
+    if (oneway)
+      return;
+
     if (result)
       resultStr = "1";
     else
       resultStr = "0";
 
-    {
-      std::lock_guard<std::recursive_mutex> lock(this->mutex);
-      // I am still not connected to this address.
-      if (std::find(this->srvConnections.begin(), this->srvConnections.end(),
-            sender) == this->srvConnections.end())
-      {
-        this->dataPtr->replier->connect(sender.c_str());
-        this->srvConnections.push_back(sender);
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-
-        if (this->verbose)
-        {
-          std::cout << "\t* Connected to [" << sender
-                    << "] for sending a response" << std::endl;
-        }
-      }
-    }
+    std::lock_guard<std::recursive_mutex> lock(this->mutex);
 
     // Send the reply.
-    try
+    this->SendSrvResponse(sender, {dstId, topic, nodeUuid, reqUuid, rep,
+      resultStr});
+  }
+  // else
+  //   std::cerr << "I do not have a service call registered for topic ["
+  //             << topic << "]\n";
+}
+
+//////////////////////////////////////////////////
+void NodeShared::SendSrvResponse(const std::string &_addr,
+  std::vector<std::string> &&_frames)
+{
+  // I am still not connected to this address. The response waits until
+  // the connection is ready.
+  if (this->srvConnections.find(_addr) == this->srvConnections.end())
+  {
+    this->dataPtr->replier->connect(_addr.c_str());
+    this->srvConnections.insert(_addr);
+
+    if (this->verbose)
     {
-      std::lock_guard<std::recursive_mutex> lock(this->mutex);
-      zmq::message_t response;
+      std::cout << "\t* Connecting to [" << _addr
+                << "] for sending a response" << std::endl;
+    }
+  }
 
-      response.rebuild(dstId.size());
-      memcpy(response.data(), dstId.data(), dstId.size());
-#ifdef IGN_ZMQ_POST_4_3_1
-      this->dataPtr->replier->send(response, zmq::send_flags::sndmore);
-#else
-      this->dataPtr->replier->send(response, ZMQ_SNDMORE);
-#endif
+  this->dataPtr->SendSrvMsg(*this->dataPtr->replier,
+    this->dataPtr->pendingResponses, _addr, std::move(_frames));
+}
 
-      response.rebuild(topic.size());
-      memcpy(response.data(), topic.data(), topic.size());
-#ifdef IGN_ZMQ_POST_4_3_1
-      this->dataPtr->replier->send(response, zmq::send_flags::sndmore);
-#else
-      this->dataPtr->replier->send(response, ZMQ_SNDMORE);
-#endif
+//////////////////////////////////////////////////
+void NodeShared::AddReplierWorkers(const std::string &_hUuid,
+  const AdvertiseServiceOptions &_options)
+{
+  if (_options.Threads() == 0)
+    return;
 
-      response.rebuild(nodeUuid.size());
-      memcpy(response.data(), nodeUuid.data(), nodeUuid.size());
-#ifdef IGN_ZMQ_POST_4_3_1
-      this->dataPtr->replier->send(response, zmq::send_flags::sndmore);
-#else
-      this->dataPtr->replier->send(response, ZMQ_SNDMORE);
-#endif
+  auto workers = std::make_shared<NodeSharedPrivate::SrvWorkers>();
+  workers->maxInFlight = _options.MaxInFlight();
+  workers->executor.reset(new CallbackExecutor(_options.Threads()));
 
-      response.rebuild(reqUuid.size());
-      memcpy(response.data(), reqUuid.data(), reqUuid.size());
-#ifdef IGN_ZMQ_POST_4_3_1
-      this->dataPtr->replier->send(response, zmq::send_flags::sndmore);
-#else
-      this->dataPtr->replier->send(response, ZMQ_SNDMORE);
-#endif
+  std::lock_guard<std::mutex> lk(this->dataPtr->srvWorkersMutex);
+  this->dataPtr->srvWorkers[_hUuid] = workers;
+}
 
-      response.rebuild(rep.size());
-      memcpy(response.data(), rep.data(), rep.size());
-#ifdef IGN_ZMQ_POST_4_3_1
-      this->dataPtr->replier->send(response, zmq::send_flags::sndmore);
-#else
-      this->dataPtr->replier->send(response, ZMQ_SNDMORE);
-#endif
+//////////////////////////////////////////////////
+void NodeShared::RemoveReplierWorkers(const std::vector<std::string> &_hUuids)
+{
+  // Destroyed once the lock is released, as it waits for the running
+  // requests.
+  std::vector<std::shared_ptr<NodeSharedPrivate::SrvWorkers>> removed;
 
-      response.rebuild(resultStr.size());
-      memcpy(response.data(), resultStr.data(), resultStr.size());
-#ifdef IGN_ZMQ_POST_4_3_1
-      this->dataPtr->replier->send(response, zmq::send_flags::none);
-#else
-      this->dataPtr->replier->send(response, 0);
-#endif
-    }
-    catch(const zmq::error_t &_error)
-    {
-      std::cerr << "NodeShared::RecvSrvRequest() error sending response: "
-                << _error.what() << std::endl;
-      return;
-    }
+  std::lock_guard<std::mutex> lk(this->dataPtr->srvWorkersMutex);
+  for (const auto &hUuid : _hUuids)
+  {
+    auto it = this->dataPtr->srvWorkers.find(hUuid);
+    if (it == this->dataPtr->srvWorkers.end())
+      continue;
+
+    removed.push_back(std::move(it->second));
+    this->dataPtr->srvWorkers.erase(it);
   }
-  // else
-  //   std::cerr << "I do not have a service call registered for topic ["
-  //             << topic << "]\n";
 }
 
 //////////////////////////////////////////////////
@@ -893,8 +1762,12 @@ void NodeShared::RecvSrvResponse()
       return;
     }
 
-    hasHandler =
-      this->requests.Handler(topic, nodeUuid, reqUuid, reqHandlerPtr);
+    auto it = this->dataPtr->requestsByUuid.find(reqUuid);
+    hasHandler = it != this->dataPtr->requestsByUuid.end() &&
+      it->second.topic == topic &&
+      it->second.handler->NodeUuid() == nodeUuid;
+    if (hasHandler)
+      reqHandlerPtr = it->second.handler;
   }
 
   if (hasHandler)
@@ -902,18 +1775,14 @@ void NodeShared::RecvSrvResponse()
     // Notify the result.
     reqHandlerPtr->NotifyResult(rep, result);
 
-    // Remove the handler.
+    // Remove the handler. It might be gone already if the request was
+    // cancelled while notifying the result.
     std::lock_guard<std::recursive_mutex> lock(this->mutex);
-    {
-      if (!this->requests.RemoveHandler(topic, nodeUuid, reqUuid))
-      {
-        std::cerr << "NodeShare::RecvSrvResponse(): "
-                  << "Error removing request handler" << std::endl;
-      }
-    }
+    this->RemoveRequest(topic, nodeUuid, reqUuid);
   }
-  else
+  else if (this->verbose)
   {
+    // Expected when the request was cancelled or timed out.
     std::cerr << "Received a service call response but I don't have a handler"
               << " for it" << std::endl;
   }
@@ -923,16 +1792,15 @@ void NodeShared::RecvSrvResponse()
 void NodeShared::SendPendingRemoteReqs(const std::string &_topic,
   const std::string &_reqType, const std::string &_repType)
 {
-  std::string responserAddr;
-  std::string responserId;
   SrvAddresses_M addresses;
   this->dataPtr->srvDiscovery->Publishers(_topic, addresses);
   if (addresses.empty())
     return;
 
-  // Find a publisher that offers this service with a particular pair of REQ/REP
-  // types.
-  bool found = false;
+  // Find the publishers that offer this service with a particular pair of
+  // REQ/REP types. Untargeted requests go to the first one.
+  std::string firstAddr;
+  std::map<std::string, std::string> responsers;
   for (auto &proc : addresses)
   {
     auto &v = proc.second;
@@ -940,163 +1808,130 @@ void NodeShared::SendPendingRemoteReqs(const std::string &_topic,
     {
       if (pub.ReqTypeName() == _reqType && pub.RepTypeName() == _repType)
       {
-        found = true;
-        responserAddr = pub.Addr();
-        responserId = pub.SocketId();
-        break;
+        if (firstAddr.empty())
+          firstAddr = pub.Addr();
+        responsers.emplace(pub.Addr(), pub.SocketId());
       }
     }
-    if (found)
-      break;
   }
 
-  if (!found)
+  if (responsers.empty())
     return;
 
   if (verbose)
   {
     std::cout << "Found a service call responser at ["
-              << responserAddr << "]" << std::endl;
+              << firstAddr << "]" << std::endl;
   }
 
   std::lock_guard<std::recursive_mutex> lock(this->mutex);
 
-  // I am still not connected to this address.
-  if (std::find(this->srvConnections.begin(), this->srvConnections.end(),
-        responserAddr) == this->srvConnections.end())
+  // I am still not connected to this address. The requests wait until the
+  // connection is ready.
+  auto connect = [this](const std::string &_addr)
   {
-    this->dataPtr->requester->connect(responserAddr.c_str());
-    this->srvConnections.push_back(responserAddr);
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-    if (this->verbose)
+    if (this->srvConnections.find(_addr) == this->srvConnections.end())
     {
-      std::cout << "\t* Connected to [" << responserAddr
-                << "] for service requests" << std::endl;
+      this->dataPtr->requester->connect(_addr.c_str());
+      this->srvConnections.insert(_addr);
+      if (this->verbose)
+      {
+        std::cout << "\t* Connecting to [" << _addr
+                  << "] for service requests" << std::endl;
+      }
     }
-  }
+  };
+  connect(firstAddr);
 
-  // Send all the pending REQs.
-  IReqHandler_M reqs;
-  if (!this->requests.Handlers(_topic, reqs))
+  // Send all the pending REQs. Only the requests not sent yet are visited.
+  auto unsent = this->dataPtr->unsentRequests.find(_topic);
+  if (unsent == this->dataPtr->unsentRequests.end())
     return;
 
-  for (auto &node : reqs)
+  const bool oneway = _repType == ignition::msgs::Empty().GetTypeName();
+  auto &queue = unsent->second;
+  for (auto it = queue.begin(); it != queue.end();)
   {
-    for (auto &req : node.second)
-    {
-      // Check if this service call has been already requested.
-      if (req.second->Requested())
-        continue;
-
-      // Check that the pending service call has types that match the responser.
-      if (req.second->ReqTypeName() != _reqType ||
-          req.second->RepTypeName() != _repType)
-      {
-        continue;
-      }
-
-      // Mark the handler as requested.
-      req.second->Requested(true);
-
-      std::string data;
-      if (!req.second->Serialize(data))
-        continue;
-
-      auto nodeUuid = req.second->NodeUuid();
-      auto reqUuid = req.second->HandlerUuid();
-
-      try
-      {
-        zmq::message_t msg;
-
-        msg.rebuild(responserId.size());
-        memcpy(msg.data(), responserId.data(), responserId.size());
-#ifdef IGN_ZMQ_POST_4_3_1
-        this->dataPtr->requester->send(msg, zmq::send_flags::sndmore);
-#else
-        this->dataPtr->requester->send(msg, ZMQ_SNDMORE);
-#endif
+    // Keep the handler alive, the iterator is invalidated below.
+    IReqHandlerPtr req = *it;
 
-        msg.rebuild(_topic.size());
-        memcpy(msg.data(), _topic.data(), _topic.size());
-#ifdef IGN_ZMQ_POST_4_3_1
-        this->dataPtr->requester->send(msg, zmq::send_flags::sndmore);
-#else
-        this->dataPtr->requester->send(msg, ZMQ_SNDMORE);
-#endif
+    // Check that the pending service call has types that match the responser.
+    if (req->ReqTypeName() != _reqType || req->RepTypeName() != _repType)
+    {
+      ++it;
+      continue;
+    }
 
-        msg.rebuild(this->myRequesterAddress.size());
-        memcpy(msg.data(), this->myRequesterAddress.data(),
-          this->myRequesterAddress.size());
-#ifdef IGN_ZMQ_POST_4_3_1
-        this->dataPtr->requester->send(msg, zmq::send_flags::sndmore);
-#else
-        this->dataPtr->requester->send(msg, ZMQ_SNDMORE);
-#endif
+    // A request targeting a responser that isn't known yet waits.
+    std::string target = req->Responser();
+    auto responser = responsers.find(target.empty() ? firstAddr : target);
+    if (responser == responsers.end())
+    {
+      ++it;
+      continue;
+    }
+    connect(responser->first);
 
-        std::string myId = this->responseReceiverId.ToString();
-        msg.rebuild(myId.size());
-        memcpy(msg.data(), myId.data(), myId.size());
-#ifdef IGN_ZMQ_POST_4_3_1
-        this->dataPtr->requester->send(msg, zmq::send_flags::sndmore);
-#else
-        this->dataPtr->requester->send(msg, ZMQ_SNDMORE);
-#endif
+    // Mark the handler as requested.
+    req->Requested(true);
+    auto nodeUuid = req->NodeUuid();
+    auto reqUuid = req->HandlerUuid();
+    this->dataPtr->requestsByUuid[reqUuid].unsent = false;
+    it = queue.erase(it);
 
-        msg.rebuild(nodeUuid.size());
-        memcpy(msg.data(), nodeUuid.data(), nodeUuid.size());
-#ifdef IGN_ZMQ_POST_4_3_1
-        this->dataPtr->requester->send(msg, zmq::send_flags::sndmore);
-#else
-        this->dataPtr->requester->send(msg, ZMQ_SNDMORE);
-#endif
+    std::string data;
+    if (!req->Serialize(data))
+      continue;
 
-        msg.rebuild(reqUuid.size());
-        memcpy(msg.data(), reqUuid.data(), reqUuid.size());
-#ifdef IGN_ZMQ_POST_4_3_1
-        this->dataPtr->requester->send(msg, zmq::send_flags::sndmore);
-#else
-        this->dataPtr->requester->send(msg, ZMQ_SNDMORE);
-#endif
+    this->dataPtr->SendSrvMsg(*this->dataPtr->requester,
+      this->dataPtr->pendingRequests, responser->first,
+      {responser->second, _topic, this->myRequesterAddress,
+       this->responseReceiverId.ToString(), nodeUuid, reqUuid, data,
+       _reqType, _repType});
 
-        msg.rebuild(data.size());
-        memcpy(msg.data(), data.data(), data.size());
-#ifdef IGN_ZMQ_POST_4_3_1
-        this->dataPtr->requester->send(msg, zmq::send_flags::sndmore);
-#else
-        this->dataPtr->requester->send(msg, ZMQ_SNDMORE);
-#endif
+    // Remove the handler associated to this service request. We won't
+    // receive a response because this is a oneway request.
+    if (oneway)
+      this->RemoveRequest(_topic, nodeUuid, reqUuid);
+  }
 
-        msg.rebuild(_reqType.size());
-        memcpy(msg.data(), _reqType.data(), _reqType.size());
-#ifdef IGN_ZMQ_POST_4_3_1
-        this->dataPtr->requester->send(msg, zmq::send_flags::sndmore);
-#else
-        this->dataPtr->requester->send(msg, ZMQ_SNDMORE);
-#endif
+  if (queue.empty())
+    this->dataPtr->unsentRequests.erase(unsent);
+}
 
-        msg.rebuild(_repType.size());
-        memcpy(msg.data(), _repType.data(), _repType.size());
-#ifdef IGN_ZMQ_POST_4_3_1
-        this->dataPtr->requester->send(msg, zmq::send_flags::none);
-#else
-        this->dataPtr->requester->send(msg, 0);
-#endif
-      }
-      catch(const zmq::error_t& /*ze*/)
-      {
-        // Debug output.
-        // std::cerr << "Error connecting [" << ze.what() << "]\n";
-      }
+//////////////////////////////////////////////////
+void NodeShared::AddRequest(const std::string &_topic,
+  const std::string &_nUuid, const IReqHandlerPtr &_handler)
+{
+  this->requests.AddHandler(_topic, _nUuid, _handler);
+
+  auto &queue = this->dataPtr->unsentRequests[_topic];
+  NodeSharedPrivate::PendingReq pending;
+  pending.handler = _handler;
+  pending.topic = _topic;
+  pending.unsentIt = queue.insert(queue.end(), _handler);
+  this->dataPtr->requestsByUuid[_handler->HandlerUuid()] = std::move(pending);
+}
 
-      // Remove the handler associated to this service request. We won't
-      // receive a response because this is a oneway request.
-      if (_repType == ignition::msgs::Empty().GetTypeName())
-      {
-        this->requests.RemoveHandler(_topic, nodeUuid, reqUuid);
-      }
+//////////////////////////////////////////////////
+bool NodeShared::RemoveRequest(const std::string &_topic,
+  const std::string &_nUuid, const std::string &_hUuid)
+{
+  auto it = this->dataPtr->requestsByUuid.find(_hUuid);
+  if (it != this->dataPtr->requestsByUuid.end() &&
+      it->second.topic == _topic)
+  {
+    if (it->second.unsent)
+    {
+      auto unsent = this->dataPtr->unsentRequests.find(_topic);
+      unsent->second.erase(it->second.unsentIt);
+      if (unsent->second.empty())
+        this->dataPtr->unsentRequests.erase(unsent);
     }
+    this->dataPtr->requestsByUuid.erase(it);
   }
+
+  return this->requests.RemoveHandler(_topic, _nUuid, _hUuid);
 }
 
 //////////////////////////////////////////////////
@@ -1112,11 +1947,20 @@ void NodeShared::OnNewConnection(const MessagePublisher &_pub)
     std::cout << _pub;
   }
 
-  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+  std::lock_guard<std::mutex> lock(this->dataPtr->connectionsMutex);
 
   // Check if we are interested in this topic.
-  if (this->localSubscribers.HasSubscriber(topic) &&
-      this->pUuid.compare(procUuid) != 0)
+  std::vector<std::string> handlerNodeUuids;
+  {
+    std::shared_lock<std::shared_mutex> subsLock(this->subscribersMutex);
+    if (!this->localSubscribers.HasSubscriber(topic))
+      return;
+
+    handlerNodeUuids =
+      this->localSubscribers.NodeUuids(topic, _pub.MsgTypeName());
+  }
+
+  if (this->pUuid.compare(procUuid) != 0)
   {
     // Handle security
     this->dataPtr->SecurityOnNewConnection();
@@ -1125,19 +1969,81 @@ void NodeShared::OnNewConnection(const MessagePublisher &_pub)
     if (!this->connections.HasPublisher(addr))
       this->dataPtr->subscriber->connect(addr.c_str());
 
-    // Add a new filter for the topic.
+    // Publishers running on the same host deliver the data through shared
+    // memory. In that case, we only receive notifications from them.
+    const bool useShm = this->dataPtr->shmEnabled &&
+      _pub.Options().Scope() != Scope_t::PROCESS &&
+      !_pub.ShmHostId().empty() &&
+      _pub.ShmHostId() == this->dataPtr->shmHostId &&
+      this->dataPtr->shmUnreachable.count(addr) == 0;
+    if (useShm)
+      this->dataPtr->shmPublishers[topic].insert(addr);
+
+    auto subscribe = [this](const std::string &_filter)
+    {
 #ifdef IGN_CPPZMQ_POST_4_7_0
-    this->dataPtr->subscriber->set(zmq::sockopt::subscribe, topic);
+      this->dataPtr->subscriber->set(zmq::sockopt::subscribe, _filter);
 #else
-    this->dataPtr->subscriber->setsockopt(ZMQ_SUBSCRIBE,
-        topic.data(), topic.size());
+      this->dataPtr->subscriber->setsockopt(ZMQ_SUBSCRIBE,
+          _filter.data(), _filter.size());
 #endif
+    };
+
+    // The nodes whose subscriptions declare a filter receive the messages
+    // that the publisher selects for them in a separate stream. The shared
+    // memory notifications carry every message.
+    std::vector<std::string> nodeFilters;
+    bool unfiltered = useShm;
+    {
+      const HandlerInfo handlers = this->CheckHandlerInfo(topic);
+      for (const std::string &nodeUuid : handlerNodeUuids)
+      {
+        nodeFilters.push_back(
+          useShm ? std::string() : nodeFilterKey(handlers, nodeUuid));
+        const std::string &key = nodeFilters.back();
+        if (key.empty())
+        {
+          unfiltered = true;
+          continue;
+        }
+
+        const std::string frame = NodeSharedPrivate::FilterFrame(
+          MessageFilterPrivate::SubscriptionId(key), topic);
+        if (this->dataPtr->filterFrames[topic].insert(frame).second)
+          subscribe(frame);
+      }
+    }
+
+    // Add a new filter for the topic.
+    if (unfiltered)
+      subscribe(useShm ? NodeSharedPrivate::kShmTopicPrefix + topic : topic);
 
     // Register the new connection with the publisher.
     this->connections.AddPublisher(_pub);
 
+    // The messages of this publisher only carry its stream identifier.
+    NodeSharedPrivate::RemoteStream stream;
+    stream.topic = topic;
+    stream.sender = addr;
+    stream.msgType = _pub.MsgTypeName();
+    this->dataPtr->remoteStreams[_pub.StreamId()] = std::move(stream);
+
+    // Compressed messages are dropped if we can't decompress them.
+    const std::string codecName = _pub.Options().Compression();
+    if (!useShm && !codecName.empty() && !Codec::Find(codecName))
+    {
+      std::cerr << "Publisher [" << addr << "] compresses the messages of "
+                << "topic [" << topic << "] with codec [" << codecName
+                << "], which is not available. Its messages larger than "
+                << "the compression threshold will be discarded."
+                << std::endl;
+    }
+
     if (this->verbose)
-      std::cout << "\t* Connected to [" << addr << "] for data\n";
+    {
+      std::cout << "\t* Connected to [" << addr << "] for data"
+                << (useShm ? " (shared memory)" : "") << std::endl;
+    }
 
     MessagePublisher pub(_pub);
     pub.SetPUuid(this->pUuid);
@@ -1145,11 +2051,13 @@ void NodeShared::OnNewConnection(const MessagePublisher &_pub)
     // Hack: We use this field to store the PUuid of the topic publisher.
     pub.SetCtrl(_pub.PUuid());
 
-    std::vector<std::string> handlerNodeUuids =
-        this->localSubscribers.NodeUuids(topic, _pub.MsgTypeName());
-    for (const std::string &nodeUuid : handlerNodeUuids)
+    // Let the publisher know if we want the data through shared memory.
+    pub.SetShmHostId(useShm ? this->dataPtr->shmHostId : "");
+
+    for (size_t i = 0; i < handlerNodeUuids.size(); ++i)
     {
-      pub.SetNUuid(nodeUuid);
+      pub.SetNUuid(handlerNodeUuids[i]);
+      pub.SetFilter(nodeFilters[i]);
 
       // Send a message to the publisher notify it
       // about all my remoteSubscribers.
@@ -1161,8 +2069,6 @@ void NodeShared::OnNewConnection(const MessagePublisher &_pub)
 //////////////////////////////////////////////////
 void NodeShared::OnNewDisconnection(const MessagePublisher &_pub)
 {
-  std::lock_guard<std::recursive_mutex> lock(this->mutex);
-
   std::string topic = _pub.Topic();
   std::string procUuid = _pub.PUuid();
   std::string nUuid = _pub.NUuid();
@@ -1176,7 +2082,13 @@ void NodeShared::OnNewDisconnection(const MessagePublisher &_pub)
   // A remote subscriber[s] has been disconnected.
   if (topic != "" && nUuid != "")
   {
-    this->remoteSubscribers.DelPublisherByNode(topic, procUuid, nUuid);
+    {
+      std::lock_guard<std::shared_mutex> subsLock(this->subscribersMutex);
+      this->remoteSubscribers.DelPublisherByNode(topic, procUuid, nUuid);
+    }
+    ++this->dataPtr->subscribersEpoch;
+
+    std::lock_guard<std::mutex> lock(this->dataPtr->connectionsMutex);
 
     MessagePublisher connection;
     if (!this->connections.Publisher(topic, procUuid, nUuid, connection))
@@ -1184,9 +2096,42 @@ void NodeShared::OnNewDisconnection(const MessagePublisher &_pub)
 
     // I am no longer connected.
     this->connections.DelPublisherByNode(topic, procUuid, nUuid);
+
+    // Stop using the shared memory of the publisher's process if it has no
+    // more publishers for this topic.
+    if (!this->connections.HasAnyPublishers(topic, procUuid))
+    {
+      this->dataPtr->shmPublishers[topic].erase(connection.Addr());
+      this->dataPtr->shmReaders.erase(connection.Addr() + topic);
+    }
+
+    // Forget the stream if no other node of the process publishes it.
+    std::map<std::string, std::vector<MessagePublisher>> topicPubs;
+    this->connections.Publishers(topic, topicPubs);
+    bool streamInUse = false;
+    for (const auto &pub : topicPubs[procUuid])
+      streamInUse = streamInUse || pub.StreamId() == connection.StreamId();
+    if (!streamInUse)
+      this->dataPtr->remoteStreams.erase(connection.StreamId());
   }
   else
   {
+    std::lock_guard<std::mutex> lock(this->dataPtr->connectionsMutex);
+
+    // Stop using the shared memory of the disconnected process.
+    std::map<std::string, std::vector<MessagePublisher>> procPubs;
+    this->connections.PublishersByProc(procUuid, procPubs);
+    for (const auto &procTopic : procPubs)
+    {
+      for (const auto &pub : procTopic.second)
+      {
+        this->dataPtr->shmPublishers[procTopic.first].erase(pub.Addr());
+        this->dataPtr->shmReaders.erase(pub.Addr() + procTopic.first);
+        this->dataPtr->shmUnreachable.erase(pub.Addr());
+        this->dataPtr->remoteStreams.erase(pub.StreamId());
+      }
+    }
+
     // Note: We deliberately don't remove the list of remote subscribers
     // for this process. Remote nodes might suffer package delays (due to WiFi
     // or traffic load) and if we remove them, they won't be able to receive
@@ -1218,23 +2163,21 @@ void NodeShared::OnNewSrvConnection(const ServicePublisher &_pub)
   }
 
   // I am still not connected to this address.
-  if (std::find(this->srvConnections.begin(), this->srvConnections.end(),
-        addr) == this->srvConnections.end())
+  if (this->srvConnections.find(addr) == this->srvConnections.end())
   {
     this->dataPtr->requester->connect(addr.c_str());
-    this->srvConnections.push_back(addr);
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    this->srvConnections.insert(addr);
     if (this->verbose)
     {
-      std::cout << "\t* Connected to [" << addr
+      std::cout << "\t* Connecting to [" << addr
                 << "] for service requests" << std::endl;
     }
   }
 
-  // Check if there's a pending service request with this specific combination
-  // of request and response types.
-  IReqHandlerPtr handler;
-  if (this->requests.FirstHandler(topic, reqType, repType, handler))
+  // Check if there's a service request waiting for this topic. Only the ones
+  // with this specific combination of request and response types are sent.
+  if (this->dataPtr->unsentRequests.find(topic) !=
+      this->dataPtr->unsentRequests.end())
   {
     // Request all pending service calls for this topic and req/rep types.
     this->SendPendingRemoteReqs(topic, reqType, repType);
@@ -1249,9 +2192,7 @@ void NodeShared::OnNewSrvDisconnection(const ServicePublisher &_pub)
   std::lock_guard<std::recursive_mutex> lock(this->mutex);
 
   // Remove the address from the list of connected addresses.
-  this->srvConnections.erase(std::remove(std::begin(this->srvConnections),
-    std::end(this->srvConnections), addr.c_str()),
-    std::end(this->srvConnections));
+  this->srvConnections.erase(addr);
 
   if (this->verbose)
   {
@@ -1277,9 +2218,47 @@ void NodeShared::OnNewRegistration(const MessagePublisher &_pub)
     std::cout << "\tNode UUID: [" << nodeUuid << "]" << std::endl;
   }
 
-  // Add a remote subscriber.
-  std::lock_guard<std::recursive_mutex> lock(this->mutex);
-  this->remoteSubscribers.AddPublisher(_pub);
+  // Add a remote subscriber. A node registers again when its filter
+  // changes or when it can't open our shared memory.
+  bool newNode = true;
+  {
+    std::lock_guard<std::shared_mutex> lock(this->subscribersMutex);
+    MessagePublisher previous;
+    if (this->remoteSubscribers.Publisher(_pub.Topic(), procUuid, nodeUuid,
+          previous))
+    {
+      newNode = false;
+      if (previous.Filter() != _pub.Filter() ||
+          previous.ShmHostId() != _pub.ShmHostId())
+      {
+        this->remoteSubscribers.DelPublisherByNode(_pub.Topic(), procUuid,
+          nodeUuid);
+      }
+    }
+    this->remoteSubscribers.AddPublisher(_pub);
+  }
+  ++this->dataPtr->subscribersEpoch;
+
+  // Replay the messages of our latched publishers to the new node, once its
+  // subscriptions had time to reach our publisher socket.
+  if (newNode && this->dataPtr->Latched(_pub.Topic()))
+  {
+    this->ScheduleTimer(
+      std::chrono::steady_clock::now() + NodeSharedPrivate::kLatchReplayDelay,
+      [this, _pub]()
+      {
+        {
+          std::shared_lock<std::shared_mutex> lock(this->subscribersMutex);
+          MessagePublisher current;
+          if (!this->remoteSubscribers.Publisher(_pub.Topic(), _pub.PUuid(),
+                _pub.NUuid(), current))
+          {
+            return;
+          }
+        }
+        this->dataPtr->ReplayRemote(_pub);
+      });
+  }
 }
 
 //////////////////////////////////////////////////
@@ -1301,8 +2280,11 @@ void NodeShared::OnEndRegistration(const MessagePublisher &_pub)
   }
 
   // Delete a remote subscriber.
-  std::lock_guard<std::recursive_mutex> lock(this->mutex);
-  this->remoteSubscribers.DelPublisherByNode(topic, procUuid, nodeUuid);
+  {
+    std::lock_guard<std::shared_mutex> lock(this->subscribersMutex);
+    this->remoteSubscribers.DelPublisherByNode(topic, procUuid, nodeUuid);
+  }
+  ++this->dataPtr->subscribersEpoch;
 }
 
 //////////////////////////////////////////////////
@@ -1366,6 +2348,16 @@ bool NodeShared::InitializeSockets()
           &rcvQueueVal, sizeof(rcvQueueVal));
 #endif
 
+    // Receive the messages that latched publishers replay to our nodes.
+    const std::string latchFilter =
+      NodeSharedPrivate::kLatchTopicPrefix + this->pUuid + ":";
+#ifdef IGN_CPPZMQ_POST_4_7_0
+    this->dataPtr->subscriber->set(zmq::sockopt::subscribe, latchFilter);
+#else
+    this->dataPtr->subscriber->setsockopt(ZMQ_SUBSCRIBE,
+          latchFilter.data(), latchFilter.size());
+#endif
+
     // Set the capacity of the buffer for sending messages.
     std::string ignSndHwm;
     int sndQueueVal = kDefaultSndHwm;
@@ -1460,6 +2452,33 @@ bool NodeShared::InitializeSockets()
     this->dataPtr->requester->setsockopt(ZMQ_ROUTER_MANDATORY, &RouteOn,
       sizeof(RouteOn));
 #endif
+
+    // Get notified when the connections used for service calls are ready,
+    // so the requests and responses waiting for them are sent right away.
+    // Without the monitors, they are retried periodically.
+    if (!monitorSocket(*this->dataPtr->requester,
+          *this->dataPtr->requesterMonitor, "inproc://ign-requester-monitor") ||
+        !monitorSocket(*this->dataPtr->replier,
+          *this->dataPtr->replierMonitor, "inproc://ign-replier-monitor"))
+    {
+      std::cerr << "InitializeSockets() Unable to monitor the service call "
+                << "sockets: " << zmq_strerror(zmq_errno()) << std::endl;
+    }
+
+    // The service worker threads wake up the reception thread through this
+    // pair of sockets when a response is ready.
+    const std::string srvWakeAddr = "inproc://ign-srv-responses";
+#ifdef IGN_CPPZMQ_POST_4_7_0
+    this->dataPtr->srvWakeReceiver->set(zmq::sockopt::linger, lingerVal);
+    this->dataPtr->srvWakeSender->set(zmq::sockopt::linger, lingerVal);
+#else
+    this->dataPtr->srvWakeReceiver->setsockopt(ZMQ_LINGER,
+        &lingerVal, sizeof(lingerVal));
+    this->dataPtr->srvWakeSender->setsockopt(ZMQ_LINGER,
+        &lingerVal, sizeof(lingerVal));
+#endif
+    this->dataPtr->srvWakeReceiver->bind(srvWakeAddr.c_str());
+    this->dataPtr->srvWakeSender->connect(srvWakeAddr.c_str());
   }
   catch(const zmq::error_t& ze)
   {
@@ -1482,9 +2501,17 @@ bool NodeShared::TopicPublishers(const std::string &_topic,
 /////////////////////////////////////////////////
 bool NodeShared::DiscoverService(const std::string &_topic) const
 {
+  this->dataPtr->srvDiscovery->AddInterest(_topic);
   return this->dataPtr->srvDiscovery->Discover(_topic);
 }
 
+/////////////////////////////////////////////////
+void NodeShared::EnableFullCatalog()
+{
+  this->dataPtr->msgDiscovery->SetFilterByInterest(false);
+  this->dataPtr->srvDiscovery->SetFilterByInterest(false);
+}
+
 /////////////////////////////////////////////////
 bool NodeShared::AdvertisePublisher(const ServicePublisher &_publisher)
 {
@@ -1533,6 +2560,24 @@ int NodeShared::SndHwm()
   return sndHwm;
 }
 
+/////////////////////////////////////////////////
+std::size_t NodeShared::PubQueueCapacity() const
+{
+  return this->dataPtr->pubQueue->Capacity();
+}
+
+/////////////////////////////////////////////////
+std::size_t NodeShared::PubQueueDepth() const
+{
+  return this->dataPtr->pubQueue->Size();
+}
+
+/////////////////////////////////////////////////
+uint64_t NodeShared::PubQueueDropped() const
+{
+  return this->dataPtr->pubQueue->Dropped();
+}
+
 //////////////////////////////////////////////////
 bool NodeShared::HandlerWrapper::HasSubscriber(
     const std::string &_fullyQualifiedTopic,
@@ -1563,10 +2608,12 @@ static void AppendNodeUuids(const HandlerStorage<HandlerT> &_handlerStorage,
                             std::vector<std::string> &_uuids)
 {
   using HandlerTPtr = std::shared_ptr<HandlerT>;
-  std::map<std::string, std::map<std::string, HandlerTPtr>> handlers;
 
-  _handlerStorage.Handlers(_fullyQualifiedTopic, handlers);
-  for (const auto &collection : handlers)
+  auto handlers = _handlerStorage.Handlers(_fullyQualifiedTopic);
+  if (!handlers)
+    return;
+
+  for (const auto &collection : *handlers)
   {
     for (const auto &collectionEntry : collection.second)
     {
@@ -1805,78 +2852,549 @@ void NodeSharedPrivate::AccessControlHandler()
 }
 
 /////////////////////////////////////////////////
-void NodeSharedPrivate::PublishThread()
+uint64_t NodeSharedPrivate::StreamId(const std::string &_topic,
+  const std::string &_msgType)
 {
-  // Loop until exits
-  while (!this->exit)
+  std::string key;
+  key.reserve(_topic.size() + 1 + _msgType.size());
+  key.append(_topic).push_back('\0');
+  key.append(_msgType);
+
+  uint64_t &id = this->streamIds[key];
+  while (id == 0)
+    id = this->streamIdGenerator();
+  return id;
+}
+
+/////////////////////////////////////////////////
+std::string NodeSharedPrivate::FilterFrame(const uint64_t _filterId,
+  const std::string &_topic)
+{
+  std::ostringstream frame;
+  frame << kFilterTopicPrefix << std::hex << std::setfill('0')
+        << std::setw(kFilterIdDigits) << _filterId << ':' << _topic;
+  return frame.str();
+}
+
+/////////////////////////////////////////////////
+std::string NodeSharedPrivate::LatchFrame(const std::string &_pUuid,
+  const std::string &_nUuid, const std::string &_topic)
+{
+  return kLatchTopicPrefix + _pUuid + ":" + _nUuid + ":" + _topic;
+}
+
+/////////////////////////////////////////////////
+bool NodeSharedPrivate::Latched(const std::string &_topic) const
+{
+  std::lock_guard<std::mutex> lk(this->latchMutex);
+  return this->latchCaches.find(_topic) != this->latchCaches.end();
+}
+
+/////////////////////////////////////////////////
+std::vector<LatchCache::Entry> NodeSharedPrivate::LatchedMsgs(
+  const std::string &_topic) const
+{
+  std::vector<std::shared_ptr<LatchCache>> caches;
   {
-    std::unique_ptr<PublishMsgDetails> msgDetails = nullptr;
-    // Lock the mutex, and acquire the next message to be published.
-    {
-      std::unique_lock<std::mutex> queueLock(this->pubThreadMutex);
+    std::lock_guard<std::mutex> lk(this->latchMutex);
+    auto it = this->latchCaches.find(_topic);
+    if (it == this->latchCaches.end())
+      return {};
+    caches = it->second;
+  }
 
-      // Wait for more messages if the queue is empty. Otherwise get the
-      // next message and continue.
-      if (this->pubQueue.empty())
-      {
-        auto now = std::chrono::system_clock::now();
-        this->signalNewPub.wait_until(queueLock, now + 500ms,
-          [&]{return !this->pubQueue.empty() || this->exit;});
-      }
+  std::vector<LatchCache::Entry> msgs;
+  for (const auto &cache : caches)
+  {
+    std::vector<LatchCache::Entry> entries = cache->Entries();
+    msgs.insert(msgs.end(), std::make_move_iterator(entries.begin()),
+      std::make_move_iterator(entries.end()));
+  }
+  return msgs;
+}
+
+/////////////////////////////////////////////////
+std::vector<std::unique_ptr<NodeSharedPrivate::PublishMsgDetails>>
+  NodeSharedPrivate::LatchedDeliveries(const std::string &_topic,
+    const std::shared_ptr<SubscriptionHandlerBase> &_handler) const
+{
+  std::vector<std::unique_ptr<PublishMsgDetails>> deliveries;
+  if (!_handler)
+    return deliveries;
+
+  auto local = std::dynamic_pointer_cast<ISubscriptionHandler>(_handler);
+  auto raw = std::dynamic_pointer_cast<RawSubscriptionHandler>(_handler);
+  const std::string handlerType = _handler->TypeName();
+
+  for (const LatchCache::Entry &entry : this->LatchedMsgs(_topic))
+  {
+    if (handlerType != kGenericMessageType && handlerType != entry.msgType)
+      continue;
 
-      if (this->pubQueue.empty())
+    std::unique_ptr<PublishMsgDetails> details(new PublishMsgDetails);
+    details->info.SetTopicAndPartition(_topic);
+    details->info.SetType(entry.msgType);
+    details->info.SetIntraProcess(true);
+
+    if (local)
+    {
+      details->msgCopy = local->CreateMsg(entry.data->data(),
+        entry.data->size(), entry.msgType);
+      if (!details->msgCopy)
         continue;
+      details->localHandlers.push_back(local);
+    }
+    else if (raw)
+    {
+      // The delivery shares the data kept in the cache.
+      details->sharedBuffer =
+        std::shared_ptr<const char>(entry.data, entry.data->data());
+      details->msgSize = entry.data->size();
+      details->rawHandlers.push_back(raw);
+    }
+    else
+    {
+      continue;
+    }
+
+    deliveries.push_back(std::move(details));
+  }
+
+  return deliveries;
+}
+
+/////////////////////////////////////////////////
+void NodeSharedPrivate::ReplayRemote(const MessagePublisher &_subscriber)
+{
+  const std::string &topic = _subscriber.Topic();
+  const std::string &subscriberType = _subscriber.MsgTypeName();
+  const std::string frame =
+    LatchFrame(_subscriber.PUuid(), _subscriber.NUuid(), topic);
 
-      // Stop early on exit.
-      if (this->exit)
-        break;
+  // ZeroMQ drops its reference on the cached data once sent.
+  auto deallocator = [](void *, void *_hint)
+  {
+    delete static_cast<std::shared_ptr<const std::string> *>(_hint);
+  };
 
-      // Get the message
-      msgDetails = std::move(this->pubQueue.front());
-      this->pubQueue.pop();
+  for (const LatchCache::Entry &entry : this->LatchedMsgs(topic))
+  {
+    if (subscriberType != kGenericMessageType &&
+        subscriberType != entry.msgType)
+    {
+      continue;
     }
 
-    // Send the message to all the local handlers.
-    for (auto &handler : msgDetails->localHandlers)
+    // The type is always sent, the stream might be the one of a generic
+    // publisher.
+    this->SendMsg(frame, entry.streamId,
+      const_cast<char *>(entry.data->data()), entry.data->size(),
+      deallocator, entry.msgType,
+      new std::shared_ptr<const std::string>(entry.data));
+  }
+}
+
+/////////////////////////////////////////////////
+bool NodeSharedPrivate::SendMsg(const std::string &_frameTopic,
+  const uint64_t _streamId, char *_data, const size_t _dataSize,
+  DeallocFunc *_ffn, const std::string &_msgType, void *_hint,
+  const uint8_t _codec)
+{
+  try
+  {
+    // Note that we use zero copy for passing the message data.
+    zmq::message_t topicMsg(_frameTopic.data(), _frameTopic.size());
+    zmq::message_t dataMsg(_data, _dataSize, _ffn, _hint);
+
+    MsgHeader header;
+    header.streamId = _streamId;
+    header.codec = _codec;
+    if (!_msgType.empty())
+      header.flags |= MsgHeader::kTypeFlag;
+
+    std::lock_guard<std::mutex> lock(this->publisherMutex);
+
+    size_t headerSize = MsgHeader::kBaseSize;
+    if (this->topicStatsEnabled)
     {
-      try
-      {
-        handler->RunLocalCallback(*(msgDetails->msgCopy.get()),
-            msgDetails->info);
-      }
-      catch (...)
+      // Send the sequence number, which can be used to detect dropped
+      // messages, and the publication time.
+      header.flags |= MsgHeader::kStatsFlag;
+      header.seq = this->topicPubSeq[_frameTopic]++;
+      header.stamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now().time_since_epoch()).count();
+      headerSize = sizeof(header);
+    }
+    zmq::message_t headerMsg(&header, headerSize);
+
+#ifdef IGN_ZMQ_POST_4_3_1
+    this->publisher->send(topicMsg, zmq::send_flags::sndmore);
+    this->publisher->send(headerMsg, zmq::send_flags::sndmore);
+    if (_msgType.empty())
+    {
+      this->publisher->send(dataMsg, zmq::send_flags::none);
+    }
+    else
+    {
+      zmq::message_t typeMsg(_msgType.data(), _msgType.size());
+      this->publisher->send(dataMsg, zmq::send_flags::sndmore);
+      this->publisher->send(typeMsg, zmq::send_flags::none);
+    }
+#else
+    this->publisher->send(topicMsg, ZMQ_SNDMORE);
+    this->publisher->send(headerMsg, ZMQ_SNDMORE);
+    if (_msgType.empty())
+    {
+      this->publisher->send(dataMsg, 0);
+    }
+    else
+    {
+      zmq::message_t typeMsg(_msgType.data(), _msgType.size());
+      this->publisher->send(dataMsg, ZMQ_SNDMORE);
+      this->publisher->send(typeMsg, 0);
+    }
+#endif
+  }
+  catch(const zmq::error_t& ze)
+  {
+     std::cerr << "NodeShared::Publish() Error: " << ze.what() << std::endl;
+     return false;
+  }
+
+  return true;
+}
+
+/////////////////////////////////////////////////
+bool NodeSharedPrivate::SendSrvMsg(zmq::socket_t &_socket,
+    std::vector<PendingSrvMsg> &_pending, const std::string &_addr,
+    std::vector<std::string> &&_frames)
+{
+  // Keep the order of the messages sent to the same peer.
+  const bool waiting = std::any_of(_pending.begin(), _pending.end(),
+    [&_frames](const PendingSrvMsg &_msg)
+    {
+      return _msg.frames.front() == _frames.front();
+    });
+
+  try
+  {
+    if (!waiting && sendSrvFrames(_socket, _frames))
+      return true;
+  }
+  catch(const zmq::error_t &_error)
+  {
+    std::cerr << "Error sending service call message to [" << _addr
+              << "]: " << _error.what() << std::endl;
+    return false;
+  }
+
+  PendingSrvMsg msg;
+  msg.addr = _addr;
+  msg.frames = std::move(_frames);
+  msg.deadline = std::chrono::steady_clock::now() +
+    std::chrono::milliseconds(kSrvConnectTimeout);
+  _pending.push_back(std::move(msg));
+  this->hasPendingSrvMsgs = true;
+  return true;
+}
+
+/////////////////////////////////////////////////
+void NodeSharedPrivate::RetryPendingSrvMsgs()
+{
+  const auto now = std::chrono::steady_clock::now();
+
+  auto retry = [&now](zmq::socket_t &_socket,
+    std::vector<PendingSrvMsg> &_pending)
+  {
+    // Peers with a message still waiting. Their next messages wait too.
+    std::set<std::string> blocked;
+    std::vector<PendingSrvMsg> remaining;
+    for (PendingSrvMsg &msg : _pending)
+    {
+      const std::string &id = msg.frames.front();
+      if (blocked.find(id) == blocked.end())
       {
-        std::cerr << "Exception occurred in a local callback "
-          << "on topic [" << msgDetails->info.Topic() << "] with message ["
-          << msgDetails->msgCopy->DebugString() << "]" << std::endl;
+        try
+        {
+          if (sendSrvFrames(_socket, msg.frames))
+            continue;
+        }
+        catch(const zmq::error_t &_error)
+        {
+          std::cerr << "Error sending service call message to ["
+                    << msg.addr << "]: " << _error.what() << std::endl;
+          continue;
+        }
+
+        if (now >= msg.deadline)
+        {
+          std::cerr << "Unable to connect to [" << msg.addr << "]. "
+                    << "Discarding service call message" << std::endl;
+          continue;
+        }
+
+        blocked.insert(id);
       }
+      remaining.push_back(std::move(msg));
+    }
+    _pending.swap(remaining);
+  };
+
+  retry(*this->requester, this->pendingRequests);
+  retry(*this->replier, this->pendingResponses);
+
+  this->hasPendingSrvMsgs =
+    !this->pendingRequests.empty() || !this->pendingResponses.empty();
+}
+
+/////////////////////////////////////////////////
+std::shared_ptr<NodeSharedPrivate::SrvWorkers>
+NodeSharedPrivate::ReplierWorkers(const std::string &_hUuid) const
+{
+  std::lock_guard<std::mutex> lk(this->srvWorkersMutex);
+  auto it = this->srvWorkers.find(_hUuid);
+  if (it == this->srvWorkers.end())
+    return nullptr;
+  return it->second;
+}
+
+/////////////////////////////////////////////////
+void NodeSharedPrivate::QueueSrvResponse(const std::string &_addr,
+  std::vector<std::string> &&_frames)
+{
+  std::lock_guard<std::mutex> lk(this->srvResponsesMutex);
+
+  PendingSrvMsg msg;
+  msg.addr = _addr;
+  msg.frames = std::move(_frames);
+  this->srvResponses.push_back(std::move(msg));
+
+  // The reception thread was already woken up and hasn't taken the
+  // responses yet.
+  if (this->srvResponses.size() > 1)
+    return;
+
+  try
+  {
+    zmq::message_t wake(0);
+#ifdef IGN_ZMQ_POST_4_3_1
+    this->srvWakeSender->send(wake, zmq::send_flags::dontwait);
+#else
+    this->srvWakeSender->send(wake, ZMQ_DONTWAIT);
+#endif
+  }
+  catch(const zmq::error_t &_error)
+  {
+    std::cerr << "Error waking up the reception thread: " << _error.what()
+              << std::endl;
+  }
+}
+
+/////////////////////////////////////////////////
+std::vector<std::function<void()>> NodeSharedPrivate::ExpiredTimers(
+  const std::chrono::steady_clock::time_point &_now)
+{
+  std::vector<std::function<void()>> expired;
+  std::lock_guard<std::mutex> lock(this->timersMutex);
+  auto end = this->timers.upper_bound(_now);
+  for (auto it = this->timers.begin(); it != end; ++it)
+    expired.push_back(std::move(it->second));
+  this->timers.erase(this->timers.begin(), end);
+  return expired;
+}
+
+/////////////////////////////////////////////////
+int NodeSharedPrivate::TimersTimeout(
+  const std::chrono::steady_clock::time_point &_now) const
+{
+  std::lock_guard<std::mutex> lock(this->timersMutex);
+  if (this->timers.empty())
+    return Timeout;
+
+  // Round up, so the timer has expired when the poll returns.
+  auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+    this->timers.begin()->first - _now) + std::chrono::milliseconds(1);
+  return static_cast<int>(std::max<std::chrono::milliseconds::rep>(0,
+    std::min<std::chrono::milliseconds::rep>(Timeout, wait.count())));
+}
+
+/////////////////////////////////////////////////
+void NodeSharedPrivate::PublishThread()
+{
+  std::vector<std::unique_ptr<PublishMsgDetails>> batch;
+
+  // Loop until exits
+  while (!this->exit)
+  {
+    // Wait for more messages if the queue is empty.
+    if (!this->pubQueue->Wait(500ms))
+      continue;
+
+    // Stop early on exit.
+    if (this->exit)
+      break;
+
+    // Take all the messages available at once. This makes room in the queue
+    // for blocked publishers as soon as possible.
+    std::unique_ptr<PublishMsgDetails> next;
+    while (batch.size() < this->pubQueue->Capacity() &&
+           this->pubQueue->Pop(next))
+    {
+      batch.push_back(std::move(next));
     }
 
-    // Send the message to all the raw handlers.
-    for (auto &handler : msgDetails->rawHandlers)
+    for (auto &msgDetails : batch)
+      this->DeliverLocal(*msgDetails);
+    batch.clear();
+  }
+}
+
+/////////////////////////////////////////////////
+void NodeSharedPrivate::DeliverLocal(const PublishMsgDetails &_msgDetails)
+{
+  // Send the message to all the local handlers.
+  for (auto &handler : _msgDetails.localHandlers)
+  {
+    try
     {
-      try
+      if (handler->Queue())
       {
-        handler->RunRawCallback(msgDetails->sharedBuffer.get(),
-            msgDetails->msgSize, msgDetails->info);
+        ISubscriptionHandler *h = handler.get();
+        this->QueueDelivery(handler,
+          [h, msg = _msgDetails.msgCopy, info = _msgDetails.info]()
+          {
+            h->RunLocalCallback(*msg, info);
+          });
+        continue;
       }
-      catch (...)
+
+      handler->RunLocalCallback(*(_msgDetails.msgCopy.get()),
+          _msgDetails.info);
+    }
+    catch (...)
+    {
+      std::cerr << "Exception occurred in a local callback "
+        << "on topic [" << _msgDetails.info.Topic() << "] with message ["
+        << _msgDetails.msgCopy->DebugString() << "]" << std::endl;
+    }
+  }
+
+  // Send the message to all the raw handlers.
+  for (auto &handler : _msgDetails.rawHandlers)
+  {
+    try
+    {
+      if (handler->Queue())
       {
-        std::cerr << "Exception occured in a local raw callback "
-          << "on topic [" << msgDetails->info.Topic() << "] with "
-          << "message [" << msgDetails->msgCopy->DebugString() << "]"
-          << std::endl;
+        RawSubscriptionHandler *h = handler.get();
+        this->QueueDelivery(handler,
+          [h, data = _msgDetails.sharedBuffer, size = _msgDetails.msgSize,
+           info = _msgDetails.info]()
+          {
+            h->RunRawCallback(data.get(), size, info);
+          });
+        continue;
       }
+
+      handler->RunRawCallback(_msgDetails.sharedBuffer.get(),
+          _msgDetails.msgSize, _msgDetails.info);
+    }
+    catch (...)
+    {
+      std::cerr << "Exception occured in a local raw callback "
+        << "on topic [" << _msgDetails.info.Topic() << "]" << std::endl;
     }
   }
+
+  // Rest of the batch.
+  for (const auto &next : _msgDetails.batch)
+    this->DeliverLocal(*next);
+}
+
+/////////////////////////////////////////////////
+void NodeSharedPrivate::QueueDelivery(
+  const std::shared_ptr<SubscriptionHandlerBase> &_handler,
+  std::function<void()> _delivery)
+{
+  if (!_handler->Queue()->Push(std::move(_delivery)))
+    return;
+
+  std::lock_guard<std::mutex> lk(this->callbackExecutorMutex);
+  CallbackExecutor *executor = this->callbackExecutor.get();
+  if (!executor)
+  {
+    // Shutting down.
+    if (this->exit)
+      return;
+
+    if (!this->queueExecutor)
+      this->queueExecutor.reset(new CallbackExecutor(1u));
+    executor = this->queueExecutor.get();
+  }
+
+  // The task keeps the handler alive while its queue is drained. The
+  // messages of a subscription keep their order, and a slow callback only
+  // delays its own subscription.
+  executor->Post(_handler->HandlerUuid(), [_handler]()
+  {
+    _handler->Queue()->Drain();
+  });
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::WaitForCallbacks(const std::string &_topic,
+  const std::vector<std::shared_ptr<SubscriptionHandlerBase>> &_handlers)
+{
+  for (const auto &handler : _handlers)
+  {
+    if (handler->Queue())
+      handler->Queue()->Close();
+  }
+
+  // The executors are only destroyed with NodeShared.
+  CallbackExecutor *callbackExec = nullptr;
+  CallbackExecutor *queueExec = nullptr;
+  {
+    std::lock_guard<std::mutex> lk(this->callbackExecutorMutex);
+    callbackExec = this->callbackExecutor.get();
+    queueExec = this->queueExecutor.get();
+  }
+
+  for (CallbackExecutor *executor : {callbackExec, queueExec})
+  {
+    if (!executor)
+      continue;
+
+    executor->Wait(_topic);
+    for (const auto &handler : _handlers)
+      executor->Wait(handler->HandlerUuid());
+  }
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::AddPartitionInterest(const std::string &_partition)
+{
+  if (this->discoveryInterest != DiscoveryInterest::PARTITION)
+    return;
+
+  // The prefix of the fully qualified names in the partition, e.g. "@/p@".
+  std::string name;
+  if (!TopicUtils::FullyQualifiedName(_partition, "", "/_", name))
+    return;
+  const std::string prefix = name.substr(0, name.rfind('@') + 1);
+
+  this->msgDiscovery->AddInterestPrefix(prefix);
+  this->srvDiscovery->AddInterestPrefix(prefix);
 }
 
 //////////////////////////////////////////////////
 std::optional<transport::TopicStatistics> NodeShared::TopicStats(
     const std::string &_topic) const
 {
-  if (this->dataPtr->topicStats.find(_topic) != this->dataPtr->topicStats.end())
-    return this->dataPtr->topicStats.at(_topic);
+  std::lock_guard<std::mutex> lk(this->dataPtr->statsMutex);
+  auto it = this->dataPtr->topicStats.find(_topic);
+  if (it != this->dataPtr->topicStats.end())
+    return it->second;
   return std::nullopt;
 }
 
@@ -1884,6 +3402,7 @@ std::optional<transport::TopicStatistics> NodeShared::TopicStats(
 void NodeShared::EnableStats(const std::string &_topic, bool _enable,
     std::function<void(const TopicStatistics &_stats)> _statCb)
 {
+  std::lock_guard<std::mutex> lk(this->dataPtr->statsMutex);
   if (_enable)
   {
     this->dataPtr->enabledTopicStatistics.insert({_topic, _statCb});
@@ -27,14 +27,26 @@
 #endif
 
 #include <atomic>
+#include <chrono>
+#include <functional>
+#include <list>
 #include <map>
 #include <memory>
-#include <queue>
+#include <mutex>
+#include <random>
+#include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "ignition/transport/Discovery.hh"
 #include "ignition/transport/Node.hh"
+#include "ignition/transport/SharedMemoryRing.hh"
+
+#include "BufferPool.hh"
+#include "CallbackExecutor.hh"
+#include "LatchCache.hh"
+#include "MpscQueue.hh"
 
 namespace ignition
 {
@@ -43,10 +55,43 @@ namespace ignition
     // Inline bracket to help doxygen filtering.
     inline namespace IGNITION_TRANSPORT_VERSION_NAMESPACE {
     //
-    /// \brief Metadata for a publication. This is sent as part of the ZMQ
-    /// message for topic statistics.
-    class PublicationMetadata
+    /// \brief Header of a publication, sent in a single frame between the
+    /// topic and the data. The sender and the message type are not sent,
+    /// the stream identifier maps to them through the discovery (see
+    /// MessagePublisher::StreamId()). The statistics fields are only sent
+    /// when kStatsFlag is set. A generic publisher sending a type other than
+    /// the advertised one sets kTypeFlag and sends the type in a last frame,
+    /// after the data.
+    class MsgHeader
     {
+      /// \brief Version of the header layout.
+      public: static constexpr uint8_t kVersion = 1;
+
+      /// \brief Flag set when the header contains stamp and seq.
+      public: static constexpr uint8_t kStatsFlag = 0x01;
+
+      /// \brief Flag set when the message type follows the data.
+      public: static constexpr uint8_t kTypeFlag = 0x02;
+
+      /// \brief Size of the header without the statistics fields.
+      public: static constexpr size_t kBaseSize = 16;
+
+      /// \brief Version of the header layout.
+      public: uint8_t version = kVersion;
+
+      /// \brief Combination of flags.
+      public: uint8_t flags = 0;
+
+      /// \brief Identifier of the codec that compressed the payload, or 0
+      /// when it's not compressed. See Codec.
+      public: uint8_t codec = 0;
+
+      /// \brief Unused, for alignment.
+      public: uint8_t reserved[5] = {0};
+
+      /// \brief Identifier of the publisher's process, topic and type.
+      public: uint64_t streamId = 0;
+
       /// \brief Publication timestamp.
       public: uint64_t stamp = 0;
 
@@ -65,7 +110,11 @@ namespace ignition
                 subscriber(new zmq::socket_t(*context, ZMQ_SUB)),
                 requester(new zmq::socket_t(*context, ZMQ_ROUTER)),
                 responseReceiver(new zmq::socket_t(*context, ZMQ_ROUTER)),
-                replier(new zmq::socket_t(*context, ZMQ_ROUTER))
+                replier(new zmq::socket_t(*context, ZMQ_ROUTER)),
+                requesterMonitor(new zmq::socket_t(*context, ZMQ_PAIR)),
+                replierMonitor(new zmq::socket_t(*context, ZMQ_PAIR)),
+                srvWakeSender(new zmq::socket_t(*context, ZMQ_PAIR)),
+                srvWakeReceiver(new zmq::socket_t(*context, ZMQ_PAIR))
       {
       }
 
@@ -79,6 +128,11 @@ namespace ignition
       /// This function is designed to be run in a thread.
       public: void AccessControlHandler();
 
+      /// \brief Buffers used to serialize the messages sent to remote
+      /// subscribers. ZeroMQ returns them to the pool once sent, so it's
+      /// declared before the context to outlive it.
+      public: BufferPool bufferPool;
+
       //////////////////////////////////////////////////
       ///////    Declare here the ZMQ Context    ///////
       //////////////////////////////////////////////////
@@ -106,9 +160,36 @@ namespace ignition
       /// \brief ZMQ socket to receive service call requests.
       public: std::unique_ptr<zmq::socket_t> replier;
 
+      /// \brief ZMQ socket to receive the connection events of the
+      /// requester socket.
+      public: std::unique_ptr<zmq::socket_t> requesterMonitor;
+
+      /// \brief ZMQ socket to receive the connection events of the replier
+      /// socket.
+      public: std::unique_ptr<zmq::socket_t> replierMonitor;
+
+      /// \brief ZMQ socket used by the service worker threads to wake up the
+      /// reception thread when a response is ready. Protected by
+      /// srvResponsesMutex.
+      public: std::unique_ptr<zmq::socket_t> srvWakeSender;
+
+      /// \brief ZMQ socket polled by the reception thread to know when the
+      /// service worker threads have responses ready.
+      public: std::unique_ptr<zmq::socket_t> srvWakeReceiver;
+
       /// \brief Thread the handle access control
       public: std::thread accessControlThread;
 
+      /// \brief Mutex to protect the publisher socket, topicPubSeq and
+      /// streamIds.
+      public: std::mutex publisherMutex;
+
+      /// \brief Mutex to protect the subscriber socket, the connections to
+      /// remote publishers (NodeShared::connections), remoteStreams,
+      /// shmPublishers, shmReaders, shmUnreachable and filterFrames. When
+      /// NodeShared::subscribersMutex is also needed, lock this mutex first.
+      public: std::mutex connectionsMutex;
+
       //////////////////////////////////////////////////
       /////// Declare here the discovery object  ///////
       //////////////////////////////////////////////////
@@ -129,6 +210,122 @@ namespace ignition
       /// \brief Timeout used for receiving messages (ms.).
       public: static const int Timeout = 250;
 
+      ////////////////////////////////////////////////////////////////
+      /////// The following is for sending service calls while ///////
+      /////// the connection with the peer is being set up.     ///////
+      ////////////////////////////////////////////////////////////////
+
+      /// \brief A service call request or response waiting for the
+      /// connection with its peer.
+      public: struct PendingSrvMsg
+              {
+                /// \brief Address of the peer.
+                public: std::string addr;
+
+                /// \brief Frames of the message. The first one is the
+                /// socket identity of the peer.
+                public: std::vector<std::string> frames;
+
+                /// \brief The message is discarded if it's still waiting at
+                /// this time.
+                public: std::chrono::steady_clock::time_point deadline;
+              };
+
+      /// \brief Send a service call request or response. ROUTER sockets
+      /// can't send to a peer until the connection handshake is done, so if
+      /// the connection is not ready yet, or other messages for the same
+      /// peer are waiting, the message is queued. The queued messages are
+      /// sent from the reception thread when the socket monitors report a
+      /// new connection. NodeShared::mutex must be locked.
+      /// \param[in] _socket The requester or the replier socket.
+      /// \param[in] _pending The messages waiting on _socket.
+      /// \param[in] _addr Address of the peer.
+      /// \param[in] _frames Frames of the message. The first one is the
+      /// socket identity of the peer.
+      /// \return False if the message couldn't be sent nor queued.
+      public: bool SendSrvMsg(zmq::socket_t &_socket,
+                              std::vector<PendingSrvMsg> &_pending,
+                              const std::string &_addr,
+                              std::vector<std::string> &&_frames);
+
+      /// \brief Try to send the queued service call messages again, and
+      /// discard the ones that waited for too long. NodeShared::mutex must be
+      /// locked.
+      public: void RetryPendingSrvMsgs();
+
+      /// \brief A pending service call request, see NodeShared::AddRequest.
+      public: struct PendingReq
+              {
+                /// \brief Request handler.
+                public: IReqHandlerPtr handler;
+
+                /// \brief Service name.
+                public: std::string topic;
+
+                /// \brief True while the request is in unsentRequests.
+                public: bool unsent = true;
+
+                /// \brief Position of the request in unsentRequests.
+                public: std::list<IReqHandlerPtr>::iterator unsentIt;
+              };
+
+      /// \brief Pending service call requests indexed by handler UUID.
+      /// Protected by NodeShared::mutex.
+      public: std::unordered_map<std::string, PendingReq> requestsByUuid;
+
+      /// \brief Requests not sent yet, in order of arrival, indexed by
+      /// service name. Protected by NodeShared::mutex.
+      public: std::unordered_map<std::string, std::list<IReqHandlerPtr>>
+                unsentRequests;
+
+      /// \brief Requests waiting for the requester socket to connect.
+      public: std::vector<PendingSrvMsg> pendingRequests;
+
+      /// \brief Responses waiting for the replier socket to connect.
+      public: std::vector<PendingSrvMsg> pendingResponses;
+
+      /// \brief True if pendingRequests or pendingResponses are not empty.
+      /// Lets the reception thread check it without locking.
+      public: std::atomic<bool> hasPendingSrvMsgs{false};
+
+      /// \brief Time that a service call message waits for its connection
+      /// before being discarded (ms.).
+      public: static constexpr int kSrvConnectTimeout = 5000;
+
+      /// \brief Timeout used for receiving messages while some service call
+      /// messages are waiting for their connection (ms.). The socket monitors
+      /// usually wake up the reception thread before, this is a fallback for
+      /// ZeroMQ versions that only report the TCP connection and not the end
+      /// of the handshake.
+      public: static constexpr int kSrvRetryTimeout = 10;
+
+      ////////////////////////////////////////////////////////////////
+      /////// The following is for expiring asynchronous       ///////
+      /////// service calls from the reception thread.         ///////
+      ////////////////////////////////////////////////////////////////
+
+      /// \brief Remove the timers that expired.
+      /// \param[in] _now Current time.
+      /// \return The callbacks of the expired timers, in deadline order.
+      /// They must be executed without holding timersMutex.
+      public: std::vector<std::function<void()>> ExpiredTimers(
+                  const std::chrono::steady_clock::time_point &_now);
+
+      /// \brief Get the time that the reception thread can wait for new
+      /// messages without missing a timer.
+      /// \param[in] _now Current time.
+      /// \return The poll timeout (ms.).
+      public: int TimersTimeout(
+                  const std::chrono::steady_clock::time_point &_now) const;
+
+      /// \brief Callbacks executed by the reception thread once their
+      /// deadline expires. Ordered by deadline.
+      public: std::multimap<std::chrono::steady_clock::time_point,
+                            std::function<void()>> timers;
+
+      /// \brief Mutex to protect timers.
+      public: mutable std::mutex timersMutex;
+
       ////////////////////////////////////////////////////////////////
       /////// The following is for asynchronous publication of ///////
       /////// messages to local subscribers.                    ///////
@@ -151,11 +348,14 @@ namespace ignition
                 /// \brief All the raw handlers.
                 public: std::vector<RawSubscriptionHandlerPtr> rawHandlers;
 
-                /// \brief Buffer for the raw handlers.
-                public: std::unique_ptr<char[]> sharedBuffer = nullptr;
+                /// \brief Buffer for the raw handlers. It may also be in use
+                /// by ZeroMQ for sending the message to remote subscribers.
+                public: std::shared_ptr<const char> sharedBuffer = nullptr;
 
-                /// \brief Msg copy for the local handlers.
-                public: std::unique_ptr<ProtoMsg> msgCopy = nullptr;
+                /// \brief Msg for the local handlers. It's either a copy of
+                /// the published message or the message handed over by the
+                /// publisher.
+                public: std::shared_ptr<const ProtoMsg> msgCopy = nullptr;
 
                 /// \brief Message size.
                 // cppcheck-suppress unusedStructMember
@@ -163,30 +363,106 @@ namespace ignition
 
                 /// \brief Information about the topic and type.
                 public: MessageInfo info;
+
+                /// \brief Messages published after this one with the same
+                /// Node::Publisher::PublishBatch() or Node::PublishBatch()
+                /// call. They are delivered right after this one and take a
+                /// single element of the publish queue.
+                public: std::vector<std::unique_ptr<PublishMsgDetails>> batch;
               };
 
       /// \brief Publish thread used to process the pubQueue.
       public: std::thread pubThread;
 
-      /// \brief Mutex to protect the pubThread and pubQueue.
-      public: std::mutex pubThreadMutex;
-
       /// \brief Queue onto which new messages are pushed. The pubThread
       /// will pop off the messages and send them to local subscribers.
-      public: std::queue<std::unique_ptr<PublishMsgDetails>> pubQueue;
-
-      /// \brief used to signal when new work is available
-      public: std::condition_variable signalNewPub;
+      /// Publishers don't take any lock to push. The capacity and the
+      /// overflow policy are set with IGN_TRANSPORT_PUB_QUEUE_SIZE and
+      /// IGN_TRANSPORT_PUB_QUEUE_POLICY.
+      public: std::unique_ptr<MpscQueue<std::unique_ptr<PublishMsgDetails>>>
+                pubQueue;
 
       /// \brief Handles local publication of messages on the pubQueue.
+      /// All the messages available are popped at once and then delivered.
       public: void PublishThread();
 
+      /// \brief Run the local and raw callbacks of a message.
+      /// \param[in] _msgDetails The message and its handlers.
+      public: void DeliverLocal(const PublishMsgDetails &_msgDetails);
+
       /// \brief Topic publication sequence numbers.
       public: std::map<std::string, uint64_t> topicPubSeq;
 
-      /// \brief True if topic statistics have been enabled.
+      /// \brief Get the stream identifier of a topic and message type
+      /// published by this process. It's created the first time. The
+      /// publishers keep it from their advertisement, so it isn't looked up
+      /// on every publication. publisherMutex must be locked.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[in] _msgType Message type.
+      /// \return The stream identifier, never 0.
+      public: uint64_t StreamId(const std::string &_topic,
+                                const std::string &_msgType);
+
+      /// \brief Send a message through the publisher socket.
+      /// \param[in] _frameTopic Topic sent in the first frame, which the
+      /// subscribers filter on.
+      /// \param[in] _streamId Stream identifier of the publisher.
+      /// \param[in] _data Serialized data, owned by ZeroMQ from now on.
+      /// \param[in] _dataSize Size of _data.
+      /// \param[in] _ffn Function that releases _data once sent.
+      /// \param[in] _msgType Message type if it isn't the type of the
+      /// stream, or empty. It's only the case of the generic publishers.
+      /// \param[in] _hint Passed to _ffn.
+      /// \param[in] _codec Identifier of the codec that compressed _data,
+      /// or 0.
+      /// \return True if the message was sent.
+      public: bool SendMsg(const std::string &_frameTopic,
+                           const uint64_t _streamId,
+                           char *_data,
+                           const size_t _dataSize,
+                           DeallocFunc *_ffn,
+                           const std::string &_msgType,
+                           void *_hint,
+                           const uint8_t _codec = 0);
+
+      /// \brief Stream identifiers of the topics published by this process.
+      /// The key is the topic and the message type, separated by a null
+      /// character.
+      public: std::unordered_map<std::string, uint64_t> streamIds;
+
+      /// \brief Generator of stream identifiers. They are random, so
+      /// different processes don't use the same ones.
+      public: std::mt19937_64 streamIdGenerator{std::random_device{}()};
+
+      /// \brief A topic and message type published by a remote process.
+      public: struct RemoteStream
+              {
+                /// \brief Fully qualified topic name.
+                public: std::string topic;
+
+                /// \brief Address of the publisher.
+                public: std::string sender;
+
+                /// \brief Message type.
+                public: std::string msgType;
+              };
+
+      /// \brief Streams of the remote publishers we are connected to,
+      /// indexed by stream identifier.
+      public: std::unordered_map<uint64_t, RemoteStream> remoteStreams;
+
+      /// \brief Incremented every time a local or remote subscriber is added
+      /// or removed. Publishers cache their subscribers and only look them up
+      /// again when it changes. Always increment it after the change.
+      public: std::atomic<uint64_t> subscribersEpoch{0};
+
+      /// \brief True if topic statistics have been enabled. It's only set
+      /// when the NodeShared instance is created.
       public: bool topicStatsEnabled = false;
 
+      /// \brief Mutex to protect topicStats and enabledTopicStatistics.
+      public: std::mutex statsMutex;
+
       /// \brief Statistics for a topic. The key in the map is the topic
       /// name and the value contains the topic statistics.
       public: std::map<std::string, TopicStatistics> topicStats;
@@ -195,6 +471,282 @@ namespace ignition
       public: std::map<std::string,
               std::function<void(const TopicStatistics &_stats)>>
                 enabledTopicStatistics;
+
+      ////////////////////////////////////////////////////////////////
+      /////// The following is for delivering messages through  ///////
+      /////// shared memory to subscribers on the same host.     ///////
+      ////////////////////////////////////////////////////////////////
+
+      /// \brief Prefix added to the topic frame of the notifications sent to
+      /// subscribers that receive the data through shared memory. Topic names
+      /// always start with '@', so these frames never match a regular
+      /// subscription filter.
+      public: static inline const std::string kShmTopicPrefix = "shm:";
+
+      /// \brief True if shared memory delivery is enabled. It can be disabled
+      /// by setting IGN_TRANSPORT_SHM=0.
+      public: bool shmEnabled = false;
+
+      /// \brief Identifier of this host, used to detect same-host peers.
+      public: std::string shmHostId;
+
+      /// \brief Rings used to publish through shared memory. The key is the
+      /// topic name.
+      public: std::map<std::string, std::shared_ptr<SharedMemoryRing>>
+                shmWriters;
+
+      /// \brief Number of rings created by this process. Used to give each
+      /// ring a unique name.
+      public: uint32_t shmRingCount = 0;
+
+      /// \brief Mutex to protect shmWriters and shmRingCount.
+      public: std::mutex shmMutex;
+
+      /// \brief Rings opened to receive data through shared memory. The key
+      /// is the publisher address followed by the topic name.
+      public: std::map<std::string, std::shared_ptr<SharedMemoryRing>>
+                shmReaders;
+
+      /// \brief Publishers that deliver data to this process through shared
+      /// memory. The key is the topic name and the value contains the
+      /// addresses of the publishers. Messages received over TCP from these
+      /// publishers are duplicates and are discarded.
+      public: std::map<std::string, std::set<std::string>> shmPublishers;
+
+      /// \brief Addresses of the publishers whose shared memory couldn't be
+      /// opened, e.g. because they run in another IPC namespace. They
+      /// deliver data to this process through TCP.
+      public: std::set<std::string> shmUnreachable;
+
+      ////////////////////////////////////////////////////////////////
+      /////// The following is for sending the messages selected ///////
+      /////// by the filters of the remote subscribers.          ///////
+      ////////////////////////////////////////////////////////////////
+
+      /// \brief Prefix added to the topic frame of the messages that a
+      /// publisher selected for the subscribers with a filter. It's followed
+      /// by the filter identifier, as kFilterIdDigits hexadecimal digits, a
+      /// colon and the topic name. Only the subscribers with that filter
+      /// subscribe to these frames.
+      public: static inline const std::string kFilterTopicPrefix = "flt:";
+
+      /// \brief Number of hexadecimal digits of the filter identifier in the
+      /// topic frame.
+      public: static constexpr std::size_t kFilterIdDigits = 16;
+
+      /// \brief Get the topic frame of the messages selected by a filter.
+      /// \param[in] _filterId Identifier of the filter key, see
+      /// MessageFilterPrivate::SubscriptionId().
+      /// \param[in] _topic Fully qualified topic name.
+      /// \return The topic frame.
+      public: static std::string FilterFrame(const uint64_t _filterId,
+                                             const std::string &_topic);
+
+      /// \brief Topic frames of the filters that the subscriber socket is
+      /// subscribed to. The key is the topic name.
+      public: std::map<std::string, std::set<std::string>> filterFrames;
+
+      ////////////////////////////////////////////////////////////////
+      /////// The following is for replaying the messages of    ///////
+      /////// the latched publishers to the new subscribers.    ///////
+      ////////////////////////////////////////////////////////////////
+
+      /// \brief Prefix added to the topic frame of the messages replayed to
+      /// a single remote node. It's followed by the process UUID of the
+      /// subscriber, a colon, its node UUID, a colon and the topic name. Each
+      /// process subscribes to the frames that carry its own process UUID.
+      public: static inline const std::string kLatchTopicPrefix = "lat:";
+
+      /// \brief Time between the registration of a remote node and the
+      /// replay. The node connects to us before registering, but its
+      /// subscriptions might reach our publisher socket after the
+      /// registration, and the messages sent in the meantime would be lost.
+      public: static constexpr std::chrono::milliseconds kLatchReplayDelay{
+        200};
+
+      /// \brief Get the topic frame of the messages replayed to a remote
+      /// node.
+      /// \param[in] _pUuid Process UUID of the subscriber.
+      /// \param[in] _nUuid Node UUID of the subscriber.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \return The topic frame.
+      public: static std::string LatchFrame(const std::string &_pUuid,
+                                            const std::string &_nUuid,
+                                            const std::string &_topic);
+
+      /// \brief Check whether a topic has latched publishers in this
+      /// process.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \return True if there's at least one.
+      public: bool Latched(const std::string &_topic) const;
+
+      /// \brief Get the messages kept by the latched publishers of a topic.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \return The messages, oldest first for each publisher.
+      public: std::vector<LatchCache::Entry> LatchedMsgs(
+        const std::string &_topic) const;
+
+      /// \brief Prepare the local deliveries that replay the messages kept
+      /// for a topic to a new subscription of this process.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[in] _handler Handler of the new subscription.
+      /// \return The deliveries, to be queued in the publish queue.
+      public: std::vector<std::unique_ptr<PublishMsgDetails>>
+        LatchedDeliveries(const std::string &_topic,
+          const std::shared_ptr<SubscriptionHandlerBase> &_handler) const;
+
+      /// \brief Replay the messages kept for a topic to a remote node.
+      /// \param[in] _subscriber Registration of the remote node.
+      public: void ReplayRemote(const MessagePublisher &_subscriber);
+
+      /// \brief Caches of the latched publishers of this process. The key is
+      /// the topic name.
+      public: std::map<std::string, std::vector<std::shared_ptr<LatchCache>>>
+        latchCaches;
+
+      /// \brief Mutex to protect latchCaches.
+      public: mutable std::mutex latchMutex;
+
+      ////////////////////////////////////////////////////////////////
+      /////// The following is for ignoring the remote topics    ///////
+      /////// and services that this process doesn't use.        ///////
+      ////////////////////////////////////////////////////////////////
+
+      /// \brief Remote topics and services kept by the discovery.
+      public: enum class DiscoveryInterest
+      {
+        /// \brief All of them, the full catalog.
+        ALL,
+        /// \brief The ones in the partitions of the nodes of this process,
+        /// plus the ones it subscribes to or requests.
+        PARTITION,
+        /// \brief Only the ones that this process subscribes to or requests.
+        TOPIC
+      };
+
+      /// \brief Declare the interest of a node in its partition.
+      /// \param[in] _partition Partition of the node.
+      public: void AddPartitionInterest(const std::string &_partition);
+
+      /// \brief Remote topics and services kept by the discovery. It can be
+      /// set with IGN_TRANSPORT_DISCOVERY_INTEREST.
+      public: DiscoveryInterest discoveryInterest = DiscoveryInterest::ALL;
+
+      ////////////////////////////////////////////////////////////////
+      /////// The following is for running the subscriber       ///////
+      /////// callbacks outside of the reception thread.        ///////
+      ////////////////////////////////////////////////////////////////
+
+      /// \brief Run the subscriber callbacks of the messages received from
+      /// other processes on a pool of worker threads. The pool is created the
+      /// first time and grows if a larger number of threads is requested
+      /// later.
+      /// \param[in] _threads Number of worker threads.
+      public: void EnableCallbackExecutor(const unsigned int _threads)
+      {
+        std::lock_guard<std::mutex> lk(this->callbackExecutorMutex);
+        if (!this->callbackExecutor)
+        {
+          this->callbackExecutor.reset(new CallbackExecutor(_threads,
+            static_cast<size_t>(this->callbackQueueSize),
+            this->callbackQueuePolicy));
+        }
+        else
+          this->callbackExecutor->Grow(_threads);
+      }
+
+      /// \brief Worker pool that runs the subscriber callbacks. When nullptr,
+      /// the callbacks run in the reception thread.
+      public: std::unique_ptr<CallbackExecutor> callbackExecutor;
+
+      /// \brief Maximum number of callbacks queued per topic by the
+      /// callback executor. It can be set with
+      /// IGN_TRANSPORT_CALLBACK_QUEUE_SIZE.
+      public: int callbackQueueSize = kDefaultCallbackQueueSize;
+
+      /// \brief What the callback executor does when a topic has
+      /// callbackQueueSize callbacks queued. It can be set with
+      /// IGN_TRANSPORT_CALLBACK_QUEUE_POLICY.
+      public: QueueOverflowPolicy callbackQueuePolicy =
+        QueueOverflowPolicy::DROP_OLDEST;
+
+      /// \brief Mutex to protect callbackExecutor and queueExecutor.
+      public: std::mutex callbackExecutorMutex;
+
+      /// \brief Queue a message for a subscription with its own queue (see
+      /// SubscribeOptions::Queued()) and make sure that a worker drains the
+      /// queue. The queues are drained by the callback executor if it's
+      /// enabled, or by queueExecutor otherwise. Each queue is drained by one
+      /// worker at a time.
+      /// \param[in] _handler The subscription handler.
+      /// \param[in] _delivery Runs the callback of the handler with the
+      /// message.
+      public: void QueueDelivery(
+        const std::shared_ptr<SubscriptionHandlerBase> &_handler,
+        std::function<void()> _delivery);
+
+      /// \brief Called after removing subscription handlers. Discard the
+      /// messages queued for them and wait for their callbacks running on
+      /// the executors. The callbacks queued by the callback executor look
+      /// up their handlers when they run, so they skip the removed ones.
+      /// It must be called without holding any lock taken by a callback.
+      /// \param[in] _topic Fully qualified topic of the handlers.
+      /// \param[in] _handlers The handlers removed.
+      public: void WaitForCallbacks(const std::string &_topic,
+        const std::vector<std::shared_ptr<SubscriptionHandlerBase>>
+          &_handlers);
+
+      /// \brief Worker that drains the subscription queues when the callback
+      /// executor isn't enabled. It's created the first time it's needed.
+      public: std::unique_ptr<CallbackExecutor> queueExecutor;
+
+      ////////////////////////////////////////////////////////////////
+      /////// The following is for running the service         ///////
+      /////// callbacks outside of the reception thread.        ///////
+      ////////////////////////////////////////////////////////////////
+
+      /// \brief Worker threads dedicated to a service replier.
+      public: struct SrvWorkers
+              {
+                /// \brief Maximum number of requests queued or running.
+                /// 0 means no limit.
+                public: unsigned int maxInFlight = 0;
+
+                /// \brief Number of requests queued or running. Only
+                /// incremented by the reception thread.
+                public: std::atomic<unsigned int> inFlight{0};
+
+                /// \brief Threads running the requests. Declared last, so
+                /// they are joined before the rest of members are destroyed.
+                public: std::unique_ptr<CallbackExecutor> executor;
+              };
+
+      /// \brief Get the worker threads of a service replier.
+      /// \param[in] _hUuid UUID of the replier handler.
+      /// \return The workers or nullptr if the requests run in the reception
+      /// thread.
+      public: std::shared_ptr<SrvWorkers> ReplierWorkers(
+                  const std::string &_hUuid) const;
+
+      /// \brief Queue a service call response produced by a worker thread
+      /// and wake up the reception thread, which sends it.
+      /// \param[in] _addr Address of the requester.
+      /// \param[in] _frames Frames of the response.
+      public: void QueueSrvResponse(const std::string &_addr,
+                                    std::vector<std::string> &&_frames);
+
+      /// \brief Worker threads indexed by replier handler UUID.
+      public: std::map<std::string, std::shared_ptr<SrvWorkers>> srvWorkers;
+
+      /// \brief Mutex to protect srvWorkers.
+      public: mutable std::mutex srvWorkersMutex;
+
+      /// \brief Responses produced by the worker threads, waiting for the
+      /// reception thread.
+      public: std::vector<PendingSrvMsg> srvResponses;
+
+      /// \brief Mutex to protect srvResponses and srvWakeSender.
+      public: std::mutex srvResponsesMutex;
     };
     }
   }
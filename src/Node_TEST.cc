@@ -15,13 +15,17 @@
  *
 */
 
+#include <algorithm>
 #include <chrono>
+#include <condition_variable>
 #include <csignal>
 #include <cstdlib>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
+#include <vector>
 #include <ignition/msgs.hh>
 
 #include "gtest/gtest.h"
@@ -613,6 +617,69 @@ TEST(NodeTest, PubSubSameThread)
   reset();
 }
 
+//////////////////////////////////////////////////
+/// \brief Messages published through a smart pointer reach the local
+/// subscribers without being copied.
+TEST(NodeTest, PubSubSameThreadSharedMsg)
+{
+  reset();
+
+  transport::Node node;
+  auto pub = node.Advertise<ignition::msgs::Int32>(g_topic);
+  EXPECT_TRUE(pub);
+
+  const ignition::msgs::Int32 *received = nullptr;
+  std::function<void(const ignition::msgs::Int32 &)> subCb =
+    [&received](const ignition::msgs::Int32 &_msg)
+    {
+      EXPECT_EQ(_msg.data(), data);
+      std::lock_guard<std::mutex> lk(cbMutex);
+      received = &_msg;
+      cbExecuted = true;
+    };
+  EXPECT_TRUE(node.Subscribe(g_topic, subCb));
+  EXPECT_TRUE(node.SubscribeRaw(g_topic, rawCbInfo));
+
+  // Wait some time before publishing.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  auto sharedMsg = std::make_shared<ignition::msgs::Int32>();
+  sharedMsg->set_data(data);
+  EXPECT_TRUE(pub.Publish(
+    std::shared_ptr<const ignition::msgs::Int32>(sharedMsg)));
+
+  // Give some time to the subscribers.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  {
+    std::lock_guard<std::mutex> lk(cbMutex);
+    EXPECT_TRUE(cbExecuted);
+    EXPECT_EQ(sharedMsg.get(), received);
+    EXPECT_EQ(1, counter);
+  }
+
+  reset();
+
+  auto uniqueMsg = std::make_unique<ignition::msgs::Int32>();
+  uniqueMsg->set_data(data);
+  const ignition::msgs::Int32 *uniquePtr = uniqueMsg.get();
+  EXPECT_TRUE(pub.Publish(std::move(uniqueMsg)));
+
+  // Give some time to the subscribers.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  {
+    std::lock_guard<std::mutex> lk(cbMutex);
+    EXPECT_TRUE(cbExecuted);
+    EXPECT_EQ(uniquePtr, received);
+    EXPECT_EQ(1, counter);
+  }
+
+  // Null and wrong type messages are rejected.
+  EXPECT_FALSE(pub.Publish(std::shared_ptr<const transport::ProtoMsg>()));
+  EXPECT_FALSE(pub.Publish(std::make_unique<ignition::msgs::Vector3d>()));
+
+  reset();
+}
+
 //////////////////////////////////////////////////
 /// \brief A thread can create a node, and send and receive messages.
 TEST(NodeTest, PubSubSameThreadGenericCb)
@@ -738,6 +805,174 @@ TEST(NodeTest, RawPubSubSameThreadMessageInfo)
   reset();
 }
 
+//////////////////////////////////////////////////
+/// \brief Publish several messages in a single call.
+TEST(NodeTest, PubBatchSameThread)
+{
+  reset();
+
+  transport::Node node;
+  auto pub = node.Advertise<ignition::msgs::Int32>(g_topic);
+  EXPECT_TRUE(pub);
+
+  std::vector<int> received;
+  std::function<void(const ignition::msgs::Int32 &)> subCb =
+    [&received](const ignition::msgs::Int32 &_msg)
+    {
+      std::lock_guard<std::mutex> lk(cbMutex);
+      received.push_back(_msg.data());
+    };
+  EXPECT_TRUE(node.Subscribe(g_topic, subCb));
+
+  std::vector<int> rawReceived;
+  EXPECT_TRUE(node.SubscribeRaw(g_topic,
+    [&rawReceived](const char *_msgData, const size_t _size,
+                   const transport::MessageInfo &)
+    {
+      ignition::msgs::Int32 msg;
+      EXPECT_TRUE(msg.ParseFromArray(_msgData, static_cast<int>(_size)));
+      std::lock_guard<std::mutex> lk(cbMutex);
+      rawReceived.push_back(msg.data());
+    }));
+
+  // Wait some time before publishing.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  std::vector<ignition::msgs::Int32> msgs(3);
+  for (int i = 0; i < 3; ++i)
+    msgs[i].set_data(data);
+  msgs[1].set_data(data + 1);
+  EXPECT_TRUE(pub.PublishBatch(msgs));
+
+  // Give some time to the subscribers.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  {
+    std::lock_guard<std::mutex> lk(cbMutex);
+    EXPECT_EQ(std::vector<int>({data, data + 1, data}), received);
+    EXPECT_EQ(received, rawReceived);
+  }
+
+  // Wrong types or null messages reject the whole batch.
+  ignition::msgs::Vector3d wrongMsg;
+  EXPECT_FALSE(pub.PublishBatch({&msgs[0], &wrongMsg}));
+  EXPECT_FALSE(pub.PublishBatch({&msgs[0], nullptr}));
+  EXPECT_TRUE(pub.PublishBatch(std::vector<const transport::ProtoMsg *>()));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  {
+    std::lock_guard<std::mutex> lk(cbMutex);
+    EXPECT_EQ(3u, received.size());
+  }
+
+  reset();
+}
+
+//////////////////////////////////////////////////
+/// \brief Publish a message on several topics in a single call.
+TEST(NodeTest, PubBatchMultipleTopics)
+{
+  reset();
+
+  const std::string topic2 = g_topic + "2";
+
+  transport::Node node;
+  auto pub1 = node.Advertise<ignition::msgs::Int32>(g_topic);
+  auto pub2 = node.Advertise<ignition::msgs::Int32>(topic2);
+  auto pubWrong = node.Advertise<ignition::msgs::Vector3d>(g_topic + "3");
+  EXPECT_TRUE(pub1);
+  EXPECT_TRUE(pub2);
+  EXPECT_TRUE(pubWrong);
+
+  std::vector<std::string> topics;
+  std::function<void(const ignition::msgs::Int32 &,
+                     const transport::MessageInfo &)> subCb =
+    [&topics](const ignition::msgs::Int32 &_msg,
+              const transport::MessageInfo &_info)
+    {
+      EXPECT_EQ(data, _msg.data());
+      std::lock_guard<std::mutex> lk(cbMutex);
+      topics.push_back(_info.Topic());
+    };
+  EXPECT_TRUE(node.Subscribe(g_topic, subCb));
+  EXPECT_TRUE(node.Subscribe(topic2, subCb));
+
+  // Wait some time before publishing.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  ignition::msgs::Int32 msg;
+  msg.set_data(data);
+  EXPECT_TRUE(node.PublishBatch({pub1, pub2}, msg));
+
+  // Give some time to the subscribers.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  {
+    std::lock_guard<std::mutex> lk(cbMutex);
+    EXPECT_EQ(std::vector<std::string>({g_topic, topic2}), topics);
+  }
+
+  // A publisher of a different type rejects the whole batch.
+  EXPECT_FALSE(node.PublishBatch({pub1, pubWrong}, msg));
+  EXPECT_FALSE(node.PublishBatch({pub1, transport::Node::Publisher()}, msg));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  {
+    std::lock_guard<std::mutex> lk(cbMutex);
+    EXPECT_EQ(2u, topics.size());
+  }
+
+  reset();
+}
+
+//////////////////////////////////////////////////
+/// \brief Publish a raw message from a caller provided buffer.
+TEST(NodeTest, RawPubBorrowedBufferSameThread)
+{
+  reset();
+
+  ignition::msgs::Int32 msg;
+  msg.set_data(data);
+  const std::string serialized = msg.SerializeAsString();
+
+  transport::Node node;
+  auto pub = node.Advertise<ignition::msgs::Int32>(g_topic);
+  EXPECT_TRUE(pub);
+
+  EXPECT_TRUE(node.Subscribe(g_topic, cbInfo));
+
+  // Wait some time before publishing.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  // There are no remote subscribers, so the buffer is released before
+  // returning.
+  int done = 0;
+  EXPECT_TRUE(pub.PublishRaw(serialized.data(), serialized.size(),
+    msg.GetTypeName(), [&done]() {++done;}));
+  EXPECT_EQ(1, done);
+
+  // Give some time to the subscribers.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  // Check that the message was received.
+  EXPECT_TRUE(cbExecuted);
+
+  reset();
+
+  // Without a completion callback the buffer can be reused right away.
+  EXPECT_TRUE(pub.PublishRaw(serialized.data(), serialized.size(),
+    msg.GetTypeName(), nullptr));
+
+  // Give some time to the subscribers.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_TRUE(cbExecuted);
+
+  // The buffer is released on errors too.
+  EXPECT_FALSE(pub.PublishRaw(serialized.data(), serialized.size(),
+    "wrong.type", [&done]() {++done;}));
+  EXPECT_EQ(2, done);
+
+  reset();
+}
+
 //////////////////////////////////////////////////
 TEST(NodeTest, RawPubRawSubSameThreadMessageInfo)
 {
@@ -1711,6 +1946,83 @@ TEST(NodeTest, ServiceCallWithoutInputSyncTimeout)
   reset();
 }
 
+//////////////////////////////////////////////////
+/// \brief Make a service call returning a future.
+TEST(NodeTest, ServiceCallFuture)
+{
+  reset();
+
+  ignition::msgs::Int32 req;
+  req.set_data(data);
+
+  transport::Node node;
+  EXPECT_TRUE(node.Advertise(g_topic, srvEcho));
+
+  // Request an invalid service name.
+  auto future =
+    node.RequestAsync<ignition::msgs::Int32>("invalid service", req, 1000);
+  EXPECT_EQ(future.Status(), transport::RequestStatus::NOT_SENT);
+
+  // The responser is in this process, so the request completes right away.
+  future = node.RequestAsync<ignition::msgs::Int32>(g_topic, req, 1000);
+  ASSERT_TRUE(future.Ready());
+  EXPECT_EQ(future.Status(), transport::RequestStatus::SUCCEEDED);
+  EXPECT_EQ(future.Reply().data(), data);
+  EXPECT_TRUE(srvExecuted);
+
+  // Chain a second request using the first response.
+  reset();
+  auto chained = future.Then(
+    [&node](const transport::RequestFuture<ignition::msgs::Int32> &_done)
+    {
+      ignition::msgs::Int32 nextReq;
+      nextReq.set_data(_done.Reply().data());
+      return node.RequestAsync<ignition::msgs::Int32>(g_topic, nextReq);
+    });
+  EXPECT_EQ(chained.Wait(), transport::RequestStatus::SUCCEEDED);
+  EXPECT_EQ(chained.Reply().data(), data);
+  EXPECT_TRUE(srvExecuted);
+
+  reset();
+}
+
+//////////////////////////////////////////////////
+/// \brief Check the deadline and the cancellation of a service call
+/// returning a future.
+TEST(NodeTest, ServiceCallFutureTimeout)
+{
+  reset();
+
+  ignition::msgs::Int32 req;
+  int64_t timeout = 500;
+
+  req.set_data(data);
+
+  transport::Node node;
+
+  auto t1 = std::chrono::steady_clock::now();
+  auto future = node.RequestAsync<ignition::msgs::Int32>(g_topic, req,
+      static_cast<unsigned int>(timeout));
+  EXPECT_FALSE(future.Ready());
+  EXPECT_EQ(future.Wait(), transport::RequestStatus::TIMED_OUT);
+  auto t2 = std::chrono::steady_clock::now();
+
+  int64_t elapsed =
+    std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count();
+
+  // Check if the elapsed time was close to the timeout.
+  auto diff = std::max(elapsed, timeout) - std::min(elapsed, timeout);
+  EXPECT_LE(diff, 200);
+
+  // A request without deadline stays pending until it's cancelled.
+  future = node.RequestAsync<ignition::msgs::Int32>(g_topic, req);
+  EXPECT_FALSE(future.WaitFor(100));
+  EXPECT_TRUE(future.Cancel());
+  EXPECT_EQ(future.Status(), transport::RequestStatus::CANCELLED);
+
+  reset();
+}
+
 //////////////////////////////////////////////////
 /// \brief Create a publisher that sends messages "forever". This function will
 /// be used emiting a SIGINT or SIGTERM signal, to make sure that the transport
@@ -1944,6 +2256,135 @@ TEST(NodeTest, SubThrottled)
   reset();
 }
 
+//////////////////////////////////////////////////
+/// \brief A subscriber that only wants the latest message gets the newest
+/// one after its callback was busy, and the messages in between are dropped.
+TEST(NodeTest, SubLatestOnly)
+{
+  reset();
+
+  transport::Node node;
+
+  auto pub = node.Advertise<ignition::msgs::Int32>(g_topic);
+  EXPECT_TRUE(pub);
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  bool published = false;
+  std::vector<int> received;
+  std::function<void(const ignition::msgs::Int32&)> subCb =
+    [&](const ignition::msgs::Int32 &_msg)
+  {
+    std::unique_lock<std::mutex> lk(mutex);
+    received.push_back(_msg.data());
+    condition.notify_all();
+
+    // The first callback is busy until all the messages are published.
+    condition.wait_for(lk, std::chrono::seconds(5), [&] {return published;});
+  };
+
+  transport::SubscribeOptions opts;
+  opts.SetHistory(transport::SubscribeOptions::HistoryPolicy::LATEST_ONLY);
+  EXPECT_TRUE(node.Subscribe(g_topic, subCb, opts));
+
+  const int kMsgs = 10;
+  ignition::msgs::Int32 msg;
+  for (int i = 0; i < kMsgs; ++i)
+  {
+    msg.set_data(i);
+    EXPECT_TRUE(pub.Publish(msg));
+  }
+
+  // Give some time to the publish thread to queue the messages.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  {
+    std::lock_guard<std::mutex> lk(mutex);
+    published = true;
+  }
+  condition.notify_all();
+
+  std::unique_lock<std::mutex> lk(mutex);
+  EXPECT_TRUE(condition.wait_for(lk, std::chrono::seconds(5), [&]
+  {
+    return !received.empty() && received.back() == kMsgs - 1;
+  }));
+
+  // The callback got the first message and the latest one.
+  EXPECT_TRUE(std::is_sorted(received.begin(), received.end()));
+  EXPECT_LT(received.size(), static_cast<size_t>(kMsgs));
+  EXPECT_EQ(static_cast<uint64_t>(kMsgs),
+    received.size() + node.DroppedMessages(g_topic));
+  lk.unlock();
+
+  reset();
+}
+
+//////////////////////////////////////////////////
+/// \brief A latched publisher replays its last messages to the subscribers
+/// that join later, and only to them.
+TEST(NodeTest, PubLatched)
+{
+  reset();
+
+  transport::Node node;
+
+  transport::AdvertiseMessageOptions opts;
+  opts.SetLatchDepth(2);
+  auto pub = node.Advertise<ignition::msgs::Int32>(g_topic, opts);
+  EXPECT_TRUE(pub);
+
+  ignition::msgs::Int32 msg;
+  for (int i = 0; i < 3; ++i)
+  {
+    msg.set_data(i);
+    EXPECT_TRUE(pub.Publish(msg));
+  }
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::vector<int> first;
+  std::vector<int> second;
+  auto subscriber = [&](std::vector<int> &_received)
+  {
+    return std::function<void(const ignition::msgs::Int32&)>(
+      [&](const ignition::msgs::Int32 &_msg)
+      {
+        std::lock_guard<std::mutex> lk(mutex);
+        _received.push_back(_msg.data());
+        condition.notify_all();
+      });
+  };
+
+  // The late subscriber gets the last two messages.
+  auto firstCb = subscriber(first);
+  EXPECT_TRUE(node.Subscribe(g_topic, firstCb));
+  {
+    std::unique_lock<std::mutex> lk(mutex);
+    EXPECT_TRUE(condition.wait_for(lk, std::chrono::seconds(5),
+      [&] {return first.size() == 2u;}));
+    EXPECT_EQ(std::vector<int>({1, 2}), first);
+  }
+
+  // A second subscriber gets the replay too, but the first one doesn't get
+  // it again.
+  transport::Node node2;
+  auto secondCb = subscriber(second);
+  EXPECT_TRUE(node2.Subscribe(g_topic, secondCb));
+  {
+    std::unique_lock<std::mutex> lk(mutex);
+    EXPECT_TRUE(condition.wait_for(lk, std::chrono::seconds(5),
+      [&] {return second.size() == 2u;}));
+    EXPECT_EQ(std::vector<int>({1, 2}), second);
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  {
+    std::lock_guard<std::mutex> lk(mutex);
+    EXPECT_EQ(2u, first.size());
+  }
+
+  reset();
+}
+
 //////////////////////////////////////////////////
 /// \brief This test creates one publisher and one subscriber. The publisher
 /// publishes at a throttled frequency .
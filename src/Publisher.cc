@@ -29,6 +29,22 @@
 using namespace ignition;
 using namespace transport;
 
+/// \brief Key of the discovery header entry that stores the shared memory
+/// host identifier of a message publisher.
+static const char kShmHostIdKey[] = "shm_host_id";
+
+/// \brief Key of the discovery header entry that stores the stream
+/// identifier of a message publisher.
+static const char kStreamIdKey[] = "stream_id";
+
+/// \brief Key of the discovery header entry that stores the codec that
+/// compresses the messages of a message publisher.
+static const char kCompressionKey[] = "compression";
+
+/// \brief Key of the discovery header entry that stores the filter declared
+/// by a subscriber.
+static const char kFilterKey[] = "filter";
+
 //////////////////////////////////////////////////
 Publisher::Publisher(const std::string &_topic, const std::string &_addr,
   const std::string &_pUuid, const std::string &_nUuid,
@@ -223,6 +239,42 @@ void MessagePublisher::SetMsgTypeName(const std::string &_msgTypeName)
   this->msgTypeName = _msgTypeName;
 }
 
+//////////////////////////////////////////////////
+std::string MessagePublisher::ShmHostId() const
+{
+  return this->shmHostId;
+}
+
+//////////////////////////////////////////////////
+void MessagePublisher::SetShmHostId(const std::string &_hostId)
+{
+  this->shmHostId = _hostId;
+}
+
+//////////////////////////////////////////////////
+uint64_t MessagePublisher::StreamId() const
+{
+  return this->streamId;
+}
+
+//////////////////////////////////////////////////
+void MessagePublisher::SetStreamId(const uint64_t _streamId)
+{
+  this->streamId = _streamId;
+}
+
+//////////////////////////////////////////////////
+std::string MessagePublisher::Filter() const
+{
+  return this->filter;
+}
+
+//////////////////////////////////////////////////
+void MessagePublisher::SetFilter(const std::string &_filter)
+{
+  this->filter = _filter;
+}
+
 //////////////////////////////////////////////////
 const AdvertiseMessageOptions& MessagePublisher::Options() const
 {
@@ -246,6 +298,36 @@ void MessagePublisher::FillDiscovery(msgs::Discovery &_msg) const
   pub->mutable_msg_pub()->set_msg_type(this->MsgTypeName());
   pub->mutable_msg_pub()->set_throttled(this->msgOpts.Throttled());
   pub->mutable_msg_pub()->set_msgs_per_sec(this->msgOpts.MsgsPerSec());
+
+  // The shared memory host identifier travels in the header, so peers that
+  // don't know about it simply ignore it.
+  if (!this->shmHostId.empty())
+  {
+    msgs::Header::Map *data = _msg.mutable_header()->add_data();
+    data->set_key(kShmHostIdKey);
+    data->add_value(this->shmHostId);
+  }
+
+  if (this->streamId != 0)
+  {
+    msgs::Header::Map *data = _msg.mutable_header()->add_data();
+    data->set_key(kStreamIdKey);
+    data->add_value(std::to_string(this->streamId));
+  }
+
+  if (!this->msgOpts.Compression().empty())
+  {
+    msgs::Header::Map *data = _msg.mutable_header()->add_data();
+    data->set_key(kCompressionKey);
+    data->add_value(this->msgOpts.Compression());
+  }
+
+  if (!this->filter.empty())
+  {
+    msgs::Header::Map *data = _msg.mutable_header()->add_data();
+    data->set_key(kFilterKey);
+    data->add_value(this->filter);
+  }
 }
 
 //////////////////////////////////////////////////
@@ -259,6 +341,40 @@ void MessagePublisher::SetFromDiscovery(const msgs::Discovery &_msg)
     this->msgOpts.SetMsgsPerSec(kUnthrottled);
   else
     this->msgOpts.SetMsgsPerSec(_msg.pub().msg_pub().msgs_per_sec());
+
+  this->msgOpts.SetCompression("");
+  this->shmHostId.clear();
+  this->streamId = 0;
+  this->filter.clear();
+  for (const auto &data : _msg.header().data())
+  {
+    if (data.value_size() == 0)
+      continue;
+
+    if (data.key() == kShmHostIdKey)
+    {
+      this->shmHostId = data.value(0);
+    }
+    else if (data.key() == kStreamIdKey)
+    {
+      try
+      {
+        this->streamId = std::stoull(data.value(0));
+      }
+      catch (...)
+      {
+        this->streamId = 0;
+      }
+    }
+    else if (data.key() == kCompressionKey)
+    {
+      this->msgOpts.SetCompression(data.value(0));
+    }
+    else if (data.key() == kFilterKey)
+    {
+      this->filter = data.value(0);
+    }
+  }
 }
 
 //////////////////////////////////////////////////
@@ -281,6 +397,9 @@ MessagePublisher &MessagePublisher::operator=(const MessagePublisher &_other)
   Publisher::operator=(_other);
   this->SetCtrl(_other.Ctrl());
   this->SetMsgTypeName(_other.MsgTypeName());
+  this->SetShmHostId(_other.ShmHostId());
+  this->SetStreamId(_other.StreamId());
+  this->SetFilter(_other.Filter());
   this->SetOptions(_other.Options());
   return *this;
 }
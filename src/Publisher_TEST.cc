@@ -221,6 +221,48 @@ TEST(PublisherTest, MessagePublisherIO)
   EXPECT_EQ(publisher.NUuid(),       otherPublisher.NUuid());
   EXPECT_EQ(publisher.MsgTypeName(), otherPublisher.MsgTypeName());
   EXPECT_EQ(publisher.Options(),     otherPublisher.Options());
+  EXPECT_TRUE(otherPublisher.ShmHostId().empty());
+  EXPECT_EQ(0u, otherPublisher.StreamId());
+
+  // The shared memory host id and the stream id are also packed.
+  publisher.SetShmHostId("host");
+  publisher.SetStreamId(0xfedcba9876543210u);
+  msg.Clear();
+  publisher.FillDiscovery(msg);
+  otherPublisher.SetFromDiscovery(msg);
+  EXPECT_EQ("host", otherPublisher.ShmHostId());
+  EXPECT_EQ(0xfedcba9876543210u, otherPublisher.StreamId());
+
+  MessagePublisher copyPublisher(otherPublisher);
+  EXPECT_EQ("host", copyPublisher.ShmHostId());
+  EXPECT_EQ(0xfedcba9876543210u, copyPublisher.StreamId());
+
+  // The filter declared by a subscriber.
+  EXPECT_TRUE(otherPublisher.Filter().empty());
+  publisher.SetFilter("10\x1d" "data\x1f" "0\x1f" "1");
+  msg.Clear();
+  publisher.FillDiscovery(msg);
+  otherPublisher.SetFromDiscovery(msg);
+  EXPECT_EQ(publisher.Filter(), otherPublisher.Filter());
+  copyPublisher = otherPublisher;
+  EXPECT_EQ(publisher.Filter(), copyPublisher.Filter());
+  publisher.SetFilter("");
+
+  // The codec is packed, the compression level stays in the publisher.
+  AdvertiseMessageOptions compressedOpts(g_msgOpts2);
+  compressedOpts.SetCompression("zstd", 5);
+  publisher.SetOptions(compressedOpts);
+  msg.Clear();
+  publisher.FillDiscovery(msg);
+  otherPublisher.SetFromDiscovery(msg);
+  EXPECT_EQ("zstd", otherPublisher.Options().Compression());
+  EXPECT_EQ(0, otherPublisher.Options().CompressionLevel());
+
+  publisher.SetOptions(g_msgOpts2);
+  msg.Clear();
+  publisher.FillDiscovery(msg);
+  otherPublisher.SetFromDiscovery(msg);
+  EXPECT_TRUE(otherPublisher.Options().Compression().empty());
 }
 
 //////////////////////////////////////////////////
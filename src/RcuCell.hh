@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef IGN_TRANSPORT_RCUCELL_HH_
+#define IGN_TRANSPORT_RCUCELL_HH_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "ignition/transport/config.hh"
+
+namespace ignition
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace IGNITION_TRANSPORT_VERSION_NAMESPACE {
+    //
+    /// \internal
+    /// \brief Holds an immutable value that is read often and replaced
+    /// rarely, in the spirit of read-copy-update. Readers don't take any lock
+    /// nor allocate: they register themselves in the counter of the current
+    /// epoch and load the current pointer. Writers publish a new value with a
+    /// pointer swap and retire the old one in the current epoch. The epoch
+    /// advances once the readers of the previous epoch are gone, and then
+    /// the values retired two epochs ago are freed. Readers that register
+    /// later use the counter of the new epoch, so a steady flow of
+    /// overlapping readers doesn't keep the replaced values alive.
+    template<typename T>
+    class RcuCell
+    {
+      /// \brief Keeps every value that is current while it exists alive
+      /// until it's destroyed. Readers should not hold it for long, as the
+      /// values replaced meanwhile aren't freed until then.
+      public: class ReadGuard
+      {
+        /// \brief Constructor. Registers the reader in the current epoch.
+        /// \param[in] _cell The cell to read.
+        public: explicit ReadGuard(const RcuCell &_cell)
+          : cell(_cell)
+        {
+          // The epoch might advance between loading it and registering.
+          // Then, the counter is the one of a future epoch, so try again.
+          while (true)
+          {
+            const uint64_t epoch = this->cell.epoch.load();
+            this->counter = &this->cell.readers[epoch % 2];
+            this->counter->fetch_add(1);
+            if (this->cell.epoch.load() == epoch)
+              break;
+            this->counter->fetch_sub(1);
+          }
+          this->value = this->cell.current.load();
+        }
+
+        /// \brief Destructor. Unregisters the reader. The last reader of an
+        /// epoch frees the values that no reader can see anymore.
+        public: ~ReadGuard()
+        {
+          if (this->counter->fetch_sub(1) == 1 &&
+              this->cell.hasRetired.load())
+          {
+            std::lock_guard<std::mutex> lk(this->cell.mutex);
+            this->cell.ReclaimLocked();
+          }
+        }
+
+        /// \brief Get the value.
+        /// \return The value or nullptr if no value was set.
+        public: const T *Get() const
+        {
+          return this->value;
+        }
+
+        /// \brief No copies, a guard registers a single reader.
+        public: ReadGuard(const ReadGuard &) = delete;
+
+        /// \brief No copies, a guard registers a single reader.
+        public: ReadGuard &operator=(const ReadGuard &) = delete;
+
+        /// \brief The cell.
+        private: const RcuCell &cell;
+
+        /// \brief Counter of the epoch in which the reader registered.
+        private: std::atomic<int> *counter = nullptr;
+
+        /// \brief The value.
+        private: const T *value = nullptr;
+      };
+
+      /// \brief Default constructor. The cell starts empty.
+      public: RcuCell() = default;
+
+      /// \brief Destructor. There must not be any reader.
+      public: ~RcuCell()
+      {
+        delete this->current.load();
+      }
+
+      /// \brief No copies.
+      public: RcuCell(const RcuCell &) = delete;
+
+      /// \brief No copies.
+      public: RcuCell &operator=(const RcuCell &) = delete;
+
+      /// \brief Register a reader.
+      /// \return The guard that gives access to the value.
+      public: ReadGuard Read() const
+      {
+        return ReadGuard(*this);
+      }
+
+      /// \brief Replace the value. The readers registered before the call
+      /// keep seeing the old value until they unregister. It can be called
+      /// while holding a ReadGuard: the new value stays alive until the
+      /// guard is destroyed.
+      /// \param[in] _value The new value.
+      public: void Update(std::unique_ptr<const T> _value)
+      {
+        std::lock_guard<std::mutex> lk(this->mutex);
+        const T *old = this->current.exchange(_value.release());
+        if (old)
+        {
+          this->retired[this->epoch.load() % 2].emplace_back(old);
+          this->hasRetired = true;
+        }
+        this->ReclaimLocked();
+      }
+
+      /// \brief Advance the epoch while the readers of the previous epoch
+      /// are gone, freeing the values retired in it. A value retired in an
+      /// epoch can only be seen by the readers registered up to that epoch,
+      /// and advancing requires the readers of the epochs before the current
+      /// one to be gone. The mutex must be locked.
+      private: void ReclaimLocked() const
+      {
+        while (this->hasRetired.load())
+        {
+          // The previous epoch has the other parity.
+          const uint64_t previous = this->epoch.load() + 1;
+          if (this->readers[previous % 2].load() != 0)
+            return;
+
+          this->retired[previous % 2].clear();
+          this->epoch.fetch_add(1);
+          this->hasRetired = !this->retired[0].empty() ||
+            !this->retired[1].empty();
+        }
+      }
+
+      /// \brief The current value.
+      private: std::atomic<const T *> current{nullptr};
+
+      /// \brief Current epoch. Only changes with the mutex locked.
+      private: mutable std::atomic<uint64_t> epoch{0};
+
+      /// \brief Number of registered readers of the current and the
+      /// previous epoch, indexed by the parity of the epoch.
+      private: mutable std::atomic<int> readers[2] = {{0}, {0}};
+
+      /// \brief True if there are replaced values waiting to be freed.
+      private: mutable std::atomic<bool> hasRetired{false};
+
+      /// \brief Values replaced in the current and the previous epoch,
+      /// indexed by the parity of the epoch. They may still be in use by a
+      /// reader.
+      private: mutable std::vector<std::unique_ptr<const T>> retired[2];
+
+      /// \brief Protects the replaced values and the epoch changes.
+      private: mutable std::mutex mutex;
+    };
+    }
+  }
+}
+#endif
@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "RcuCell.hh"
+
+using namespace ignition;
+using namespace transport;
+
+/// \brief A value that counts the live instances.
+struct Counted
+{
+  explicit Counted(int _value)
+    : value(_value)
+  {
+    ++live;
+  }
+
+  ~Counted()
+  {
+    --live;
+  }
+
+  int value;
+
+  static std::atomic<int> live;
+};
+
+std::atomic<int> Counted::live{0};
+
+//////////////////////////////////////////////////
+TEST(RcuCellTest, ReadUpdate)
+{
+  {
+    RcuCell<Counted> cell;
+    EXPECT_EQ(nullptr, cell.Read().Get());
+
+    cell.Update(std::make_unique<Counted>(1));
+    EXPECT_EQ(1, cell.Read().Get()->value);
+    EXPECT_EQ(1, Counted::live);
+
+    {
+      // The reader keeps the old value alive.
+      auto reader = cell.Read();
+      cell.Update(std::make_unique<Counted>(2));
+      EXPECT_EQ(1, reader.Get()->value);
+      EXPECT_EQ(2, cell.Read().Get()->value);
+      EXPECT_EQ(2, Counted::live);
+    }
+
+    // The last reader freed it.
+    EXPECT_EQ(1, Counted::live);
+
+    // Without readers, values are freed right away.
+    cell.Update(std::make_unique<Counted>(3));
+    EXPECT_EQ(3, cell.Read().Get()->value);
+    EXPECT_EQ(1, Counted::live);
+  }
+  EXPECT_EQ(0, Counted::live);
+}
+
+//////////////////////////////////////////////////
+/// \brief Replaced values are freed even if there's always a reader
+/// registered, as long as every reader finishes at some point.
+TEST(RcuCellTest, OverlappingReaders)
+{
+  {
+    RcuCell<Counted> cell;
+    cell.Update(std::make_unique<Counted>(0));
+
+    auto reader = std::make_unique<RcuCell<Counted>::ReadGuard>(cell);
+    for (int i = 1; i <= 1000; ++i)
+    {
+      cell.Update(std::make_unique<Counted>(i));
+      auto next = std::make_unique<RcuCell<Counted>::ReadGuard>(cell);
+      EXPECT_EQ(i, next->Get()->value);
+      reader = std::move(next);
+      EXPECT_LE(Counted::live, 3);
+    }
+  }
+  EXPECT_EQ(0, Counted::live);
+}
+
+//////////////////////////////////////////////////
+/// \brief A value set while holding a guard stays alive until the guard is
+/// destroyed, even if it's replaced.
+TEST(RcuCellTest, UpdateWhileReading)
+{
+  {
+    RcuCell<Counted> cell;
+    auto reader = cell.Read();
+    auto value = std::make_unique<Counted>(1);
+    const Counted *first = value.get();
+    cell.Update(std::move(value));
+    cell.Update(std::make_unique<Counted>(2));
+    cell.Update(std::make_unique<Counted>(3));
+    EXPECT_EQ(1, first->value);
+    EXPECT_EQ(3, Counted::live);
+  }
+  EXPECT_EQ(0, Counted::live);
+}
+
+//////////////////////////////////////////////////
+/// \brief Readers always see a live and consistent value while a writer
+/// keeps replacing it.
+TEST(RcuCellTest, Threads)
+{
+  {
+    RcuCell<Counted> cell;
+    cell.Update(std::make_unique<Counted>(0));
+
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i)
+    {
+      readers.emplace_back([&cell, &stop]()
+      {
+        int last = 0;
+        while (!stop)
+        {
+          auto reader = cell.Read();
+          const int value = reader.Get()->value;
+          EXPECT_GE(value, last);
+          last = value;
+        }
+      });
+    }
+
+    for (int i = 1; i <= 10000; ++i)
+      cell.Update(std::make_unique<Counted>(i));
+
+    stop = true;
+    for (auto &reader : readers)
+      reader.join();
+
+    EXPECT_EQ(10000, cell.Read().Get()->value);
+    EXPECT_EQ(1, Counted::live);
+  }
+  EXPECT_EQ(0, Counted::live);
+}
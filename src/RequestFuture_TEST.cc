@@ -0,0 +1,256 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <ignition/msgs.hh>
+
+#include "gtest/gtest.h"
+#include "ignition/transport/RequestFuture.hh"
+
+using namespace ignition;
+using namespace transport;
+
+using Int32State = RequestState<msgs::Int32>;
+using Int32Future = RequestFuture<msgs::Int32>;
+
+//////////////////////////////////////////////////
+/// \brief Create a response.
+msgs::Int32 makeReply(const int _data)
+{
+  msgs::Int32 rep;
+  rep.set_data(_data);
+  return rep;
+}
+
+//////////////////////////////////////////////////
+TEST(RequestFutureTest, Invalid)
+{
+  Int32Future future;
+  EXPECT_FALSE(future.Valid());
+  EXPECT_TRUE(future.Ready());
+  EXPECT_EQ(RequestStatus::NOT_SENT, future.Status());
+  EXPECT_EQ(RequestStatus::NOT_SENT, future.Wait());
+  EXPECT_FALSE(future.Cancel());
+
+  bool executed = false;
+  auto next = future.Then([&](const Int32Future &){executed = true;});
+  EXPECT_FALSE(next.Valid());
+  EXPECT_FALSE(executed);
+}
+
+//////////////////////////////////////////////////
+TEST(RequestFutureTest, Complete)
+{
+  auto state = std::make_shared<Int32State>();
+  Int32Future future(state);
+  EXPECT_TRUE(future.Valid());
+  EXPECT_FALSE(future.Ready());
+  EXPECT_EQ(RequestStatus::PENDING, future.Status());
+  EXPECT_FALSE(future.WaitFor(10));
+
+  std::thread t([state]
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_TRUE(state->Complete(RequestStatus::SUCCEEDED, makeReply(5)));
+  });
+
+  EXPECT_EQ(RequestStatus::SUCCEEDED, future.Wait());
+  EXPECT_EQ(5, future.Reply().data());
+  t.join();
+
+  // The first completion wins.
+  EXPECT_FALSE(state->Complete(RequestStatus::FAILED, makeReply(6)));
+  EXPECT_FALSE(future.Cancel());
+  EXPECT_EQ(RequestStatus::SUCCEEDED, future.Status());
+  EXPECT_EQ(5, future.Reply().data());
+}
+
+//////////////////////////////////////////////////
+TEST(RequestFutureTest, Cancel)
+{
+  auto state = std::make_shared<Int32State>();
+  Int32Future future(state);
+
+  int cancelled = 0;
+  state->OnCancel([&]{++cancelled;});
+
+  EXPECT_TRUE(future.Cancel());
+  EXPECT_EQ(1, cancelled);
+  EXPECT_EQ(RequestStatus::CANCELLED, future.Status());
+  EXPECT_TRUE(future.WaitFor(0));
+
+  // A late response is discarded.
+  EXPECT_FALSE(state->Complete(RequestStatus::SUCCEEDED, makeReply(5)));
+  EXPECT_EQ(RequestStatus::CANCELLED, future.Status());
+  EXPECT_EQ(0, future.Reply().data());
+
+  // A hook registered after the cancellation runs right away.
+  state->OnCancel([&]{++cancelled;});
+  EXPECT_EQ(2, cancelled);
+
+  // Completing the request discards the hook.
+  auto other = std::make_shared<Int32State>();
+  other->OnCancel([&]{++cancelled;});
+  EXPECT_TRUE(other->Complete(RequestStatus::FAILED));
+  EXPECT_FALSE(other->Cancel());
+  EXPECT_EQ(2, cancelled);
+}
+
+//////////////////////////////////////////////////
+TEST(RequestFutureTest, Timeout)
+{
+  auto state = std::make_shared<Int32State>();
+  Int32Future future(state);
+
+  EXPECT_TRUE(state->Cancel(RequestStatus::TIMED_OUT));
+  EXPECT_EQ(RequestStatus::TIMED_OUT, future.Status());
+  EXPECT_FALSE(future.Cancel());
+}
+
+//////////////////////////////////////////////////
+TEST(RequestFutureTest, ThenVoid)
+{
+  auto state = std::make_shared<Int32State>();
+  Int32Future future(state);
+
+  int data = 0;
+  auto next = future.Then([&](const Int32Future &_done)
+  {
+    EXPECT_EQ(RequestStatus::SUCCEEDED, _done.Status());
+    data = _done.Reply().data();
+  });
+  EXPECT_FALSE(next.Ready());
+
+  state->Complete(RequestStatus::SUCCEEDED, makeReply(5));
+  EXPECT_EQ(5, data);
+  EXPECT_EQ(RequestStatus::SUCCEEDED, next.Status());
+  EXPECT_EQ(5, next.Reply().data());
+
+  // Chaining a completed future executes the function right away.
+  data = 0;
+  future.Then([&](const Int32Future &_done){data = _done.Reply().data();});
+  EXPECT_EQ(5, data);
+}
+
+//////////////////////////////////////////////////
+TEST(RequestFutureTest, ThenFuture)
+{
+  auto first = std::make_shared<Int32State>();
+  auto second = std::make_shared<RequestState<msgs::StringMsg>>();
+
+  auto next = Int32Future(first).Then([&](const Int32Future &_done)
+  {
+    EXPECT_EQ(5, _done.Reply().data());
+    return RequestFuture<msgs::StringMsg>(second);
+  });
+  EXPECT_FALSE(next.Ready());
+
+  first->Complete(RequestStatus::SUCCEEDED, makeReply(5));
+  EXPECT_FALSE(next.Ready());
+
+  msgs::StringMsg rep;
+  rep.set_data("done");
+  second->Complete(RequestStatus::FAILED, rep);
+  EXPECT_EQ(RequestStatus::FAILED, next.Status());
+  EXPECT_EQ("done", next.Reply().data());
+
+  // An invalid future returned by the function.
+  auto invalid = Int32Future(first).Then([](const Int32Future &)
+  {
+    return Int32Future();
+  });
+  EXPECT_EQ(RequestStatus::NOT_SENT, invalid.Status());
+}
+
+//////////////////////////////////////////////////
+TEST(RequestFutureTest, ThenCancel)
+{
+  // Cancelling before the source completes cancels the source.
+  auto first = std::make_shared<Int32State>();
+  bool executed = false;
+  auto next = Int32Future(first).Then([&](const Int32Future &)
+  {
+    executed = true;
+  });
+
+  EXPECT_TRUE(next.Cancel());
+  EXPECT_EQ(RequestStatus::CANCELLED, first->Status());
+  EXPECT_FALSE(executed);
+
+  // Cancelling after the source completes cancels the chained request.
+  first = std::make_shared<Int32State>();
+  auto second = std::make_shared<Int32State>();
+  next = Int32Future(first).Then([&](const Int32Future &)
+  {
+    return Int32Future(second);
+  });
+
+  first->Complete(RequestStatus::SUCCEEDED, makeReply(5));
+  EXPECT_TRUE(next.Cancel());
+  EXPECT_EQ(RequestStatus::CANCELLED, second->Status());
+}
+
+#ifdef IGN_TRANSPORT_HAVE_COROUTINES
+//////////////////////////////////////////////////
+/// \brief Coroutine type that starts right away and can't be awaited.
+struct FireAndForget
+{
+  struct promise_type
+  {
+    FireAndForget get_return_object() {return {};}
+    std::suspend_never initial_suspend() {return {};}
+    std::suspend_never final_suspend() noexcept {return {};}
+    void return_void() {}
+    void unhandled_exception() {std::terminate();}
+  };
+};
+
+//////////////////////////////////////////////////
+/// \brief Add the responses of two requests.
+FireAndForget addReplies(Int32Future _a, Int32Future _b, int &_sum)
+{
+  auto a = co_await _a;
+  auto b = co_await _b;
+  _sum = a.Reply().data() + b.Reply().data();
+}
+
+//////////////////////////////////////////////////
+TEST(RequestFutureTest, CoAwait)
+{
+  auto a = std::make_shared<Int32State>();
+  auto b = std::make_shared<Int32State>();
+
+  // The second request completes before being awaited.
+  b->Complete(RequestStatus::SUCCEEDED, makeReply(2));
+
+  int sum = 0;
+  addReplies(Int32Future(a), Int32Future(b), sum);
+  EXPECT_EQ(0, sum);
+
+  a->Complete(RequestStatus::SUCCEEDED, makeReply(3));
+  EXPECT_EQ(5, sum);
+}
+#endif
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,594 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef _WIN32
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <string>
+
+#include "ignition/transport/SharedMemoryRing.hh"
+
+using namespace ignition;
+using namespace transport;
+
+namespace
+{
+  /// \brief Value stored at the beginning of every segment ("ignshmr2").
+  const uint64_t kMagic = 0x69676e73686d7232;
+
+  /// \brief Sequence number of a slot that is being written.
+  const uint64_t kWriting = std::numeric_limits<uint64_t>::max();
+
+  /// \brief Alignment of the slots inside the segment.
+  const uint64_t kAlignment = 64;
+
+  /// \brief Maximum number of reader processes whose slots are reclaimed if
+  /// they crash.
+  const uint32_t kMaxReaders = 64;
+
+  /// \brief Minimum time between two checks for crashed readers.
+  const std::chrono::seconds kReclaimPeriod(1);
+
+  /// \brief Header stored at the beginning of the segment.
+  struct SegmentHeader
+  {
+    /// \brief Used to validate the segment.
+    uint64_t magic;
+
+    /// \brief Number of slots.
+    uint32_t slotCount;
+
+    /// \brief Number of entries of the reader table.
+    uint32_t readerCount;
+
+    /// \brief Size of each slot (bytes).
+    uint64_t slotSize;
+  };
+
+  /// \brief Header stored at the beginning of every slot.
+  struct SlotHeader
+  {
+    /// \brief Sequence number of the data stored in the slot. 0 if the slot
+    /// doesn't contain valid data and kWriting while it is being written.
+    std::atomic<uint64_t> seq;
+
+    /// \brief Number of readers that have currently acquired the slot.
+    std::atomic<uint32_t> readers;
+
+    /// \brief Unused.
+    uint32_t reserved;
+
+    /// \brief Size of the data stored in the slot (bytes).
+    uint64_t size;
+  };
+
+  static_assert(std::atomic<uint64_t>::is_always_lock_free,
+    "Shared memory transport requires lock free 64 bit atomics");
+  static_assert(std::atomic<uint32_t>::is_always_lock_free,
+    "Shared memory transport requires lock free 32 bit atomics");
+
+  //////////////////////////////////////////////////
+  /// \brief Round a value up to the next multiple of kAlignment.
+  uint64_t align(const uint64_t _value)
+  {
+    return (_value + kAlignment - 1) & ~(kAlignment - 1);
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Size of a segment.
+  /// \param[in] _slotCount Number of slots.
+  /// \param[in] _stride Distance between two consecutive slots (bytes).
+  /// \param[in] _readerCount Number of entries of the reader table.
+  /// \return The size (bytes).
+  uint64_t segmentLength(const uint64_t _slotCount, const uint64_t _stride,
+    const uint64_t _readerCount)
+  {
+    return align(sizeof(SegmentHeader)) + _slotCount * _stride +
+      align(_readerCount * _slotCount * sizeof(std::atomic<uint32_t>));
+  }
+
+#ifdef F_OFD_SETLK
+  //////////////////////////////////////////////////
+  /// \brief Take or give up the lock of an entry of the reader table without
+  /// blocking. The lock belongs to the open file description, so it's
+  /// released when the process that holds it dies, even if it crashes.
+  /// \param[in] _fd Descriptor of the segment.
+  /// \param[in] _reader Index of the entry.
+  /// \param[in] _type F_WRLCK or F_UNLCK.
+  /// \return True on success, false if another process holds the lock.
+  bool lockReader(const int _fd, const uint32_t _reader, const short _type)
+  {
+    struct flock fl;
+    memset(&fl, 0, sizeof(fl));
+    fl.l_type = _type;
+    fl.l_whence = SEEK_SET;
+    fl.l_start = static_cast<off_t>(_reader);
+    fl.l_len = 1;
+    return fcntl(_fd, F_OFD_SETLK, &fl) == 0;
+  }
+#endif
+}
+
+/// \internal
+/// \brief Private data for SharedMemoryRing class.
+class ignition::transport::SharedMemoryRingPrivate
+{
+  /// \brief Get the header of a slot.
+  /// \param[in] _slot Index of the slot.
+  /// \return Pointer to the slot header.
+  public: SlotHeader *Slot(const uint32_t _slot) const
+  {
+    return reinterpret_cast<SlotHeader *>(
+      this->base + align(sizeof(SegmentHeader)) + _slot * this->stride);
+  }
+
+  /// \brief Get the number of slots that a reader has acquired, for each
+  /// slot.
+  /// \param[in] _reader Index of the entry of the reader table.
+  /// \return Pointer to the counters of the reader.
+  public: std::atomic<uint32_t> *Acquired(const uint32_t _reader) const
+  {
+    return reinterpret_cast<std::atomic<uint32_t> *>(
+      this->base + align(sizeof(SegmentHeader)) +
+      this->slotCount * this->stride) + _reader * this->slotCount;
+  }
+
+  /// \brief Give back the slots acquired by a reader that is gone. The
+  /// lock of its entry has to be held.
+  /// \param[in] _reader Index of the entry of the reader table.
+  /// \return True if some slot was given back.
+  public: bool Reclaim(const uint32_t _reader) const
+  {
+    bool reclaimed = false;
+    std::atomic<uint32_t> *acquired = this->Acquired(_reader);
+    for (uint32_t i = 0; i < this->slotCount; ++i)
+    {
+      uint32_t count = acquired[i].exchange(0);
+      if (count != 0)
+      {
+        this->Slot(i)->readers.fetch_sub(count);
+        reclaimed = true;
+      }
+    }
+    return reclaimed;
+  }
+
+  /// \brief Give back the slots acquired by the readers that crashed. Only
+  /// used by the writer, at most once per kReclaimPeriod.
+  /// \return True if some slot was given back.
+  public: bool ReclaimCrashed()
+  {
+    bool reclaimed = false;
+#ifdef F_OFD_SETLK
+    auto now = std::chrono::steady_clock::now();
+    if (now < this->nextReclaim)
+      return false;
+    this->nextReclaim = now + kReclaimPeriod;
+
+    for (uint32_t i = 0; i < this->readerCount; ++i)
+    {
+      // Nobody holds the lock, so the reader that used this entry is gone.
+      if (lockReader(this->fd, i, F_WRLCK))
+      {
+        reclaimed = this->Reclaim(i) || reclaimed;
+        lockReader(this->fd, i, F_UNLCK);
+      }
+    }
+#endif
+    return reclaimed;
+  }
+
+  /// \brief Get the data stored in a slot.
+  /// \param[in] _slot Index of the slot.
+  /// \return Pointer to the data.
+  public: char *Data(const uint32_t _slot) const
+  {
+    return reinterpret_cast<char *>(this->Slot(_slot)) +
+      align(sizeof(SlotHeader));
+  }
+
+  /// \brief Name of the segment.
+  public: std::string name;
+
+  /// \brief Start of the mapped segment.
+  public: char *base = nullptr;
+
+  /// \brief Size of the mapped segment (bytes).
+  public: uint64_t length = 0;
+
+  /// \brief Descriptor of the segment.
+  public: int fd = -1;
+
+  /// \brief Number of slots.
+  public: uint32_t slotCount = 0;
+
+  /// \brief Number of entries of the reader table.
+  public: uint32_t readerCount = 0;
+
+  /// \brief Entry of the reader table that tracks the slots acquired by
+  /// this reader, -1 if they aren't tracked.
+  public: int reader = -1;
+
+  /// \brief Size of the data area of a slot (bytes).
+  public: uint64_t slotSize = 0;
+
+  /// \brief Distance between two consecutive slots (bytes).
+  public: uint64_t stride = 0;
+
+  /// \brief True if this process created the segment.
+  public: bool writer = false;
+
+  /// \brief Index of the next slot to be reserved. Only used by the writer.
+  public: uint32_t nextSlot = 0;
+
+  /// \brief Last sequence number committed. Only used by the writer.
+  public: uint64_t seq = 0;
+
+  /// \brief Next time that the writer looks for crashed readers.
+  public: std::chrono::steady_clock::time_point nextReclaim;
+
+  /// \brief Protects nextSlot, seq and nextReclaim when multiple threads of
+  /// the writer process publish on the same ring.
+  public: std::mutex mutex;
+};
+
+//////////////////////////////////////////////////
+SharedMemoryRing::SharedMemoryRing()
+  : dataPtr(new SharedMemoryRingPrivate)
+{
+}
+
+//////////////////////////////////////////////////
+SharedMemoryRing::~SharedMemoryRing()
+{
+#ifndef _WIN32
+  if (this->dataPtr->base)
+    munmap(this->dataPtr->base, this->dataPtr->length);
+
+  // Closing the descriptor releases the lock of the reader entry.
+  if (this->dataPtr->fd >= 0)
+    close(this->dataPtr->fd);
+
+  if (this->dataPtr->writer)
+    shm_unlink(this->dataPtr->name.c_str());
+#endif
+}
+
+//////////////////////////////////////////////////
+std::unique_ptr<SharedMemoryRing> SharedMemoryRing::Create(
+  const std::string &_name, const uint32_t _slotCount,
+  const uint64_t _slotSize)
+{
+#ifdef _WIN32
+  (void)_name;
+  (void)_slotCount;
+  (void)_slotSize;
+  return nullptr;
+#else
+  if (_slotCount == 0 || _slotSize == 0)
+    return nullptr;
+
+  const uint64_t stride = align(sizeof(SlotHeader)) + align(_slotSize);
+  const uint64_t length = segmentLength(_slotCount, stride, kMaxReaders);
+
+  // Remove any stale segment with the same name.
+  shm_unlink(_name.c_str());
+
+  int fd = shm_open(_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0)
+  {
+    std::cerr << "SharedMemoryRing::Create(): Unable to create ["
+              << _name << "]" << std::endl;
+    return nullptr;
+  }
+
+  if (ftruncate(fd, static_cast<off_t>(length)) != 0)
+  {
+    std::cerr << "SharedMemoryRing::Create(): Unable to allocate "
+              << length << " bytes for [" << _name << "]" << std::endl;
+    close(fd);
+    shm_unlink(_name.c_str());
+    return nullptr;
+  }
+
+  void *addr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (addr == MAP_FAILED)
+  {
+    std::cerr << "SharedMemoryRing::Create(): Unable to map ["
+              << _name << "]" << std::endl;
+    close(fd);
+    shm_unlink(_name.c_str());
+    return nullptr;
+  }
+
+  // The descriptor is kept to check the locks of the readers.
+  std::unique_ptr<SharedMemoryRing> ring(new SharedMemoryRing());
+  ring->dataPtr->name = _name;
+  ring->dataPtr->base = static_cast<char *>(addr);
+  ring->dataPtr->length = length;
+  ring->dataPtr->fd = fd;
+  ring->dataPtr->slotCount = _slotCount;
+  ring->dataPtr->readerCount = kMaxReaders;
+  ring->dataPtr->slotSize = _slotSize;
+  ring->dataPtr->stride = stride;
+  ring->dataPtr->writer = true;
+
+  // The memory returned by ftruncate() is zero filled, so all the slots are
+  // empty at this point.
+  SegmentHeader *header = reinterpret_cast<SegmentHeader *>(addr);
+  header->slotCount = _slotCount;
+  header->readerCount = kMaxReaders;
+  header->slotSize = _slotSize;
+  header->magic = kMagic;
+
+  return ring;
+#endif
+}
+
+//////////////////////////////////////////////////
+std::unique_ptr<SharedMemoryRing> SharedMemoryRing::Open(
+  const std::string &_name)
+{
+#ifdef _WIN32
+  (void)_name;
+  return nullptr;
+#else
+  int fd = shm_open(_name.c_str(), O_RDWR, 0600);
+  if (fd < 0)
+    return nullptr;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      static_cast<uint64_t>(st.st_size) < align(sizeof(SegmentHeader)))
+  {
+    close(fd);
+    return nullptr;
+  }
+
+  const uint64_t length = static_cast<uint64_t>(st.st_size);
+  void *addr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (addr == MAP_FAILED)
+  {
+    close(fd);
+    return nullptr;
+  }
+
+  std::unique_ptr<SharedMemoryRing> ring(new SharedMemoryRing());
+  ring->dataPtr->name = _name;
+  ring->dataPtr->base = static_cast<char *>(addr);
+  ring->dataPtr->length = length;
+  ring->dataPtr->fd = fd;
+
+  const SegmentHeader *header = reinterpret_cast<SegmentHeader *>(addr);
+  const uint64_t stride = align(sizeof(SlotHeader)) + align(header->slotSize);
+  if (header->magic != kMagic || header->slotCount == 0 ||
+      segmentLength(header->slotCount, stride, header->readerCount) > length)
+  {
+    std::cerr << "SharedMemoryRing::Open(): Invalid segment [" << _name
+              << "]" << std::endl;
+    return nullptr;
+  }
+
+  ring->dataPtr->slotCount = header->slotCount;
+  ring->dataPtr->readerCount = header->readerCount;
+  ring->dataPtr->slotSize = header->slotSize;
+  ring->dataPtr->stride = stride;
+
+#ifdef F_OFD_SETLK
+  // Take a free entry of the reader table, so the writer can give back our
+  // slots if we crash. The previous owner of the entry might have crashed
+  // too.
+  for (uint32_t i = 0; i < ring->dataPtr->readerCount; ++i)
+  {
+    if (lockReader(fd, i, F_WRLCK))
+    {
+      ring->dataPtr->Reclaim(i);
+      ring->dataPtr->reader = static_cast<int>(i);
+      break;
+    }
+  }
+#endif
+
+  return ring;
+#endif
+}
+
+//////////////////////////////////////////////////
+bool SharedMemoryRing::Supported()
+{
+#ifdef _WIN32
+  return false;
+#else
+  return true;
+#endif
+}
+
+//////////////////////////////////////////////////
+std::string SharedMemoryRing::HostId()
+{
+  if (!Supported())
+    return "";
+
+  std::string id;
+#ifndef _WIN32
+  char hostname[256] = {0};
+  if (gethostname(hostname, sizeof(hostname) - 1) == 0)
+    id = hostname;
+
+  // Two containers might share the host name but not the boot id.
+  std::ifstream bootId("/proc/sys/kernel/random/boot_id");
+  std::string boot;
+  if (bootId && std::getline(bootId, boot))
+    id += "/" + boot;
+
+  // Or share both, e.g. when they use the network of the host, but not the
+  // shared memory segments, which live in the IPC namespace.
+  char ipc[64] = {0};
+  ssize_t ipcSize = readlink("/proc/self/ns/ipc", ipc, sizeof(ipc) - 1);
+  if (ipcSize > 0)
+    id += "/" + std::string(ipc, static_cast<size_t>(ipcSize));
+
+  // The segments are only accessible to their owner.
+  id += "/" + std::to_string(getuid());
+#endif
+  return id;
+}
+
+//////////////////////////////////////////////////
+std::string SharedMemoryRing::Name() const
+{
+  return this->dataPtr->name;
+}
+
+//////////////////////////////////////////////////
+uint32_t SharedMemoryRing::SlotCount() const
+{
+  return this->dataPtr->slotCount;
+}
+
+//////////////////////////////////////////////////
+uint64_t SharedMemoryRing::SlotSize() const
+{
+  return this->dataPtr->slotSize;
+}
+
+//////////////////////////////////////////////////
+char *SharedMemoryRing::Reserve(const uint64_t _size, uint32_t &_slot)
+{
+  if (!this->dataPtr->writer || _size > this->dataPtr->slotSize)
+    return nullptr;
+
+  std::lock_guard<std::mutex> lk(this->dataPtr->mutex);
+
+  do
+  {
+    for (uint32_t i = 0; i < this->dataPtr->slotCount; ++i)
+    {
+      uint32_t index =
+        (this->dataPtr->nextSlot + i) % this->dataPtr->slotCount;
+      SlotHeader *slot = this->dataPtr->Slot(index);
+
+      // Another thread of this process is still writing on this slot.
+      uint64_t prev = slot->seq.load();
+      if (prev == kWriting)
+        continue;
+
+      // Invalidate the slot before checking for readers. A reader increments
+      // the counter before validating the sequence number, so either we see
+      // the reader or the reader sees that the slot is being written.
+      slot->seq.store(kWriting);
+      if (slot->readers.load() != 0)
+      {
+        slot->seq.store(prev);
+        continue;
+      }
+
+      this->dataPtr->nextSlot = (index + 1) % this->dataPtr->slotCount;
+      _slot = index;
+      return this->dataPtr->Data(index);
+    }
+  }
+  // All the slots are acquired. Try again if some of them were held by
+  // readers that crashed.
+  while (this->dataPtr->ReclaimCrashed());
+
+  return nullptr;
+}
+
+//////////////////////////////////////////////////
+uint64_t SharedMemoryRing::Commit(const uint32_t _slot, const uint64_t _size)
+{
+  if (!this->dataPtr->writer || _slot >= this->dataPtr->slotCount ||
+      _size > this->dataPtr->slotSize)
+  {
+    return 0;
+  }
+
+  SlotHeader *slot = this->dataPtr->Slot(_slot);
+  if (slot->seq.load() != kWriting)
+    return 0;
+
+  uint64_t seq;
+  {
+    std::lock_guard<std::mutex> lk(this->dataPtr->mutex);
+    seq = ++this->dataPtr->seq;
+  }
+
+  slot->size = _size;
+  slot->seq.store(seq, std::memory_order_release);
+  return seq;
+}
+
+//////////////////////////////////////////////////
+void SharedMemoryRing::Abort(const uint32_t _slot)
+{
+  if (!this->dataPtr->writer || _slot >= this->dataPtr->slotCount)
+    return;
+
+  SlotHeader *slot = this->dataPtr->Slot(_slot);
+  if (slot->seq.load() == kWriting)
+    slot->seq.store(0);
+}
+
+//////////////////////////////////////////////////
+bool SharedMemoryRing::Acquire(const uint32_t _slot, const uint64_t _seq,
+  const char *&_data, uint64_t &_size)
+{
+  if (_slot >= this->dataPtr->slotCount || _seq == 0 || _seq == kWriting)
+    return false;
+
+  // The slot is counted in the reader table after the slot counter, and
+  // released in the opposite order. If we crash in between, the slot leaks
+  // instead of being given back twice.
+  SlotHeader *slot = this->dataPtr->Slot(_slot);
+  slot->readers.fetch_add(1);
+  if (this->dataPtr->reader >= 0)
+    this->dataPtr->Acquired(this->dataPtr->reader)[_slot].fetch_add(1);
+
+  if (slot->seq.load() != _seq || slot->size > this->dataPtr->slotSize)
+  {
+    // The writer already reused the slot.
+    this->Release(_slot);
+    return false;
+  }
+
+  _data = this->dataPtr->Data(_slot);
+  _size = slot->size;
+  return true;
+}
+
+//////////////////////////////////////////////////
+void SharedMemoryRing::Release(const uint32_t _slot)
+{
+  if (_slot >= this->dataPtr->slotCount)
+    return;
+
+  if (this->dataPtr->reader >= 0)
+    this->dataPtr->Acquired(this->dataPtr->reader)[_slot].fetch_sub(1);
+  this->dataPtr->Slot(_slot)->readers.fetch_sub(1);
+}
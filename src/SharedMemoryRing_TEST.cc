@@ -0,0 +1,233 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef _WIN32
+  #include <sys/wait.h>
+  #include <unistd.h>
+#endif
+
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "ignition/transport/SharedMemoryRing.hh"
+#include "ignition/transport/Uuid.hh"
+
+using namespace ignition;
+using namespace transport;
+
+/// \brief Get a unique segment name for each test.
+std::string segmentName()
+{
+  return "/ign-test-" + Uuid().ToString().substr(0, 8);
+}
+
+//////////////////////////////////////////////////
+TEST(SharedMemoryRingTest, CreateAndOpen)
+{
+  if (!SharedMemoryRing::Supported())
+    return;
+
+  EXPECT_FALSE(SharedMemoryRing::HostId().empty());
+
+  std::string name = segmentName();
+  EXPECT_EQ(nullptr, SharedMemoryRing::Open(name));
+
+  auto writer = SharedMemoryRing::Create(name, 4u, 128u);
+  ASSERT_NE(nullptr, writer);
+  EXPECT_EQ(name, writer->Name());
+  EXPECT_EQ(4u, writer->SlotCount());
+  EXPECT_EQ(128u, writer->SlotSize());
+
+  auto reader = SharedMemoryRing::Open(name);
+  ASSERT_NE(nullptr, reader);
+  EXPECT_EQ(4u, reader->SlotCount());
+  EXPECT_EQ(128u, reader->SlotSize());
+
+  // Only the writer can reserve slots.
+  uint32_t slot;
+  EXPECT_EQ(nullptr, reader->Reserve(10u, slot));
+
+  // The segment is removed when the writer goes away.
+  writer.reset();
+  EXPECT_EQ(nullptr, SharedMemoryRing::Open(name));
+}
+
+//////////////////////////////////////////////////
+TEST(SharedMemoryRingTest, WriteAndRead)
+{
+  if (!SharedMemoryRing::Supported())
+    return;
+
+  std::string name = segmentName();
+  auto writer = SharedMemoryRing::Create(name, 2u, 64u);
+  ASSERT_NE(nullptr, writer);
+  auto reader = SharedMemoryRing::Open(name);
+  ASSERT_NE(nullptr, reader);
+
+  // Too large.
+  uint32_t slot;
+  EXPECT_EQ(nullptr, writer->Reserve(65u, slot));
+
+  const std::string payload = "hello shared memory";
+  char *buffer = writer->Reserve(payload.size(), slot);
+  ASSERT_NE(nullptr, buffer);
+  memcpy(buffer, payload.data(), payload.size());
+  uint64_t seq = writer->Commit(slot, payload.size());
+  EXPECT_NE(0u, seq);
+
+  // Commit twice is not allowed.
+  EXPECT_EQ(0u, writer->Commit(slot, payload.size()));
+
+  const char *data = nullptr;
+  uint64_t size = 0;
+  EXPECT_FALSE(reader->Acquire(slot, seq + 1, data, size));
+  EXPECT_FALSE(reader->Acquire(100u, seq, data, size));
+  ASSERT_TRUE(reader->Acquire(slot, seq, data, size));
+  EXPECT_EQ(payload, std::string(data, size));
+
+  // The writer skips the acquired slot.
+  uint32_t otherSlot;
+  ASSERT_NE(nullptr, writer->Reserve(payload.size(), otherSlot));
+  EXPECT_NE(slot, otherSlot);
+  writer->Abort(otherSlot);
+
+  uint32_t sameSlot;
+  ASSERT_NE(nullptr, writer->Reserve(payload.size(), sameSlot));
+  EXPECT_NE(slot, sameSlot);
+  writer->Abort(sameSlot);
+
+  // All the slots are in use.
+  ASSERT_NE(nullptr, writer->Reserve(payload.size(), otherSlot));
+  EXPECT_EQ(nullptr, writer->Reserve(payload.size(), sameSlot));
+  writer->Abort(otherSlot);
+
+  // The data is still valid while acquired.
+  EXPECT_EQ(payload, std::string(data, size));
+  reader->Release(slot);
+
+  // Now the slot can be overwritten and the old sequence number is no longer
+  // valid.
+  for (int i = 0; i < 2; ++i)
+  {
+    ASSERT_NE(nullptr, writer->Reserve(payload.size(), otherSlot));
+    EXPECT_NE(0u, writer->Commit(otherSlot, payload.size()));
+  }
+  EXPECT_FALSE(reader->Acquire(slot, seq, data, size));
+}
+
+#ifndef _WIN32
+//////////////////////////////////////////////////
+/// \brief Commit a payload in a new slot.
+/// \param[in] _writer The ring.
+/// \param[in] _payload The payload.
+/// \param[out] _slot The slot used.
+/// \return The sequence number, 0 on error.
+uint64_t write(SharedMemoryRing &_writer, const std::string &_payload,
+  uint32_t &_slot)
+{
+  char *buffer = _writer.Reserve(_payload.size(), _slot);
+  if (!buffer)
+    return 0;
+  memcpy(buffer, _payload.data(), _payload.size());
+  return _writer.Commit(_slot, _payload.size());
+}
+
+//////////////////////////////////////////////////
+/// \brief Check that another process reads the data.
+TEST(SharedMemoryRingTest, CrossProcess)
+{
+  if (!SharedMemoryRing::Supported())
+    return;
+
+  std::string name = segmentName();
+  auto writer = SharedMemoryRing::Create(name, 2u, 64u);
+  ASSERT_NE(nullptr, writer);
+
+  const std::string payload = "hello other process";
+  uint32_t slot;
+  uint64_t seq = write(*writer, payload, slot);
+  ASSERT_NE(0u, seq);
+
+  pid_t pid = fork();
+  ASSERT_NE(-1, pid);
+  if (pid == 0)
+  {
+    auto reader = SharedMemoryRing::Open(name);
+    const char *data = nullptr;
+    uint64_t size = 0;
+    bool ok = reader && reader->Acquire(slot, seq, data, size) &&
+      std::string(data, size) == payload;
+    if (reader)
+      reader->Release(slot);
+    _exit(ok ? 0 : 1);
+  }
+
+  int status = 0;
+  ASSERT_EQ(pid, waitpid(pid, &status, 0));
+  ASSERT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(0, WEXITSTATUS(status));
+}
+
+#ifdef __linux__
+//////////////////////////////////////////////////
+/// \brief Check that the writer reuses the slots of a reader that exits
+/// without releasing them.
+TEST(SharedMemoryRingTest, CrashedReader)
+{
+  if (!SharedMemoryRing::Supported())
+    return;
+
+  std::string name = segmentName();
+  auto writer = SharedMemoryRing::Create(name, 2u, 64u);
+  ASSERT_NE(nullptr, writer);
+
+  const std::string payload = "data";
+  uint32_t slots[2];
+  uint64_t seqs[2];
+  for (int i = 0; i < 2; ++i)
+  {
+    seqs[i] = write(*writer, payload, slots[i]);
+    ASSERT_NE(0u, seqs[i]);
+  }
+
+  pid_t pid = fork();
+  ASSERT_NE(-1, pid);
+  if (pid == 0)
+  {
+    // Acquire all the slots and exit without releasing them.
+    auto reader = SharedMemoryRing::Open(name);
+    const char *data = nullptr;
+    uint64_t size = 0;
+    bool ok = reader != nullptr;
+    for (int i = 0; ok && i < 2; ++i)
+      ok = reader->Acquire(slots[i], seqs[i], data, size);
+    _exit(ok ? 0 : 1);
+  }
+
+  int status = 0;
+  ASSERT_EQ(pid, waitpid(pid, &status, 0));
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(0, WEXITSTATUS(status));
+
+  // The slots are given back to the writer.
+  uint32_t slot;
+  EXPECT_NE(0u, write(*writer, payload, slot));
+}
+#endif
+#endif
@@ -36,6 +36,9 @@ SubscribeOptions::SubscribeOptions(const SubscribeOptions &_otherSubscribeOpts)
   : dataPtr(new SubscribeOptionsPrivate())
 {
   this->SetMsgsPerSec(_otherSubscribeOpts.MsgsPerSec());
+  this->SetFilter(_otherSubscribeOpts.Filter());
+  this->SetHistory(_otherSubscribeOpts.History());
+  this->SetQueueDepth(_otherSubscribeOpts.QueueDepth());
 }
 
 //////////////////////////////////////////////////
@@ -60,3 +63,45 @@ void SubscribeOptions::SetMsgsPerSec(const uint64_t _newMsgsPerSec)
 {
   this->dataPtr->msgsPerSec = _newMsgsPerSec;
 }
+
+//////////////////////////////////////////////////
+void SubscribeOptions::SetFilter(const MessageFilter &_filter)
+{
+  this->dataPtr->filter = _filter;
+}
+
+//////////////////////////////////////////////////
+const MessageFilter &SubscribeOptions::Filter() const
+{
+  return this->dataPtr->filter;
+}
+
+//////////////////////////////////////////////////
+void SubscribeOptions::SetHistory(const HistoryPolicy _history)
+{
+  this->dataPtr->history = _history;
+}
+
+//////////////////////////////////////////////////
+SubscribeOptions::HistoryPolicy SubscribeOptions::History() const
+{
+  return this->dataPtr->history;
+}
+
+//////////////////////////////////////////////////
+void SubscribeOptions::SetQueueDepth(const uint64_t _depth)
+{
+  this->dataPtr->queueDepth = _depth;
+}
+
+//////////////////////////////////////////////////
+uint64_t SubscribeOptions::QueueDepth() const
+{
+  return this->dataPtr->queueDepth;
+}
+
+//////////////////////////////////////////////////
+bool SubscribeOptions::Queued() const
+{
+  return this->History() != HistoryPolicy::KEEP_ALL || this->QueueDepth() > 0;
+}
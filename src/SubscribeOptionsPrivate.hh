@@ -21,6 +21,8 @@
 #include <cstdint>
 
 #include "ignition/transport/Helpers.hh"
+#include "ignition/transport/MessageFilter.hh"
+#include "ignition/transport/SubscribeOptions.hh"
 
 namespace ignition
 {
@@ -41,6 +43,16 @@ namespace ignition
 
       /// \brief Default message subscription rate.
       public: uint64_t msgsPerSec = kUnthrottled;
+
+      /// \brief Filter on the content of the messages.
+      public: MessageFilter filter;
+
+      /// \brief History policy.
+      public: SubscribeOptions::HistoryPolicy history =
+        SubscribeOptions::HistoryPolicy::KEEP_ALL;
+
+      /// \brief Maximum number of messages buffered by the subscription.
+      public: uint64_t queueDepth = 0;
     };
     }
   }
@@ -16,6 +16,7 @@
 */
 
 #include "ignition/transport/Helpers.hh"
+#include "ignition/transport/MessageFilter.hh"
 #include "ignition/transport/SubscribeOptions.hh"
 #include "ignition/transport/test_config.h"
 #include "gtest/gtest.h"
@@ -30,8 +31,16 @@ TEST(SubscribeOptionsTest, copyConstructor)
   SubscribeOptions opts1;
   opts1.SetMsgsPerSec(2u);
   EXPECT_EQ(opts1.MsgsPerSec(), 2u);
+  MessageFilter filter;
+  EXPECT_TRUE(filter.AddCondition("x", MessageFilter::Op::LESS, "1"));
+  opts1.SetFilter(filter);
+  opts1.SetHistory(SubscribeOptions::HistoryPolicy::KEEP_LAST);
+  opts1.SetQueueDepth(5u);
   SubscribeOptions opts2(opts1);
   EXPECT_EQ(opts2.MsgsPerSec(), opts1.MsgsPerSec());
+  EXPECT_EQ(opts2.Filter(), opts1.Filter());
+  EXPECT_EQ(opts2.History(), opts1.History());
+  EXPECT_EQ(opts2.QueueDepth(), opts1.QueueDepth());
 }
 
 //////////////////////////////////////////////////
@@ -43,6 +52,34 @@ TEST(SubscribeOptionsTest, accessors)
   EXPECT_EQ(opts.MsgsPerSec(), kUnthrottled);
   opts.SetMsgsPerSec(3u);
   EXPECT_EQ(opts.MsgsPerSec(), 3u);
+
+  // Filter.
+  EXPECT_TRUE(opts.Filter().Empty());
+  MessageFilter filter;
+  EXPECT_TRUE(filter.AddCondition("x", MessageFilter::Op::EQUAL, "1"));
+  opts.SetFilter(filter);
+  EXPECT_EQ(opts.Filter(), filter);
+
+  // History and queue depth.
+  EXPECT_EQ(opts.History(), SubscribeOptions::HistoryPolicy::KEEP_ALL);
+  EXPECT_EQ(opts.QueueDepth(), 0u);
+  opts.SetHistory(SubscribeOptions::HistoryPolicy::LATEST_ONLY);
+  EXPECT_EQ(opts.History(), SubscribeOptions::HistoryPolicy::LATEST_ONLY);
+  opts.SetQueueDepth(10u);
+  EXPECT_EQ(opts.QueueDepth(), 10u);
+}
+
+//////////////////////////////////////////////////
+/// \brief Check Queued().
+TEST(SubscribeOptionsTest, queued)
+{
+  SubscribeOptions opts;
+  EXPECT_FALSE(opts.Queued());
+  opts.SetQueueDepth(3u);
+  EXPECT_TRUE(opts.Queued());
+  opts.SetQueueDepth(0u);
+  opts.SetHistory(SubscribeOptions::HistoryPolicy::KEEP_LAST);
+  EXPECT_TRUE(opts.Queued());
 }
 
 //////////////////////////////////////////////////
@@ -17,6 +17,9 @@
 
 #include "ignition/transport/SubscriptionHandler.hh"
 
+#include "MessageFilterPrivate.hh"
+#include "SubscriptionQueue.hh"
+
 namespace ignition
 {
   namespace transport
@@ -35,6 +38,15 @@ namespace ignition
     {
       if (this->opts.Throttled())
         this->periodNs = 1e9 / this->opts.MsgsPerSec();
+
+      this->filterKey = MessageFilterPrivate::SubscriptionKey(
+        this->opts.Filter(), this->opts.MsgsPerSec());
+
+      if (this->opts.Queued())
+      {
+        this->queue = std::make_shared<SubscriptionQueue>(
+          this->opts.History(), this->opts.QueueDepth());
+      }
     }
 
     /////////////////////////////////////////////////
@@ -49,6 +61,25 @@ namespace ignition
       return this->hUuid;
     }
 
+    /////////////////////////////////////////////////
+    const std::string &SubscriptionHandlerBase::FilterKey() const
+    {
+      return this->filterKey;
+    }
+
+    /////////////////////////////////////////////////
+    const std::shared_ptr<SubscriptionQueue> &
+    SubscriptionHandlerBase::Queue() const
+    {
+      return this->queue;
+    }
+
+    /////////////////////////////////////////////////
+    uint64_t SubscriptionHandlerBase::Dropped() const
+    {
+      return this->queue ? this->queue->Dropped() : 0;
+    }
+
     /////////////////////////////////////////////////
     bool SubscriptionHandlerBase::UpdateThrottling()
     {
@@ -80,6 +111,17 @@ namespace ignition
       // Do nothing
     }
 
+    /////////////////////////////////////////////////
+    const std::shared_ptr<ProtoMsg> ISubscriptionHandler::CreateMsg(
+        const char *_data, const size_t _size,
+        const std::string &_type) const
+    {
+      if (this->inPlaceParser)
+        return this->inPlaceParser->ParseMsg(_data, _size, _type);
+
+      return this->CreateMsg(std::string(_data, _size), _type);
+    }
+
     /////////////////////////////////////////////////
     class RawSubscriptionHandler::Implementation
     {
@@ -94,12 +136,24 @@ namespace ignition
       public: RawCallback callback;
     };
 
+    /////////////////////////////////////////////////
+    /// \brief Get the options of a raw subscription. The messages are not
+    /// parsed, so the filter on their content doesn't apply.
+    /// \param[in] _opts Subscription options.
+    /// \return The options without the filter.
+    static SubscribeOptions RawOptions(const SubscribeOptions &_opts)
+    {
+      SubscribeOptions opts(_opts);
+      opts.SetFilter(MessageFilter());
+      return opts;
+    }
+
     /////////////////////////////////////////////////
     RawSubscriptionHandler::RawSubscriptionHandler(
         const std::string &_nUuid,
         const std::string &_msgType,
         const SubscribeOptions &_opts)
-      : SubscriptionHandlerBase(_nUuid, _opts),
+      : SubscriptionHandlerBase(_nUuid, RawOptions(_opts)),
         pimpl(new Implementation(_msgType))
     {
       // Do nothing
@@ -120,7 +174,7 @@ namespace ignition
     /////////////////////////////////////////////////
     bool RawSubscriptionHandler::RunRawCallback(
         const char *_msgData, const size_t _size,
-        const MessageInfo &_info)
+        const MessageInfo &_info, const bool _prefiltered)
     {
       // Make sure we have a callback
       if (!this->pimpl->callback)
@@ -131,7 +185,7 @@ namespace ignition
       }
 
       // Check if we need to throttle
-      if (!this->UpdateThrottling())
+      if (!_prefiltered && !this->UpdateThrottling())
         return true;
 
       // Trigger the callback
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+#include "SubscriptionQueue.hh"
+
+using namespace ignition;
+using namespace transport;
+
+//////////////////////////////////////////////////
+SubscriptionQueue::SubscriptionQueue(
+  const SubscribeOptions::HistoryPolicy _history, const uint64_t _depth)
+  : capacity(_depth),
+    dropOldest(_history != SubscribeOptions::HistoryPolicy::KEEP_ALL)
+{
+  if (_history == SubscribeOptions::HistoryPolicy::LATEST_ONLY)
+    this->capacity = 1;
+  else if (_history == SubscribeOptions::HistoryPolicy::KEEP_LAST)
+    this->capacity = std::max<uint64_t>(this->capacity, 1);
+}
+
+//////////////////////////////////////////////////
+bool SubscriptionQueue::Push(std::function<void()> _delivery)
+{
+  // The discarded delivery is destroyed after releasing the lock.
+  std::function<void()> discarded;
+
+  std::lock_guard<std::mutex> lk(this->mutex);
+  if (this->closed)
+  {
+    discarded = std::move(_delivery);
+    return false;
+  }
+
+  if (this->deliveries.size() >= this->capacity)
+  {
+    ++this->dropped;
+    if (!this->dropOldest)
+    {
+      discarded = std::move(_delivery);
+      return false;
+    }
+    discarded = std::move(this->deliveries.front());
+    this->deliveries.pop_front();
+  }
+  this->deliveries.push_back(std::move(_delivery));
+
+  if (this->scheduled)
+    return false;
+
+  this->scheduled = true;
+  return true;
+}
+
+//////////////////////////////////////////////////
+void SubscriptionQueue::Drain()
+{
+  while (true)
+  {
+    std::function<void()> delivery;
+    {
+      std::lock_guard<std::mutex> lk(this->mutex);
+      if (this->deliveries.empty())
+      {
+        this->scheduled = false;
+        return;
+      }
+      delivery = std::move(this->deliveries.front());
+      this->deliveries.pop_front();
+    }
+
+    // An exception must not leave the queue scheduled without a worker.
+    try
+    {
+      delivery();
+    }
+    catch (...)
+    {
+      std::cerr << "Exception occurred in a queued subscription callback"
+                << std::endl;
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+uint64_t SubscriptionQueue::Capacity() const
+{
+  return this->capacity;
+}
+
+//////////////////////////////////////////////////
+uint64_t SubscriptionQueue::Size() const
+{
+  std::lock_guard<std::mutex> lk(this->mutex);
+  return this->deliveries.size();
+}
+
+//////////////////////////////////////////////////
+uint64_t SubscriptionQueue::Dropped() const
+{
+  std::lock_guard<std::mutex> lk(this->mutex);
+  return this->dropped;
+}
+
+//////////////////////////////////////////////////
+void SubscriptionQueue::Close()
+{
+  // The deliveries are destroyed after releasing the lock.
+  std::deque<std::function<void()>> discarded;
+  std::lock_guard<std::mutex> lk(this->mutex);
+  this->closed = true;
+  discarded.swap(this->deliveries);
+}
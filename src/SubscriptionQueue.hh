@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef IGN_TRANSPORT_SUBSCRIPTIONQUEUE_HH_
+#define IGN_TRANSPORT_SUBSCRIPTIONQUEUE_HH_
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+#include "ignition/transport/config.hh"
+#include "ignition/transport/Export.hh"
+#include "ignition/transport/SubscribeOptions.hh"
+
+namespace ignition
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace IGNITION_TRANSPORT_VERSION_NAMESPACE {
+    //
+    /// \internal
+    /// \brief The messages waiting for the callback of a subscription with
+    /// its own queue (see SubscribeOptions::Queued()). Every message is
+    /// queued as a delivery: a function that runs the callback with it. A
+    /// worker runs the deliveries with Drain(), one at a time and in order.
+    class IGNITION_TRANSPORT_VISIBLE SubscriptionQueue
+    {
+      /// \brief Constructor.
+      /// \param[in] _history What to do when the queue is full.
+      /// \param[in] _depth Maximum number of deliveries queued.
+      public: SubscriptionQueue(const SubscribeOptions::HistoryPolicy _history,
+                                const uint64_t _depth);
+
+      /// \brief Queue a delivery, discarding a delivery if the queue is full.
+      /// \param[in] _delivery The delivery.
+      /// \return True if the queue wasn't being drained. Then, the caller
+      /// must arrange for a worker to call Drain().
+      public: bool Push(std::function<void()> _delivery);
+
+      /// \brief Run the queued deliveries until the queue is empty.
+      public: void Drain();
+
+      /// \brief Get the maximum number of deliveries queued.
+      /// \return The capacity of the queue.
+      public: uint64_t Capacity() const;
+
+      /// \brief Get the number of deliveries queued.
+      /// \return The number of deliveries waiting to run.
+      public: uint64_t Size() const;
+
+      /// \brief Get the number of deliveries discarded because the queue was
+      /// full.
+      /// \return The number of messages dropped.
+      public: uint64_t Dropped() const;
+
+      /// \brief Discard the deliveries queued and the ones pushed later.
+      /// Used when the subscription is removed. A delivery running in
+      /// Drain() isn't interrupted.
+      public: void Close();
+
+      /// \brief Protects all the member variables below.
+      private: mutable std::mutex mutex;
+
+      /// \brief Deliveries waiting to run.
+      private: std::deque<std::function<void()>> deliveries;
+
+      /// \brief Maximum number of deliveries queued.
+      private: uint64_t capacity;
+
+      /// \brief True to discard the oldest delivery when the queue is full,
+      /// false to discard the new one.
+      private: bool dropOldest;
+
+      /// \brief True from Push() returning true until Drain() empties the
+      /// queue.
+      private: bool scheduled = false;
+
+      /// \brief True after Close().
+      private: bool closed = false;
+
+      /// \brief Number of deliveries discarded.
+      private: uint64_t dropped = 0;
+    };
+    }
+  }
+}
+#endif
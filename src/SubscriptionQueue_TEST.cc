@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "SubscriptionQueue.hh"
+
+using namespace ignition;
+using namespace transport;
+
+using History = SubscribeOptions::HistoryPolicy;
+
+//////////////////////////////////////////////////
+/// \brief Push the numbers in [_first, _last) into a queue.
+/// \param[in] _queue The queue.
+/// \param[in] _first First number.
+/// \param[in] _last Last number, excluded.
+/// \param[out] _received Where the deliveries store their number.
+/// \return Number of times that Push() asked for a drain.
+int pushRange(SubscriptionQueue &_queue, const int _first, const int _last,
+  std::vector<int> &_received)
+{
+  int drains = 0;
+  for (int i = _first; i < _last; ++i)
+  {
+    if (_queue.Push([&_received, i]() {_received.push_back(i);}))
+      ++drains;
+  }
+  return drains;
+}
+
+//////////////////////////////////////////////////
+/// \brief KEEP_ALL discards the messages that don't fit.
+TEST(SubscriptionQueueTest, KeepAll)
+{
+  SubscriptionQueue queue(History::KEEP_ALL, 3);
+  EXPECT_EQ(3u, queue.Capacity());
+
+  std::vector<int> received;
+  EXPECT_EQ(1, pushRange(queue, 0, 5, received));
+  EXPECT_EQ(3u, queue.Size());
+  EXPECT_EQ(2u, queue.Dropped());
+
+  queue.Drain();
+  EXPECT_EQ(std::vector<int>({0, 1, 2}), received);
+  EXPECT_EQ(0u, queue.Size());
+
+  // The queue is idle again, so the next push asks for a drain.
+  EXPECT_EQ(1, pushRange(queue, 5, 6, received));
+  queue.Drain();
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 5}), received);
+  EXPECT_EQ(2u, queue.Dropped());
+}
+
+//////////////////////////////////////////////////
+/// \brief KEEP_LAST discards the oldest messages.
+TEST(SubscriptionQueueTest, KeepLast)
+{
+  SubscriptionQueue queue(History::KEEP_LAST, 3);
+
+  std::vector<int> received;
+  EXPECT_EQ(1, pushRange(queue, 0, 5, received));
+  EXPECT_EQ(2u, queue.Dropped());
+  queue.Drain();
+  EXPECT_EQ(std::vector<int>({2, 3, 4}), received);
+
+  // It keeps at least one message.
+  SubscriptionQueue empty(History::KEEP_LAST, 0);
+  EXPECT_EQ(1u, empty.Capacity());
+}
+
+//////////////////////////////////////////////////
+/// \brief LATEST_ONLY only keeps the newest message.
+TEST(SubscriptionQueueTest, LatestOnly)
+{
+  SubscriptionQueue queue(History::LATEST_ONLY, 10);
+  EXPECT_EQ(1u, queue.Capacity());
+
+  std::vector<int> received;
+  EXPECT_EQ(1, pushRange(queue, 0, 5, received));
+  EXPECT_EQ(1u, queue.Size());
+  EXPECT_EQ(4u, queue.Dropped());
+  queue.Drain();
+  EXPECT_EQ(std::vector<int>({4}), received);
+}
+
+//////////////////////////////////////////////////
+/// \brief The discarded deliveries are released, and the messages that
+/// arrive while draining are delivered by the same drain.
+TEST(SubscriptionQueueTest, Lifetime)
+{
+  SubscriptionQueue queue(History::LATEST_ONLY, 1);
+  auto msg = std::make_shared<int>(1);
+  EXPECT_TRUE(queue.Push([msg]() {}));
+  EXPECT_EQ(2, msg.use_count());
+  EXPECT_FALSE(queue.Push([]() {}));
+  EXPECT_EQ(1, msg.use_count());
+
+  std::vector<int> received;
+  SubscriptionQueue reentrant(History::KEEP_ALL, 10);
+  EXPECT_TRUE(reentrant.Push([&]()
+  {
+    received.push_back(0);
+    EXPECT_FALSE(reentrant.Push([&]() {received.push_back(1);}));
+  }));
+  reentrant.Drain();
+  EXPECT_EQ(std::vector<int>({0, 1}), received);
+}
+
+//////////////////////////////////////////////////
+/// \brief An exception in a callback doesn't stall the queue.
+TEST(SubscriptionQueueTest, Exception)
+{
+  SubscriptionQueue queue(History::KEEP_ALL, 10);
+  std::vector<int> received;
+  EXPECT_TRUE(queue.Push([]() {throw std::runtime_error("error");}));
+  EXPECT_FALSE(queue.Push([&received]() {received.push_back(1);}));
+  queue.Drain();
+  EXPECT_EQ(std::vector<int>({1}), received);
+  EXPECT_TRUE(queue.Push([&received]() {received.push_back(2);}));
+}
+
+//////////////////////////////////////////////////
+/// \brief A closed queue discards its deliveries.
+TEST(SubscriptionQueueTest, Close)
+{
+  SubscriptionQueue queue(History::KEEP_ALL, 10);
+  std::vector<int> received;
+  auto msg = std::make_shared<int>(1);
+  EXPECT_TRUE(queue.Push([msg, &received]() {received.push_back(1);}));
+  queue.Close();
+  EXPECT_EQ(0u, queue.Size());
+  EXPECT_EQ(1, msg.use_count());
+  EXPECT_FALSE(queue.Push([&received]() {received.push_back(2);}));
+  queue.Drain();
+  EXPECT_TRUE(received.empty());
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "ignition/transport/Discovery.hh"
+#include "ignition/transport/Node.hh"
+#include "ignition/transport/NodeShared.hh"
+#include "ignition/transport/Uuid.hh"
+
+using namespace ignition;
+using namespace transport;
+
+//////////////////////////////////////////////////
+/// \brief Print the usage of the program.
+/// \param[in] _name Name of the program.
+static void usage(const char *_name)
+{
+  std::cout << "Usage: " << _name << " [-v]\n\n"
+            << "Discovery server for the topics and services of the processes "
+            << "that set\nIGN_DISCOVERY_SERVER to the IP address of this host."
+            << "\n\n  -v, --verbose  Print the discovery messages.\n"
+            << "  -h, --help     Print this help.\n";
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  bool verbose = false;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (!strcmp(argv[i], "-v") || !strcmp(argv[i], "--verbose"))
+    {
+      verbose = true;
+    }
+    else
+    {
+      usage(argv[0]);
+      const bool help = !strcmp(argv[i], "-h") || !strcmp(argv[i], "--help");
+      return help ? 0 : -1;
+    }
+  }
+
+  // One server for the topics and another one for the services, on the same
+  // ports as the multicast discovery.
+  const std::string pUuid = Uuid().ToString();
+  MsgDiscovery msgServer(pUuid, NodeShared::kMsgDiscPort, verbose, true);
+  SrvDiscovery srvServer(pUuid, NodeShared::kSrvDiscPort, verbose, true);
+  msgServer.Start();
+  srvServer.Start();
+
+  std::cout << "Discovery server running on ports "
+            << NodeShared::kMsgDiscPort << " (topics) and "
+            << NodeShared::kSrvDiscPort << " (services)" << std::endl;
+
+  waitForShutdown();
+  return 0;
+}
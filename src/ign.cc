@@ -33,6 +33,7 @@
 #include "ignition/transport/config.hh"
 #include "ignition/transport/Helpers.hh"
 #include "ignition/transport/Node.hh"
+#include "ignition/transport/NodeShared.hh"
 
 #ifdef _MSC_VER
 # pragma warning(disable: 4503)
@@ -44,6 +45,7 @@ using namespace transport;
 //////////////////////////////////////////////////
 extern "C" void IGNITION_TRANSPORT_VISIBLE cmdTopicList()
 {
+  NodeShared::Instance()->EnableFullCatalog();
   Node node;
 
   std::vector<std::string> topics;
@@ -62,6 +64,7 @@ extern "C" void IGNITION_TRANSPORT_VISIBLE cmdTopicInfo(const char *_topic)
     return;
   }
 
+  NodeShared::Instance()->EnableFullCatalog();
   Node node;
 
   // Get the publishers on the requested topic
@@ -91,6 +94,7 @@ extern "C" void IGNITION_TRANSPORT_VISIBLE cmdTopicInfo(const char *_topic)
 //////////////////////////////////////////////////
 extern "C" void IGNITION_TRANSPORT_VISIBLE cmdServiceList()
 {
+  NodeShared::Instance()->EnableFullCatalog();
   Node node;
 
   std::vector<std::string> services;
@@ -109,6 +113,7 @@ extern "C" void IGNITION_TRANSPORT_VISIBLE cmdServiceInfo(const char *_service)
     return;
   }
 
+  NodeShared::Instance()->EnableFullCatalog();
   Node node;
 
   // Get the publishers on the requested topic
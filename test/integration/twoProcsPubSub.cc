@@ -177,6 +177,39 @@ TEST(twoProcPubSub, RawPubSubTwoProcsThreeNodes)
   testing::waitAndCleanupFork(pi);
 }
 
+//////////////////////////////////////////////////
+/// \brief This is the same as the last test, but the publisher is advertised
+/// with the generic type. The subscribers get the type of each message.
+TEST(twoProcPubSub, GenericRawPubSubTwoProcsThreeNodes)
+{
+  transport::Node node;
+  auto pub = node.Advertise(g_topic, transport::kGenericMessageType);
+  EXPECT_TRUE(pub);
+
+  std::string subscriberPath = testing::portablePathUnion(
+     IGN_TRANSPORT_TEST_DIR,
+     "INTEGRATION_twoProcsPubSubSubscriber_aux");
+
+  testing::forkHandlerType pi = testing::forkAndRun(subscriberPath.c_str(),
+    partition.c_str());
+
+  ignition::msgs::Vector3d msg;
+  msg.set_x(1.0);
+  msg.set_y(2.0);
+  msg.set_z(3.0);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+  // Publish messages for a few seconds
+  for (auto i = 0; i < 10; ++i)
+  {
+    EXPECT_TRUE(pub.PublishRaw(msg.SerializeAsString(), msg.GetTypeName()));
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  }
+
+  testing::waitAndCleanupFork(pi);
+}
+
 //////////////////////////////////////////////////
 /// \brief Check that a message is not received if the callback does not use
 /// the advertised types.
@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <ignition/msgs.hh>
+
+#include "ignition/transport/Node.hh"
+#include "gtest/gtest.h"
+#include "ignition/transport/test_config.h"
+
+using namespace ignition;
+
+static std::string partition; // NOLINT(*)
+static std::string g_topic = "/foo"; // NOLINT(*)
+static int data = 5;
+
+//////////////////////////////////////////////////
+/// \brief Service callback that echoes the request.
+bool echo(const ignition::msgs::Int32 &_req, ignition::msgs::Int32 &_rep)
+{
+  _rep.set_data(_req.data());
+  return true;
+}
+
+//////////////////////////////////////////////////
+/// \brief This test spawns two service responsers and a requester that sends
+/// the same request to both of them at once.
+TEST(twoProcSrvCallAll, SrvAllResponsers)
+{
+  std::string responser_path = testing::portablePathUnion(
+     IGN_TRANSPORT_TEST_DIR,
+     "INTEGRATION_twoProcsSrvCallReplier_aux");
+
+  testing::forkHandlerType pi1 = testing::forkAndRun(responser_path.c_str(),
+    partition.c_str());
+  testing::forkHandlerType pi2 = testing::forkAndRun(responser_path.c_str(),
+    partition.c_str());
+
+  unsigned int timeout = 1000;
+  ignition::msgs::Int32 req;
+  req.set_data(data);
+
+  transport::Node node;
+
+  // Make sure that the addresses of the service call providers are known.
+  std::this_thread::sleep_for(std::chrono::milliseconds(3000));
+
+  // Wait for every responser.
+  auto all = node.RequestAll<ignition::msgs::Int32>(g_topic, req, timeout);
+  ASSERT_EQ(all.Wait(), transport::RequestStatus::SUCCEEDED);
+  ASSERT_EQ(all.Reply().size(), 2u);
+  EXPECT_NE(all.Reply()[0].responser.Addr(), all.Reply()[1].responser.Addr());
+  for (const auto &reply : all.Reply())
+  {
+    EXPECT_TRUE(reply.result);
+    EXPECT_EQ(reply.reply.data(), data);
+  }
+
+  // Wait for the first response only.
+  auto first =
+    node.RequestAll<ignition::msgs::Int32>(g_topic, req, timeout, 1);
+  ASSERT_EQ(first.Wait(), transport::RequestStatus::SUCCEEDED);
+  ASSERT_EQ(first.Reply().size(), 1u);
+  EXPECT_EQ(first.Reply()[0].reply.data(), data);
+
+  // A responser within this process answers too.
+  transport::Node localNode;
+  ASSERT_TRUE(localNode.Advertise(g_topic, echo));
+
+  auto withLocal =
+    node.RequestAll<ignition::msgs::Int32>(g_topic, req, timeout);
+  ASSERT_EQ(withLocal.Wait(), transport::RequestStatus::SUCCEEDED);
+  ASSERT_EQ(withLocal.Reply().size(), 3u);
+  for (const auto &reply : withLocal.Reply())
+  {
+    EXPECT_TRUE(reply.result);
+    EXPECT_EQ(reply.reply.data(), data);
+  }
+  EXPECT_EQ(1, std::count_if(withLocal.Reply().begin(),
+    withLocal.Reply().end(),
+    [](const transport::ServiceReply<ignition::msgs::Int32> &_r)
+    {
+      return _r.responser.PUuid() == transport::NodeShared::Instance()->pUuid;
+    }));
+
+  // A service without responsers.
+  auto none =
+    node.RequestAll<ignition::msgs::Int32>("unknown_service", req, timeout);
+  EXPECT_EQ(none.Status(), transport::RequestStatus::NOT_SENT);
+
+  // Wait for the child processes to return.
+  testing::waitAndCleanupFork(pi1);
+  testing::waitAndCleanupFork(pi2);
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  // Get a random partition name.
+  partition = testing::getRandomNumber();
+
+  // Set the partition name for this process.
+  setenv("IGN_PARTITION", partition.c_str(), 1);
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
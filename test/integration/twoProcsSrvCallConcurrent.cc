@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <ignition/msgs.hh>
+
+#include "ignition/transport/Node.hh"
+#include "gtest/gtest.h"
+#include "ignition/transport/test_config.h"
+
+using namespace ignition;
+
+static std::string partition; // NOLINT(*)
+
+/// \brief Number of replier processes.
+static const int kRepliers = 2;
+
+/// \brief Number of services advertised by each replier.
+static const int kServices = 4;
+
+/// \brief Number of threads making requests.
+static const int kThreads = 8;
+
+/// \brief Number of requests made by each thread.
+static const int kRequests = 100;
+
+//////////////////////////////////////////////////
+/// \brief Several threads make many blocking and non-blocking requests at
+/// the same time to the services of several repliers. Every request gets
+/// the reply to itself.
+TEST(twoProcSrvCallConcurrent, ManyRequestsManyRepliers)
+{
+  std::string replierPath = testing::portablePathUnion(
+    IGN_TRANSPORT_TEST_DIR,
+    "INTEGRATION_twoProcsSrvCallManyReplier_aux");
+
+  std::vector<testing::forkHandlerType> pis;
+  for (int i = 0; i < kRepliers; ++i)
+  {
+    pis.push_back(testing::forkAndRun(replierPath.c_str(),
+      partition.c_str()));
+  }
+
+  // Wait until all the services are discovered.
+  transport::Node node;
+  std::vector<std::string> services;
+  for (int i = 0; i < 500; ++i)
+  {
+    std::vector<std::string> all;
+    node.ServiceList(all);
+    services.clear();
+    for (const auto &service : all)
+    {
+      if (service.find("/many_") == 0)
+        services.push_back(service);
+    }
+    if (services.size() == static_cast<size_t>(kRepliers * kServices))
+      break;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_EQ(services.size(), static_cast<size_t>(kRepliers * kServices));
+
+  std::atomic<int> replies{0};
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t)
+  {
+    threads.emplace_back([&node, &services, &replies, t]()
+    {
+      ignition::msgs::Int32 req;
+      ignition::msgs::Int32 rep;
+      bool result;
+      for (int i = 0; i < kRequests; ++i)
+      {
+        const std::string &service = services[(t + i) % services.size()];
+        req.set_data(t * kRequests + i);
+
+        // Alternate non-blocking and blocking requests.
+        if (i % 2 == 0)
+        {
+          const int expected = req.data();
+          std::function<void(const ignition::msgs::Int32 &, const bool)> cb =
+            [&replies, expected](const ignition::msgs::Int32 &_rep,
+                                 const bool _result)
+          {
+            EXPECT_TRUE(_result);
+            EXPECT_EQ(_rep.data(), expected);
+            ++replies;
+          };
+          EXPECT_TRUE(node.Request(service, req, cb));
+          continue;
+        }
+
+        EXPECT_TRUE(node.Request(service, req, 5000u, rep, result));
+        EXPECT_TRUE(result);
+        EXPECT_EQ(rep.data(), req.data());
+        ++replies;
+      }
+    });
+  }
+
+  for (auto &thread : threads)
+    thread.join();
+
+  // Wait until the non-blocking requests are answered.
+  const int expected = kThreads * kRequests;
+  for (int i = 0; i < 500 && replies < expected; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_EQ(replies, expected);
+
+  // Wait for the child processes to return.
+  for (auto pi : pis)
+    testing::waitAndCleanupFork(pi);
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  // Get a random partition name.
+  partition = testing::getRandomNumber();
+
+  // Set the partition name for this process.
+  setenv("IGN_PARTITION", partition.c_str(), 1);
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <ignition/msgs.hh>
+
+#include "ignition/transport/Node.hh"
+#include "gtest/gtest.h"
+#include "ignition/transport/test_config.h"
+
+using namespace ignition;
+
+static std::string partition; // NOLINT(*)
+static std::string g_topic = "/foo"; // NOLINT(*)
+static int data = 5;
+static std::atomic<bool> responseExecuted{false};
+
+/// \brief Message printed when a service call message is discarded.
+static const char kDiscarded[] = "Discarding service call message";
+
+/// \brief Time that a service call message waits for its connection (ms.).
+/// See NodeSharedPrivate::kSrvConnectTimeout.
+static const int kSrvConnectTimeout = 5000;
+
+//////////////////////////////////////////////////
+/// \brief Path of the auxiliary process that advertises g_topic.
+std::string replierPath()
+{
+  return testing::portablePathUnion(
+    IGN_TRANSPORT_TEST_DIR,
+    "INTEGRATION_twoProcsSrvCallReplier_aux");
+}
+
+//////////////////////////////////////////////////
+/// \brief The first request to a responder that has just started is
+/// answered, without waiting for the connection before calling.
+TEST(twoProcSrvCallConnect, FirstCallWithoutSleep)
+{
+  testing::forkHandlerType pi = testing::forkAndRun(replierPath().c_str(),
+    partition.c_str());
+
+  ignition::msgs::Int32 req;
+  ignition::msgs::Int32 rep;
+  bool result;
+  req.set_data(data);
+
+  transport::Node node;
+  EXPECT_TRUE(node.Request(g_topic, req, 5000u, rep, result));
+  EXPECT_TRUE(result);
+  EXPECT_EQ(rep.data(), data);
+
+  // Wait for the child process to return.
+  testing::waitAndCleanupFork(pi);
+}
+
+//////////////////////////////////////////////////
+/// \brief The requests sent to the same responder while the connection is
+/// being set up are answered in the order they were made.
+TEST(twoProcSrvCallConnect, OrderPerPeer)
+{
+  const int kRequests = 100;
+
+  testing::forkHandlerType pi = testing::forkAndRun(replierPath().c_str(),
+    partition.c_str());
+
+  std::mutex mutex;
+  std::vector<int> replies;
+  std::function<void(const ignition::msgs::Int32 &, const bool)> cb =
+    [&mutex, &replies](const ignition::msgs::Int32 &_rep, const bool _result)
+  {
+    EXPECT_TRUE(_result);
+    std::lock_guard<std::mutex> lk(mutex);
+    replies.push_back(_rep.data());
+  };
+
+  transport::Node node;
+  ignition::msgs::Int32 req;
+  for (int i = 0; i < kRequests; ++i)
+  {
+    req.set_data(i);
+    EXPECT_TRUE(node.Request(g_topic, req, cb));
+  }
+
+  // Wait until all the replies arrive.
+  for (int i = 0; i < 500; ++i)
+  {
+    {
+      std::lock_guard<std::mutex> lk(mutex);
+      if (replies.size() == static_cast<size_t>(kRequests))
+        break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  {
+    std::lock_guard<std::mutex> lk(mutex);
+    ASSERT_EQ(replies.size(), static_cast<size_t>(kRequests));
+    for (int i = 0; i < kRequests; ++i)
+      EXPECT_EQ(replies[i], i);
+  }
+
+  // Wait for the child process to return.
+  testing::waitAndCleanupFork(pi);
+}
+
+//////////////////////////////////////////////////
+/// \brief A request to a responder that went away without saying goodbye
+/// waits for the connection and is discarded after kSrvConnectTimeout.
+TEST(twoProcSrvCallConnect, UnreachablePeerDiscarded)
+{
+  testing::forkHandlerType pi = testing::forkAndRun(replierPath().c_str(),
+    partition.c_str());
+
+  ignition::msgs::Int32 req;
+  ignition::msgs::Int32 rep;
+  bool result;
+  req.set_data(data);
+
+  // Connect to the responder.
+  transport::Node node;
+  ASSERT_TRUE(node.Request(g_topic, req, 5000u, rep, result));
+
+  // Stop the responder. The discovery still knows about it until the
+  // silence interval expires.
+  testing::killFork(pi);
+  testing::waitAndCleanupFork(pi);
+
+  responseExecuted = false;
+  std::function<void(const ignition::msgs::Int32 &, const bool)> cb =
+    [](const ignition::msgs::Int32 &, const bool)
+  {
+    responseExecuted = true;
+  };
+
+  testing::internal::CaptureStderr();
+  EXPECT_TRUE(node.Request(g_topic, req, cb));
+
+  // The request is still waiting for its connection.
+  std::this_thread::sleep_for(
+    std::chrono::milliseconds(kSrvConnectTimeout - 1000));
+  std::string output = testing::internal::GetCapturedStderr();
+  EXPECT_EQ(output.find(kDiscarded), std::string::npos) << output;
+
+  // And it's discarded once the timeout expires.
+  testing::internal::CaptureStderr();
+  std::this_thread::sleep_for(std::chrono::milliseconds(2000));
+  output = testing::internal::GetCapturedStderr();
+  EXPECT_NE(output.find(kDiscarded), std::string::npos) << output;
+
+  EXPECT_FALSE(responseExecuted);
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  // Get a random partition name.
+  partition = testing::getRandomNumber();
+
+  // Set the partition name for this process.
+  setenv("IGN_PARTITION", partition.c_str(), 1);
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <ignition/msgs.hh>
+
+#include "ignition/transport/Node.hh"
+#include "gtest/gtest.h"
+#include "ignition/transport/test_config.h"
+
+using namespace ignition;
+
+static std::string partition; // NOLINT(*)
+
+/// \brief Time that the slow service of the replier takes (ms.).
+static const int kSlowMs = 2000;
+
+/// \brief Number of pong messages received.
+static std::atomic<int> pongs{0};
+
+//////////////////////////////////////////////////
+/// \brief Count the pong messages.
+void cbPong(const ignition::msgs::Int32 &)
+{
+  ++pongs;
+}
+
+//////////////////////////////////////////////////
+/// \brief Launch the replier and wait until its services answer and its
+/// topics are connected.
+/// \param[in] _node Node used to talk to the replier.
+/// \param[out] _pingPub Publisher of the ping messages.
+/// \return Process handler of the replier.
+testing::forkHandlerType startReplier(transport::Node &_node,
+  transport::Node::Publisher &_pingPub)
+{
+  std::string replierPath = testing::portablePathUnion(
+    IGN_TRANSPORT_TEST_DIR,
+    "INTEGRATION_twoProcsSrvCallWorkersReplier_aux");
+
+  testing::forkHandlerType pi = testing::forkAndRun(replierPath.c_str(),
+    partition.c_str());
+
+  ignition::msgs::Int32 req;
+  ignition::msgs::Int32 rep;
+  bool result;
+  EXPECT_TRUE(_node.Request("/fast", req, 5000u, rep, result));
+
+  _pingPub = _node.Advertise<ignition::msgs::Int32>("/ping");
+  EXPECT_TRUE(_pingPub);
+  EXPECT_TRUE(_node.Subscribe("/pong", cbPong));
+
+  pongs = 0;
+  for (int i = 0; i < 100 && pongs == 0; ++i)
+  {
+    _pingPub.Publish(req);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+  EXPECT_GT(pongs, 0);
+
+  return pi;
+}
+
+//////////////////////////////////////////////////
+/// \brief While the slow service runs in its worker thread, the replier
+/// keeps answering the fast service and receiving topic messages.
+TEST(twoProcSrvCallWorkers, SlowCallbackDoesNotBlock)
+{
+  transport::Node node;
+  transport::Node::Publisher pingPub;
+  testing::forkHandlerType pi = startReplier(node, pingPub);
+
+  std::atomic<bool> slowExecuted{false};
+  std::function<void(const ignition::msgs::Int32 &, const bool)> cb =
+    [&slowExecuted](const ignition::msgs::Int32 &_rep, const bool _result)
+  {
+    EXPECT_TRUE(_result);
+    EXPECT_EQ(_rep.data(), 1);
+    slowExecuted = true;
+  };
+
+  ignition::msgs::Int32 req;
+  req.set_data(1);
+  EXPECT_TRUE(node.Request("/slow", req, cb));
+
+  // The fast service answers right away.
+  ignition::msgs::Int32 rep;
+  bool result;
+  req.set_data(2);
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_TRUE(node.Request("/fast", req, 1000u, rep, result));
+  EXPECT_TRUE(result);
+  EXPECT_EQ(rep.data(), 2);
+
+  // And so does the topic.
+  pongs = 0;
+  EXPECT_TRUE(pingPub.Publish(req));
+  for (int i = 0; i < 100 && pongs == 0; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_GT(pongs, 0);
+
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  EXPECT_LT(elapsed, std::chrono::milliseconds(kSlowMs));
+  EXPECT_FALSE(slowExecuted);
+
+  // The slow service finishes eventually.
+  for (int i = 0; i < 500 && !slowExecuted; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_TRUE(slowExecuted);
+
+  // Wait for the child process to return.
+  testing::waitAndCleanupFork(pi);
+}
+
+//////////////////////////////////////////////////
+/// \brief The slow service accepts a single request in flight. A second
+/// request made while the first one runs is rejected right away.
+TEST(twoProcSrvCallWorkers, MaxInFlight)
+{
+  transport::Node node;
+  transport::Node::Publisher pingPub;
+  testing::forkHandlerType pi = startReplier(node, pingPub);
+
+  std::mutex mutex;
+  std::vector<std::pair<int, bool>> results;
+  std::function<void(const ignition::msgs::Int32 &, const bool)> cb =
+    [&mutex, &results](const ignition::msgs::Int32 &_rep, const bool _result)
+  {
+    std::lock_guard<std::mutex> lk(mutex);
+    results.emplace_back(_rep.data(), _result);
+  };
+
+  ignition::msgs::Int32 req;
+  req.set_data(1);
+  EXPECT_TRUE(node.Request("/slow", req, cb));
+  req.set_data(2);
+  EXPECT_TRUE(node.Request("/slow", req, cb));
+
+  // The rejected request is answered before the accepted one finishes.
+  for (int i = 0; i < 500; ++i)
+  {
+    {
+      std::lock_guard<std::mutex> lk(mutex);
+      if (results.size() == 2u)
+        break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  {
+    std::lock_guard<std::mutex> lk(mutex);
+    ASSERT_EQ(results.size(), 2u);
+    EXPECT_FALSE(results[0].second);
+    EXPECT_TRUE(results[1].second);
+    EXPECT_EQ(results[1].first, 1);
+  }
+
+  // Wait for the child process to return.
+  testing::waitAndCleanupFork(pi);
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  // Get a random partition name.
+  partition = testing::getRandomNumber();
+
+  // Set the partition name for this process.
+  setenv("IGN_PARTITION", partition.c_str(), 1);
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <chrono>
+#include <string>
+#include <thread>
+#include <ignition/msgs.hh>
+
+#include "ignition/transport/Node.hh"
+#include "gtest/gtest.h"
+#include "ignition/transport/test_config.h"
+
+using namespace ignition;
+
+/// \brief Time that the slow service takes to reply (ms.).
+static const int kSlowMs = 2000;
+
+/// \brief Publisher of the replies to the ping messages.
+static transport::Node::Publisher g_pongPub;
+
+//////////////////////////////////////////////////
+/// \brief Slow service, executed by its own worker thread.
+bool srvSlow(const ignition::msgs::Int32 &_req, ignition::msgs::Int32 &_rep)
+{
+  std::this_thread::sleep_for(std::chrono::milliseconds(kSlowMs));
+  _rep.set_data(_req.data());
+  return true;
+}
+
+//////////////////////////////////////////////////
+/// \brief Fast service, executed by the reception thread.
+bool srvFast(const ignition::msgs::Int32 &_req, ignition::msgs::Int32 &_rep)
+{
+  _rep.set_data(_req.data());
+  return true;
+}
+
+//////////////////////////////////////////////////
+/// \brief Reply to every ping message with a pong message.
+void cbPing(const ignition::msgs::Int32 &_msg)
+{
+  g_pongPub.Publish(_msg);
+}
+
+//////////////////////////////////////////////////
+void runReplier()
+{
+  transport::Node node;
+
+  // One worker thread, and a single request queued or running.
+  transport::AdvertiseServiceOptions opts;
+  opts.SetThreads(1);
+  opts.SetMaxInFlight(1);
+  EXPECT_TRUE(node.Advertise("/slow", srvSlow, opts));
+  EXPECT_TRUE(node.Advertise("/fast", srvFast));
+
+  g_pongPub = node.Advertise<ignition::msgs::Int32>("/pong");
+  EXPECT_TRUE(g_pongPub);
+  EXPECT_TRUE(node.Subscribe("/ping", cbPing));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(10000));
+  g_pongPub = transport::Node::Publisher();
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  if (argc != 2)
+  {
+    std::cerr << "Partition name has not be passed as argument" << std::endl;
+    return -1;
+  }
+
+  // Set the partition name for this test.
+  setenv("IGN_PARTITION", argv[1], 1);
+
+  runReplier();
+}
@@ -0,0 +1,301 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <ignition/msgs.hh>
+
+#include "gtest/gtest.h"
+#include "ignition/transport/Codec.hh"
+
+using namespace ignition;
+using namespace transport;
+
+/// \brief Bytes processed for each measurement, to get stable timings.
+static const double kBytesPerMeasurement = 64.0 * 1024 * 1024;
+
+/// \brief Pi.
+static const double kPi = 3.14159265358979323846;
+
+/// \brief Link bandwidths used to estimate the throughput, in bits/s.
+static const std::vector<std::pair<std::string, double>> kLinks =
+{
+  {"100 Mbit/s", 100e6},
+  {"1 Gbit/s", 1e9},
+};
+
+//////////////////////////////////////////////////
+/// \brief A laser scan of a room: smooth walls plus sensor noise.
+/// \param[in, out] _rng Random generator.
+/// \return The serialized message (~6 KB).
+static std::string laserScan(std::mt19937 &_rng)
+{
+  std::normal_distribution<float> noise(0.0f, 0.01f);
+  msgs::LaserScan msg;
+  msg.set_frame("lidar");
+  msg.set_angle_min(-kPi);
+  msg.set_angle_max(kPi);
+  msg.set_count(720);
+  for (int i = 0; i < 720; ++i)
+  {
+    const double angle = -kPi + i * 2 * kPi / 720;
+    const double range = 4.0 / std::max(std::abs(std::cos(angle)),
+      std::abs(std::sin(angle)));
+    msg.add_ranges(static_cast<float>(range) + noise(_rng));
+    msg.add_intensities(100.0f);
+  }
+  return msg.SerializeAsString();
+}
+
+//////////////////////////////////////////////////
+/// \brief A depth image of a floor with a few boxes, quantized to
+/// millimeters as depth cameras do.
+/// \param[in, out] _rng Random generator.
+/// \return The serialized message (~300 KB).
+static std::string depthImage(std::mt19937 &_rng)
+{
+  const unsigned int width = 320;
+  const unsigned int height = 240;
+  std::uniform_int_distribution<int> noise(-2, 2);
+  std::vector<float> depth(width * height);
+  for (unsigned int v = 0; v < height; ++v)
+  {
+    for (unsigned int u = 0; u < width; ++u)
+    {
+      float d = 10.0f - 8.0f * v / height;
+      if ((u / 80) % 2 == 0 && v > height / 2)
+        d = 2.0f + 0.5f * (u / 80);
+      depth[v * width + u] = std::round(d * 1000 + noise(_rng)) / 1000;
+    }
+  }
+
+  msgs::Image msg;
+  msg.set_width(width);
+  msg.set_height(height);
+  msg.set_step(width * sizeof(float));
+  msg.set_pixel_format_type(msgs::PixelFormatType::R_FLOAT32);
+  msg.set_data(reinterpret_cast<const char *>(depth.data()),
+    depth.size() * sizeof(float));
+  return msg.SerializeAsString();
+}
+
+//////////////////////////////////////////////////
+/// \brief A rendered color image: large flat regions, gradients and some
+/// texture.
+/// \param[in, out] _rng Random generator.
+/// \return The serialized message (~900 KB).
+static std::string colorImage(std::mt19937 &_rng)
+{
+  const unsigned int width = 640;
+  const unsigned int height = 480;
+  std::uniform_int_distribution<int> noise(0, 3);
+  std::string data(width * height * 3, '\0');
+  for (unsigned int v = 0; v < height; ++v)
+  {
+    for (unsigned int u = 0; u < width; ++u)
+    {
+      unsigned char *pixel =
+        reinterpret_cast<unsigned char *>(&data[(v * width + u) * 3]);
+      if (v < height / 3)
+      {
+        // Sky.
+        pixel[0] = 120;
+        pixel[1] = static_cast<unsigned char>(160 + v / 4);
+        pixel[2] = 230;
+      }
+      else if ((u / 40 + v / 40) % 2 == 0)
+      {
+        // Textured floor.
+        pixel[0] = static_cast<unsigned char>(90 + noise(_rng));
+        pixel[1] = static_cast<unsigned char>(80 + noise(_rng));
+        pixel[2] = static_cast<unsigned char>(60 + noise(_rng));
+      }
+      else
+      {
+        pixel[0] = pixel[1] = pixel[2] = 200;
+      }
+    }
+  }
+
+  msgs::Image msg;
+  msg.set_width(width);
+  msg.set_height(height);
+  msg.set_step(width * 3);
+  msg.set_pixel_format_type(msgs::PixelFormatType::RGB_INT8);
+  msg.set_data(data);
+  return msg.SerializeAsString();
+}
+
+//////////////////////////////////////////////////
+/// \brief A point cloud of a lidar: XYZ as floats and an intensity.
+/// \param[in, out] _rng Random generator.
+/// \return The serialized message (~500 KB).
+static std::string pointCloud(std::mt19937 &_rng)
+{
+  const unsigned int points = 32000;
+  std::normal_distribution<float> noise(0.0f, 0.01f);
+  std::vector<float> data;
+  data.reserve(points * 4);
+  for (unsigned int i = 0; i < points; ++i)
+  {
+    const float ring = static_cast<float>(i % 16);
+    const float angle = static_cast<float>((i / 16) * 2 * kPi / 2000);
+    const float range = 10.0f + noise(_rng);
+    data.push_back(range * std::cos(angle));
+    data.push_back(range * std::sin(angle));
+    data.push_back(-1.0f + ring * 0.1f);
+    data.push_back(ring);
+  }
+
+  msgs::PointCloudPacked msg;
+  msg.set_height(1);
+  msg.set_width(points);
+  msg.set_point_step(4 * sizeof(float));
+  msg.set_row_step(points * 4 * sizeof(float));
+  msg.set_is_dense(true);
+  const char *names[] = {"x", "y", "z", "intensity"};
+  for (unsigned int i = 0; i < 4; ++i)
+  {
+    auto field = msg.add_field();
+    field->set_name(names[i]);
+    field->set_offset(i * sizeof(float));
+    field->set_datatype(msgs::PointCloudPacked::Field::FLOAT32);
+    field->set_count(1);
+  }
+  msg.set_data(reinterpret_cast<const char *>(data.data()),
+    data.size() * sizeof(float));
+  return msg.SerializeAsString();
+}
+
+//////////////////////////////////////////////////
+/// \brief Run a function enough times and get its average duration.
+/// \param[in] _iterations Number of runs.
+/// \param[in] _func The function.
+/// \return Average duration in seconds.
+template<typename F>
+static double measure(const int _iterations, F _func)
+{
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < _iterations; ++i)
+    _func();
+  std::chrono::duration<double> elapsed =
+    std::chrono::steady_clock::now() - start;
+  return elapsed.count() / _iterations;
+}
+
+//////////////////////////////////////////////////
+/// \brief Compress representative messages with every available codec and
+/// estimate the publication throughput over different links, compared with
+/// sending them uncompressed. The publisher compresses, the link transmits
+/// and the subscriber decompresses concurrently, so the slowest of the three
+/// sets the throughput.
+TEST(Compression, Throughput)
+{
+  std::mt19937 rng(42);
+  const std::vector<std::pair<std::string, std::string>> payloads =
+  {
+    {"LaserScan", laserScan(rng)},
+    {"Image (depth)", depthImage(rng)},
+    {"Image (color)", colorImage(rng)},
+    {"PointCloudPacked", pointCloud(rng)},
+  };
+
+  std::vector<std::pair<std::string, int>> codecs = {{"none", 0}};
+  for (const auto &name : Codec::Names())
+  {
+    codecs.push_back({name, 0});
+    codecs.push_back({name, 1});
+  }
+
+  std::cout << std::left << std::setw(18) << "Payload"
+            << std::setw(12) << "Codec"
+            << std::right << std::setw(10) << "Size"
+            << std::setw(8) << "Ratio"
+            << std::setw(12) << "Comp MB/s"
+            << std::setw(12) << "Dec MB/s";
+  for (const auto &link : kLinks)
+    std::cout << std::setw(18) << ("msgs/s " + link.first);
+  std::cout << std::endl;
+
+  for (const auto &payload : payloads)
+  {
+    const std::string &data = payload.second;
+    const int iterations = std::max(10,
+      static_cast<int>(kBytesPerMeasurement / data.size()));
+
+    for (const auto &entry : codecs)
+    {
+      double compressTime = 0;
+      double decompressTime = 0;
+      size_t size = data.size();
+
+      if (entry.first != "none")
+      {
+        auto codec = Codec::Find(entry.first);
+        ASSERT_NE(nullptr, codec);
+
+        std::string compressed;
+        compressTime = measure(iterations, [&]()
+        {
+          codec->Compress(data.data(), data.size(), entry.second,
+            compressed);
+        });
+        size = compressed.size();
+
+        std::string restored;
+        decompressTime = measure(iterations, [&]()
+        {
+          codec->Decompress(compressed.data(), compressed.size(), restored);
+        });
+        EXPECT_EQ(data, restored);
+      }
+
+      std::ostringstream codecName;
+      codecName << entry.first;
+      if (entry.first != "none")
+        codecName << ":" << entry.second;
+
+      std::cout << std::left << std::setw(18) << payload.first
+                << std::setw(12) << codecName.str()
+                << std::right << std::setw(10) << size
+                << std::setw(8) << std::fixed << std::setprecision(2)
+                << static_cast<double>(data.size()) / size
+                << std::setw(12) << std::setprecision(0)
+                << (compressTime > 0 ? data.size() / compressTime / 1e6 : 0)
+                << std::setw(12)
+                << (decompressTime > 0 ?
+                     data.size() / decompressTime / 1e6 : 0);
+
+      for (const auto &link : kLinks)
+      {
+        const double wireTime = size * 8.0 / link.second;
+        const double slowest =
+          std::max({compressTime, wireTime, decompressTime});
+        std::cout << std::setw(18) << 1.0 / slowest;
+      }
+      std::cout << std::endl;
+    }
+  }
+}
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <ignition/msgs.hh>
+
+#include "gtest/gtest.h"
+#include "ignition/transport/Node.hh"
+#include "test_config.h"
+
+using namespace ignition;
+
+/// \brief Number of messages published by each thread.
+static const int kMessages = 20000;
+
+/// \brief Number of messages received by all the subscribers.
+static std::atomic<int> received{0};
+
+//////////////////////////////////////////////////
+/// \brief Subscriber callback.
+void cb(const msgs::Int32 &)
+{
+  ++received;
+}
+
+//////////////////////////////////////////////////
+/// \brief Service callback.
+bool srvEcho(const msgs::Int32 &_req, msgs::Int32 &_rep)
+{
+  _rep.set_data(_req.data());
+  return true;
+}
+
+//////////////////////////////////////////////////
+/// \brief Publish from several threads, each one on its own topic, while
+/// another thread keeps making service calls and subscribing and
+/// unsubscribing. Prints the publication throughput for each number of
+/// threads.
+TEST(PublishContention, Scaling)
+{
+  const unsigned int maxThreads =
+    std::max(1u, std::min(8u, std::thread::hardware_concurrency()));
+
+  transport::Node node;
+  ASSERT_TRUE(node.Advertise("/contention_srv", srvEcho));
+
+  double baseline = 0;
+  for (unsigned int threads = 1; threads <= maxThreads; threads *= 2)
+  {
+    std::vector<std::unique_ptr<transport::Node>> nodes;
+    std::vector<transport::Node::Publisher> pubs;
+    for (unsigned int i = 0; i < threads; ++i)
+    {
+      const std::string topic = "/contention_" + std::to_string(threads) +
+        "_" + std::to_string(i);
+      nodes.emplace_back(new transport::Node());
+      pubs.push_back(nodes.back()->Advertise<msgs::Int32>(topic));
+      ASSERT_TRUE(pubs.back());
+      ASSERT_TRUE(node.Subscribe(topic, cb));
+    }
+
+    received = 0;
+    std::atomic<bool> stop{false};
+
+    // Service calls and subscription changes in the background.
+    std::thread background([&node, &stop]()
+    {
+      msgs::Int32 req;
+      msgs::Int32 rep;
+      bool result;
+      while (!stop)
+      {
+        node.Request("/contention_srv", req, 1000u, rep, result);
+        node.Subscribe("/contention_churn", cb);
+        node.Unsubscribe("/contention_churn");
+      }
+    });
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> publishers;
+    for (unsigned int i = 0; i < threads; ++i)
+    {
+      publishers.emplace_back([&pubs, i]()
+      {
+        msgs::Int32 msg;
+        for (int j = 0; j < kMessages; ++j)
+        {
+          msg.set_data(j);
+          EXPECT_TRUE(pubs[i].Publish(msg));
+        }
+      });
+    }
+
+    for (auto &publisher : publishers)
+      publisher.join();
+
+    // Wait until the callbacks run.
+    const int expected = kMessages * static_cast<int>(threads);
+    for (int i = 0; i < 500 && received < expected; ++i)
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    stop = true;
+    background.join();
+
+    EXPECT_EQ(expected, received);
+
+    const double seconds =
+      std::chrono::duration<double>(elapsed).count();
+    const double rate = expected / seconds;
+    if (threads == 1)
+      baseline = rate;
+
+    std::cout << threads << " publisher thread(s): "
+              << static_cast<uint64_t>(rate) << " msgs/s (x"
+              << rate / baseline << ")" << std::endl;
+  }
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  // Get a random partition name.
+  std::string partition = testing::getRandomNumber();
+
+  // Set the partition name for this process.
+  setenv("IGN_PARTITION", partition.c_str(), 1);
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <ignition/msgs.hh>
+
+#include "gtest/gtest.h"
+#include "ignition/transport/Node.hh"
+#include "ignition/transport/test_config.h"
+
+using namespace ignition;
+
+static std::string partition; // NOLINT(*)
+
+/// \brief Number of requests made for each number of requests in flight.
+static const int kRequests = 8192;
+
+/// \brief Number of replies received.
+static std::atomic<int> replies{0};
+
+//////////////////////////////////////////////////
+/// \brief Service call response callback.
+void response(const msgs::Int32 &, const bool _result)
+{
+  EXPECT_TRUE(_result);
+  ++replies;
+}
+
+//////////////////////////////////////////////////
+/// \brief Make requests to a replier in another process, keeping an
+/// increasing number of them in flight. Prints the request throughput for
+/// each number of requests in flight, which shouldn't drop as it grows.
+TEST(ServiceRequests, InFlight)
+{
+  std::string replierPath = testing::portablePathUnion(
+    IGN_TRANSPORT_TEST_DIR,
+    "PERFORMANCE_serviceRequestsReplier_aux");
+
+  testing::forkHandlerType pi = testing::forkAndRun(replierPath.c_str(),
+    partition.c_str());
+
+  transport::Node node;
+  msgs::Int32 req;
+  msgs::Int32 rep;
+  bool result;
+
+  // Wait until the replier is ready.
+  ASSERT_TRUE(node.Request("/perf_srv", req, 5000u, rep, result));
+
+  double baseline = 0;
+  for (int inFlight = 1; inFlight <= 4096; inFlight *= 16)
+  {
+    replies = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (int sent = 0; sent < kRequests; sent += inFlight)
+    {
+      for (int i = 0; i < inFlight; ++i)
+      {
+        req.set_data(sent + i);
+        EXPECT_TRUE(node.Request("/perf_srv", req, response));
+      }
+
+      // Wait until the batch is answered.
+      const int expected = sent + inFlight;
+      for (int i = 0; i < 5000 && replies < expected; ++i)
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+      EXPECT_EQ(expected, replies);
+    }
+
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    const double seconds =
+      std::chrono::duration<double>(elapsed).count();
+    const double rate = kRequests / seconds;
+    if (inFlight == 1)
+      baseline = rate;
+
+    std::cout << inFlight << " request(s) in flight: "
+              << static_cast<uint64_t>(rate) << " requests/s (x"
+              << rate / baseline << ")" << std::endl;
+  }
+
+  testing::killFork(pi);
+  testing::waitAndCleanupFork(pi);
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  // Get a random partition name.
+  partition = testing::getRandomNumber();
+
+  // Set the partition name for this process.
+  setenv("IGN_PARTITION", partition.c_str(), 1);
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
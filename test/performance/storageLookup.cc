@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <ignition/msgs.hh>
+
+#include "gtest/gtest.h"
+#include "ignition/transport/AdvertiseOptions.hh"
+#include "ignition/transport/HandlerStorage.hh"
+#include "ignition/transport/Publisher.hh"
+#include "ignition/transport/SubscriptionHandler.hh"
+#include "ignition/transport/TopicStorage.hh"
+
+using namespace ignition;
+using namespace transport;
+
+/// \brief Number of topics stored.
+static const int kTopics = 10000;
+
+/// \brief Number of lookups measured.
+static const int kLookups = 1000000;
+
+//////////////////////////////////////////////////
+/// \brief Get a fully qualified topic name.
+/// \param[in] _index Index of the topic.
+/// \return The topic name.
+static std::string topicName(const int _index)
+{
+  return "@/partition@/robot/sensors/topic_" + std::to_string(_index);
+}
+
+//////////////////////////////////////////////////
+/// \brief Run a function for every lookup and print the average time.
+/// \param[in] _name Name of the measurement.
+/// \param[in] _topics Topics looked up, in a round-robin fashion.
+/// \param[in] _lookup Function that looks up a topic. It returns true if the
+/// topic was found.
+template<typename F>
+static void measure(const std::string &_name,
+  const std::vector<std::string> &_topics, F _lookup)
+{
+  int found = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kLookups; ++i)
+  {
+    if (_lookup(_topics[i % _topics.size()]))
+      ++found;
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  EXPECT_EQ(kLookups, found);
+  std::cout << _name << ": "
+            << std::chrono::duration_cast<std::chrono::nanoseconds>(
+                 elapsed).count() / kLookups
+            << " ns/lookup (" << kTopics << " topics)" << std::endl;
+}
+
+//////////////////////////////////////////////////
+/// \brief Lookup cost of the subscription handlers of a topic, as done for
+/// every message received and every publication that needs to refresh its
+/// subscribers.
+TEST(StorageLookup, Handlers)
+{
+  HandlerStorage<ISubscriptionHandler> storage;
+
+  // The same data stored as it used to be, for comparison.
+  std::map<std::string, std::map<std::string, ISubscriptionHandler_M>>
+    sortedStorage;
+
+  std::vector<std::string> topics;
+  for (int i = 0; i < kTopics; ++i)
+  {
+    const std::string nUuid = "node-" + std::to_string(i % 10);
+    auto handler =
+      std::make_shared<SubscriptionHandler<msgs::Int32>>(nUuid);
+    topics.push_back(topicName(i));
+    storage.AddHandler(topics.back(), nUuid, handler);
+    sortedStorage[topics.back()][nUuid][handler->HandlerUuid()] = handler;
+  }
+
+  measure("std::map with copy", topics,
+    [&sortedStorage](const std::string &_topic)
+    {
+      auto it = sortedStorage.find(_topic);
+      if (it == sortedStorage.end())
+        return false;
+      std::map<std::string, ISubscriptionHandler_M> handlers = it->second;
+      return !handlers.empty();
+    });
+
+  measure("HandlerStorage::Handlers() copy", topics,
+    [&storage](const std::string &_topic)
+    {
+      std::map<std::string, ISubscriptionHandler_M> handlers;
+      return storage.Handlers(_topic, handlers);
+    });
+
+  measure("HandlerStorage::Handlers() view", topics,
+    [&storage](const std::string &_topic)
+    {
+      return storage.Handlers(_topic) != nullptr;
+    });
+}
+
+//////////////////////////////////////////////////
+/// \brief Lookup cost of the remote subscribers of a topic.
+TEST(StorageLookup, Publishers)
+{
+  TopicStorage<MessagePublisher> storage;
+  std::vector<std::string> topics;
+  for (int i = 0; i < kTopics; ++i)
+  {
+    topics.push_back(topicName(i));
+    MessagePublisher publisher(topics.back(), "tcp://127.0.0.1:12345",
+      "tcp://127.0.0.1:12346", "process-" + std::to_string(i % 10),
+      "node-" + std::to_string(i % 100), msgs::Int32().GetTypeName(),
+      AdvertiseMessageOptions());
+    storage.AddPublisher(publisher);
+  }
+
+  const std::string type = msgs::Int32().GetTypeName();
+  measure("TopicStorage::HasTopic()", topics,
+    [&storage, &type](const std::string &_topic)
+    {
+      return storage.HasTopic(_topic, type);
+    });
+}